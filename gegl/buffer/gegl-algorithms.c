@@ -28,9 +28,15 @@
 #include "gegl-buffer.h"
 #include "gegl-buffer-formats.h"
 #include "gegl-algorithms.h"
+#include "gegl-cpuaccel.h"
 
 #include <math.h>
 
+#if defined(ARCH_X86) && defined(__GNUC__)
+#define DOWNSCALE_SIMD 1
+#include <immintrin.h>
+#endif
+
 void gegl_downscale_2x2 (const Babl *format,
                          gint        src_width,
                          gint        src_height,
@@ -92,9 +98,9 @@ gegl_downscale_2x2_generic (const Babl *format,
                      src_data, src_rowstride,
                      in_tmp,   in_tmp_rowstride,
                      src_width, src_height);
-  gegl_downscale_2x2_float (tmp_format, src_width, src_height,
-                            in_tmp,  in_tmp_rowstride,
-                            out_tmp, out_tmp_rowstride);
+  gegl_downscale_2x2_get_fun (tmp_format) (tmp_format, src_width, src_height,
+                                           in_tmp,  in_tmp_rowstride,
+                                           out_tmp, out_tmp_rowstride);
   babl_process_rows (to_fish,
                      out_tmp,   out_tmp_rowstride,
                      dst_data,  dst_rowstride,
@@ -912,6 +918,574 @@ gegl_downscale_2x2_u8_rgb (const Babl *format,
 }
 
 
+#ifdef DOWNSCALE_SIMD
+
+/* SIMD versions of the 2x2 box filters for linear data with up to four
+ * components.  they add up the four source pixels in the same order as the
+ * scalar code, so the results are identical.  whatever is left of a row
+ * once the vector loop is done is finished one pixel at a time; for three
+ * component pixels, where each vector store spills into the next pixel,
+ * that is always the last pixel of the row.
+ */
+
+/* packs the 32-bit lanes of @lo and @hi, which must all fit in 16 bits, to
+ * 16-bit lanes.  sse2 only has a signed saturating pack, so the values are
+ * biased into the signed range and back.
+ */
+#define DOWNSCALE_PACK_U32(lo, hi)                                         \
+  _mm_xor_si128 (_mm_packs_epi32 (_mm_sub_epi32 ((lo), bias32),            \
+                                  _mm_sub_epi32 ((hi), bias32)),           \
+                 bias16)
+
+/* the even and odd 32-bit lanes of two vectors */
+#define DOWNSCALE_EVEN_32(a, b) \
+  _mm_shuffle_ps ((a), (b), _MM_SHUFFLE (2, 0, 2, 0))
+#define DOWNSCALE_ODD_32(a, b) \
+  _mm_shuffle_ps ((a), (b), _MM_SHUFFLE (3, 1, 3, 1))
+
+/* the even and odd 64-bit lanes of two vectors */
+#define DOWNSCALE_EVEN_64(a, b) \
+  _mm_shuffle_ps ((a), (b), _MM_SHUFFLE (1, 0, 1, 0))
+#define DOWNSCALE_ODD_64(a, b) \
+  _mm_shuffle_ps ((a), (b), _MM_SHUFFLE (3, 2, 3, 2))
+
+__attribute__ ((target ("sse2")))
+static void
+gegl_downscale_2x2_float_sse2 (const Babl *format,
+                               gint        src_width,
+                               gint        src_height,
+                               guchar     *src_data,
+                               gint        src_rowstride,
+                               guchar     *dst_data,
+                               gint        dst_rowstride)
+{
+  const gint   components = babl_format_get_bytes_per_pixel (format) /
+                            sizeof (gfloat);
+  const gint   dst_width  = src_width / 2;
+  const __m128 quarter    = _mm_set1_ps (0.25f);
+  gint         y;
+
+  if (!src_data || !dst_data)
+    return;
+
+  for (y = 0; y < src_height / 2; y++)
+    {
+      const gfloat *a   = (gfloat *) (src_data + src_rowstride * y * 2);
+      const gfloat *b   = (gfloat *) (src_data + src_rowstride * (y * 2 + 1));
+      gfloat       *dst = (gfloat *) (dst_data + dst_rowstride * y);
+      gint          x   = 0;
+      gint          c;
+
+      switch (components)
+        {
+        case 1:
+          for (; x + 4 <= dst_width; x += 4)
+            {
+              __m128 a0 = _mm_loadu_ps (a + 2 * x);
+              __m128 a1 = _mm_loadu_ps (a + 2 * x + 4);
+              __m128 b0 = _mm_loadu_ps (b + 2 * x);
+              __m128 b1 = _mm_loadu_ps (b + 2 * x + 4);
+              __m128 sum;
+
+              sum = _mm_add_ps (DOWNSCALE_EVEN_32 (a0, a1),
+                                DOWNSCALE_ODD_32  (a0, a1));
+              sum = _mm_add_ps (sum, DOWNSCALE_EVEN_32 (b0, b1));
+              sum = _mm_add_ps (sum, DOWNSCALE_ODD_32  (b0, b1));
+
+              _mm_storeu_ps (dst + x, _mm_mul_ps (sum, quarter));
+            }
+          break;
+
+        case 2:
+          for (; x + 2 <= dst_width; x += 2)
+            {
+              __m128 a0 = _mm_loadu_ps (a + 4 * x);
+              __m128 a1 = _mm_loadu_ps (a + 4 * x + 4);
+              __m128 b0 = _mm_loadu_ps (b + 4 * x);
+              __m128 b1 = _mm_loadu_ps (b + 4 * x + 4);
+              __m128 sum;
+
+              sum = _mm_add_ps (DOWNSCALE_EVEN_64 (a0, a1),
+                                DOWNSCALE_ODD_64  (a0, a1));
+              sum = _mm_add_ps (sum, DOWNSCALE_EVEN_64 (b0, b1));
+              sum = _mm_add_ps (sum, DOWNSCALE_ODD_64  (b0, b1));
+
+              _mm_storeu_ps (dst + 2 * x, _mm_mul_ps (sum, quarter));
+            }
+          break;
+
+        case 3:
+          for (; x + 1 < dst_width; x++)
+            {
+              __m128 sum;
+
+              sum = _mm_add_ps (_mm_loadu_ps (a + 6 * x),
+                                _mm_loadu_ps (a + 6 * x + 3));
+              sum = _mm_add_ps (sum, _mm_loadu_ps (b + 6 * x));
+              sum = _mm_add_ps (sum, _mm_loadu_ps (b + 6 * x + 3));
+
+              _mm_storeu_ps (dst + 3 * x, _mm_mul_ps (sum, quarter));
+            }
+          break;
+
+        case 4:
+          for (; x < dst_width; x++)
+            {
+              __m128 sum;
+
+              sum = _mm_add_ps (_mm_loadu_ps (a + 8 * x),
+                                _mm_loadu_ps (a + 8 * x + 4));
+              sum = _mm_add_ps (sum, _mm_loadu_ps (b + 8 * x));
+              sum = _mm_add_ps (sum, _mm_loadu_ps (b + 8 * x + 4));
+
+              _mm_storeu_ps (dst + 4 * x, _mm_mul_ps (sum, quarter));
+            }
+          break;
+        }
+
+      for (; x < dst_width; x++)
+        {
+          for (c = 0; c < components; c++)
+            {
+              dst[x * components + c] = (a[(2 * x)     * components + c] +
+                                         a[(2 * x + 1) * components + c] +
+                                         b[(2 * x)     * components + c] +
+                                         b[(2 * x + 1) * components + c]) /
+                                        4.0f;
+            }
+        }
+    }
+}
+
+__attribute__ ((target ("sse2")))
+static void
+gegl_downscale_2x2_u16_sse2 (const Babl *format,
+                             gint        src_width,
+                             gint        src_height,
+                             guchar     *src_data,
+                             gint        src_rowstride,
+                             guchar     *dst_data,
+                             gint        dst_rowstride)
+{
+  const gint    components = babl_format_get_bytes_per_pixel (format) /
+                             sizeof (guint16);
+  const gint    dst_width  = src_width / 2;
+  const __m128i zero       = _mm_setzero_si128 ();
+  const __m128i low16      = _mm_set1_epi32 (0xffff);
+  const __m128i bias32     = _mm_set1_epi32 (0x8000);
+  const __m128i bias16     = _mm_set1_epi16 ((gshort) 0x8000);
+  gint          y;
+
+  if (!src_data || !dst_data)
+    return;
+
+  for (y = 0; y < src_height / 2; y++)
+    {
+      const guint16 *a   = (guint16 *) (src_data + src_rowstride * y * 2);
+      const guint16 *b   = (guint16 *) (src_data + src_rowstride * (y * 2 + 1));
+      guint16       *dst = (guint16 *) (dst_data + dst_rowstride * y);
+      gint           x   = 0;
+      gint           c;
+
+      switch (components)
+        {
+        case 1:
+          for (; x + 8 <= dst_width; x += 8)
+            {
+              __m128i sum[2];
+              gint    i;
+
+              for (i = 0; i < 2; i++)
+                {
+                  __m128i va = _mm_loadu_si128 ((__m128i *) (a + 2 * x + 8 * i));
+                  __m128i vb = _mm_loadu_si128 ((__m128i *) (b + 2 * x + 8 * i));
+
+                  sum[i] = _mm_add_epi32 (_mm_add_epi32 (_mm_and_si128 (va, low16),
+                                                         _mm_srli_epi32 (va, 16)),
+                                          _mm_add_epi32 (_mm_and_si128 (vb, low16),
+                                                         _mm_srli_epi32 (vb, 16)));
+                  sum[i] = _mm_srli_epi32 (sum[i], 2);
+                }
+
+              _mm_storeu_si128 ((__m128i *) (dst + x),
+                                DOWNSCALE_PACK_U32 (sum[0], sum[1]));
+            }
+          break;
+
+        case 2:
+          for (; x + 4 <= dst_width; x += 4)
+            {
+              __m128i sum[2];
+              gint    i;
+
+              for (i = 0; i < 2; i++)
+                {
+                  __m128i va = _mm_loadu_si128 ((__m128i *) (a + 4 * x + 8 * i));
+                  __m128i vb = _mm_loadu_si128 ((__m128i *) (b + 4 * x + 8 * i));
+                  __m128i al = _mm_unpacklo_epi16 (va, zero);
+                  __m128i ah = _mm_unpackhi_epi16 (va, zero);
+                  __m128i bl = _mm_unpacklo_epi16 (vb, zero);
+                  __m128i bh = _mm_unpackhi_epi16 (vb, zero);
+
+                  sum[i] = _mm_add_epi32 (_mm_add_epi32 (_mm_unpacklo_epi64 (al, ah),
+                                                         _mm_unpackhi_epi64 (al, ah)),
+                                          _mm_add_epi32 (_mm_unpacklo_epi64 (bl, bh),
+                                                         _mm_unpackhi_epi64 (bl, bh)));
+                  sum[i] = _mm_srli_epi32 (sum[i], 2);
+                }
+
+              _mm_storeu_si128 ((__m128i *) (dst + 2 * x),
+                                DOWNSCALE_PACK_U32 (sum[0], sum[1]));
+            }
+          break;
+
+        case 3:
+          for (; x + 1 < dst_width; x++)
+            {
+              __m128i sum;
+
+              sum = _mm_add_epi32 (
+                _mm_add_epi32 (
+                  _mm_unpacklo_epi16 (_mm_loadl_epi64 ((__m128i *) (a + 6 * x)),     zero),
+                  _mm_unpacklo_epi16 (_mm_loadl_epi64 ((__m128i *) (a + 6 * x + 3)), zero)),
+                _mm_add_epi32 (
+                  _mm_unpacklo_epi16 (_mm_loadl_epi64 ((__m128i *) (b + 6 * x)),     zero),
+                  _mm_unpacklo_epi16 (_mm_loadl_epi64 ((__m128i *) (b + 6 * x + 3)), zero)));
+              sum = _mm_srli_epi32 (sum, 2);
+
+              _mm_storel_epi64 ((__m128i *) (dst + 3 * x),
+                                DOWNSCALE_PACK_U32 (sum, sum));
+            }
+          break;
+
+        case 4:
+          for (; x + 2 <= dst_width; x += 2)
+            {
+              __m128i sum[2];
+              gint    i;
+
+              for (i = 0; i < 2; i++)
+                {
+                  __m128i va = _mm_loadu_si128 ((__m128i *) (a + 8 * x + 8 * i));
+                  __m128i vb = _mm_loadu_si128 ((__m128i *) (b + 8 * x + 8 * i));
+
+                  sum[i] = _mm_add_epi32 (_mm_add_epi32 (_mm_unpacklo_epi16 (va, zero),
+                                                         _mm_unpackhi_epi16 (va, zero)),
+                                          _mm_add_epi32 (_mm_unpacklo_epi16 (vb, zero),
+                                                         _mm_unpackhi_epi16 (vb, zero)));
+                  sum[i] = _mm_srli_epi32 (sum[i], 2);
+                }
+
+              _mm_storeu_si128 ((__m128i *) (dst + 4 * x),
+                                DOWNSCALE_PACK_U32 (sum[0], sum[1]));
+            }
+          break;
+        }
+
+      for (; x < dst_width; x++)
+        {
+          for (c = 0; c < components; c++)
+            {
+              dst[x * components + c] = ((guint) a[(2 * x)     * components + c] +
+                                         (guint) a[(2 * x + 1) * components + c] +
+                                         (guint) b[(2 * x)     * components + c] +
+                                         (guint) b[(2 * x + 1) * components + c]) /
+                                        4;
+            }
+        }
+    }
+}
+
+__attribute__ ((target ("sse2")))
+static void
+gegl_downscale_2x2_u8_sse2 (const Babl *format,
+                            gint        src_width,
+                            gint        src_height,
+                            guchar     *src_data,
+                            gint        src_rowstride,
+                            guchar     *dst_data,
+                            gint        dst_rowstride)
+{
+  const gint    components = babl_format_get_bytes_per_pixel (format);
+  const gint    dst_width  = src_width / 2;
+  const __m128i zero       = _mm_setzero_si128 ();
+  const __m128i low8       = _mm_set1_epi16 (0xff);
+  gint          y;
+
+  if (!src_data || !dst_data)
+    return;
+
+  for (y = 0; y < src_height / 2; y++)
+    {
+      const guint8 *a   = src_data + src_rowstride * y * 2;
+      const guint8 *b   = src_data + src_rowstride * (y * 2 + 1);
+      guint8       *dst = dst_data + dst_rowstride * y;
+      gint          x   = 0;
+      gint          c;
+
+      switch (components)
+        {
+        case 1:
+          for (; x + 8 <= dst_width; x += 8)
+            {
+              __m128i va = _mm_loadu_si128 ((__m128i *) (a + 2 * x));
+              __m128i vb = _mm_loadu_si128 ((__m128i *) (b + 2 * x));
+              __m128i sum;
+
+              sum = _mm_add_epi16 (_mm_add_epi16 (_mm_and_si128 (va, low8),
+                                                  _mm_srli_epi16 (va, 8)),
+                                   _mm_add_epi16 (_mm_and_si128 (vb, low8),
+                                                  _mm_srli_epi16 (vb, 8)));
+              sum = _mm_srli_epi16 (sum, 2);
+
+              _mm_storel_epi64 ((__m128i *) (dst + x),
+                                _mm_packus_epi16 (sum, sum));
+            }
+          break;
+
+        case 2:
+          for (; x + 4 <= dst_width; x += 4)
+            {
+              __m128i va = _mm_loadu_si128 ((__m128i *) (a + 4 * x));
+              __m128i vb = _mm_loadu_si128 ((__m128i *) (b + 4 * x));
+              __m128  al = _mm_castsi128_ps (_mm_unpacklo_epi8 (va, zero));
+              __m128  ah = _mm_castsi128_ps (_mm_unpackhi_epi8 (va, zero));
+              __m128  bl = _mm_castsi128_ps (_mm_unpacklo_epi8 (vb, zero));
+              __m128  bh = _mm_castsi128_ps (_mm_unpackhi_epi8 (vb, zero));
+              __m128i sum;
+
+              sum = _mm_add_epi16 (
+                _mm_add_epi16 (_mm_castps_si128 (DOWNSCALE_EVEN_32 (al, ah)),
+                               _mm_castps_si128 (DOWNSCALE_ODD_32  (al, ah))),
+                _mm_add_epi16 (_mm_castps_si128 (DOWNSCALE_EVEN_32 (bl, bh)),
+                               _mm_castps_si128 (DOWNSCALE_ODD_32  (bl, bh))));
+              sum = _mm_srli_epi16 (sum, 2);
+
+              _mm_storel_epi64 ((__m128i *) (dst + 2 * x),
+                                _mm_packus_epi16 (sum, sum));
+            }
+          break;
+
+        case 3:
+          for (; x + 1 < dst_width; x++)
+            {
+              __m128i va = _mm_unpacklo_epi8 (
+                _mm_loadl_epi64 ((__m128i *) (a + 6 * x)), zero);
+              __m128i vb = _mm_unpacklo_epi8 (
+                _mm_loadl_epi64 ((__m128i *) (b + 6 * x)), zero);
+              __m128i sum;
+              gint32  pixel;
+
+              sum = _mm_add_epi16 (_mm_add_epi16 (va, _mm_srli_si128 (va, 6)),
+                                   _mm_add_epi16 (vb, _mm_srli_si128 (vb, 6)));
+              sum = _mm_srli_epi16 (sum, 2);
+
+              pixel = _mm_cvtsi128_si32 (_mm_packus_epi16 (sum, sum));
+              memcpy (dst + 3 * x, &pixel, sizeof (pixel));
+            }
+          break;
+
+        case 4:
+          for (; x + 2 <= dst_width; x += 2)
+            {
+              __m128i va = _mm_loadu_si128 ((__m128i *) (a + 8 * x));
+              __m128i vb = _mm_loadu_si128 ((__m128i *) (b + 8 * x));
+              __m128i al = _mm_unpacklo_epi8 (va, zero);
+              __m128i ah = _mm_unpackhi_epi8 (va, zero);
+              __m128i bl = _mm_unpacklo_epi8 (vb, zero);
+              __m128i bh = _mm_unpackhi_epi8 (vb, zero);
+              __m128i sum;
+
+              sum = _mm_add_epi16 (_mm_add_epi16 (_mm_unpacklo_epi64 (al, ah),
+                                                  _mm_unpackhi_epi64 (al, ah)),
+                                   _mm_add_epi16 (_mm_unpacklo_epi64 (bl, bh),
+                                                  _mm_unpackhi_epi64 (bl, bh)));
+              sum = _mm_srli_epi16 (sum, 2);
+
+              _mm_storel_epi64 ((__m128i *) (dst + 4 * x),
+                                _mm_packus_epi16 (sum, sum));
+            }
+          break;
+        }
+
+      for (; x < dst_width; x++)
+        {
+          for (c = 0; c < components; c++)
+            {
+              dst[x * components + c] = ((guint) a[(2 * x)     * components + c] +
+                                         (guint) a[(2 * x + 1) * components + c] +
+                                         (guint) b[(2 * x)     * components + c] +
+                                         (guint) b[(2 * x + 1) * components + c]) /
+                                        4;
+            }
+        }
+    }
+}
+
+/* half floats are converted to single precision, averaged, and rounded
+ * back to the nearest half.
+ */
+__attribute__ ((target ("avx,f16c")))
+static void
+gegl_downscale_2x2_half_f16c (const Babl *format,
+                              gint        src_width,
+                              gint        src_height,
+                              guchar     *src_data,
+                              gint        src_rowstride,
+                              guchar     *dst_data,
+                              gint        dst_rowstride)
+{
+  const gint   components = babl_format_get_bytes_per_pixel (format) /
+                            sizeof (guint16);
+  const gint   dst_width  = src_width / 2;
+  const __m128 quarter    = _mm_set1_ps (0.25f);
+  gint         y;
+
+#define LOAD_HALF4(p) \
+  _mm_cvtph_ps (_mm_loadl_epi64 ((__m128i *) (p)))
+#define STORE_HALF4(p, v) \
+  _mm_storel_epi64 ((__m128i *) (p), \
+                    _mm_cvtps_ph ((v), _MM_FROUND_TO_NEAREST_INT))
+
+  if (!src_data || !dst_data)
+    return;
+
+  for (y = 0; y < src_height / 2; y++)
+    {
+      const guint16 *a   = (guint16 *) (src_data + src_rowstride * y * 2);
+      const guint16 *b   = (guint16 *) (src_data + src_rowstride * (y * 2 + 1));
+      guint16       *dst = (guint16 *) (dst_data + dst_rowstride * y);
+      gint           x   = 0;
+      gint           c;
+
+      switch (components)
+        {
+        case 1:
+          for (; x + 4 <= dst_width; x += 4)
+            {
+              __m128 a0 = LOAD_HALF4 (a + 2 * x);
+              __m128 a1 = LOAD_HALF4 (a + 2 * x + 4);
+              __m128 b0 = LOAD_HALF4 (b + 2 * x);
+              __m128 b1 = LOAD_HALF4 (b + 2 * x + 4);
+              __m128 sum;
+
+              sum = _mm_add_ps (DOWNSCALE_EVEN_32 (a0, a1),
+                                DOWNSCALE_ODD_32  (a0, a1));
+              sum = _mm_add_ps (sum, DOWNSCALE_EVEN_32 (b0, b1));
+              sum = _mm_add_ps (sum, DOWNSCALE_ODD_32  (b0, b1));
+
+              STORE_HALF4 (dst + x, _mm_mul_ps (sum, quarter));
+            }
+          break;
+
+        case 2:
+          for (; x + 2 <= dst_width; x += 2)
+            {
+              __m128 a0 = LOAD_HALF4 (a + 4 * x);
+              __m128 a1 = LOAD_HALF4 (a + 4 * x + 4);
+              __m128 b0 = LOAD_HALF4 (b + 4 * x);
+              __m128 b1 = LOAD_HALF4 (b + 4 * x + 4);
+              __m128 sum;
+
+              sum = _mm_add_ps (DOWNSCALE_EVEN_64 (a0, a1),
+                                DOWNSCALE_ODD_64  (a0, a1));
+              sum = _mm_add_ps (sum, DOWNSCALE_EVEN_64 (b0, b1));
+              sum = _mm_add_ps (sum, DOWNSCALE_ODD_64  (b0, b1));
+
+              STORE_HALF4 (dst + 2 * x, _mm_mul_ps (sum, quarter));
+            }
+          break;
+
+        case 3:
+          for (; x + 1 < dst_width; x++)
+            {
+              __m128 sum;
+
+              sum = _mm_add_ps (LOAD_HALF4 (a + 6 * x),
+                                LOAD_HALF4 (a + 6 * x + 3));
+              sum = _mm_add_ps (sum, LOAD_HALF4 (b + 6 * x));
+              sum = _mm_add_ps (sum, LOAD_HALF4 (b + 6 * x + 3));
+
+              STORE_HALF4 (dst + 3 * x, _mm_mul_ps (sum, quarter));
+            }
+          break;
+
+        case 4:
+          for (; x < dst_width; x++)
+            {
+              __m128 sum;
+
+              sum = _mm_add_ps (LOAD_HALF4 (a + 8 * x),
+                                LOAD_HALF4 (a + 8 * x + 4));
+              sum = _mm_add_ps (sum, LOAD_HALF4 (b + 8 * x));
+              sum = _mm_add_ps (sum, LOAD_HALF4 (b + 8 * x + 4));
+
+              STORE_HALF4 (dst + 4 * x, _mm_mul_ps (sum, quarter));
+            }
+          break;
+        }
+
+      for (; x < dst_width; x++)
+        {
+          for (c = 0; c < components; c++)
+            {
+              gfloat sum = _cvtsh_ss (a[(2 * x)     * components + c]) +
+                           _cvtsh_ss (a[(2 * x + 1) * components + c]) +
+                           _cvtsh_ss (b[(2 * x)     * components + c]) +
+                           _cvtsh_ss (b[(2 * x + 1) * components + c]);
+
+              dst[x * components + c] = _cvtss_sh (sum * 0.25f,
+                                                   _MM_FROUND_TO_NEAREST_INT);
+            }
+        }
+    }
+
+#undef LOAD_HALF4
+#undef STORE_HALF4
+}
+
+#undef DOWNSCALE_PACK_U32
+#undef DOWNSCALE_EVEN_32
+#undef DOWNSCALE_ODD_32
+#undef DOWNSCALE_EVEN_64
+#undef DOWNSCALE_ODD_64
+
+/* returns a SIMD 2x2 box filter for the linear @format, or NULL if there is
+ * none for its component type and count, or the cpu lacks the instructions.
+ */
+static GeglDownscale2x2Fun
+gegl_downscale_2x2_get_simd_fun (const Babl *format)
+{
+  const Babl        *comp_type  = babl_format_get_type (format, 0);
+  gint               components = babl_format_get_n_components (format);
+  gint               bpp        = babl_format_get_bytes_per_pixel (format);
+  GeglCpuAccelFlags  accel      = gegl_cpu_accel_get_support ();
+
+  if (components > 4)
+    return NULL;
+
+  if (accel & GEGL_CPU_ACCEL_X86_SSE2)
+    {
+      if (comp_type == gegl_babl_float () && bpp == components * 4)
+        return gegl_downscale_2x2_float_sse2;
+      else if (comp_type == gegl_babl_u16 () && bpp == components * 2)
+        return gegl_downscale_2x2_u16_sse2;
+      else if (comp_type == gegl_babl_u8 () && bpp == components)
+        return gegl_downscale_2x2_u8_sse2;
+    }
+
+  if (accel & GEGL_CPU_ACCEL_X86_F16C)
+    {
+      if (comp_type == gegl_babl_half () && bpp == components * 2)
+        return gegl_downscale_2x2_half_f16c;
+    }
+
+  return NULL;
+}
+
+#endif /* DOWNSCALE_SIMD */
+
+
 /* FIXME:  disable the _alpha() variants for now, so that we use the same gamma
  * curve for the alpha component as we do for the color components.  this is
  * necessary to avoid producing over-saturated pixels when using a format with
@@ -941,6 +1515,13 @@ GeglDownscale2x2Fun gegl_downscale_2x2_get_fun (const Babl *format)
   if ((model_flags & BABL_MODEL_FLAG_LINEAR)||
       (model_flags & BABL_MODEL_FLAG_CMYK))
   {
+#ifdef DOWNSCALE_SIMD
+    GeglDownscale2x2Fun simd_fun = gegl_downscale_2x2_get_simd_fun (format);
+
+    if (simd_fun)
+      return simd_fun;
+#endif
+
     if (comp_type == gegl_babl_float())
     {
       return gegl_downscale_2x2_float;
@@ -34,6 +34,7 @@
 #include "gegl-buffer-private.h"
 #include "gegl-tile-storage.h"
 #include "gegl-tile-handler-empty.h"
+#include "gegl-tile-handler-zoom.h"
 #include "gegl-sampler.h"
 #include "gegl-tile-backend.h"
 #include "gegl-buffer-iterator.h"
@@ -1817,6 +1818,52 @@ gegl_buffer_iterate_read_fringed (GeglBuffer          *buffer,
                                    level);
 }
 
+/* when reading a reduced level of an area spanning several tiles, build the
+ * mipmap levels up front, rendering the tiles of each level in parallel,
+ * rather than one by one as they're fetched.
+ */
+static void
+gegl_buffer_build_mipmaps (GeglBuffer          *buffer,
+                           const GeglRectangle *roi,
+                           gint                 level)
+{
+  GeglTileStorage *tile_storage = buffer->tile_storage;
+  GeglTileHandler *zoom;
+  GeglRectangle    rect;
+  gint             tile_width;
+  gint             tile_height;
+
+  if (! gegl_rectangle_intersect (&rect, roi, &buffer->abyss))
+    return;
+
+  rect.x += buffer->shift_x;
+  rect.y += buffer->shift_y;
+
+  /* most of the work is in level 1; a read within a single one of its tiles
+   * has nothing to render in parallel.
+   */
+  tile_width  = tile_storage->tile_width  << 1;
+  tile_height = tile_storage->tile_height << 1;
+
+  if (gegl_tile_indice (rect.x, tile_width) ==
+      gegl_tile_indice (rect.x + rect.width - 1, tile_width) &&
+      gegl_tile_indice (rect.y, tile_height) ==
+      gegl_tile_indice (rect.y + rect.height - 1, tile_height))
+    {
+      return;
+    }
+
+  zoom = gegl_tile_handler_chain_get_first (
+    GEGL_TILE_HANDLER_CHAIN (tile_storage),
+    GEGL_TYPE_TILE_HANDLER_ZOOM);
+
+  if (zoom)
+    {
+      gegl_tile_handler_zoom_build (GEGL_TILE_HANDLER_ZOOM (zoom),
+                                    &rect, level);
+    }
+}
+
 static void
 gegl_buffer_iterate_read_dispatch (GeglBuffer          *buffer,
                                    const GeglRectangle *roi,
@@ -1847,6 +1894,8 @@ gegl_buffer_iterate_read_dispatch (GeglBuffer          *buffer,
       roi_factored.y       = (buffer->shift_y + roi_factored.y) / factor;
       roi_factored.width  /= factor;
       roi_factored.height /= factor;
+
+      gegl_buffer_build_mipmaps (buffer, roi, level);
     }
   else
     {
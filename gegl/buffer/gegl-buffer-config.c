@@ -40,6 +40,9 @@ enum
   PROP_TILE_WIDTH,
   PROP_TILE_HEIGHT,
   PROP_QUEUE_SIZE,
+  PROP_SWAP_PREFETCH,
+  PROP_TILE_CACHE_POLICY,
+  PROP_TILE_ALLOC_NUMA,
 };
 
 static void
@@ -76,6 +79,18 @@ gegl_buffer_config_get_property (GObject    *gobject,
         g_value_set_int (value, config->queue_size);
         break;
 
+      case PROP_SWAP_PREFETCH:
+        g_value_set_int (value, config->swap_prefetch);
+        break;
+
+      case PROP_TILE_CACHE_POLICY:
+        g_value_set_string (value, config->tile_cache_policy);
+        break;
+
+      case PROP_TILE_ALLOC_NUMA:
+        g_value_set_boolean (value, config->tile_alloc_numa);
+        break;
+
       default:
         G_OBJECT_WARN_INVALID_PROPERTY_ID (gobject, property_id, pspec);
         break;
@@ -104,6 +119,9 @@ gegl_buffer_config_set_property (GObject      *gobject,
       case PROP_QUEUE_SIZE:
         config->queue_size = g_value_get_int (value);
         break;
+      case PROP_SWAP_PREFETCH:
+        config->swap_prefetch = g_value_get_int (value);
+        break;
       case PROP_SWAP:
         g_free (config->swap);
         config->swap = g_value_dup_string (value);
@@ -112,6 +130,13 @@ gegl_buffer_config_set_property (GObject      *gobject,
         g_free (config->swap_compression);
         config->swap_compression = g_value_dup_string (value);
         break;
+      case PROP_TILE_CACHE_POLICY:
+        g_free (config->tile_cache_policy);
+        config->tile_cache_policy = g_value_dup_string (value);
+        break;
+      case PROP_TILE_ALLOC_NUMA:
+        config->tile_alloc_numa = g_value_get_boolean (value);
+        break;
       default:
         G_OBJECT_WARN_INVALID_PROPERTY_ID (gobject, property_id, pspec);
         break;
@@ -125,6 +150,7 @@ gegl_buffer_config_finalize (GObject *gobject)
 
   g_free (config->swap);
   g_free (config->swap_compression);
+  g_free (config->tile_cache_policy);
 
   G_OBJECT_CLASS (gegl_buffer_config_parent_class)->finalize (gobject);
 }
@@ -194,6 +220,33 @@ gegl_buffer_config_class_init (GeglBufferConfigClass *klass)
                                                      G_PARAM_READWRITE |
                                                      G_PARAM_CONSTRUCT |
                                                      G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_SWAP_PREFETCH,
+                                   g_param_spec_int ("swap-prefetch",
+                                                     "Swap prefetch",
+                                                     "number of tiles buffer iterators read ahead from the swap, 0 disables prefetching",
+                                                     0, G_MAXINT, 4,
+                                                     G_PARAM_READWRITE |
+                                                     G_PARAM_CONSTRUCT |
+                                                     G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_TILE_CACHE_POLICY,
+                                   g_param_spec_string ("tile-cache-policy",
+                                                        "Tile cache policy",
+                                                        "eviction policy of the tile cache: lru, arc or clock-pro",
+                                                        "lru",
+                                                        G_PARAM_READWRITE |
+                                                        G_PARAM_CONSTRUCT |
+                                                        G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_TILE_ALLOC_NUMA,
+                                   g_param_spec_boolean ("tile-alloc-numa",
+                                                         "Tile alloc NUMA",
+                                                         "allocate tile data on the NUMA node of the allocating thread, through per-thread caches",
+                                                         FALSE,
+                                                         G_PARAM_READWRITE |
+                                                         G_PARAM_CONSTRUCT |
+                                                         G_PARAM_STATIC_STRINGS));
 }
 
 static void
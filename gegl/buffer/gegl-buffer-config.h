@@ -49,6 +49,9 @@ struct _GeglBufferConfig
   gint     tile_width;
   gint     tile_height;
   gint     queue_size;
+  gint     swap_prefetch;
+  gchar   *tile_cache_policy;
+  gboolean tile_alloc_numa;
 };
 
 struct _GeglBufferConfigClass
@@ -10,6 +10,10 @@ GeglBuffer on disk representation
 
 /* Increase this number when the structures change.*/
 #define GEGL_FILE_SPEC_REV     0
+/* the revision written by gegl_buffer_save (), where the tiles are stored
+ * compressed, in chunks carrying their own piece of the index.
+ */
+#define GEGL_FILE_SPEC_REV_CHUNKED 1
 #define GEGL_MAGIC             {'G','E','G','L'}
 
 #define GEGL_FLAG_TILE         1
@@ -18,6 +22,9 @@ GeglBuffer on disk representation
 /* a VOID message, indicating that the specified tile has been rewritten */
 #define GEGL_FLAG_INVALIDATED  2
 
+/* a GeglBufferChunk, see below */
+#define GEGL_FLAG_CHUNK        4
+
 /* these flags are used for the header, the lower bits of the
  * header store the revision
  */
@@ -59,7 +66,11 @@ typedef struct {
 
   guint32 rev;             /* if it changes on disk it means the index has changed */
 
-  gint32  padding[36];     /* Pad the structure to be 256 bytes long */
+  gchar   compression[16]; /* the gegl-compression algorithm used for the
+                            * tiles, only for GEGL_FILE_SPEC_REV_CHUNKED.
+                            */
+
+  gint32  padding[32];     /* Pad the structure to be 256 bytes long */
 } GeglBufferHeader;
 
 /* the revision of the format is stored in the flags of the header in the
@@ -99,12 +110,42 @@ typedef struct {
                             own state when revision differs. */
 } GeglBufferTile;
 
+/* In GEGL_FILE_SPEC_REV_CHUNKED files the header is followed by a linked
+ * list of chunks instead.  each chunk covers a square of tiles, and is
+ * immediately followed by an entry per stored tile, and then by the tile
+ * data itself; block.length covers the chunk and its entries, so that the
+ * chunks outside of a region of interest can be skipped by reading nothing
+ * but their first bytes.
+ */
+typedef struct {
+  GeglBufferBlock block;   /* flags is GEGL_FLAG_CHUNK                      */
+  gint32  x;               /* the covered tiles, in tile coordinates        */
+  gint32  y;
+  guint32 width;
+  guint32 height;
+  gint32  z;
+  guint32 n_tiles;         /* number of entries following the chunk         */
+  guint64 data_offset;     /* offset into file of the data of the tiles     */
+  guint64 data_length;
+} GeglBufferChunk;
+
+typedef struct {
+  gint32  x;               /* tile coordinates                              */
+  gint32  y;
+  guint32 offset;          /* offset of the tile data from data_offset      */
+  guint32 length;          /* compressed length of the tile data, tiles
+                            * that did not compress are stored as is, with
+                            * length being the size of a tile.
+                            */
+} GeglBufferChunkTile;
+
 /* A convenience union to allow quick and simple casting */
 typedef union {
   guint32          length;
   GeglBufferBlock  block;
   GeglBufferHeader header;
   GeglBufferTile   tile;
+  GeglBufferChunk  chunk;
 } GeglBufferItem;
 
 /* functions to initialize data structures */
@@ -141,7 +182,9 @@ GList          *gegl_buffer_read_index (int      i,
     }
 #define GEGL_BUFFER_STRUCT_CHECK_PADDING \
   {struct_check_padding (GeglBufferBlock, 16);\
-  struct_check_padding (GeglBufferHeader, 256);}
+  struct_check_padding (GeglBufferHeader, 256);\
+  struct_check_padding (GeglBufferChunk, 56);\
+  struct_check_padding (GeglBufferChunkTile, 16);}
 #define GEGL_BUFFER_SANITY {static gboolean done=FALSE;if(!done){GEGL_BUFFER_STRUCT_CHECK_PADDING;done=TRUE;}}
 
 #endif
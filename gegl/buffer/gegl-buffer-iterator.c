@@ -31,7 +31,9 @@
 #include "gegl-buffer-iterator.h"
 #include "gegl-buffer-iterator-private.h"
 #include "gegl-buffer-private.h"
+#include "gegl-buffer-config.h"
 #include "gegl-tile-storage.h"
+#include "gegl-tile-backend-swap.h"
 
 typedef enum {
   GeglIteratorState_Start,
@@ -63,6 +65,7 @@ typedef struct _SubIterState {
   GeglRectangle        real_roi;
   gint                 level;
   gboolean             can_discard_data;
+  gboolean             prefetch;
   /* Direct data members */
   GeglTile            *current_tile;
   /* Indirect data members */
@@ -78,6 +81,9 @@ struct _GeglBufferIteratorPriv
   GeglIteratorState state;
   GeglRectangle     origin_tile;
   gint              remaining_rows;
+  gint              tile_index;
+  gint              n_tiles;
+  gint              n_prefetch_tiles;
   gint              max_slots;
   SubIterState      sub_iter[];
   /* gint           access_order[]; */ /* allocated, but accessed through
@@ -166,6 +172,7 @@ _gegl_buffer_iterator_add (GeglBufferIterator  *iter,
       sub->level            = level;
       sub->can_discard_data = (access_mode & GEGL_ACCESS_READWRITE) ==
                               GEGL_ACCESS_WRITE;
+      sub->prefetch         = FALSE;
       sub->alias            = -1;
 
       if (index > 0)
@@ -462,6 +469,126 @@ needs_rows (GeglBufferIterator *iter,
   return FALSE;
 }
 
+/* Hint the tile sources of the sub-iterators that read from the swap about
+ * the tiles of the index-th iteration rect, so that they can be loaded in the
+ * background while the current rect is being processed.
+ */
+static void
+prefetch_rects (GeglBufferIterator *iter,
+                gint                index)
+{
+  GeglBufferIteratorPriv *priv     = iter->priv;
+  SubIterState           *lead_sub = &priv->sub_iter[0];
+  GeglRectangle           rect;
+  gint                    n_tiles_x;
+  gint                    tile_x;
+  gint                    tile_y;
+  gint                    i;
+
+  n_tiles_x = gegl_tile_indice (lead_sub->full_rect.x + lead_sub->full_rect.width - 1 +
+                                priv->origin_tile.x,
+                                priv->origin_tile.width) -
+              gegl_tile_indice (lead_sub->full_rect.x + priv->origin_tile.x,
+                                priv->origin_tile.width) + 1;
+
+  tile_x = gegl_tile_indice (lead_sub->full_rect.x + priv->origin_tile.x,
+                             priv->origin_tile.width)  + index % n_tiles_x;
+  tile_y = gegl_tile_indice (lead_sub->full_rect.y + priv->origin_tile.y,
+                             priv->origin_tile.height) + index / n_tiles_x;
+
+  rect.x      = tile_x * priv->origin_tile.width  - priv->origin_tile.x;
+  rect.y      = tile_y * priv->origin_tile.height - priv->origin_tile.y;
+  rect.width  = priv->origin_tile.width;
+  rect.height = priv->origin_tile.height;
+
+  gegl_rectangle_intersect (&rect, &rect, &lead_sub->full_rect);
+
+  for (i = 0; i < priv->num_buffers; i++)
+    {
+      SubIterState  *sub = &priv->sub_iter[i];
+      GeglBuffer    *buf = sub->buffer;
+      GeglRectangle  sub_rect;
+      gint           x0, x1;
+      gint           y0, y1;
+      gint           x, y;
+
+      if (! sub->prefetch)
+        continue;
+
+      sub_rect    = rect;
+      sub_rect.x += sub->full_rect.x - lead_sub->full_rect.x;
+      sub_rect.y += sub->full_rect.y - lead_sub->full_rect.y;
+
+      if (! gegl_rectangle_intersect (&sub_rect, &sub_rect, &buf->abyss))
+        continue;
+
+      x0 = gegl_tile_indice (sub_rect.x + buf->shift_x, buf->tile_width);
+      x1 = gegl_tile_indice (sub_rect.x + sub_rect.width - 1 + buf->shift_x,
+                             buf->tile_width);
+      y0 = gegl_tile_indice (sub_rect.y + buf->shift_y, buf->tile_height);
+      y1 = gegl_tile_indice (sub_rect.y + sub_rect.height - 1 + buf->shift_y,
+                             buf->tile_height);
+
+      g_rec_mutex_lock (&buf->tile_storage->mutex);
+
+      for (y = y0; y <= y1; y++)
+        for (x = x0; x <= x1; x++)
+          gegl_tile_source_prefetch (GEGL_TILE_SOURCE (buf), x, y, sub->level);
+
+      g_rec_mutex_unlock (&buf->tile_storage->mutex);
+    }
+}
+
+static void
+prepare_prefetch (GeglBufferIterator *iter)
+{
+  GeglBufferIteratorPriv *priv     = iter->priv;
+  SubIterState           *lead_sub = &priv->sub_iter[0];
+  gint                    n_prefetch_tiles;
+  gint                    i;
+
+  priv->tile_index       = 0;
+  priv->n_prefetch_tiles = 0;
+
+  n_prefetch_tiles = gegl_buffer_config ()->swap_prefetch;
+
+  if (n_prefetch_tiles <= 0)
+    return;
+
+  for (i = 0; i < priv->num_buffers; i++)
+    {
+      SubIterState *sub = &priv->sub_iter[i];
+
+      sub->prefetch = sub->alias < 0                            &&
+                      (sub->access_mode & GEGL_ACCESS_READ)     &&
+                      ! sub->linear_tile                        &&
+                      GEGL_IS_TILE_BACKEND_SWAP (
+                        gegl_buffer_backend (sub->buffer));
+
+      if (sub->prefetch)
+        priv->n_prefetch_tiles = n_prefetch_tiles;
+    }
+
+  if (! priv->n_prefetch_tiles)
+    return;
+
+  priv->n_tiles =
+    (gegl_tile_indice (lead_sub->full_rect.x + lead_sub->full_rect.width - 1 +
+                       priv->origin_tile.x,
+                       priv->origin_tile.width) -
+     gegl_tile_indice (lead_sub->full_rect.x + priv->origin_tile.x,
+                       priv->origin_tile.width) + 1) *
+    (gegl_tile_indice (lead_sub->full_rect.y + lead_sub->full_rect.height - 1 +
+                       priv->origin_tile.y,
+                       priv->origin_tile.height) -
+     gegl_tile_indice (lead_sub->full_rect.y + priv->origin_tile.y,
+                       priv->origin_tile.height) + 1);
+
+  /* the first rect is fetched right away */
+  for (i = 1; i <= priv->n_prefetch_tiles && i < priv->n_tiles; i++)
+    prefetch_rects (iter, i);
+}
+
 /* Do the final setup of the iter struct */
 static inline void
 prepare_iteration (GeglBufferIterator *iter)
@@ -821,6 +948,8 @@ gegl_buffer_iterator_next (GeglBufferIterator *iter)
 
       initialize_rects (iter);
 
+      prepare_prefetch (iter);
+
       load_rects (iter);
 
       return TRUE;
@@ -861,6 +990,14 @@ gegl_buffer_iterator_next (GeglBufferIterator *iter)
           return FALSE;
         }
 
+      if (priv->n_prefetch_tiles)
+        {
+          gint index = ++priv->tile_index + priv->n_prefetch_tiles;
+
+          if (index < priv->n_tiles)
+            prefetch_rects (iter, index);
+        }
+
       load_rects (iter);
 
       return TRUE;
@@ -12,6 +12,7 @@
 #include "gegl-buffer-private.h"
 #include "gegl-tile-storage.h"
 #include "gegl-tile-handler-cache.h"
+#include "gegl-tile-handler.h"
 
 GeglBuffer *
 gegl_buffer_linear_new (const GeglRectangle *extent,
@@ -148,31 +149,49 @@ gegl_buffer_linear_open (GeglBuffer          *buffer,
 
   /*gegl_buffer_lock (buffer);*/
   g_rec_mutex_lock (&buffer->tile_storage->mutex);
-  if (extent->x     == buffer->extent.x &&
-      extent->y     == buffer->extent.y &&
-      extent->width == buffer->tile_width &&
-      extent->height <= buffer->tile_height &&
-      buffer->soft_format == format)
+  /* the extent can be accessed in place if it falls within a single tile;
+   * when the caller doesn't ask for the rowstride it has to be that of the
+   * extent, meaning that the extent must span the width of the tile.
+   * only one extent is accessed in place at a time, others are copied.
+   */
+  if (buffer->soft_format == format &&
+      ! g_object_get_data (G_OBJECT (buffer), "linear-tile"))
     {
-      GeglTile *tile;
+      gint tile_width  = buffer->tile_width;
+      gint tile_height = buffer->tile_height;
+      gint tile_x      = gegl_tile_indice (extent->x + buffer->shift_x,
+                                           tile_width);
+      gint tile_y      = gegl_tile_indice (extent->y + buffer->shift_y,
+                                           tile_height);
+      gint offset_x    = extent->x + buffer->shift_x - tile_x * tile_width;
+      gint offset_y    = extent->y + buffer->shift_y - tile_y * tile_height;
+
+      if (offset_x + extent->width  <= tile_width  &&
+          offset_y + extent->height <= tile_height &&
+          (rowstride || (offset_x == 0 && extent->width == tile_width)))
+        {
+          GeglTile *tile;
+          gpointer  data;
+          gint      bpp = babl_format_get_bytes_per_pixel (format);
+
+          g_assert (buffer->tile_width <= buffer->tile_storage->tile_width);
+          g_assert (buffer->tile_height == buffer->tile_storage->tile_height);
 
-      g_assert (buffer->tile_width <= buffer->tile_storage->tile_width);
-      g_assert (buffer->tile_height == buffer->tile_storage->tile_height);
+          tile = gegl_tile_source_get_tile ((GeglTileSource*) (buffer),
+                                            tile_x, tile_y, 0);
+          g_assert (tile);
+          gegl_tile_lock (tile);
 
-      tile = g_object_get_data (G_OBJECT (buffer), "linear-tile");
-      g_assert (tile == NULL); /* We need to reference count returned direct
-                                * linear buffers to allow multiple open like
-                                * the copying case.
-                                */
-      tile = gegl_tile_source_get_tile ((GeglTileSource*) (buffer),
-                                        0,0,0);
-      g_assert (tile);
-      gegl_tile_lock (tile);
+          data = gegl_tile_get_data (tile) +
+                 (offset_y * buffer->tile_storage->tile_width +
+                  offset_x) * bpp;
 
-      g_object_set_data (G_OBJECT (buffer), "linear-tile", tile);
+          g_object_set_data (G_OBJECT (buffer), "linear-tile", tile);
+          g_object_set_data (G_OBJECT (buffer), "linear-tile-data", data);
 
-      if(rowstride)*rowstride = buffer->tile_storage->tile_width * babl_format_get_bytes_per_pixel (format);
-      return (gpointer)gegl_tile_get_data (tile);
+          if(rowstride)*rowstride = buffer->tile_storage->tile_width * bpp;
+          return data;
+        }
     }
   /* first check if there is a linear buffer, share the existing buffer if one
    * exists.
@@ -227,11 +246,13 @@ gegl_buffer_linear_close (GeglBuffer *buffer,
 {
   GeglTile *tile;
   tile = g_object_get_data (G_OBJECT (buffer), "linear-tile");
-  if (tile)
+  if (tile &&
+      linear == g_object_get_data (G_OBJECT (buffer), "linear-tile-data"))
     {
       gegl_tile_unlock (tile);
       gegl_tile_unref (tile);
       g_object_set_data (G_OBJECT (buffer), "linear-tile", NULL);
+      g_object_set_data (G_OBJECT (buffer), "linear-tile-data", NULL);
     }
   else
     {
@@ -274,3 +295,207 @@ gegl_buffer_linear_close (GeglBuffer *buffer,
   g_rec_mutex_unlock (&buffer->tile_storage->mutex);
   return;
 }
+
+struct _GeglBufferView
+{
+  GeglBuffer         *buffer;
+  GeglRectangle       extent;
+  const Babl         *format;
+  GeglAccessMode      access_mode;
+
+  GeglBufferViewTile *tiles;
+  GeglTile          **direct_tiles; /* NULL for a converted copy */
+  gint                n_tiles;
+};
+
+GeglBufferView *
+gegl_buffer_view_open (GeglBuffer          *buffer,
+                       const GeglRectangle *extent,
+                       const Babl          *format,
+                       GeglAccessMode       access_mode)
+{
+  GeglBufferView *view;
+  gint            bpp;
+
+  g_return_val_if_fail (GEGL_IS_BUFFER (buffer), NULL);
+
+  if (! format)
+    format = gegl_buffer_get_format (buffer);
+
+  if (! extent)
+    extent = &buffer->extent;
+
+  view = g_slice_new0 (GeglBufferView);
+
+  view->buffer      = g_object_ref (buffer);
+  view->extent      = *extent;
+  view->format      = format;
+  view->access_mode = access_mode;
+
+  bpp = babl_format_get_bytes_per_pixel (format);
+
+  if (gegl_rectangle_is_empty (extent))
+    return view;
+
+  if (format == gegl_buffer_get_format (buffer))
+    {
+      gint tile_width  = buffer->tile_width;
+      gint tile_height = buffer->tile_height;
+      gint x1 = gegl_tile_indice (extent->x + buffer->shift_x, tile_width);
+      gint y1 = gegl_tile_indice (extent->y + buffer->shift_y, tile_height);
+      gint x2 = gegl_tile_indice (extent->x + extent->width - 1 +
+                                  buffer->shift_x, tile_width);
+      gint y2 = gegl_tile_indice (extent->y + extent->height - 1 +
+                                  buffer->shift_y, tile_height);
+      gint x;
+      gint y;
+
+      view->n_tiles      = (x2 - x1 + 1) * (y2 - y1 + 1);
+      view->tiles        = g_new (GeglBufferViewTile, view->n_tiles);
+      view->direct_tiles = g_new (GeglTile *, view->n_tiles);
+
+      gegl_buffer_lock (buffer);
+
+      for (y = y1; y <= y2; y++)
+        {
+          for (x = x1; x <= x2; x++)
+            {
+              gint                i    = (y - y1) * (x2 - x1 + 1) + x - x1;
+              GeglBufferViewTile *tile = &view->tiles[i];
+              GeglRectangle       tile_rect;
+              gint                offset_x;
+              gint                offset_y;
+
+              tile_rect.x      = x * tile_width  - buffer->shift_x;
+              tile_rect.y      = y * tile_height - buffer->shift_y;
+              tile_rect.width  = tile_width;
+              tile_rect.height = tile_height;
+
+              gegl_rectangle_intersect (&tile->rect, &tile_rect, extent);
+
+              g_rec_mutex_lock (&buffer->tile_storage->mutex);
+
+              view->direct_tiles[i] = gegl_tile_handler_get_tile (
+                (GeglTileHandler *) buffer,
+                x, y, 0,
+                (access_mode & GEGL_ACCESS_READ) ||
+                ! gegl_rectangle_equal (&tile->rect, &tile_rect));
+
+              g_rec_mutex_unlock (&buffer->tile_storage->mutex);
+
+              if (access_mode & GEGL_ACCESS_WRITE)
+                gegl_tile_lock (view->direct_tiles[i]);
+              else
+                gegl_tile_read_lock (view->direct_tiles[i]);
+
+              offset_x = tile->rect.x - tile_rect.x;
+              offset_y = tile->rect.y - tile_rect.y;
+
+              tile->rowstride = buffer->tile_storage->tile_width * bpp;
+              tile->data      = gegl_tile_get_data (view->direct_tiles[i]) +
+                                offset_y * tile->rowstride +
+                                offset_x * bpp;
+            }
+        }
+    }
+  else
+    {
+      GeglBufferViewTile *tile;
+
+      view->n_tiles = 1;
+      view->tiles   = tile = g_new (GeglBufferViewTile, 1);
+
+      tile->rect      = *extent;
+      tile->rowstride = extent->width * bpp;
+      tile->data      = gegl_malloc ((gsize) tile->rowstride * extent->height);
+
+      if (access_mode & GEGL_ACCESS_READ)
+        {
+          gegl_buffer_get (buffer, extent, 1.0, format,
+                           tile->data, tile->rowstride, GEGL_ABYSS_NONE);
+        }
+    }
+
+  return view;
+}
+
+const GeglBufferViewTile *
+gegl_buffer_view_get_tiles (GeglBufferView *view,
+                            gint           *n_tiles)
+{
+  g_return_val_if_fail (view != NULL, NULL);
+
+  if (n_tiles)
+    *n_tiles = view->n_tiles;
+
+  return view->tiles;
+}
+
+gboolean
+gegl_buffer_view_is_direct (GeglBufferView *view)
+{
+  g_return_val_if_fail (view != NULL, FALSE);
+
+  return view->direct_tiles != NULL || view->n_tiles == 0;
+}
+
+void
+gegl_buffer_view_close (GeglBufferView *view)
+{
+  GeglBuffer *buffer;
+
+  g_return_if_fail (view != NULL);
+
+  buffer = view->buffer;
+
+  if (view->direct_tiles)
+    {
+      gint i;
+
+      for (i = 0; i < view->n_tiles; i++)
+        {
+          if (view->access_mode & GEGL_ACCESS_WRITE)
+            gegl_tile_unlock_no_void (view->direct_tiles[i]);
+          else
+            gegl_tile_read_unlock (view->direct_tiles[i]);
+
+          gegl_tile_unref (view->direct_tiles[i]);
+        }
+
+      if (view->access_mode & GEGL_ACCESS_WRITE)
+        {
+          GeglRectangle damage_rect;
+
+          damage_rect.x      = view->extent.x + buffer->shift_x;
+          damage_rect.y      = view->extent.y + buffer->shift_y;
+          damage_rect.width  = view->extent.width;
+          damage_rect.height = view->extent.height;
+
+          gegl_tile_handler_damage_rect (
+            GEGL_TILE_HANDLER (buffer->tile_storage),
+            &damage_rect);
+        }
+
+      gegl_buffer_unlock (buffer);
+
+      if (view->access_mode & GEGL_ACCESS_WRITE)
+        gegl_buffer_emit_changed_signal (buffer, &view->extent);
+
+      g_free (view->direct_tiles);
+    }
+  else if (view->n_tiles)
+    {
+      if (view->access_mode & GEGL_ACCESS_WRITE)
+        {
+          gegl_buffer_set (buffer, &view->extent, 0, view->format,
+                           view->tiles[0].data, view->tiles[0].rowstride);
+        }
+
+      gegl_free (view->tiles[0].data);
+    }
+
+  g_free (view->tiles);
+  g_object_unref (buffer);
+
+  g_slice_free (GeglBufferView, view);
+}
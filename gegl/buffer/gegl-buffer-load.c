@@ -29,7 +29,10 @@
 #include "gegl-buffer.h"
 #include "gegl-buffer-private.h"
 #include "gegl-buffer-index.h"
+#include "gegl-tile.h"
+#include "gegl-compression.h"
 #include "gegl-debug.h"
+#include "gegl-parallel.h"
 
 #include <glib/gprintf.h>
 #include <glib/gstdio.h>
@@ -40,6 +43,8 @@
 #define BINARY_FLAG 0
 #endif
 
+#define DECOMPRESS_THREAD_COST 1.0
+
 typedef struct
 {
   GeglBufferHeader header;
@@ -53,10 +58,19 @@ typedef struct
   gboolean         got_header;
 } LoadInfo;
 
-static void seekto(LoadInfo *info, gint offset)
+typedef struct
+{
+  LoadInfo              *info;
+  const GeglCompression *compression;
+  GeglTile             **tiles;
+  GeglBufferChunkTile  **entries;
+  guchar                *data;
+} LoadChunk;
+
+static void seekto(LoadInfo *info, goffset offset)
 {
   info->offset = offset;
-  GEGL_NOTE (GEGL_DEBUG_BUFFER_LOAD, "seek to %i", offset);
+  GEGL_NOTE (GEGL_DEBUG_BUFFER_LOAD, "seek to %i", (gint) offset);
   if(lseek (info->i, info->offset, SEEK_SET) == -1)
     {
       g_warning ("failed seeking");
@@ -155,6 +169,9 @@ static GeglBufferItem *read_block (int           fd,
         case GEGL_FLAG_FREE_TILE:
           own_size = sizeof (GeglBufferTile);
           break;
+        case GEGL_FLAG_CHUNK:
+          own_size = sizeof (GeglBufferChunk);
+          break;
         default:
           g_warning ("skipping unknown type of entry flags=%i", block.flags);
           break;
@@ -228,14 +245,266 @@ gegl_buffer_read_index (int           i,
 }
 
 
+static gboolean
+load_read (LoadInfo *info,
+           gpointer  data,
+           gsize     size)
+{
+  ssize_t sz_read = read (info->i, data, size);
+
+  if (sz_read == -1)
+    return FALSE;
+
+  info->offset += sz_read;
+
+  return sz_read == size;
+}
+
+static gboolean
+tile_in_roi (LoadInfo            *info,
+             gint                 x,
+             gint                 y,
+             gint                 width,
+             gint                 height,
+             const GeglRectangle *roi)
+{
+  GeglRectangle rect;
+
+  if (! roi)
+    return TRUE;
+
+  rect.x      = x * info->header.tile_width;
+  rect.y      = y * info->header.tile_height;
+  rect.width  = width * info->header.tile_width;
+  rect.height = height * info->header.tile_height;
+
+  return gegl_rectangle_intersect (NULL, &rect, roi);
+}
+
+static void
+load_chunk_decompress (gsize      offset,
+                       gsize      size,
+                       LoadChunk *chunk)
+{
+  LoadInfo *info = chunk->info;
+  gint      bpp  = info->header.bytes_per_pixel;
+  gsize     i;
+
+  for (i = offset; i < offset + size; i++)
+    {
+      const GeglBufferChunkTile *entry = chunk->entries[i];
+      guchar                    *data  = gegl_tile_get_data (chunk->tiles[i]);
+
+      if (entry->length == info->tile_size)
+        {
+          memcpy (data, chunk->data + entry->offset, info->tile_size);
+        }
+      else if (! chunk->compression ||
+               ! gegl_compression_decompress (chunk->compression,
+                                              info->format,
+                                              data,
+                                              info->tile_size / bpp,
+                                              chunk->data + entry->offset,
+                                              entry->length))
+        {
+          g_warning ("%s: failed to decompress tile %d, %d of '%s'",
+                     G_STRFUNC, entry->x, entry->y, info->path);
+
+          memset (data, 0, info->tile_size);
+        }
+    }
+}
+
+/* loads the tiles of the chunks intersecting @roi, the other chunks are
+ * skipped having only read their first bytes.
+ */
+static void
+load_chunks (LoadInfo            *info,
+             GeglBuffer          *buffer,
+             const GeglRectangle *roi)
+{
+  const GeglCompression *compression = NULL;
+  gchar                  name[sizeof (info->header.compression) + 1] = "";
+  goffset                next        = info->header.next;
+  gint                   n_tiles     = 0;
+
+  memcpy (name, info->header.compression, sizeof (info->header.compression));
+
+  if (name[0])
+    {
+      compression = gegl_compression (name);
+
+      if (! compression)
+        g_warning ("%s: unknown compression '%s' in '%s'",
+                   G_STRFUNC, name, info->path);
+    }
+
+  while (next)
+    {
+      GeglBufferChunk       chunk;
+      GeglBufferChunkTile  *entries;
+      GeglBufferChunkTile **loaded_entries;
+      GeglTile            **tiles;
+      LoadChunk             data;
+      goffset               chunk_offset = next;
+      gint                  n_loaded     = 0;
+      gboolean              truncated;
+      guint                 i;
+
+      seekto (info, chunk_offset);
+
+      if (! load_read (info, &chunk, sizeof (GeglBufferChunk)))
+        {
+          g_warning ("%s: '%s' is truncated", G_STRFUNC, info->path);
+          break;
+        }
+
+      GEGL_NOTE (GEGL_DEBUG_BUFFER_LOAD,
+                 "read chunk: %i,%i %ix%i tiles:%i next:%i",
+                 chunk.x, chunk.y, chunk.width, chunk.height,
+                 chunk.n_tiles, (guint) chunk.block.next);
+
+      if (chunk.block.flags != GEGL_FLAG_CHUNK ||
+          chunk.block.length < sizeof (GeglBufferChunk) +
+                               chunk.n_tiles * sizeof (GeglBufferChunkTile))
+        {
+          g_warning ("%s: unexpected block of flags:%i in '%s'",
+                     G_STRFUNC, chunk.block.flags, info->path);
+          break;
+        }
+
+      next = chunk.block.next;
+
+      if (chunk.z != 0 ||
+          ! tile_in_roi (info,
+                         chunk.x, chunk.y, chunk.width, chunk.height,
+                         roi))
+        {
+          continue;
+        }
+
+      /* later revisions might extend the chunk, the entries are at its
+       * end.
+       */
+      seekto (info, chunk_offset + chunk.block.length -
+                    chunk.n_tiles * sizeof (GeglBufferChunkTile));
+
+      entries        = g_new (GeglBufferChunkTile, chunk.n_tiles);
+      loaded_entries = g_new (GeglBufferChunkTile *, chunk.n_tiles);
+      tiles          = g_new (GeglTile *, chunk.n_tiles);
+      data.data      = g_malloc (chunk.data_length);
+
+      truncated = ! load_read (info, entries,
+                               chunk.n_tiles * sizeof (GeglBufferChunkTile));
+
+      if (! truncated)
+        {
+          seekto (info, chunk.data_offset);
+
+          truncated = ! load_read (info, data.data, chunk.data_length);
+        }
+
+      if (truncated)
+        {
+          g_warning ("%s: '%s' is truncated", G_STRFUNC, info->path);
+          next = 0;
+        }
+      else
+        {
+          for (i = 0; i < chunk.n_tiles; i++)
+            {
+              GeglBufferChunkTile *entry = &entries[i];
+
+              if (! tile_in_roi (info, entry->x, entry->y, 1, 1, roi))
+                continue;
+
+              if ((guint64) entry->offset + entry->length >
+                    chunk.data_length ||
+                  entry->length > info->tile_size)
+                {
+                  g_warning ("%s: invalid tile %d, %d in '%s'",
+                             G_STRFUNC, entry->x, entry->y, info->path);
+                  continue;
+                }
+
+              tiles[n_loaded] = gegl_tile_source_get_tile (
+                GEGL_TILE_SOURCE (buffer), entry->x, entry->y, 0);
+              g_assert (tiles[n_loaded]);
+
+              gegl_tile_lock (tiles[n_loaded]);
+
+              loaded_entries[n_loaded++] = entry;
+            }
+
+          data.info        = info;
+          data.compression = compression;
+          data.tiles       = tiles;
+          data.entries     = loaded_entries;
+
+          gegl_parallel_distribute_range (
+            n_loaded, DECOMPRESS_THREAD_COST,
+            (GeglParallelDistributeRangeFunc) load_chunk_decompress,
+            &data);
+
+          for (i = 0; i < n_loaded; i++)
+            {
+              gegl_tile_unlock (tiles[i]);
+              gegl_tile_unref (tiles[i]);
+            }
+
+          n_tiles += n_loaded;
+        }
+
+      g_free (data.data);
+      g_free (tiles);
+      g_free (loaded_entries);
+      g_free (entries);
+    }
+
+  GEGL_NOTE (GEGL_DEBUG_BUFFER_LOAD, "%i tiles loaded", n_tiles);
+}
+
 static void sanity(void) { GEGL_BUFFER_SANITY; }
 
 
+static gboolean
+is_chunked (const gchar *path)
+{
+  GeglBufferHeader header;
+  gboolean         chunked = FALSE;
+  int              i;
+
+  i = g_open (path, O_RDONLY|BINARY_FLAG, 0);
+
+  if (i != -1)
+    {
+      if (read (i, &header, sizeof (header)) == sizeof (header) &&
+          ! memcmp (header.magic, "GEGL", 4))
+        {
+          chunked = gegl_buffer_header_get_rev (&header) ==
+                    GEGL_FILE_SPEC_REV_CHUNKED;
+        }
+
+      close (i);
+    }
+
+  return chunked;
+}
+
 GeglBuffer *
 gegl_buffer_open (const gchar *path)
 {
   sanity();
 
+  /* the tiles of a compressed buffer can't be shared in place */
+  if (is_chunked (path))
+    {
+      g_warning ("%s: '%s' is compressed, and can't be shared; "
+                 "loading a copy of it instead", G_STRFUNC, path);
+
+      return gegl_buffer_load (path);
+    }
+
   return g_object_new (GEGL_TYPE_BUFFER,
                        /* FIXME: Currently the buffer must always have a format specified,
                                  this format will be used if the path did not point to an
@@ -247,6 +516,13 @@ gegl_buffer_open (const gchar *path)
 
 GeglBuffer *
 gegl_buffer_load (const gchar *path)
+{
+  return gegl_buffer_load_roi (path, NULL);
+}
+
+GeglBuffer *
+gegl_buffer_load_roi (const gchar         *path,
+                      const GeglRectangle *roi)
 {
   GeglBuffer *ret;
 
@@ -258,6 +534,7 @@ gegl_buffer_load (const gchar *path)
   if (info->i == -1)
     {
       GEGL_NOTE (GEGL_DEBUG_BUFFER_LOAD, "failed top open %s for reading", path);
+      load_info_destroy (info);
       return NULL;
     }
 
@@ -280,6 +557,8 @@ gegl_buffer_load (const gchar *path)
                       "format", info->format,
                       "tile-width", info->header.tile_width,
                       "tile-height", info->header.tile_height,
+                      "x", info->header.x,
+                      "y", info->header.y,
                       "height", info->header.height,
                       "width", info->header.width,
                       NULL);
@@ -288,6 +567,16 @@ gegl_buffer_load (const gchar *path)
   */
   g_assert (babl_format_get_bytes_per_pixel (info->format) == info->header.bytes_per_pixel);
 
+  if (gegl_buffer_header_get_rev (&info->header) == GEGL_FILE_SPEC_REV_CHUNKED)
+    {
+      load_chunks (info, ret, roi);
+
+      GEGL_NOTE (GEGL_DEBUG_BUFFER_LOAD, "buffer loaded %s", info->path);
+
+      load_info_destroy (info);
+      return ret;
+    }
+
   info->tiles = gegl_buffer_read_index (info->i, &info->offset);
 
   /* load each tile */
@@ -300,6 +589,9 @@ gegl_buffer_load (const gchar *path)
         guchar         *data;
         GeglTile       *tile;
 
+        if (roi && (entry->z != 0 ||
+                    ! tile_in_roi (info, entry->x, entry->y, 1, 1, roi)))
+          continue;
 
         tile = gegl_tile_source_get_tile (GEGL_TILE_SOURCE (ret),
                                           entry->x,
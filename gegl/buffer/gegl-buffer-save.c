@@ -36,6 +36,8 @@
 #include "gegl-tile-storage.h"
 #include "gegl-tile.h"
 #include "gegl-buffer-index.h"
+#include "gegl-compression.h"
+#include "gegl-parallel.h"
 
 #ifdef G_OS_WIN32
 #define BINARY_FLAG O_BINARY
@@ -43,22 +45,49 @@
 #define BINARY_FLAG 0
 #endif
 
+/* chunks span CHUNK_SIZE x CHUNK_SIZE tiles */
+#define CHUNK_SIZE            16
+
+/* the algorithms tried for the tiles of chunked files, in order of
+ * precedence, as for the "fast" alias.  the one used is named in the
+ * header by its own name, so that reading a file doesn't depend on what
+ * the aliases of the reader resolve to.
+ */
+static const gchar *save_compressions[] = { "rle8", "zlib1" };
+
+#define COMPRESSION_MAX_RATIO 0.95
+
+#define COMPRESS_THREAD_COST  1.0
+
 typedef struct
 {
-  GeglBufferHeader header;
-  GList           *tiles;
-  gchar           *path;
-  gint             o;
-
-  gint             tile_size;
-  gint             offset;
-  gint             entry_count;
-  GeglBufferBlock *in_holding; /* we need to write one block added behind
-                                * to be able to recompute the forward pointing
-                                * link from one entry to the next.
-                                */
+  GeglBufferHeader       header;
+  GList                 *tiles;
+  gchar                 *path;
+  gint                   o;
+
+  gint                   entry_count;
+  GeglBufferBlock       *in_holding; /* we need to write one block added behind
+                                      * to be able to recompute the forward pointing
+                                      * link from one entry to the next.
+                                      */
+
+  const Babl            *format;
+  const GeglCompression *compression;
+  gint                   tile_size;
+  gint                   max_compressed_size;
+  goffset                offset;
+  goffset                last_block;
 } SaveInfo;
 
+typedef struct
+{
+  SaveInfo            *info;
+  GeglTile           **tiles;
+  GeglBufferChunkTile *entries;
+  guchar              *compressed;
+} SaveChunk;
+
 
 GeglBufferTile *
 gegl_tile_entry_new (gint x,
@@ -127,7 +156,172 @@ save_info_destroy (SaveInfo *info)
   g_slice_free (SaveInfo, info);
 }
 
+static void
+save_write (SaveInfo      *info,
+            gconstpointer  data,
+            gsize          size)
+{
+  ssize_t ret = write (info->o, data, size);
+
+  if (ret != -1)
+    info->offset += ret;
+}
+
+static void
+save_chunk_compress (gsize      offset,
+                     gsize      size,
+                     SaveChunk *chunk)
+{
+  SaveInfo *info = chunk->info;
+  gint      bpp  = info->header.bytes_per_pixel;
+  gsize     i;
+
+  for (i = offset; i < offset + size; i++)
+    {
+      GeglBufferChunkTile *entry = &chunk->entries[i];
+      gint                 compressed_size;
+
+      if (info->compression &&
+          gegl_compression_compress (info->compression, info->format,
+                                     gegl_tile_get_data (chunk->tiles[i]),
+                                     info->tile_size / bpp,
+                                     chunk->compressed +
+                                     i * info->max_compressed_size,
+                                     &compressed_size,
+                                     info->max_compressed_size))
+        {
+          entry->length = compressed_size;
+        }
+      else
+        {
+          entry->length = info->tile_size;
+        }
+    }
+}
+
+/* terminates the list of blocks, by clearing the next link of the block
+ * written last.
+ */
+static void
+save_terminate (SaveInfo *info)
+{
+  guint64 next = 0;
 
+  if (lseek (info->o,
+             info->last_block + G_STRUCT_OFFSET (GeglBufferBlock, next),
+             SEEK_SET) == -1 ||
+      write (info->o, &next, sizeof (next)) == -1)
+    {
+      g_warning ("%s: failed terminating '%s'", G_STRFUNC, info->path);
+    }
+}
+
+/* writes the chunk of tiles starting at tile @x, @y, unless it is empty.
+ * the chunk is linked to whatever gets written after it.
+ */
+static gboolean
+save_chunk (SaveInfo   *info,
+            GeglBuffer *buffer,
+            gint        x,
+            gint        y,
+            gint        width,
+            gint        height)
+{
+  GeglTile            *tiles[CHUNK_SIZE * CHUNK_SIZE];
+  GeglBufferChunkTile  entries[CHUNK_SIZE * CHUNK_SIZE];
+  GeglBufferChunk      chunk = {{0,}};
+  SaveChunk            data;
+  gint                 n_tiles = 0;
+  guint32              data_length;
+  gint                 tx;
+  gint                 ty;
+  gint                 i;
+
+  for (ty = y; ty < y + height; ty++)
+    for (tx = x; tx < x + width; tx++)
+      {
+        if (gegl_tile_source_exist (GEGL_TILE_SOURCE (buffer), tx, ty, 0))
+          {
+            GeglTile *tile;
+
+            GEGL_NOTE (GEGL_DEBUG_BUFFER_SAVE,
+                       "Found tile to save, tx, ty, z = %d, %d, %d",
+                       tx, ty, 0);
+
+            tile = gegl_tile_source_get_tile (GEGL_TILE_SOURCE (buffer),
+                                              tx, ty, 0);
+            g_assert (tile);
+
+            gegl_tile_read_lock (tile);
+
+            tiles[n_tiles]     = tile;
+            entries[n_tiles].x = tx;
+            entries[n_tiles].y = ty;
+            n_tiles++;
+          }
+      }
+
+  if (n_tiles == 0)
+    return FALSE;
+
+  data.info       = info;
+  data.tiles      = tiles;
+  data.entries    = entries;
+  data.compressed = g_malloc (n_tiles * info->max_compressed_size);
+
+  gegl_parallel_distribute_range (
+    n_tiles, COMPRESS_THREAD_COST,
+    (GeglParallelDistributeRangeFunc) save_chunk_compress,
+    &data);
+
+  data_length = 0;
+
+  for (i = 0; i < n_tiles; i++)
+    {
+      entries[i].offset = data_length;
+      data_length      += entries[i].length;
+    }
+
+  chunk.block.flags  = GEGL_FLAG_CHUNK;
+  chunk.block.length = sizeof (GeglBufferChunk) +
+                       n_tiles * sizeof (GeglBufferChunkTile);
+  chunk.x            = x;
+  chunk.y            = y;
+  chunk.width        = width;
+  chunk.height       = height;
+  chunk.z            = 0;
+  chunk.n_tiles      = n_tiles;
+  chunk.data_offset  = info->offset + chunk.block.length;
+  chunk.data_length  = data_length;
+  chunk.block.next   = chunk.data_offset + chunk.data_length;
+
+  info->last_block = info->offset;
+
+  save_write (info, &chunk, sizeof (GeglBufferChunk));
+  save_write (info, entries, n_tiles * sizeof (GeglBufferChunkTile));
+
+  g_assert (info->offset == chunk.data_offset);
+
+  for (i = 0; i < n_tiles; i++)
+    {
+      if (entries[i].length == info->tile_size)
+        {
+          save_write (info, gegl_tile_get_data (tiles[i]), info->tile_size);
+        }
+      else
+        {
+          save_write (info, data.compressed + i * info->max_compressed_size,
+                      entries[i].length);
+        }
+
+      gegl_tile_read_unlock (tiles[i]);
+      gegl_tile_unref (tiles[i]);
+    }
+
+  g_free (data.compressed);
+
+  return TRUE;
+}
 
 static glong z_order (const GeglBufferTile *entry)
 {
@@ -199,23 +393,18 @@ gegl_buffer_header_init (GeglBufferHeader *header,
   }
 }
 
-void
-gegl_buffer_save (GeglBuffer          *buffer,
-                  const gchar         *path,
-                  const GeglRectangle *roi)
+/* opens @path, and fills the header in for @roi of @buffer */
+static SaveInfo *
+save_info_new (GeglBuffer          *buffer,
+               const gchar         *path,
+               const GeglRectangle *roi)
 {
   SaveInfo *info = g_slice_new0 (SaveInfo);
 
-  glong prediction = 0;
   gint bpp;
   gint tile_width;
   gint tile_height;
 
-  GEGL_BUFFER_SANITY;
-
-  if (! roi)
-    roi = &buffer->extent;
-
   GEGL_NOTE (GEGL_DEBUG_BUFFER_SAVE,
              "starting to save buffer %s, roi: %d,%d %dx%d",
              path, roi->x, roi->y, roi->width, roi->height);
@@ -235,7 +424,11 @@ gegl_buffer_save (GeglBuffer          *buffer,
 
 
   if (info->o == -1)
-    g_warning ("%s: Could not open '%s': %s", G_STRFUNC, info->path, g_strerror(errno));
+    {
+      g_warning ("%s: Could not open '%s': %s", G_STRFUNC, info->path, g_strerror(errno));
+      save_info_destroy (info);
+      return NULL;
+    }
   tile_width  = buffer->tile_storage->tile_width;
   tile_height = buffer->tile_storage->tile_height;
   g_object_get (buffer, "px-size", &bpp, NULL);
@@ -250,11 +443,41 @@ gegl_buffer_save (GeglBuffer          *buffer,
                            bpp,
                            buffer->tile_storage->format
                            );
-  info->header.next = (prediction += sizeof (GeglBufferHeader));
+  info->header.next = sizeof (GeglBufferHeader);
+
+  info->format    = buffer->tile_storage->format;
   info->tile_size = tile_width * tile_height * bpp;
 
   g_assert (info->tile_size % 16 == 0);
 
+  return info;
+}
+
+void
+gegl_buffer_save (GeglBuffer          *buffer,
+                  const gchar         *path,
+                  const GeglRectangle *roi)
+{
+  SaveInfo *info;
+
+  glong prediction = 0;
+  gint tile_width;
+  gint tile_height;
+
+  GEGL_BUFFER_SANITY;
+
+  if (! roi)
+    roi = &buffer->extent;
+
+  info = save_info_new (buffer, path, roi);
+  if (! info)
+    return;
+
+  tile_width  = info->header.tile_width;
+  tile_height = info->header.tile_height;
+
+  prediction += sizeof (GeglBufferHeader);
+
   GEGL_NOTE (GEGL_DEBUG_BUFFER_SAVE,
              "collecting list of tiles to be written");
   {
@@ -266,13 +489,13 @@ gegl_buffer_save (GeglBuffer          *buffer,
         gint bufy = roi->y;
         while (bufy < roi->y + roi->height)
           {
-            gint tiledy  = roi->y + bufy;
+            gint tiledy  = bufy;
             gint offsety = gegl_tile_offset (tiledy, tile_height);
             gint bufx    = roi->x;
 
             while (bufx < roi->x + roi->width)
               {
-                gint tiledx  = roi->x + bufx;
+                gint tiledx  = bufx;
                 gint offsetx = gegl_tile_offset (tiledx, tile_width);
 
                 gint tx = gegl_tile_indice (tiledx / factor, tile_width);
@@ -372,5 +595,91 @@ gegl_buffer_save (GeglBuffer          *buffer,
         i++;
       }
   }
+  GEGL_NOTE (GEGL_DEBUG_BUFFER_SAVE, "buffer saved %s", info->path);
+
+  save_info_destroy (info);
+}
+
+void
+gegl_buffer_save_chunked (GeglBuffer          *buffer,
+                          const gchar         *path,
+                          const GeglRectangle *roi)
+{
+  SaveInfo *info;
+
+  gint tile_width;
+  gint tile_height;
+  guint i;
+
+  GEGL_BUFFER_SANITY;
+
+  if (! roi)
+    roi = &buffer->extent;
+
+  info = save_info_new (buffer, path, roi);
+  if (! info)
+    return;
+
+  tile_width  = info->header.tile_width;
+  tile_height = info->header.tile_height;
+
+  info->header.flags = (info->header.flags & ~0xff) |
+                       GEGL_FILE_SPEC_REV_CHUNKED;
+
+  for (i = 0; i < G_N_ELEMENTS (save_compressions) && ! info->compression; i++)
+    {
+      info->compression = gegl_compression (save_compressions[i]);
+
+      if (info->compression)
+        {
+          g_strlcpy (info->header.compression, save_compressions[i],
+                     sizeof (info->header.compression));
+        }
+    }
+
+  info->max_compressed_size = info->tile_size * COMPRESSION_MAX_RATIO;
+
+  /* save the header, the chunks follow it directly */
+  save_write (info, &info->header, sizeof (GeglBufferHeader));
+  g_assert (info->offset == info->header.next);
+
+  info->last_block = 0;
+
+  /* save the tiles, a chunk at a time; the chunks are aligned to a grid,
+   * so that the chunk holding a given tile is the same from one saved
+   * roi to another.
+   */
+  if (! gegl_rectangle_is_empty (roi))
+    {
+      gint x1 = gegl_tile_indice (roi->x, tile_width);
+      gint y1 = gegl_tile_indice (roi->y, tile_height);
+      gint x2 = gegl_tile_indice (roi->x + roi->width  - 1, tile_width);
+      gint y2 = gegl_tile_indice (roi->y + roi->height - 1, tile_height);
+      gint cx;
+      gint cy;
+
+      for (cy = gegl_tile_indice (y1, CHUNK_SIZE) * CHUNK_SIZE;
+           cy <= y2;
+           cy += CHUNK_SIZE)
+        {
+          for (cx = gegl_tile_indice (x1, CHUNK_SIZE) * CHUNK_SIZE;
+               cx <= x2;
+               cx += CHUNK_SIZE)
+            {
+              gint x = MAX (cx, x1);
+              gint y = MAX (cy, y1);
+
+              save_chunk (info, buffer,
+                          x, y,
+                          MIN (cx + CHUNK_SIZE - 1, x2) - x + 1,
+                          MIN (cy + CHUNK_SIZE - 1, y2) - y + 1);
+            }
+        }
+    }
+
+  save_terminate (info);
+
+  GEGL_NOTE (GEGL_DEBUG_BUFFER_SAVE, "buffer saved %s", info->path);
+
   save_info_destroy (info);
 }
@@ -110,6 +110,10 @@ void           gegl_buffer_remove_handler     (GeglBuffer          *buffer,
  * state so multiple instances of gegl can share the same buffer. Sets on
  * one buffer are reflected in the other.
  *
+ * Files written by gegl_buffer_save_chunked() store their tiles compressed,
+ * and can't be shared; they are loaded as with gegl_buffer_load() instead,
+ * with a warning, and the returned buffer is a private copy.
+ *
  * Returns: (transfer full): a GeglBuffer object.
  */
 GeglBuffer *    gegl_buffer_open              (const gchar         *path);
@@ -127,6 +131,24 @@ void            gegl_buffer_save              (GeglBuffer          *buffer,
                                                const gchar         *path,
                                                const GeglRectangle *roi);
 
+/**
+ * gegl_buffer_save_chunked:
+ * @buffer: (transfer none): a #GeglBuffer.
+ * @path: the path where the gegl buffer will be saved.
+ * @roi: the region of interest to write, or %NULL to write all of it.
+ *
+ * Like gegl_buffer_save(), but the tiles are compressed in parallel, and
+ * stored in chunks that each carry the index of their own tiles, so that a
+ * part of the file can later be read back with gegl_buffer_load_roi().
+ *
+ * This is a newer revision of the file format, which versions of GEGL
+ * before it can't read, and which gegl_buffer_open() can't share: opening
+ * such a file loads a private copy of it.
+ */
+void            gegl_buffer_save_chunked      (GeglBuffer          *buffer,
+                                               const gchar         *path,
+                                               const GeglRectangle *roi);
+
 /**
  * gegl_buffer_load:
  * @path: the path to a gegl buffer on disk.
@@ -139,6 +161,20 @@ void            gegl_buffer_save              (GeglBuffer          *buffer,
  */
 GeglBuffer *     gegl_buffer_load             (const gchar         *path);
 
+/**
+ * gegl_buffer_load_roi:
+ * @path: the path to a gegl buffer on disk.
+ * @roi: the region of interest to load, or %NULL to load all of it.
+ *
+ * Like gegl_buffer_load(), but only loads the tiles intersecting @roi. For
+ * files written by gegl_buffer_save_chunked(), the parts of the file holding other
+ * tiles are not read at all, not even their index.
+ *
+ * Returns: (transfer full): a #GeglBuffer object.
+ */
+GeglBuffer *     gegl_buffer_load_roi         (const gchar         *path,
+                                               const GeglRectangle *roi);
+
 /**
  * gegl_buffer_flush:
  * @buffer: a #GeglBuffer
@@ -515,6 +551,28 @@ typedef void (*GeglSamplerGetFun)  (GeglSampler       *self,
  */
 GeglSamplerGetFun gegl_sampler_get_fun (GeglSampler *sampler);
 
+typedef void (*GeglSamplerGetSpanFun) (GeglSampler       *self,
+                                       gdouble            x,
+                                       gdouble            y,
+                                       gdouble            dx,
+                                       gdouble            dy,
+                                       GeglBufferMatrix2 *scale,
+                                       void              *output,
+                                       gint               n,
+                                       GeglAbyssPolicy    repeat_mode);
+
+/**
+ * gegl_sampler_get_span_fun: (skip)
+ *
+ * Get the raw span sampler function, or NULL if the sampler has none.  A
+ * span function computes @n samples, the first at (@x, @y) and each
+ * following one offset by (@dx, @dy) from the previous one, all sharing
+ * @scale, and stores them consecutively in @output.  The result is the
+ * same as calling the raw sampler function on each position in turn,
+ * stepping the coordinates by repeated addition.
+ */
+GeglSamplerGetSpanFun gegl_sampler_get_span_fun (GeglSampler *sampler);
+
 
 /**
  * gegl_buffer_sampler_new: (skip)
@@ -686,6 +744,77 @@ gpointer        gegl_buffer_linear_open       (GeglBuffer          *buffer,
 void            gegl_buffer_linear_close      (GeglBuffer    *buffer,
                                                gpointer       linear);
 
+typedef struct _GeglBufferView GeglBufferView;
+
+/**
+ * GeglBufferViewTile:
+ * @rect: the part of the viewed area covered by this tile.
+ * @data: a pointer to the pixel at the top-left corner of @rect.
+ * @rowstride: the number of bytes between rows of @data.
+ *
+ * A piece of a #GeglBufferView, see gegl_buffer_view_get_tiles().
+ */
+typedef struct
+{
+  GeglRectangle rect;
+  gpointer      data;
+  gint          rowstride;
+} GeglBufferViewTile;
+
+/**
+ * gegl_buffer_view_open: (skip)
+ * @buffer: a #GeglBuffer.
+ * @extent: area to view, pass NULL for the entire buffer.
+ * @format: desired format or NULL to use the buffer's format.
+ * @access_mode: whether the view is read from, written to, or both.
+ *
+ * Provides direct access to an area of a buffer, as a list of strided
+ * pieces of linear memory, one per tile. Unlike gegl_buffer_linear_open(),
+ * no copy is made as long as @format is the format of the buffer, whatever
+ * the size and position of @extent relative to the tiles; code that needs
+ * linear memory can then work on each tile in place, or gather them.
+ *
+ * With a different format, the view consists of a single converted copy of
+ * @extent, which is written back by gegl_buffer_view_close() if
+ * @access_mode includes %GEGL_ACCESS_WRITE.
+ *
+ * Returns: a view, to be closed with gegl_buffer_view_close().
+ */
+GeglBufferView *gegl_buffer_view_open         (GeglBuffer          *buffer,
+                                               const GeglRectangle *extent,
+                                               const Babl          *format,
+                                               GeglAccessMode       access_mode);
+
+/**
+ * gegl_buffer_view_get_tiles: (skip)
+ * @view: a #GeglBufferView.
+ * @n_tiles: (out): return location for the number of tiles.
+ *
+ * Returns: the pieces of the view, in row-major order. Together, their
+ * rectangles exactly cover the viewed area.
+ */
+const GeglBufferViewTile *
+                gegl_buffer_view_get_tiles    (GeglBufferView      *view,
+                                               gint                *n_tiles);
+
+/**
+ * gegl_buffer_view_is_direct: (skip)
+ * @view: a #GeglBufferView.
+ *
+ * Returns: TRUE if the tiles of @view point at the data of the buffer,
+ * FALSE if they point at a copy.
+ */
+gboolean        gegl_buffer_view_is_direct    (GeglBufferView      *view);
+
+/**
+ * gegl_buffer_view_close: (skip)
+ * @view: a #GeglBufferView.
+ *
+ * Releases the tiles of @view, letting the buffer know about the changes
+ * made through it if it was opened for writing.
+ */
+void            gegl_buffer_view_close        (GeglBufferView      *view);
+
 
 /**
  * gegl_buffer_get_abyss:
@@ -0,0 +1,533 @@
+/* This file is part of GEGL
+ *
+ * GEGL is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * GEGL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GEGL; if not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#include "gegl-compression.h"
+#include "gegl-compression-lz.h"
+#include "gegl-scratch.h"
+
+
+/* the compressed stream is a sequence of LZ77 blocks, each consisting of:
+ *
+ *   - a token byte, whose high nibble is the number of literal bytes, and
+ *     whose low nibble is the match length, minus LZ_MIN_MATCH.  a nibble
+ *     value of 15 is followed by additional length bytes, each of which is
+ *     added to the length, until a byte other than 255 is encountered.
+ *
+ *   - the literal bytes.
+ *
+ *   - a 16-bit little-endian match offset, followed by the additional
+ *     match-length bytes, if any.
+ *
+ * the last block only contains literals, and ends the stream.
+ */
+
+
+#define LZ_MIN_MATCH       4
+#define LZ_MAX_OFFSET      65535
+#define LZ_LAST_LITERALS   5
+#define LZ_HASH_BITS      12
+#define LZ_SKIP_SHIFT      6
+
+
+typedef struct
+{
+  GeglCompression compression;
+  gboolean        shuffle;
+} GeglCompressionLz;
+
+
+/*  local function prototypes  */
+
+static gboolean   gegl_compression_lz_compress   (const GeglCompression *compression,
+                                                  const Babl            *format,
+                                                  gconstpointer          data,
+                                                  gint                   n,
+                                                  gpointer               compressed,
+                                                  gint                  *compressed_size,
+                                                  gint                   max_compressed_size);
+static gboolean   gegl_compression_lz_decompress (const GeglCompression *compression,
+                                                  const Babl            *format,
+                                                  gpointer               data,
+                                                  gint                   n,
+                                                  gconstpointer          compressed,
+                                                  gint                   compressed_size);
+
+
+/*  private functions  */
+
+static inline guint32
+gegl_compression_lz_read32 (const guint8 *p)
+{
+  guint32 v;
+
+  memcpy (&v, p, sizeof (v));
+
+  return v;
+}
+
+static inline guint
+gegl_compression_lz_hash (guint32 v)
+{
+  return (v * 2654435761u) >> (32 - LZ_HASH_BITS);
+}
+
+static inline gint
+gegl_compression_lz_length_size (gint length)
+{
+  if (length < 15)
+    return 0;
+  else
+    return (length - 15) / 255 + 1;
+}
+
+static inline guint8 *
+gegl_compression_lz_write_length (guint8 *op,
+                                  gint    length)
+{
+  if (length >= 15)
+    {
+      length -= 15;
+
+      while (length >= 255)
+        {
+          *op++ = 255;
+
+          length -= 255;
+        }
+
+      *op++ = length;
+    }
+
+  return op;
+}
+
+static inline gboolean
+gegl_compression_lz_write_block (guint8       **op_ptr,
+                                 const guint8  *op_end,
+                                 const guint8  *literals,
+                                 gint           n_literals,
+                                 gint           offset,
+                                 gint           match_length)
+{
+  guint8 *op = *op_ptr;
+  gint    size;
+
+  match_length -= LZ_MIN_MATCH;
+
+  size = 1 + gegl_compression_lz_length_size (n_literals) + n_literals;
+
+  if (offset)
+    size += 2 + gegl_compression_lz_length_size (match_length);
+
+  if (size > op_end - op)
+    return FALSE;
+
+  *op++ = (MIN (n_literals, 15) << 4) | (offset ? MIN (match_length, 15) : 0);
+
+  op = gegl_compression_lz_write_length (op, n_literals);
+
+  memcpy (op, literals, n_literals);
+  op += n_literals;
+
+  if (offset)
+    {
+      *op++ = offset & 0xff;
+      *op++ = offset >> 8;
+
+      op = gegl_compression_lz_write_length (op, match_length);
+    }
+
+  *op_ptr = op;
+
+  return TRUE;
+}
+
+static inline gboolean
+gegl_compression_lz_read_length (const guint8 **ip_ptr,
+                                 const guint8  *ip_end,
+                                 gsize         *length)
+{
+  const guint8 *ip = *ip_ptr;
+
+  if (*length == 15)
+    {
+      guint8 v;
+
+      do
+        {
+          if (ip == ip_end)
+            return FALSE;
+
+          v = *ip++;
+
+          *length += v;
+        }
+      while (v == 255);
+    }
+
+  *ip_ptr = ip;
+
+  return TRUE;
+}
+
+static gboolean
+gegl_compression_lz_compress_bytes (const guint8 *data,
+                                    gint          size,
+                                    guint8       *compressed,
+                                    gint         *compressed_size,
+                                    gint          max_compressed_size)
+{
+  guint32       table[1 << LZ_HASH_BITS];
+  const guint8 *ip     = data;
+  const guint8 *anchor = data;
+  const guint8 *limit;
+  guint8       *op     = compressed;
+  const guint8 *op_end = compressed + max_compressed_size;
+
+  if (size >= LZ_MIN_MATCH + LZ_LAST_LITERALS)
+    {
+      limit = data + size - LZ_LAST_LITERALS;
+
+      memset (table, 0, sizeof (table));
+
+      while (ip + LZ_MIN_MATCH <= limit)
+        {
+          guint32       v   = gegl_compression_lz_read32 (ip);
+          guint         h   = gegl_compression_lz_hash (v);
+          const guint8 *ref = data + table[h];
+
+          table[h] = ip - data;
+
+          if (ref < ip                  &&
+              ip - ref <= LZ_MAX_OFFSET &&
+              gegl_compression_lz_read32 (ref) == v)
+            {
+              const guint8 *end = ip  + LZ_MIN_MATCH;
+              const guint8 *r   = ref + LZ_MIN_MATCH;
+
+              while (end < limit && *end == *r)
+                {
+                  end++;
+                  r++;
+                }
+
+              while (ip > anchor && ref > data && ip[-1] == ref[-1])
+                {
+                  ip--;
+                  ref--;
+                }
+
+              if (! gegl_compression_lz_write_block (&op, op_end,
+                                                     anchor, ip - anchor,
+                                                     ip - ref, end - ip))
+                {
+                  return FALSE;
+                }
+
+              /* seed the table with the end of the match, which tends to
+               * be where the next one starts for periodic data.
+               */
+              table[gegl_compression_lz_hash (
+                gegl_compression_lz_read32 (end - 2))] = end - 2 - data;
+
+              ip     = end;
+              anchor = end;
+            }
+          else
+            {
+              /* skip ahead faster the longer we go without a match, so
+               * that incompressible data isn't slower than it has to be.
+               */
+              ip += 1 + ((ip - anchor) >> LZ_SKIP_SHIFT);
+            }
+        }
+    }
+
+  if (! gegl_compression_lz_write_block (&op, op_end,
+                                         anchor, data + size - anchor,
+                                         0, LZ_MIN_MATCH))
+    {
+      return FALSE;
+    }
+
+  *compressed_size = op - compressed;
+
+  return TRUE;
+}
+
+static gboolean
+gegl_compression_lz_decompress_bytes (guint8       *data,
+                                      gint          size,
+                                      const guint8 *compressed,
+                                      gint          compressed_size)
+{
+  const guint8 *ip     = compressed;
+  const guint8 *ip_end = compressed + compressed_size;
+  guint8       *op     = data;
+  guint8       *op_end = data + size;
+
+  while (TRUE)
+    {
+      const guint8 *ref;
+      guint8        token;
+      gsize         length;
+      gsize         offset;
+
+      if (ip == ip_end)
+        return FALSE;
+
+      token = *ip++;
+
+      length = token >> 4;
+
+      if (! gegl_compression_lz_read_length (&ip, ip_end, &length) ||
+          length > (gsize) (ip_end - ip)                           ||
+          length > (gsize) (op_end - op))
+        {
+          return FALSE;
+        }
+
+      memcpy (op, ip, length);
+      ip += length;
+      op += length;
+
+      if (ip == ip_end)
+        break;
+
+      if (ip_end - ip < 2)
+        return FALSE;
+
+      offset = ip[0] | (ip[1] << 8);
+      ip += 2;
+
+      if (offset == 0 || offset > (gsize) (op - data))
+        return FALSE;
+
+      length = token & 0x0f;
+
+      if (! gegl_compression_lz_read_length (&ip, ip_end, &length))
+        return FALSE;
+
+      length += LZ_MIN_MATCH;
+
+      if (length > (gsize) (op_end - op))
+        return FALSE;
+
+      ref = op - offset;
+
+      if (offset >= length)
+        {
+          memcpy (op, ref, length);
+          op += length;
+        }
+      else
+        {
+          /* overlapping match */
+          while (length--)
+            *op++ = *ref++;
+        }
+    }
+
+  return op == op_end;
+}
+
+static gint
+gegl_compression_lz_get_element_size (const Babl *format)
+{
+  gint bpp          = babl_format_get_bytes_per_pixel (format);
+  gint n_components = babl_format_get_n_components (format);
+
+  if (n_components > 0 && bpp % n_components == 0)
+    return bpp / n_components;
+  else
+    return 1;
+}
+
+/* split the data into byte planes, so that the more-significant bytes of
+ * multi-byte components, which vary slowly across natural images, form long
+ * matches, instead of being interleaved with the noisy less-significant
+ * bytes.
+ */
+static void
+gegl_compression_lz_shuffle (const guint8 *src,
+                             guint8       *dest,
+                             gint          n_elements,
+                             gint          element_size)
+{
+  gint b;
+
+  for (b = 0; b < element_size; b++)
+    {
+      const guint8 *s = src + b;
+      guint8       *d = dest + b * n_elements;
+      gint          i;
+
+      for (i = 0; i < n_elements; i++)
+        {
+          d[i] = *s;
+
+          s += element_size;
+        }
+    }
+}
+
+static void
+gegl_compression_lz_unshuffle (const guint8 *src,
+                               guint8       *dest,
+                               gint          n_elements,
+                               gint          element_size)
+{
+  gint b;
+
+  for (b = 0; b < element_size; b++)
+    {
+      const guint8 *s = src + b * n_elements;
+      guint8       *d = dest + b;
+      gint          i;
+
+      for (i = 0; i < n_elements; i++)
+        {
+          *d = s[i];
+
+          d += element_size;
+        }
+    }
+}
+
+static gboolean
+gegl_compression_lz_compress (const GeglCompression *compression,
+                              const Babl            *format,
+                              gconstpointer          data,
+                              gint                   n,
+                              gpointer               compressed,
+                              gint                  *compressed_size,
+                              gint                   max_compressed_size)
+{
+  const GeglCompressionLz *compression_lz;
+  gint                     size;
+  gint                     element_size = 1;
+  gboolean                 success;
+
+  compression_lz = (const GeglCompressionLz *) compression;
+
+  size = n * babl_format_get_bytes_per_pixel (format);
+
+  if (compression_lz->shuffle)
+    element_size = gegl_compression_lz_get_element_size (format);
+
+  if (element_size > 1)
+    {
+      guint8 *shuffled = gegl_scratch_alloc (size);
+
+      gegl_compression_lz_shuffle (data, shuffled,
+                                   size / element_size, element_size);
+
+      success = gegl_compression_lz_compress_bytes (shuffled, size,
+                                                    compressed,
+                                                    compressed_size,
+                                                    max_compressed_size);
+
+      gegl_scratch_free (shuffled);
+    }
+  else
+    {
+      success = gegl_compression_lz_compress_bytes (data, size,
+                                                    compressed,
+                                                    compressed_size,
+                                                    max_compressed_size);
+    }
+
+  return success;
+}
+
+static gboolean
+gegl_compression_lz_decompress (const GeglCompression *compression,
+                                const Babl            *format,
+                                gpointer               data,
+                                gint                   n,
+                                gconstpointer          compressed,
+                                gint                   compressed_size)
+{
+  const GeglCompressionLz *compression_lz;
+  gint                     size;
+  gint                     element_size = 1;
+  gboolean                 success;
+
+  compression_lz = (const GeglCompressionLz *) compression;
+
+  size = n * babl_format_get_bytes_per_pixel (format);
+
+  if (compression_lz->shuffle)
+    element_size = gegl_compression_lz_get_element_size (format);
+
+  if (element_size > 1)
+    {
+      guint8 *shuffled = gegl_scratch_alloc (size);
+
+      success = gegl_compression_lz_decompress_bytes (shuffled, size,
+                                                      compressed,
+                                                      compressed_size);
+
+      if (success)
+        {
+          gegl_compression_lz_unshuffle (shuffled, data,
+                                         size / element_size, element_size);
+        }
+
+      gegl_scratch_free (shuffled);
+    }
+  else
+    {
+      success = gegl_compression_lz_decompress_bytes (data, size,
+                                                      compressed,
+                                                      compressed_size);
+    }
+
+  return success;
+}
+
+
+/*  public functions  */
+
+void
+gegl_compression_lz_init (void)
+{
+  #define COMPRESSION_LZ(name, lz_shuffle)               \
+    G_STMT_START                                         \
+      {                                                  \
+        static const GeglCompressionLz compression_lz =  \
+        {                                                \
+          .compression =                                 \
+          {                                              \
+            .compress   = gegl_compression_lz_compress,  \
+            .decompress = gegl_compression_lz_decompress \
+          },                                             \
+          .shuffle = (lz_shuffle)                        \
+        };                                               \
+                                                         \
+        gegl_compression_register (                      \
+          name,                                          \
+          (const GeglCompression *) &compression_lz);    \
+      }                                                  \
+    G_STMT_END
+
+  COMPRESSION_LZ ("lz",         FALSE);
+  COMPRESSION_LZ ("lz-shuffle", TRUE);
+}
@@ -21,6 +21,7 @@
 #include <string.h>
 
 #include "gegl-compression.h"
+#include "gegl-compression-lz.h"
 #include "gegl-compression-nop.h"
 #include "gegl-compression-rle.h"
 #include "gegl-compression-zlib.h"
@@ -76,6 +77,7 @@ gegl_compression_init (void)
   gegl_compression_nop_init ();
   gegl_compression_rle_init ();
   gegl_compression_zlib_init ();
+  gegl_compression_lz_init ();
 
   gegl_compression_register_alias ("fast",
                                    /* in order of precedence: */
@@ -43,6 +43,15 @@ static void          gegl_sampler_linear_get         (      GeglSampler* restric
                                                             GeglBufferMatrix2     *scale,
                                                             void*        restrict  output,
                                                             GeglAbyssPolicy        repeat_mode);
+static void          gegl_sampler_linear_get_span    (      GeglSampler* restrict  self,
+                                                            gdouble                absolute_x,
+                                                            gdouble                absolute_y,
+                                                            gdouble                dx,
+                                                            gdouble                dy,
+                                                            GeglBufferMatrix2     *scale,
+                                                            void*        restrict  output,
+                                                            gint                   n,
+                                                            GeglAbyssPolicy        repeat_mode);
 
 G_DEFINE_TYPE (GeglSamplerLinear, gegl_sampler_linear, GEGL_TYPE_SAMPLER)
 
@@ -53,6 +62,7 @@ gegl_sampler_linear_class_init (GeglSamplerLinearClass *klass)
 
   sampler_class->get         = gegl_sampler_linear_get;
   sampler_class->interpolate = gegl_sampler_linear_interpolate;
+  sampler_class->get_span    = gegl_sampler_linear_get_span;
 }
 
 /*
@@ -79,14 +89,19 @@ gegl_sampler_linear_init (GeglSamplerLinear *self)
   GEGL_SAMPLER (self)->level[0].context_rect.height =  3 + 2*LINEAR_EXTRA_ELBOW_ROOM;
 }
 
+/*
+ * nc is passed in, rather than read from the sampler, so that the span
+ * function can instantiate this with a constant number of components,
+ * turning the per-component loops into vector operations.
+ */
 static inline void
-gegl_sampler_linear_interpolate (      GeglSampler       *self,
-                                 const gdouble            absolute_x,
-                                 const gdouble            absolute_y,
-                                       gfloat            *output,
-                                       GeglAbyssPolicy    repeat_mode)
+gegl_sampler_linear_interpolate_nc (      GeglSampler       *self,
+                                    const gdouble            absolute_x,
+                                    const gdouble            absolute_y,
+                                          gfloat            *output,
+                                          GeglAbyssPolicy    repeat_mode,
+                                    const gint               nc)
 {
-  gint       nc                    = self->interpolate_components;
   const gint pixels_per_buffer_row = GEGL_SAMPLER_MAXIMUM_WIDTH;
 
   /*
@@ -178,6 +193,18 @@ gegl_sampler_linear_interpolate (      GeglSampler       *self,
   }
 }
 
+static inline void
+gegl_sampler_linear_interpolate (      GeglSampler       *self,
+                                 const gdouble            absolute_x,
+                                 const gdouble            absolute_y,
+                                       gfloat            *output,
+                                       GeglAbyssPolicy    repeat_mode)
+{
+  gegl_sampler_linear_interpolate_nc (self, absolute_x, absolute_y, output,
+                                      repeat_mode,
+                                      self->interpolate_components);
+}
+
 static void
 gegl_sampler_linear_get (      GeglSampler       *self,
                          const gdouble            absolute_x,
@@ -197,3 +224,61 @@ gegl_sampler_linear_get (      GeglSampler       *self,
     babl_process (self->fish, result, output, 1);
   }
 }
+
+static void
+gegl_sampler_linear_get_span (GeglSampler       *self,
+                              gdouble            absolute_x,
+                              gdouble            absolute_y,
+                              gdouble            dx,
+                              gdouble            dy,
+                              GeglBufferMatrix2 *scale,
+                              void              *output,
+                              gint               n,
+                              GeglAbyssPolicy    repeat_mode)
+{
+  gint    nc  = self->interpolate_components;
+  gint    bpp = babl_format_get_bytes_per_pixel (self->format);
+  guchar *out = output;
+  gfloat  result[GEGL_SAMPLER_SPAN_CHUNK * 5];
+
+  if (_gegl_sampler_span_is_box (scale))
+    {
+      _gegl_sampler_get_span_generic (self, absolute_x, absolute_y, dx, dy,
+                                      scale, output, n, repeat_mode);
+      return;
+    }
+
+  while (n > 0)
+    {
+      gint chunk = MIN (n, GEGL_SAMPLER_SPAN_CHUNK);
+      gint i;
+
+      if (nc == 4)
+        {
+          for (i = 0; i < chunk; i++)
+            {
+              gegl_sampler_linear_interpolate_nc (self, absolute_x, absolute_y,
+                                                  result + i * 4,
+                                                  repeat_mode, 4);
+              absolute_x += dx;
+              absolute_y += dy;
+            }
+        }
+      else
+        {
+          for (i = 0; i < chunk; i++)
+            {
+              gegl_sampler_linear_interpolate_nc (self, absolute_x, absolute_y,
+                                                  result + i * nc,
+                                                  repeat_mode, nc);
+              absolute_x += dx;
+              absolute_y += dy;
+            }
+        }
+
+      babl_process (self->fish, result, out, chunk);
+
+      out += chunk * bpp;
+      n   -= chunk;
+    }
+}
@@ -45,6 +45,17 @@ gegl_sampler_nearest_get (GeglSampler*    restrict self,
                           void*           restrict output,
                           GeglAbyssPolicy          repeat_mode);
 
+static void
+gegl_sampler_nearest_get_span (GeglSampler*    restrict self,
+                               gdouble                  absolute_x,
+                               gdouble                  absolute_y,
+                               gdouble                  dx,
+                               gdouble                  dy,
+                               GeglBufferMatrix2       *scale,
+                               void*           restrict output,
+                               gint                     n,
+                               GeglAbyssPolicy          repeat_mode);
+
 static void
 gegl_sampler_nearest_prepare (GeglSampler*    restrict self);
 
@@ -59,6 +70,7 @@ gegl_sampler_nearest_class_init (GeglSamplerNearestClass *klass)
   object_class->dispose = gegl_sampler_nearest_dispose;
 
   sampler_class->get = gegl_sampler_nearest_get;
+  sampler_class->get_span = gegl_sampler_nearest_get_span;
   sampler_class->prepare = gegl_sampler_nearest_prepare;
 }
 
@@ -91,6 +103,62 @@ gegl_sampler_nearest_dispose (GObject *object)
   G_OBJECT_CLASS (gegl_sampler_nearest_parent_class)->dispose (object);
 }
 
+/* returns a pointer to the pixel at (x, y) in the tile holding it, which
+ * becomes the hot tile.  the caller must hold the buffer lock, and (x, y)
+ * must be inside the abyss.
+ */
+static inline guchar *
+gegl_sampler_nearest_get_tile_data (GeglSamplerNearest *nearest_sampler,
+                                    gint                x,
+                                    gint                y)
+{
+  GeglBuffer *buffer      = GEGL_SAMPLER (nearest_sampler)->buffer;
+  gint        tile_width  = buffer->tile_width;
+  gint        tile_height = buffer->tile_height;
+  gint        tiledy      = y + buffer->shift_y;
+  gint        tiledx      = x + buffer->shift_x;
+  gint        indice_x    = gegl_tile_indice (tiledx, tile_width);
+  gint        indice_y    = gegl_tile_indice (tiledy, tile_height);
+
+  GeglTile *tile = nearest_sampler->hot_tile;
+
+  if (!(tile &&
+        tile->x == indice_x &&
+        tile->y == indice_y))
+    {
+      g_rec_mutex_lock (&buffer->tile_storage->mutex);
+
+      if (tile)
+        {
+          gegl_tile_read_unlock (tile);
+
+          gegl_tile_unref (tile);
+        }
+
+      tile = gegl_tile_source_get_tile ((GeglTileSource *) (buffer),
+                                        indice_x, indice_y,
+                                        0);
+      nearest_sampler->hot_tile = tile;
+
+      gegl_tile_read_lock (tile);
+
+      g_rec_mutex_unlock (&buffer->tile_storage->mutex);
+    }
+
+  if (tile)
+    {
+      gint tile_origin_x = indice_x * tile_width;
+      gint tile_origin_y = indice_y * tile_height;
+      gint       offsetx = tiledx - tile_origin_x;
+      gint       offsety = tiledy - tile_origin_y;
+
+      return gegl_tile_get_data (tile) +
+             (offsety * tile_width + offsetx) * nearest_sampler->buffer_bpp;
+    }
+
+  return NULL;
+}
+
 static void inline
 gegl_sampler_get_pixel (GeglSampler    *sampler,
                         gint            x,
@@ -102,6 +170,7 @@ gegl_sampler_get_pixel (GeglSampler    *sampler,
   GeglBuffer *buffer = sampler->buffer;
   const GeglRectangle *abyss = &buffer->abyss;
   guchar              *buf   = data;
+  guchar              *tp;
 
   if (y <  abyss->y ||
       x <  abyss->x ||
@@ -150,54 +219,10 @@ gegl_sampler_get_pixel (GeglSampler    *sampler,
 
   gegl_buffer_lock (sampler->buffer);
 
-  {
-    gint tile_width  = buffer->tile_width;
-    gint tile_height = buffer->tile_height;
-    gint tiledy      = y + buffer->shift_y;
-    gint tiledx      = x + buffer->shift_x;
-    gint indice_x    = gegl_tile_indice (tiledx, tile_width);
-    gint indice_y    = gegl_tile_indice (tiledy, tile_height);
-
-    GeglTile *tile = nearest_sampler->hot_tile;
-
-    if (!(tile &&
-          tile->x == indice_x &&
-          tile->y == indice_y))
-      {
-        g_rec_mutex_lock (&buffer->tile_storage->mutex);
-
-        if (tile)
-          {
-            gegl_tile_read_unlock (tile);
-
-            gegl_tile_unref (tile);
-          }
+  tp = gegl_sampler_nearest_get_tile_data (nearest_sampler, x, y);
 
-        tile = gegl_tile_source_get_tile ((GeglTileSource *) (buffer),
-                                          indice_x, indice_y,
-                                          0);
-        nearest_sampler->hot_tile = tile;
-
-        gegl_tile_read_lock (tile);
-
-        g_rec_mutex_unlock (&buffer->tile_storage->mutex);
-      }
-
-    if (tile)
-      {
-        gint tile_origin_x = indice_x * tile_width;
-        gint tile_origin_y = indice_y * tile_height;
-        gint       offsetx = tiledx - tile_origin_x;
-        gint       offsety = tiledy - tile_origin_y;
-
-        guchar *tp;
-
-        tp = gegl_tile_get_data (tile) +
-             (offsety * tile_width + offsetx) * nearest_sampler->buffer_bpp;
-
-        babl_process (sampler->fish, tp, buf, 1);
-      }
-  }
+  if (tp)
+    babl_process (sampler->fish, tp, buf, 1);
 
   gegl_buffer_unlock (sampler->buffer);
 }
@@ -215,6 +240,88 @@ gegl_sampler_nearest_get (      GeglSampler*    restrict  sampler,
            output, repeat_mode);
 }
 
+/* pixels inside the abyss are copied out of their tiles in runs, and each
+ * run is converted with a single babl_process() call; pixels outside the
+ * abyss go through gegl_sampler_get_pixel() one at a time.
+ */
+static void
+gegl_sampler_nearest_get_span (      GeglSampler*    restrict  sampler,
+                                     gdouble                   absolute_x,
+                                     gdouble                   absolute_y,
+                                     gdouble                   dx,
+                                     gdouble                   dy,
+                                     GeglBufferMatrix2        *scale,
+                                     void*           restrict  output,
+                                     gint                      n,
+                                     GeglAbyssPolicy           repeat_mode)
+{
+  GeglSamplerNearest  *nearest_sampler = (GeglSamplerNearest*)(sampler);
+  const GeglRectangle *abyss           = &sampler->buffer->abyss;
+  gint                 bpp             = babl_format_get_bytes_per_pixel (sampler->format);
+  gint                 buffer_bpp      = nearest_sampler->buffer_bpp;
+  guchar              *out             = output;
+  guchar               run_buf[GEGL_SAMPLER_SPAN_CHUNK * 16];
+  gint                 max_run;
+  gint                 run             = 0;
+
+  if (buffer_bpp > (gint) sizeof (run_buf))
+    {
+      _gegl_sampler_get_span_generic (sampler, absolute_x, absolute_y, dx, dy,
+                                      scale, output, n, repeat_mode);
+      return;
+    }
+
+  max_run = sizeof (run_buf) / buffer_bpp;
+
+  gegl_buffer_lock (sampler->buffer);
+
+  while (n--)
+    {
+      gint x = int_floorf (absolute_x);
+      gint y = int_floorf (absolute_y);
+
+      if (y >= abyss->y &&
+          x >= abyss->x &&
+          y <  abyss->y + abyss->height &&
+          x <  abyss->x + abyss->width)
+        {
+          guchar *tp = gegl_sampler_nearest_get_tile_data (nearest_sampler,
+                                                           x, y);
+
+          if (tp)
+            memcpy (run_buf + run * buffer_bpp, tp, buffer_bpp);
+          else
+            memset (run_buf + run * buffer_bpp, 0, buffer_bpp);
+
+          if (++run == max_run)
+            {
+              babl_process (sampler->fish, run_buf, out, run);
+              out += run * bpp;
+              run  = 0;
+            }
+        }
+      else
+        {
+          if (run)
+            {
+              babl_process (sampler->fish, run_buf, out, run);
+              out += run * bpp;
+              run  = 0;
+            }
+
+          gegl_sampler_get_pixel (sampler, x, y, out, repeat_mode);
+          out += bpp;
+        }
+
+      absolute_x += dx;
+      absolute_y += dy;
+    }
+
+  if (run)
+    babl_process (sampler->fish, run_buf, out, run);
+
+  gegl_buffer_unlock (sampler->buffer);
+}
 
 static void
 gegl_sampler_nearest_prepare (GeglSampler* restrict sampler)
@@ -89,6 +89,7 @@ gegl_sampler_class_init (GeglSamplerClass *klass)
   klass->prepare     = NULL;
   klass->get         = NULL;
   klass->interpolate = NULL;
+  klass->get_span    = NULL;
   klass->set_buffer  = set_buffer;
 
   object_class->set_property = set_property;
@@ -147,6 +148,7 @@ constructed (GObject *self)
 
   sampler->get         = klass->get;
   sampler->interpolate = klass->interpolate;
+  sampler->get_span    = klass->get_span;
 
   if (sampler->buffer)
     {
@@ -626,3 +628,13 @@ GeglSamplerGetFun gegl_sampler_get_fun (GeglSampler *sampler)
   return sampler->get;
 }
 
+GeglSamplerGetSpanFun gegl_sampler_get_span_fun (GeglSampler *sampler)
+{
+  /* like gegl_sampler_get_fun(), the function is only valid until the
+   * buffer is next modified
+   */
+  if (gegl_buffer_ext_flush)
+    gegl_buffer_ext_flush (sampler->buffer, NULL);
+  return sampler->get_span;
+}
+
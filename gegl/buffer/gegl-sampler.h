@@ -79,6 +79,7 @@ struct _GeglSampler
 
   GeglSamplerGetFun          get;
   GeglSamplerInterpolateFun  interpolate;
+  GeglSamplerGetSpanFun      get_span;
 
   /*< private >*/
   GeglBuffer                *buffer;
@@ -99,6 +100,7 @@ struct _GeglSamplerClass
   void                      (* prepare)    (GeglSampler *self);
   GeglSamplerGetFun            get;
   GeglSamplerInterpolateFun    interpolate;
+  GeglSamplerGetSpanFun        get_span;
   void                      (* set_buffer) (GeglSampler *self,
                                             GeglBuffer  *buffer);
 };
@@ -380,6 +382,54 @@ _gegl_sampler_box_get (GeglSampler*    restrict  self,
   return FALSE;
 }
 
+/* span functions interpolate this many samples at a time, and convert them
+ * to the output format with a single babl_process() call.
+ */
+#define GEGL_SAMPLER_SPAN_CHUNK 64
+
+/* whether _gegl_sampler_box_get() box-filters for @scale; since all samples
+ * of a span share the scale matrix, this is decided once per span.
+ */
+static inline gboolean
+_gegl_sampler_span_is_box (GeglBufferMatrix2 *scale)
+{
+  if (scale)
+    {
+      const gdouble u_norm2 = scale->coeff[0][0] * scale->coeff[0][0] +
+                              scale->coeff[1][0] * scale->coeff[1][0];
+      const gdouble v_norm2 = scale->coeff[0][1] * scale->coeff[0][1] +
+                              scale->coeff[1][1] * scale->coeff[1][1];
+
+      return u_norm2 >= 4.0 || v_norm2 >= 4.0;
+    }
+
+  return FALSE;
+}
+
+static inline void
+_gegl_sampler_get_span_generic (GeglSampler       *self,
+                                gdouble            x,
+                                gdouble            y,
+                                gdouble            dx,
+                                gdouble            dy,
+                                GeglBufferMatrix2 *scale,
+                                void              *output,
+                                gint               n,
+                                GeglAbyssPolicy    repeat_mode)
+{
+  gint    bpp = babl_format_get_bytes_per_pixel (self->format);
+  guchar *out = output;
+
+  while (n--)
+    {
+      self->get (self, x, y, scale, out, repeat_mode);
+
+      out += bpp;
+      x   += dx;
+      y   += dy;
+    }
+}
+
 G_END_DECLS
 
 #endif /* __GEGL_SAMPLER_H__ */
@@ -16,9 +16,12 @@
  * Copyright 2019 Ell
  */
 
+#define _GNU_SOURCE /* for sched_getcpu() */
+
 #include "config.h"
 
 #include <math.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
@@ -26,6 +29,14 @@
 #include <malloc.h>
 #endif
 
+#ifdef HAVE_MMAP
+#include <sys/mman.h>
+#endif
+
+#ifdef HAVE_SCHED_GETCPU
+#include <sched.h>
+#endif
+
 #include <glib-object.h>
 
 #include "gegl-buffer-config.h"
@@ -46,11 +57,31 @@
 #define GEGL_TILE_BLOCKS_PER_TRIM     10
 #define GEGL_TILE_SENTINEL_BLOCK      ((GeglTileBlock *) ~(guintptr) 0)
 
+#define GEGL_TILE_N_DIVISORS          3
+#define GEGL_TILE_N_CLASSES           (GEGL_TILE_N_DIVISORS * \
+                                       GEGL_TILE_MAX_SIZE_LOG2)
+
+#define GEGL_TILE_MAX_NODES           8
+#define GEGL_TILE_MAX_CPUS            1024
+
+/* the number of buffers a magazine holds for a size class is bounded by
+ * both a count and a total size.
+ */
+#define GEGL_TILE_MAGAZINE_MAX_BUFFERS 16
+#define GEGL_TILE_MAGAZINE_MAX_SIZE    (1 << 21)
+
+/* the number of allocations and frees after which a magazine checks which
+ * node its thread runs on, and publishes its stats.
+ */
+#define GEGL_TILE_MAGAZINE_INTERVAL   64
+
 
 /*  private types  */
 
-typedef struct _GeglTileBuffer GeglTileBuffer;
-typedef struct _GeglTileBlock  GeglTileBlock;
+typedef struct _GeglTileBuffer   GeglTileBuffer;
+typedef struct _GeglTileBlock    GeglTileBlock;
+typedef struct _GeglTileMagazine GeglTileMagazine;
+typedef struct _GeglTileNode     GeglTileNode;
 
 struct _GeglTileBuffer
 {
@@ -70,6 +101,50 @@ struct _GeglTileBlock
 
   GeglTileBlock            *next;
   GeglTileBlock            *prev;
+
+  gint                      node;
+  gint                      size_class;
+  gint                      magazine_capacity;
+  gboolean                  mapped;
+};
+
+/* a per-thread cache of free buffers, in front of the block lists of the
+ * node the thread runs on.  the buffers are linked through their data, and
+ * remain allocated as far as their blocks are concerned.
+ *
+ * the mutex is only ever contended when the magazines of all threads are
+ * flushed, by gegl_tile_magazines_flush().
+ */
+struct _GeglTileMagazine
+{
+  GMutex          mutex;
+
+  gint            node;
+  gint            countdown;
+
+  GeglTileBuffer *buffers[GEGL_TILE_N_CLASSES];
+  gint            n_buffers[GEGL_TILE_N_CLASSES];
+  gint            n_total_buffers;
+
+  /* stats not yet published to the node */
+  guint           n_allocs;
+  guint           n_magazine_allocs;
+  guint           n_frees;
+  guint           n_remote_frees;
+};
+
+struct _GeglTileNode
+{
+  GeglTileBlock *empty_block;
+
+  guintptr       total;
+  guintptr       n_allocs;
+  guintptr       n_magazine_allocs;
+  guintptr       n_frees;
+  guintptr       n_remote_frees;
+
+  /* keep the nodes in separate cache lines */
+  guint8         padding[64 - 6 * sizeof (gpointer)];
 };
 
 
@@ -78,11 +153,25 @@ struct _GeglTileBlock
 static gint                    gegl_tile_log2i            (guint                      n);
 
 static GeglTileBlock         * gegl_tile_block_new        (GeglTileBlock * volatile  *block_ptr,
+                                                           gint                       node,
+                                                           gint                       size_class,
                                                            gsize                      size);
 static void                    gegl_tile_block_free       (GeglTileBlock             *block,
                                                            GeglTileBlock            **head_block);
 static void                    gegl_tile_block_free_mem   (GeglTileBlock             *block);
 
+static void                    gegl_tile_buffer_release   (GeglTileBuffer            *buffer);
+
+static GeglTileMagazine      * gegl_tile_magazine_lock    (void);
+static void                    gegl_tile_magazine_unlock  (GeglTileMagazine          *magazine);
+static void                    gegl_tile_magazine_update  (GeglTileMagazine          *magazine);
+static void                    gegl_tile_magazine_flush   (GeglTileMagazine          *magazine);
+static void                    gegl_tile_magazine_free    (GeglTileMagazine          *magazine);
+static void                    gegl_tile_magazines_flush  (void);
+
+static gint                    gegl_tile_current_node     (void);
+static void                    gegl_tile_init_nodes       (void);
+
 static inline gpointer         gegl_tile_buffer_to_data   (GeglTileBuffer            *buffer);
 static inline GeglTileBuffer * gegl_tile_buffer_from_data (gpointer                   data);
 
@@ -91,13 +180,22 @@ static gpointer                gegl_tile_alloc_fallback   (gsize
 
 /*  local variables  */
 
-static const gint     gegl_tile_divisors[] = {1, 3, 5};
-static GeglTileBlock *gegl_tile_blocks[G_N_ELEMENTS (gegl_tile_divisors)]
+static const gint     gegl_tile_divisors[GEGL_TILE_N_DIVISORS] = {1, 3, 5};
+static GeglTileBlock *gegl_tile_blocks[GEGL_TILE_MAX_NODES]
+                                      [G_N_ELEMENTS (gegl_tile_divisors)]
                                       [GEGL_TILE_MAX_SIZE_LOG2];
-static GeglTileBlock *gegl_tile_empty_block;
+static GeglTileNode   gegl_tile_nodes[GEGL_TILE_MAX_NODES];
+static gint           gegl_tile_n_nodes = 1;
+static gint8          gegl_tile_cpu_nodes[GEGL_TILE_MAX_CPUS];
 static gint           gegl_tile_n_blocks;
 static gint           gegl_tile_max_n_blocks;
 
+static gboolean       gegl_tile_alloc_numa;
+static GPrivate       gegl_tile_magazine = G_PRIVATE_INIT (
+  (GDestroyNotify) gegl_tile_magazine_free);
+static GMutex         gegl_tile_magazines_mutex;
+static GSList        *gegl_tile_magazines;
+
 static guintptr       gegl_tile_alloc_total;
 
 
@@ -138,23 +236,26 @@ gegl_tile_log2i (guint n)
 
 static GeglTileBlock *
 gegl_tile_block_new (GeglTileBlock * volatile *block_ptr,
+                     gint                      node,
+                     gint                      size_class,
                      gsize                     size)
 {
   GeglTileBlock *block;
   gsize          block_size;
   gsize          buffer_size;
   gsize          n_buffers;
+  gboolean       mapped     = FALSE;
   gboolean       init_block = TRUE;
 
   buffer_size = GEGL_TILE_BUFFER_DATA_OFFSET + GEGL_ALIGN (size);
 
   do
     {
-      block = gegl_tile_empty_block;
+      block = gegl_tile_nodes[node].empty_block;
     }
   while (block &&
-         ! g_atomic_pointer_compare_and_exchange (&gegl_tile_empty_block,
-                                                  block, NULL));
+         ! g_atomic_pointer_compare_and_exchange (
+             &gegl_tile_nodes[node].empty_block, block, NULL));
 
   if (block && block->size - GEGL_TILE_BLOCK_BUFFER_OFFSET < buffer_size)
     {
@@ -188,17 +289,41 @@ gegl_tile_block_new (GeglTileBlock * volatile *block_ptr,
 
       block_size = GEGL_TILE_BLOCK_BUFFER_OFFSET + n_buffers * buffer_size;
 
-      block = gegl_try_malloc (block_size);
+#ifdef HAVE_MMAP
+      /* memory fresh from the kernel is placed on the node of the thread
+       * that first touches it, which for the start of each buffer is the
+       * current thread, below, and for the rest, most likely another thread
+       * of the same node allocating from the block.  malloc() may instead
+       * hand out memory previously touched elsewhere.
+       */
+      if (gegl_tile_n_nodes > 1 && g_atomic_int_get (&gegl_tile_alloc_numa))
+        {
+          block = mmap (NULL, block_size,
+                        PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS,
+                        -1, 0);
+
+          if (block == MAP_FAILED)
+            block = NULL;
+          else
+            mapped = TRUE;
+        }
+#endif
+
+      if (! block)
+        block = gegl_try_malloc (block_size);
 
       if (! block)
         return NULL;
 
+      block->mapped = mapped;
+
       n_blocks = g_atomic_int_add (&gegl_tile_n_blocks, +1) + 1;
 
       if (n_blocks % GEGL_TILE_BLOCKS_PER_TRIM == 0)
         gegl_tile_max_n_blocks = MAX (gegl_tile_max_n_blocks, n_blocks);
 
       g_atomic_pointer_add (&gegl_tile_alloc_total, +block_size);
+      g_atomic_pointer_add (&gegl_tile_nodes[node].total, +block_size);
     }
 
   if (init_block)
@@ -210,6 +335,12 @@ gegl_tile_block_new (GeglTileBlock * volatile *block_ptr,
       block->block_ptr   = block_ptr;
       block->size        = block_size;
 
+      block->node              = node;
+      block->size_class        = size_class;
+      block->magazine_capacity = CLAMP (GEGL_TILE_MAGAZINE_MAX_SIZE /
+                                        buffer_size,
+                                        1, GEGL_TILE_MAGAZINE_MAX_BUFFERS);
+
       block->head        = (GeglTileBuffer *) ((guint8 *) block +
                                                GEGL_TILE_BLOCK_BUFFER_OFFSET);
       block->n_allocated = 0;
@@ -249,13 +380,13 @@ gegl_tile_block_free (GeglTileBlock  *block,
   if (block->next)
     block->next->prev = block->prev;
 
-  if (! gegl_tile_empty_block)
+  if (! gegl_tile_nodes[block->node].empty_block)
     {
       block->prev = NULL;
       block->next = NULL;
 
-      if (g_atomic_pointer_compare_and_exchange (&gegl_tile_empty_block,
-                                                 NULL, block))
+      if (g_atomic_pointer_compare_and_exchange (
+            &gegl_tile_nodes[block->node].empty_block, NULL, block))
         {
           return;
         }
@@ -268,13 +399,20 @@ static void
 gegl_tile_block_free_mem (GeglTileBlock *block)
 {
   guintptr block_size = block->size;
+  gint     node       = block->node;
   gint     n_blocks;
 
-  gegl_free (block);
+#ifdef HAVE_MMAP
+  if (block->mapped)
+    munmap (block, block_size);
+  else
+#endif
+    gegl_free (block);
 
   n_blocks = g_atomic_int_add (&gegl_tile_n_blocks, -1) - 1;
 
   g_atomic_pointer_add (&gegl_tile_alloc_total, -block_size);
+  g_atomic_pointer_add (&gegl_tile_nodes[node].total, -block_size);
 
 #ifdef HAVE_MALLOC_TRIM
   if (gegl_tile_max_n_blocks - n_blocks >= GEGL_TILE_BLOCKS_PER_TRIM)
@@ -300,6 +438,289 @@ gegl_tile_buffer_from_data (gpointer data)
   return (GeglTileBuffer *) ((guint8 *) data - GEGL_TILE_BUFFER_DATA_OFFSET);
 }
 
+/* returns a buffer to its block */
+static void
+gegl_tile_buffer_release (GeglTileBuffer *buffer)
+{
+  GeglTileBlock * volatile  *block_ptr;
+  GeglTileBlock             *block;
+  GeglTileBlock             *head_block;
+  GeglTileBuffer           **next_buffer;
+
+  block     = buffer->block;
+  block_ptr = block->block_ptr;
+
+  do
+    {
+      head_block = *block_ptr;
+    }
+  while (head_block == GEGL_TILE_SENTINEL_BLOCK ||
+         ! g_atomic_pointer_compare_and_exchange (block_ptr,
+                                                  head_block,
+                                                  GEGL_TILE_SENTINEL_BLOCK));
+
+  block->n_allocated--;
+
+  next_buffer = gegl_tile_buffer_to_data (buffer);
+
+  *next_buffer = block->head;
+
+  if (! block->head)
+    {
+      block->prev = NULL;
+      block->next = head_block;
+
+      if (head_block)
+        head_block->prev = block;
+
+      head_block = block;
+    }
+
+  block->head = buffer;
+
+  if (block->n_allocated == 0)
+    gegl_tile_block_free (block, &head_block);
+
+  g_atomic_pointer_set (block_ptr, head_block);
+}
+
+/* returns the magazine of the current thread, locked, or NULL if the
+ * allocator has been turned off in the meantime.
+ */
+static GeglTileMagazine *
+gegl_tile_magazine_lock (void)
+{
+  GeglTileMagazine *magazine = g_private_get (&gegl_tile_magazine);
+
+  if (G_UNLIKELY (! magazine))
+    {
+      magazine = g_slice_new0 (GeglTileMagazine);
+
+      g_mutex_init (&magazine->mutex);
+
+      magazine->node = gegl_tile_current_node ();
+
+      g_private_set (&gegl_tile_magazine, magazine);
+
+      g_mutex_lock (&gegl_tile_magazines_mutex);
+
+      gegl_tile_magazines = g_slist_prepend (gegl_tile_magazines, magazine);
+
+      g_mutex_unlock (&gegl_tile_magazines_mutex);
+    }
+
+  g_mutex_lock (&magazine->mutex);
+
+  /* the magazines are flushed after the allocator is turned off, so don't
+   * refill them past that point.
+   */
+  if (G_UNLIKELY (! g_atomic_int_get (&gegl_tile_alloc_numa)))
+    {
+      g_mutex_unlock (&magazine->mutex);
+
+      return NULL;
+    }
+
+  if (G_UNLIKELY (--magazine->countdown <= 0))
+    gegl_tile_magazine_update (magazine);
+
+  return magazine;
+}
+
+static void
+gegl_tile_magazine_unlock (GeglTileMagazine *magazine)
+{
+  g_mutex_unlock (&magazine->mutex);
+}
+
+/* publishes the stats of @magazine, and follows its thread to another node
+ * if it has been migrated, dropping the buffers of the old node.
+ */
+static void
+gegl_tile_magazine_update (GeglTileMagazine *magazine)
+{
+  GeglTileNode *node = &gegl_tile_nodes[magazine->node];
+  gint          current_node;
+
+  g_atomic_pointer_add (&node->n_allocs,          magazine->n_allocs);
+  g_atomic_pointer_add (&node->n_magazine_allocs, magazine->n_magazine_allocs);
+  g_atomic_pointer_add (&node->n_frees,           magazine->n_frees);
+  g_atomic_pointer_add (&node->n_remote_frees,    magazine->n_remote_frees);
+
+  magazine->n_allocs          = 0;
+  magazine->n_magazine_allocs = 0;
+  magazine->n_frees           = 0;
+  magazine->n_remote_frees    = 0;
+
+  current_node = gegl_tile_current_node ();
+
+  if (current_node != magazine->node)
+    {
+      gegl_tile_magazine_flush (magazine);
+
+      magazine->node = current_node;
+    }
+
+  magazine->countdown = GEGL_TILE_MAGAZINE_INTERVAL;
+}
+
+static void
+gegl_tile_magazine_flush (GeglTileMagazine *magazine)
+{
+  gint i;
+
+  if (! magazine->n_total_buffers)
+    return;
+
+  for (i = 0; i < GEGL_TILE_N_CLASSES; i++)
+    {
+      while (magazine->buffers[i])
+        {
+          GeglTileBuffer *buffer = magazine->buffers[i];
+
+          magazine->buffers[i] = *(GeglTileBuffer **)
+            gegl_tile_buffer_to_data (buffer);
+
+          gegl_tile_buffer_release (buffer);
+        }
+
+      magazine->n_buffers[i] = 0;
+    }
+
+  magazine->n_total_buffers = 0;
+}
+
+static void
+gegl_tile_magazine_free (GeglTileMagazine *magazine)
+{
+  g_mutex_lock (&gegl_tile_magazines_mutex);
+
+  gegl_tile_magazines = g_slist_remove (gegl_tile_magazines, magazine);
+
+  g_mutex_unlock (&gegl_tile_magazines_mutex);
+
+  magazine->countdown = 0;
+
+  gegl_tile_magazine_update (magazine);
+  gegl_tile_magazine_flush (magazine);
+
+  g_mutex_clear (&magazine->mutex);
+
+  g_slice_free (GeglTileMagazine, magazine);
+}
+
+/* returns the buffers cached by the magazines of all threads to their
+ * blocks, including threads that have gone idle.
+ */
+static void
+gegl_tile_magazines_flush (void)
+{
+  GSList *iter;
+
+  g_mutex_lock (&gegl_tile_magazines_mutex);
+
+  for (iter = gegl_tile_magazines; iter; iter = g_slist_next (iter))
+    {
+      GeglTileMagazine *magazine = iter->data;
+
+      g_mutex_lock (&magazine->mutex);
+
+      gegl_tile_magazine_flush (magazine);
+
+      g_mutex_unlock (&magazine->mutex);
+    }
+
+  g_mutex_unlock (&gegl_tile_magazines_mutex);
+}
+
+static gint
+gegl_tile_current_node (void)
+{
+#ifdef HAVE_SCHED_GETCPU
+  if (gegl_tile_n_nodes > 1)
+    {
+      gint cpu = sched_getcpu ();
+
+      if (cpu >= 0 && cpu < GEGL_TILE_MAX_CPUS)
+        return gegl_tile_cpu_nodes[cpu];
+    }
+#endif
+
+  return 0;
+}
+
+/* maps the cpus to their nodes, as listed by sysfs */
+static void
+gegl_tile_init_nodes (void)
+{
+#ifdef HAVE_SCHED_GETCPU
+  gint node;
+
+  for (node = 0; node < GEGL_TILE_MAX_NODES; node++)
+    {
+      gchar *path;
+      gchar *cpulist = NULL;
+      gchar *p;
+
+      path = g_strdup_printf ("/sys/devices/system/node/node%d/cpulist",
+                              node);
+
+      if (! g_file_get_contents (path, &cpulist, NULL, NULL))
+        {
+          g_free (path);
+
+          break;
+        }
+
+      /* a list of ranges, such as "0-7,16-23" */
+      for (p = cpulist; *p && *p != '\n';)
+        {
+          gchar *end;
+          gint   first;
+          gint   last;
+          gint   cpu;
+
+          first = last = strtol (p, &end, 10);
+
+          if (end == p)
+            break;
+
+          if (*end == '-')
+            {
+              p    = end + 1;
+              last = strtol (p, &end, 10);
+            }
+
+          for (cpu = MAX (first, 0);
+               cpu <= MIN (last, GEGL_TILE_MAX_CPUS - 1);
+               cpu++)
+            {
+              gegl_tile_cpu_nodes[cpu] = node;
+            }
+
+          p = *end == ',' ? end + 1 : end;
+        }
+
+      g_free (cpulist);
+      g_free (path);
+    }
+
+  gegl_tile_n_nodes = MAX (node, 1);
+#endif
+}
+
+static void
+gegl_buffer_config_tile_alloc_numa_notify (GObject    *gobject,
+                                           GParamSpec *pspec,
+                                           gpointer    user_data)
+{
+  g_atomic_int_set (&gegl_tile_alloc_numa,
+                    gegl_buffer_config ()->tile_alloc_numa);
+
+  if (! gegl_tile_alloc_numa)
+    gegl_tile_magazines_flush ();
+}
+
 static gpointer
 gegl_tile_alloc_fallback (gsize size)
 {
@@ -332,23 +753,43 @@ gegl_tile_alloc_enabled (void)
 void
 gegl_tile_alloc_init (void)
 {
+  gegl_tile_init_nodes ();
+
+  g_signal_connect (gegl_buffer_config (), "notify::tile-alloc-numa",
+                    G_CALLBACK (gegl_buffer_config_tile_alloc_numa_notify),
+                    NULL);
+
+  gegl_buffer_config_tile_alloc_numa_notify (
+    G_OBJECT (gegl_buffer_config ()), NULL, NULL);
 }
 
 void
 gegl_tile_alloc_cleanup (void)
 {
-  GeglTileBlock *block;
+  gint node;
 
-  do
+  g_signal_handlers_disconnect_by_func (
+    gegl_buffer_config (),
+    gegl_buffer_config_tile_alloc_numa_notify,
+    NULL);
+
+  gegl_tile_magazines_flush ();
+
+  for (node = 0; node < gegl_tile_n_nodes; node++)
     {
-      block = gegl_tile_empty_block;
-    }
-  while (block &&
-         ! g_atomic_pointer_compare_and_exchange (&gegl_tile_empty_block,
-                                                  block, NULL));
+      GeglTileBlock *block;
 
-  if (block)
-    gegl_tile_block_free_mem (block);
+      do
+        {
+          block = gegl_tile_nodes[node].empty_block;
+        }
+      while (block &&
+             ! g_atomic_pointer_compare_and_exchange (
+                 &gegl_tile_nodes[node].empty_block, block, NULL));
+
+      if (block)
+        gegl_tile_block_free_mem (block);
+    }
 }
 
 gpointer
@@ -358,6 +799,9 @@ gegl_tile_alloc (gsize size)
   GeglTileBlock             *block;
   GeglTileBuffer            *buffer;
   GeglTileBuffer           **next_buffer;
+  GeglTileMagazine          *magazine = NULL;
+  gint                       node     = 0;
+  gint                       size_class;
   gint                       n;
   gint                       i;
   gint                       j;
@@ -384,7 +828,36 @@ gegl_tile_alloc (gsize size)
 
   j = gegl_tile_log2i (n);
 
-  block_ptr = &gegl_tile_blocks[i][j];
+  size_class = i * GEGL_TILE_MAX_SIZE_LOG2 + j;
+
+  if (g_atomic_int_get (&gegl_tile_alloc_numa) &&
+      (magazine = gegl_tile_magazine_lock ()))
+    {
+      node = magazine->node;
+
+      magazine->n_allocs++;
+
+      buffer = magazine->buffers[size_class];
+
+      if (buffer)
+        {
+          next_buffer = gegl_tile_buffer_to_data (buffer);
+
+          magazine->buffers[size_class] = *next_buffer;
+          magazine->n_buffers[size_class]--;
+          magazine->n_total_buffers--;
+
+          magazine->n_magazine_allocs++;
+
+          gegl_tile_magazine_unlock (magazine);
+
+          return next_buffer;
+        }
+
+      gegl_tile_magazine_unlock (magazine);
+    }
+
+  block_ptr = &gegl_tile_blocks[node][i][j];
 
   do
     {
@@ -397,7 +870,7 @@ gegl_tile_alloc (gsize size)
 
   if (! block)
     {
-      block = gegl_tile_block_new (block_ptr, size);
+      block = gegl_tile_block_new (block_ptr, node, size_class, size);
 
       if (! block)
         {
@@ -439,11 +912,8 @@ gegl_tile_alloc0 (gsize size)
 void
 gegl_tile_free (gpointer ptr)
 {
-  GeglTileBlock * volatile  *block_ptr;
-  GeglTileBlock             *block;
-  GeglTileBlock             *head_block;
-  GeglTileBuffer            *buffer;
-  GeglTileBuffer           **next_buffer;
+  GeglTileBuffer   *buffer;
+  GeglTileMagazine *magazine;
 
   if (! ptr)
     return;
@@ -457,41 +927,38 @@ gegl_tile_free (gpointer ptr)
       return;
     }
 
-  block     = buffer->block;
-  block_ptr = block->block_ptr;
-
-  do
+  if (g_atomic_int_get (&gegl_tile_alloc_numa) &&
+      (magazine = gegl_tile_magazine_lock ()))
     {
-      head_block = *block_ptr;
-    }
-  while (head_block == GEGL_TILE_SENTINEL_BLOCK ||
-         ! g_atomic_pointer_compare_and_exchange (block_ptr,
-                                                  head_block,
-                                                  GEGL_TILE_SENTINEL_BLOCK));
+      GeglTileBlock *block = buffer->block;
 
-  block->n_allocated--;
+      magazine->n_frees++;
 
-  next_buffer = gegl_tile_buffer_to_data (buffer);
+      /* only keep buffers local to the node around */
+      if (block->node != magazine->node)
+        {
+          magazine->n_remote_frees++;
+        }
+      else if (magazine->n_buffers[block->size_class] <
+               block->magazine_capacity)
+        {
+          GeglTileBuffer **next_buffer = ptr;
 
-  *next_buffer = block->head;
+          *next_buffer = magazine->buffers[block->size_class];
 
-  if (! block->head)
-    {
-      block->prev = NULL;
-      block->next = head_block;
-
-      if (head_block)
-        head_block->prev = block;
+          magazine->buffers[block->size_class] = buffer;
+          magazine->n_buffers[block->size_class]++;
+          magazine->n_total_buffers++;
 
-      head_block = block;
-    }
+          gegl_tile_magazine_unlock (magazine);
 
-  block->head = buffer;
+          return;
+        }
 
-  if (block->n_allocated == 0)
-    gegl_tile_block_free (block, &head_block);
+      gegl_tile_magazine_unlock (magazine);
+    }
 
-  g_atomic_pointer_set (block_ptr, head_block);
+  gegl_tile_buffer_release (buffer);
 }
 
 
@@ -502,3 +969,29 @@ gegl_tile_alloc_get_total (void)
 {
   return gegl_tile_alloc_total;
 }
+
+gint
+gegl_tile_alloc_get_n_nodes (void)
+{
+  return gegl_tile_n_nodes;
+}
+
+gint
+gegl_tile_alloc_get_current_node (void)
+{
+  return gegl_tile_current_node ();
+}
+
+void
+gegl_tile_alloc_get_node_stats (gint                    node,
+                                GeglTileAllocNodeStats *stats)
+{
+  g_return_if_fail (node >= 0 && node < gegl_tile_n_nodes);
+  g_return_if_fail (stats != NULL);
+
+  stats->total             = gegl_tile_nodes[node].total;
+  stats->n_allocs          = gegl_tile_nodes[node].n_allocs;
+  stats->n_magazine_allocs = gegl_tile_nodes[node].n_magazine_allocs;
+  stats->n_frees           = gegl_tile_nodes[node].n_frees;
+  stats->n_remote_frees    = gegl_tile_nodes[node].n_remote_frees;
+}
@@ -20,6 +20,16 @@
 #define __GEGL_TILE_ALLOC_H__
 
 
+typedef struct
+{
+  guint64 total;             /* size of the blocks allocated on the node */
+  guint64 n_allocs;          /* buffers allocated by threads of the node  */
+  guint64 n_magazine_allocs; /* ... of which from a per-thread magazine   */
+  guint64 n_frees;           /* buffers freed by threads of the node      */
+  guint64 n_remote_frees;    /* ... of which allocated on another node    */
+} GeglTileAllocNodeStats;
+
+
 void       gegl_tile_alloc_init      (void);
 void       gegl_tile_alloc_cleanup   (void);
 
@@ -31,7 +41,16 @@ gpointer   gegl_tile_alloc           (gsize    size) G_GNUC_MALLOC;
 gpointer   gegl_tile_alloc0          (gsize    size) G_GNUC_MALLOC;
 void       gegl_tile_free            (gpointer ptr);
 
-guint64    gegl_tile_alloc_get_total (void);
+guint64    gegl_tile_alloc_get_total        (void);
+
+/* the stats of the numa-aware allocator, enabled by the "tile-alloc-numa"
+ * config property.  the stats of each thread are published to its node
+ * periodically, and are therefore approximate.
+ */
+gint       gegl_tile_alloc_get_n_nodes      (void);
+gint       gegl_tile_alloc_get_current_node (void);
+void       gegl_tile_alloc_get_node_stats   (gint                    node,
+                                             GeglTileAllocNodeStats *stats);
 
 
 #endif /* __GEGL_TILE_ALLOC_H__ */
@@ -28,6 +28,13 @@
  * write_mutex. The first one is used to append to the queue or read from
  * it, the second one to completely stop the writer thread from working
  * (to remove/change queue entries).
+ *
+ * When opening an existing file, the file is also mapped to memory, and the
+ * tiles present in the file at that time are handed out as zero-copy tiles
+ * pointing into the (private) mapping.  writing to such a tile only copies
+ * the affected pages, and storing it relocates the entry to a new offset in
+ * the file, so that the data referenced by the mapped tiles is never
+ * overwritten.
  */
 
 #include "config.h"
@@ -39,6 +46,9 @@
 #include <unistd.h>
 #include <string.h>
 #include <errno.h>
+#ifdef HAVE_MMAP
+#include <sys/mman.h>
+#endif
 
 #include <glib-object.h>
 #include <glib/gprintf.h>
@@ -53,6 +63,7 @@
 #include "gegl-buffer-types.h"
 #include "gegl-debug.h"
 #include "gegl-buffer-config.h"
+#include "gegl-memory-private.h"
 
 
 #ifndef HAVE_FSYNC
@@ -69,6 +80,13 @@
 #define BINARY_FLAG 0
 #endif
 
+typedef struct
+{
+  gint    ref_count;
+  guchar *data;
+  gsize   size;
+} GeglFileBackendMapping;
+
 struct _GeglTileBackendFile
 {
   GeglTileBackend  parent_instance;
@@ -140,6 +158,11 @@ struct _GeglTileBackendFile
 
   /* for reading */
   int              i;
+
+  /* the mapping of the file, when opening an existing file, or NULL.  each
+   * tile pointing into the mapping holds a reference to it.
+   */
+  GeglFileBackendMapping *mapping;
 };
 
 
@@ -436,30 +459,27 @@ gegl_tile_backend_file_file_entry_create (gint x,
   return entry;
 }
 
-static inline GeglFileBackendEntry *
-gegl_tile_backend_file_file_entry_new (GeglTileBackendFile *self)
+static guint64
+gegl_tile_backend_file_alloc_offset (GeglTileBackendFile *self)
 {
-  GeglFileBackendEntry *entry = gegl_tile_backend_file_file_entry_create (0,0,0);
-
-  GEGL_NOTE (GEGL_DEBUG_TILE_BACKEND, "Creating new entry");
-
-  gegl_tile_backend_file_ensure_exist (self);
+  guint64 offset;
 
   if (self->free_list)
     {
-      guint64 offset = *(guint64*)self->free_list->data;
+      guint64 *free_offset = self->free_list->data;
 
-      entry->tile->offset = offset;
-      self->free_list = g_slist_remove (self->free_list, self->free_list->data);
+      offset = *free_offset;
+      self->free_list = g_slist_remove (self->free_list, free_offset);
+      g_free (free_offset);
 
-      GEGL_NOTE (GEGL_DEBUG_TILE_BACKEND, "  set offset %i from free list", ((gint)entry->tile->offset));
+      GEGL_NOTE (GEGL_DEBUG_TILE_BACKEND, "  set offset %i from free list", (gint)offset);
     }
   else
     {
       gint tile_size = gegl_tile_backend_get_tile_size (GEGL_TILE_BACKEND (self));
 
-      entry->tile->offset = self->next_pre_alloc;
-      GEGL_NOTE (GEGL_DEBUG_TILE_BACKEND, "  set offset %i (next allocation)", (gint)entry->tile->offset);
+      offset = self->next_pre_alloc;
+      GEGL_NOTE (GEGL_DEBUG_TILE_BACKEND, "  set offset %i (next allocation)", (gint)offset);
       self->next_pre_alloc += tile_size;
 
       if (self->next_pre_alloc >= self->total) /* automatic growing ensuring that
@@ -480,6 +500,21 @@ gegl_tile_backend_file_file_entry_new (GeglTileBackendFile *self)
           self->in_offset = self->out_offset = -1;
         }
     }
+
+  return offset;
+}
+
+static inline GeglFileBackendEntry *
+gegl_tile_backend_file_file_entry_new (GeglTileBackendFile *self)
+{
+  GeglFileBackendEntry *entry = gegl_tile_backend_file_file_entry_create (0,0,0);
+
+  GEGL_NOTE (GEGL_DEBUG_TILE_BACKEND, "Creating new entry");
+
+  gegl_tile_backend_file_ensure_exist (self);
+
+  entry->tile->offset = gegl_tile_backend_file_alloc_offset (self);
+
   gegl_tile_backend_file_dbg_alloc (gegl_tile_backend_get_tile_size (GEGL_TILE_BACKEND (self)));
   return entry;
 }
@@ -515,7 +550,13 @@ gegl_tile_backend_file_file_entry_destroy (GeglTileBackendFile  *self,
       g_mutex_unlock (&mutex);
     }
 
-  self->free_list = g_slist_prepend (self->free_list, offset);
+  /* the data of mapped entries might still be referenced by mapped tiles,
+   * so we can't reuse their offset.
+   */
+  if (! entry->mapped)
+    self->free_list = g_slist_prepend (self->free_list, offset);
+  else
+    g_free (offset);
   g_hash_table_remove (self->index, entry);
 
   gegl_tile_backend_file_dbg_dealloc (gegl_tile_backend_get_tile_size (GEGL_TILE_BACKEND (self)));
@@ -668,6 +709,87 @@ gegl_tile_backend_file_dbg_dealloc (gint size)
   file_size -= size;
 }
 
+#ifdef HAVE_MMAP
+
+static void
+gegl_tile_backend_file_map (GeglTileBackendFile *self)
+{
+  GeglFileBackendMapping *mapping;
+  struct stat             st;
+  gpointer                data;
+
+  if (fstat (self->i, &st) < 0 || st.st_size <= 0 ||
+      (guint64) st.st_size > G_MAXSIZE)
+    {
+      return;
+    }
+
+  data = mmap (NULL, st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE,
+               self->i, 0);
+
+  if (data == MAP_FAILED)
+    {
+      GEGL_NOTE (GEGL_DEBUG_TILE_BACKEND, "unable to map %s: %s", self->path, g_strerror (errno));
+
+      return;
+    }
+
+  mapping            = g_slice_new (GeglFileBackendMapping);
+  mapping->ref_count = 1;
+  mapping->data      = data;
+  mapping->size      = st.st_size;
+
+  self->mapping = mapping;
+
+  GEGL_NOTE (GEGL_DEBUG_TILE_BACKEND, "mapped %s (%i bytes)", self->path, (gint) mapping->size);
+}
+
+static void
+gegl_tile_backend_file_mapping_unref (gpointer data)
+{
+  GeglFileBackendMapping *mapping = data;
+
+  if (g_atomic_int_dec_and_test (&mapping->ref_count))
+    {
+      munmap (mapping->data, mapping->size);
+
+      g_slice_free (GeglFileBackendMapping, mapping);
+    }
+}
+
+#endif
+
+static void
+gegl_tile_backend_file_unmap (GeglTileBackendFile *self)
+{
+#ifdef HAVE_MMAP
+  if (self->mapping)
+    {
+      gegl_tile_backend_file_mapping_unref (self->mapping);
+
+      self->mapping = NULL;
+    }
+#endif
+}
+
+/* whether the data of a newly-loaded entry can be handed out directly from the
+ * mapping
+ */
+static gboolean
+gegl_tile_backend_file_can_map (GeglTileBackendFile  *self,
+                                const GeglBufferTile *tile)
+{
+  gint tile_size;
+
+  if (! self->mapping)
+    return FALSE;
+
+  tile_size = gegl_tile_backend_get_tile_size (GEGL_TILE_BACKEND (self));
+
+  return tile->offset % GEGL_ALIGNMENT == 0 &&
+         tile->offset + tile_size <= self->mapping->size;
+}
+
 static inline GeglFileBackendEntry *
 gegl_tile_backend_file_lookup_entry (GeglTileBackendFile *self,
                                      gint                 x,
@@ -707,6 +829,32 @@ gegl_tile_backend_file_get_tile (GeglTileSource *self,
     return NULL;
 
   tile_size = gegl_tile_backend_get_tile_size (GEGL_TILE_BACKEND (self));
+
+#ifdef HAVE_MMAP
+  if (tile_backend_file->mapping && entry->mapped)
+    {
+      GeglFileBackendMapping *mapping = tile_backend_file->mapping;
+
+      /* hand out a tile pointing directly into the mapping.  the mapping is
+       * private, so writing to the tile only affects the tile itself.
+       */
+      g_atomic_int_inc (&mapping->ref_count);
+
+      tile = gegl_tile_new_bare ();
+      gegl_tile_set_data_full (tile,
+                               mapping->data + entry->tile->offset,
+                               tile_size,
+                               gegl_tile_backend_file_mapping_unref,
+                               mapping);
+      gegl_tile_set_rev (tile, entry->tile->rev);
+      gegl_tile_mark_as_stored (tile);
+
+      GEGL_NOTE (GEGL_DEBUG_TILE_BACKEND, "mapped entry %i,%i,%i at %i", entry->tile->x, entry->tile->y, entry->tile->z, (gint)entry->tile->offset);
+
+      return tile;
+    }
+#endif
+
   tile      = gegl_tile_new (tile_size);
   gegl_tile_set_rev (tile, entry->tile->rev);
   gegl_tile_mark_as_stored (tile);
@@ -738,6 +886,14 @@ gegl_tile_backend_file_set_tile (GeglTileSource *self,
       entry->tile->z = z;
       g_hash_table_insert (tile_backend_file->index, entry, entry);
     }
+  else if (entry->mapped)
+    {
+      /* the entry's data might still be referenced by mapped tiles, so don't
+       * overwrite it in place, and write the tile to a new offset instead.
+       */
+      entry->tile->offset = gegl_tile_backend_file_alloc_offset (tile_backend_file);
+      entry->mapped       = FALSE;
+    }
   entry->tile->rev = gegl_tile_get_rev (tile);
 
   gegl_tile_backend_file_entry_write (tile_backend_file, entry, gegl_tile_get_data (tile));
@@ -969,6 +1125,11 @@ gegl_tile_backend_file_finalize (GObject *object)
         }
     }
 
+  /* tiles handed out from the mapping keep it alive, until they're
+   * destroyed.
+   */
+  gegl_tile_backend_file_unmap (self);
+
   if (self->free_list)
     gegl_tile_backend_file_free_free_list (self);
 
@@ -1070,6 +1231,14 @@ gegl_tile_backend_file_load_index (GeglTileBackendFile *self,
       GEGL_NOTE(GEGL_DEBUG_TILE_BACKEND, "loading index: %s", self->path);
     }
 
+  /* if the file was modified by someone else, stop handing out tiles from the
+   * mapping, since it doesn't necessarily reflect the new contents.  the
+   * existing entries remain marked as mapped, so that we don't overwrite the
+   * data of the tiles already handed out.
+   */
+  if (self->exist)
+    gegl_tile_backend_file_unmap (self);
+
   tile_size       = gegl_tile_backend_get_tile_size (GEGL_TILE_BACKEND (self));
   offset          = self->header.next;
   self->tiles     = gegl_buffer_read_index (self->i, &offset);
@@ -1121,7 +1290,9 @@ gegl_tile_backend_file_load_index (GeglTileBackendFile *self,
             }
         }
       new = gegl_tile_backend_file_file_entry_create (0, 0, 0);
-      new->tile = iter->data;
+      g_free (new->tile);
+      new->tile   = iter->data;
+      new->mapped = gegl_tile_backend_file_can_map (self, new->tile);
       g_hash_table_insert (self->index, new, new);
     }
   g_list_free (self->tiles);
@@ -1209,6 +1380,10 @@ gegl_tile_backend_file_constructed (GObject *object)
                                                     self->header.width,
                                                     self->header.height};
 
+#ifdef HAVE_MMAP
+      gegl_tile_backend_file_map (self);
+#endif
+
       /* insert each of the entries into the hash table */
       gegl_tile_backend_file_load_index (self, TRUE);
       self->exist = TRUE;
@@ -1306,6 +1481,7 @@ gegl_tile_backend_file_init (GeglTileBackendFile *self)
   self->next_pre_alloc             = 256; /* reserved space for header */
   self->total                      = 256; /* reserved space for header */
   self->pending_ops                = 0;
+  self->mapping                    = NULL;
 }
 
 gboolean
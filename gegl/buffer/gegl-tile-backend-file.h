@@ -54,6 +54,9 @@ typedef struct
      tile data or a GeglBufferBlock*/
   GList          *tile_link;
   GList          *block_link;
+  /* whether the tile data might be referenced by tiles mapped from the
+     file, in which case it must not be overwritten in place */
+  gboolean        mapped;
 } GeglFileBackendEntry;
 
 typedef struct
@@ -42,6 +42,7 @@
 #include "gegl-tile-backend-swap.h"
 #include "gegl-tile-handler-empty.h"
 #include "gegl-debug.h"
+#include "gegl-instrument.h"
 #include "gegl-buffer-config.h"
 
 
@@ -71,6 +72,12 @@
  */
 #define COMPRESSION_MAX_RATIO 0.95
 
+/* maximal data size of prefetched tiles that haven't been requested yet, as a
+ * factor of the maximal cache size.  when the amount of prefetched data reaches
+ * this limit, the oldest prefetched tiles are dropped.
+ */
+#define PREFETCHED_MAX_RATIO 0.05
+
 
 G_DEFINE_TYPE (GeglTileBackendSwap, gegl_tile_backend_swap, GEGL_TYPE_TILE_BACKEND)
 
@@ -90,6 +97,9 @@ typedef struct
   const GeglCompression *compression;
   GList                 *link;
   gint64                 offset;
+  GList                 *prefetch_link;
+  GeglTile              *prefetched;
+  GList                 *prefetched_link;
 } SwapBlock;
 
 typedef struct
@@ -111,6 +121,13 @@ typedef struct
   ThreadOp    operation;
 } ThreadParams;
 
+typedef struct
+{
+  SwapBlock  *block;
+  const Babl *format;
+  gint        size;
+} SwapPrefetch;
+
 typedef struct _SwapGap
 {
   gint64           start;
@@ -145,6 +162,14 @@ static gint        gegl_tile_backend_swap_get_data_cost          (ThreadParams
 static void        gegl_tile_backend_swap_free_data              (ThreadParams              *params);
 static void        gegl_tile_backend_swap_write                  (ThreadParams              *params);
 static void        gegl_tile_backend_swap_destroy                (ThreadParams              *params);
+static gboolean    gegl_tile_backend_swap_read                   (gint64                     offset,
+                                                                  gint                       size,
+                                                                  const GeglCompression     *block_compression,
+                                                                  const Babl                *format,
+                                                                  guint8                    *dest,
+                                                                  gint                       tile_size);
+static void        gegl_tile_backend_swap_prefetch               (SwapPrefetch              *prefetch);
+static void        gegl_tile_backend_swap_drop_prefetched        (SwapBlock                 *block);
 static gpointer    gegl_tile_backend_swap_writer_thread          (gpointer ignored);
 static GeglTile   *gegl_tile_backend_swap_entry_read             (GeglTileBackendSwap       *self,
                                                                   SwapEntry                 *entry);
@@ -153,6 +178,7 @@ static void        gegl_tile_backend_swap_entry_write            (GeglTileBacken
                                                                   GeglTile                  *tile);
 static SwapBlock * gegl_tile_backend_swap_block_create           (void);
 static void        gegl_tile_backend_swap_block_free             (SwapBlock                 *block);
+static void        gegl_tile_backend_swap_block_cancel_prefetch  (SwapBlock                 *block);
 static SwapBlock * gegl_tile_backend_swap_block_ref              (SwapBlock                 *block,
                                                                   gint                       tile_size);
 static void        gegl_tile_backend_swap_block_unref            (SwapBlock                 *block,
@@ -195,6 +221,10 @@ static gpointer    gegl_tile_backend_swap_copy_tile              (GeglTileSource
                                                                   gint                       y,
                                                                   gint                       z,
                                                                   const GeglTileCopyParams  *params);
+static gpointer    gegl_tile_backend_swap_prefetch_tile          (GeglTileSource            *self,
+                                                                  gint                       x,
+                                                                  gint                       y,
+                                                                  gint                       z);
 static gpointer    gegl_tile_backend_swap_command                (GeglTileSource            *self,
                                                                   GeglTileCommand            command,
                                                                   gint                       x,
@@ -235,6 +265,9 @@ static gint64                 queued_total       = 0;
 static gint64                 queued_cost        = 0;
 static gint64                 queued_max         = 0;
 static gint                   queue_stalls       = 0;
+static gint64                 prefetched_total   = 0;
+static gint64                 prefetched_max     = 0;
+static gint                   prefetch_hits      = 0;
 
 static GThread      *writer_thread           = NULL;
 static GQueue       *queue                   = NULL;
@@ -246,6 +279,11 @@ static GMutex        read_mutex;
 static GMutex        queue_mutex;
 static GCond         queue_cond;
 static GCond         push_cond;
+static GQueue       *prefetch_queue          = NULL;
+static GQueue       *prefetched_queue        = NULL;
+static SwapBlock    *prefetch_in_progress    = NULL;
+static gboolean      prefetch_cancelled      = FALSE;
+static GCond         prefetch_cond;
 
 
 static void
@@ -558,6 +596,11 @@ gegl_tile_backend_swap_write (ThreadParams *params)
   const guint8 *data;
   gint64        offset = params->block->offset;
   gint          to_be_written;
+  gint          size;
+  long          trace_start = 0;
+
+  if (gegl_instrument_trace_enabled)
+    trace_start = gegl_ticks ();
 
   gegl_tile_backend_swap_ensure_exist ();
 
@@ -624,6 +667,8 @@ gegl_tile_backend_swap_write (ThreadParams *params)
 
   writing = TRUE;
 
+  size = to_be_written;
+
   if (out_offset != offset)
     {
       if (lseek (out_fd, offset, SEEK_SET) < 0)
@@ -657,6 +702,11 @@ gegl_tile_backend_swap_write (ThreadParams *params)
 
   writing = FALSE;
 
+  gegl_instrument_trace ("swap", "write", trace_start, gegl_ticks (),
+                         "\"offset\":%" G_GINT64_FORMAT ",\"bytes\":%d,"
+                         "\"uncompressed-bytes\":%d",
+                         offset, size, params->size);
+
   GEGL_NOTE (GEGL_DEBUG_TILE_BACKEND, "writer thread wrote at %i", (gint)offset);
 
   return;
@@ -691,7 +741,9 @@ gegl_tile_backend_swap_writer_thread (gpointer ignored)
     {
       ThreadParams *params;
 
-      while (g_queue_is_empty (queue) && !exit_thread)
+      while (g_queue_is_empty (queue)          &&
+             g_queue_is_empty (prefetch_queue) &&
+             !exit_thread)
         {
           busy = FALSE;
 
@@ -701,6 +753,22 @@ gegl_tile_backend_swap_writer_thread (gpointer ignored)
       if (exit_thread)
         break;
 
+      /* serve prefetch requests first, since a render thread is likely to
+       * block on the corresponding tiles soon.
+       */
+      if (! g_queue_is_empty (prefetch_queue))
+        {
+          SwapPrefetch *prefetch = g_queue_pop_head (prefetch_queue);
+
+          prefetch->block->prefetch_link = NULL;
+
+          gegl_tile_backend_swap_prefetch (prefetch);
+
+          g_slice_free (SwapPrefetch, prefetch);
+
+          continue;
+        }
+
       params = (ThreadParams *)g_queue_pop_head (queue);
       if (params->block)
         {
@@ -734,6 +802,184 @@ gegl_tile_backend_swap_writer_thread (gpointer ignored)
   return NULL;
 }
 
+/* reads a block of the given offset and size from the swap into dest,
+ * decompressing it if necessary.  called without holding the queue mutex.
+ */
+static gboolean
+gegl_tile_backend_swap_read (gint64                 offset,
+                             gint                   size,
+                             const GeglCompression *block_compression,
+                             const Babl            *format,
+                             guint8                *dest,
+                             gint                   tile_size)
+{
+  guint8 *data;
+  gint    to_be_read;
+  long    trace_start = 0;
+
+  if (gegl_instrument_trace_enabled)
+    trace_start = gegl_ticks ();
+
+  if (block_compression)
+    data = gegl_scratch_alloc (size);
+  else
+    data = dest;
+
+  g_mutex_lock (&read_mutex);
+
+  reading = TRUE;
+
+  if (in_offset != offset)
+    {
+      if (lseek (in_fd, offset, SEEK_SET) < 0)
+        {
+          reading = FALSE;
+
+          g_mutex_unlock (&read_mutex);
+
+          if (block_compression)
+            gegl_scratch_free (data);
+
+          g_warning ("unable to seek to tile in buffer: %s", g_strerror (errno));
+          return FALSE;
+        }
+      in_offset = offset;
+    }
+
+  to_be_read = size;
+
+  while (to_be_read > 0)
+    {
+      gint bytes_read;
+
+      bytes_read = read (in_fd, data + size - to_be_read, to_be_read);
+
+      if (bytes_read <= 0)
+        {
+          reading = FALSE;
+
+          g_mutex_unlock (&read_mutex);
+
+          if (block_compression)
+            gegl_scratch_free (data);
+
+          g_message ("unable to read tile data from swap: "
+                     "%s (%d/%d bytes read)",
+                     g_strerror (errno), bytes_read, to_be_read);
+          return FALSE;
+        }
+
+      to_be_read -= bytes_read;
+      in_offset  += bytes_read;
+
+      read_total += bytes_read;
+    }
+
+  reading = FALSE;
+
+  g_mutex_unlock (&read_mutex);
+
+  if (block_compression)
+    {
+      gint bpp = babl_format_get_bytes_per_pixel (format);
+
+      if (! gegl_compression_decompress (
+              block_compression, format,
+              dest, tile_size / bpp,
+              data, size))
+        {
+          g_warning ("failed to decompress tile");
+        }
+
+      gegl_scratch_free (data);
+    }
+
+  gegl_instrument_trace ("swap", "read", trace_start, gegl_ticks (),
+                         "\"offset\":%" G_GINT64_FORMAT ",\"bytes\":%d,"
+                         "\"uncompressed-bytes\":%d",
+                         offset, size, tile_size);
+
+  return TRUE;
+}
+
+/* called by the writer thread, with the queue mutex held, to read a block
+ * ahead of time.  the mutex is released while reading the data.
+ */
+static void
+gegl_tile_backend_swap_prefetch (SwapPrefetch *prefetch)
+{
+  SwapBlock             *block = prefetch->block;
+  const GeglCompression *block_compression;
+  GeglTile              *tile;
+  gint64                 offset;
+  gint                   size;
+  gboolean               success;
+
+  /* if the block has a pending write, or is already prefetched, the tile data
+   * is available without reading the swap
+   */
+  if (block->link || block->prefetched || block->offset < 0 || in_fd < 0)
+    return;
+
+  offset            = block->offset;
+  size              = block->size;
+  block_compression = block->compression;
+
+  prefetch_in_progress = block;
+  prefetch_cancelled   = FALSE;
+
+  g_mutex_unlock (&queue_mutex);
+
+  tile = gegl_tile_new (prefetch->size);
+
+  success = gegl_tile_backend_swap_read (offset, size, block_compression,
+                                         prefetch->format,
+                                         gegl_tile_get_data (tile),
+                                         prefetch->size);
+
+  g_mutex_lock (&queue_mutex);
+
+  /* the block might have been modified, or destroyed, in the meantime */
+  if (success && ! prefetch_cancelled)
+    {
+      block->prefetched = tile;
+
+      g_queue_push_tail (prefetched_queue, block);
+      block->prefetched_link = g_queue_peek_tail_link (prefetched_queue);
+
+      prefetched_total += prefetch->size;
+
+      while (prefetched_total > prefetched_max)
+        {
+          gegl_tile_backend_swap_drop_prefetched (
+            g_queue_peek_head (prefetched_queue));
+        }
+
+      GEGL_NOTE (GEGL_DEBUG_TILE_BACKEND, "prefetched block at %i", (gint) offset);
+    }
+  else
+    {
+      gegl_tile_unref (tile);
+    }
+
+  prefetch_in_progress = NULL;
+
+  g_cond_broadcast (&prefetch_cond);
+}
+
+/* must be called with the queue mutex held */
+static void
+gegl_tile_backend_swap_drop_prefetched (SwapBlock *block)
+{
+  g_queue_delete_link (prefetched_queue, block->prefetched_link);
+  block->prefetched_link = NULL;
+
+  prefetched_total -= block->prefetched->size;
+
+  gegl_tile_unref (block->prefetched);
+  block->prefetched = NULL;
+}
+
 static GeglTile *
 gegl_tile_backend_swap_entry_read (GeglTileBackendSwap *self,
                                    SwapEntry           *entry)
@@ -741,12 +987,10 @@ gegl_tile_backend_swap_entry_read (GeglTileBackendSwap *self,
   GeglTileBackend *backend = GEGL_TILE_BACKEND (self);
   const Babl      *format;
   GeglTile        *tile;
-  guint8          *data;
   guint8          *dest;
   gint64           offset;
   gint             tile_size;
   gint             bpp;
-  gint             to_be_read;
 
   format    = gegl_tile_backend_get_format (backend);
   tile_size = gegl_tile_backend_get_tile_size (backend);
@@ -802,93 +1046,56 @@ gegl_tile_backend_swap_entry_read (GeglTileBackendSwap *self,
         }
     }
 
-  offset = entry->block->offset;
-
-  g_mutex_unlock (&queue_mutex);
+  /* wait for an in-progress prefetch of the block to finish, instead of
+   * reading it a second time
+   */
+  while (prefetch_in_progress == entry->block)
+    g_cond_wait (&prefetch_cond, &queue_mutex);
 
-  if (offset < 0 || in_fd < 0)
+  if (entry->block->prefetched)
     {
-      g_warning ("no swap storage allocated for tile");
-      return NULL;
-    }
-
-  tile = gegl_tile_new (tile_size);
-  dest = gegl_tile_get_data (tile);
-  gegl_tile_mark_as_stored (tile);
+      tile = entry->block->prefetched;
 
-  if (entry->block->compression)
-    data = gegl_scratch_alloc (entry->block->size);
-  else
-    data = dest;
+      g_queue_delete_link (prefetched_queue, entry->block->prefetched_link);
+      entry->block->prefetched_link = NULL;
+      entry->block->prefetched      = NULL;
 
-  g_mutex_lock (&read_mutex);
+      prefetched_total -= tile->size;
+      prefetch_hits++;
 
-  reading = TRUE;
+      g_mutex_unlock (&queue_mutex);
 
-  if (in_offset != offset)
-    {
-      if (lseek (in_fd, offset, SEEK_SET) < 0)
-        {
-          reading = FALSE;
+      gegl_tile_mark_as_stored (tile);
 
-          g_mutex_unlock (&read_mutex);
+      GEGL_NOTE(GEGL_DEBUG_TILE_BACKEND, "read entry %i, %i, %i from prefetched data", entry->x, entry->y, entry->z);
 
-          g_warning ("unable to seek to tile in buffer: %s", g_strerror (errno));
-          return tile;
-        }
-      in_offset = offset;
+      return tile;
     }
 
-  to_be_read = entry->block->size;
-
-  while (to_be_read > 0)
-    {
-      GError *error = NULL;
-      gint    bytes_read;
-
-      bytes_read = read (in_fd,
-                         data + entry->block->size - to_be_read, to_be_read);
-
-      if (bytes_read <= 0)
-        {
-          reading = FALSE;
-
-          g_mutex_unlock (&read_mutex);
-
-          if (entry->block->compression)
-            gegl_scratch_free (data);
+  /* we're about to read the block ourselves */
+  gegl_tile_backend_swap_block_cancel_prefetch (entry->block);
 
-          g_message ("unable to read tile data from swap: "
-                     "%s (%d/%d bytes read) %s",
-                     g_strerror (errno), bytes_read, to_be_read, error?error->message:"--");
-          return tile;
-        }
+  offset = entry->block->offset;
 
-      to_be_read -= bytes_read;
-      in_offset  += bytes_read;
+  g_mutex_unlock (&queue_mutex);
 
-      read_total += bytes_read;
+  if (offset < 0 || in_fd < 0)
+    {
+      g_warning ("no swap storage allocated for tile");
+      return NULL;
     }
 
-  reading = FALSE;
-
-  g_mutex_unlock (&read_mutex);
+  tile = gegl_tile_new (tile_size);
+  dest = gegl_tile_get_data (tile);
+  gegl_tile_mark_as_stored (tile);
 
-  if (entry->block->compression)
+  if (gegl_tile_backend_swap_read (offset, entry->block->size,
+                                   entry->block->compression, format,
+                                   dest, tile_size))
     {
-      if (! gegl_compression_decompress (
-              entry->block->compression, format,
-              dest, tile_size / bpp,
-              data, entry->block->size))
-        {
-          g_warning ("failed to decompress tile");
-        }
-
-      gegl_scratch_free (data);
+      GEGL_NOTE(GEGL_DEBUG_TILE_BACKEND, "read entry %i, %i, %i from %i", entry->x, entry->y, entry->z, (gint)offset);
     }
 
-  GEGL_NOTE(GEGL_DEBUG_TILE_BACKEND, "read entry %i, %i, %i from %i", entry->x, entry->y, entry->z, (gint)offset);
-
   return tile;
 }
 
@@ -909,6 +1116,9 @@ gegl_tile_backend_swap_entry_write (GeglTileBackendSwap *self,
 
   g_mutex_lock (&queue_mutex);
 
+  /* any prefetched data is about to become stale */
+  gegl_tile_backend_swap_block_cancel_prefetch (entry->block);
+
   if (entry->block->link)
     {
       params = entry->block->link->data;
@@ -962,9 +1172,12 @@ gegl_tile_backend_swap_block_create (void)
 {
   SwapBlock *block = g_slice_new (SwapBlock);
 
-  block->ref_count = 1;
-  block->link      = NULL;
-  block->offset    = -1;
+  block->ref_count       = 1;
+  block->link            = NULL;
+  block->offset          = -1;
+  block->prefetch_link   = NULL;
+  block->prefetched      = NULL;
+  block->prefetched_link = NULL;
 
   return block;
 }
@@ -977,6 +1190,29 @@ gegl_tile_backend_swap_block_free (SwapBlock *block)
   g_slice_free (SwapBlock, block);
 }
 
+/* cancels any pending prefetch of the block, and drops any prefetched data.
+ * must be called with the queue mutex held.
+ */
+static void
+gegl_tile_backend_swap_block_cancel_prefetch (SwapBlock *block)
+{
+  if (block->prefetch_link)
+    {
+      SwapPrefetch *prefetch = block->prefetch_link->data;
+
+      g_queue_delete_link (prefetch_queue, block->prefetch_link);
+      block->prefetch_link = NULL;
+
+      g_slice_free (SwapPrefetch, prefetch);
+    }
+
+  if (prefetch_in_progress == block)
+    prefetch_cancelled = TRUE;
+
+  if (block->prefetched)
+    gegl_tile_backend_swap_drop_prefetched (block);
+}
+
 static SwapBlock *
 gegl_tile_backend_swap_block_ref (SwapBlock *block,
                                   gint       tile_size)
@@ -998,6 +1234,8 @@ gegl_tile_backend_swap_block_unref (SwapBlock *block,
       if (lock)
         g_mutex_lock (&queue_mutex);
 
+      gegl_tile_backend_swap_block_cancel_prefetch (block);
+
       if (block->link)
         {
           GList        *link      = block->link;
@@ -1286,6 +1524,54 @@ gegl_tile_backend_swap_copy_tile (GeglTileSource           *self,
   return GINT_TO_POINTER (TRUE);
 }
 
+static gpointer
+gegl_tile_backend_swap_prefetch_tile (GeglTileSource *self,
+                                      gint            x,
+                                      gint            y,
+                                      gint            z)
+{
+  GeglTileBackend     *backend;
+  GeglTileBackendSwap *swap;
+  SwapEntry           *entry;
+  SwapBlock           *block;
+
+  backend = GEGL_TILE_BACKEND (self);
+  swap    = GEGL_TILE_BACKEND_SWAP (self);
+  entry   = gegl_tile_backend_swap_lookup_entry (swap, x, y, z);
+
+  if (! entry || entry->block == gegl_tile_backend_swap_empty_block ())
+    return NULL;
+
+  block = entry->block;
+
+  g_mutex_lock (&queue_mutex);
+
+  /* only prefetch blocks whose data is only available in the swap file */
+  if (! block->link                                    &&
+      ! (in_progress && in_progress->block == block)   &&
+      ! block->prefetch_link                           &&
+      ! block->prefetched                              &&
+      prefetch_in_progress != block                    &&
+      prefetched_max > 0)
+    {
+      SwapPrefetch *prefetch = g_slice_new (SwapPrefetch);
+
+      prefetch->block  = block;
+      prefetch->format = gegl_tile_backend_get_format (backend);
+      prefetch->size   = gegl_tile_backend_get_tile_size (backend);
+
+      g_queue_push_tail (prefetch_queue, prefetch);
+      block->prefetch_link = g_queue_peek_tail_link (prefetch_queue);
+
+      /* wake up the writer thread */
+      g_cond_signal (&queue_cond);
+    }
+
+  g_mutex_unlock (&queue_mutex);
+
+  return NULL;
+}
+
 static gpointer
 gegl_tile_backend_swap_command (GeglTileSource  *self,
                                 GeglTileCommand  command,
@@ -1310,6 +1596,8 @@ gegl_tile_backend_swap_command (GeglTileSource  *self,
         return NULL;
       case GEGL_TILE_COPY:
         return gegl_tile_backend_swap_copy_tile (self, x, y, z, data);
+      case GEGL_TILE_PREFETCH:
+        return gegl_tile_backend_swap_prefetch_tile (self, x, y, z);
 
       default:
         break;
@@ -1464,7 +1752,8 @@ gegl_tile_backend_swap_tile_cache_size_notify (GObject    *config,
                 "tile-cache-size", &queued_max,
                 NULL);
 
-  queued_max *= QUEUED_MAX_RATIO;
+  prefetched_max  = queued_max * PREFETCHED_MAX_RATIO;
+  queued_max     *= QUEUED_MAX_RATIO;
 
   g_cond_broadcast (&push_cond);
 
@@ -1483,7 +1772,9 @@ gegl_tile_backend_swap_class_init (GeglTileBackendSwapClass *klass)
 
   gap_tree = g_tree_new ((GCompareFunc) gegl_tile_backend_swap_gap_compare);
 
-  queue         = g_queue_new ();
+  queue            = g_queue_new ();
+  prefetch_queue   = g_queue_new ();
+  prefetched_queue = g_queue_new ();
   writer_thread = g_thread_new ("swap writer",
                                 gegl_tile_backend_swap_writer_thread,
                                 NULL);
@@ -1532,6 +1823,18 @@ gegl_tile_backend_swap_cleanup (void)
   g_queue_free (queue);
   queue = NULL;
 
+  if (g_queue_get_length (prefetch_queue)   != 0 ||
+      g_queue_get_length (prefetched_queue) != 0)
+    {
+      g_warning ("tile-backend-swap prefetch queue wasn't empty before freeing\n");
+    }
+
+  g_queue_free (prefetch_queue);
+  prefetch_queue = NULL;
+
+  g_queue_free (prefetched_queue);
+  prefetched_queue = NULL;
+
   g_clear_pointer (&compression_buffer, g_free);
   compression_buffer_size = 0;
 
@@ -1659,11 +1962,18 @@ gegl_tile_backend_swap_get_write_total (void)
   return write_total;
 }
 
+gint
+gegl_tile_backend_swap_get_prefetch_hits (void)
+{
+  return prefetch_hits;
+}
+
 void
 gegl_tile_backend_swap_reset_stats (void)
 {
   read_total  = 0;
   write_total = 0;
 
-  queue_stalls = 0;
+  queue_stalls  = 0;
+  prefetch_hits = 0;
 }
@@ -59,6 +59,7 @@ gboolean   gegl_tile_backend_swap_get_reading            (void);
 guint64    gegl_tile_backend_swap_get_read_total         (void);
 gboolean   gegl_tile_backend_swap_get_writing            (void);
 guint64    gegl_tile_backend_swap_get_write_total        (void);
+gint       gegl_tile_backend_swap_get_prefetch_hits      (void);
 
 void       gegl_tile_backend_swap_reset_stats            (void);
 
@@ -27,6 +27,7 @@
 #include "gegl-buffer-private.h"
 #include "gegl-tile-source.h"
 #include "gegl-tile-backend.h"
+#include "gegl-tile-storage.h"
 #include "gegl-buffer-config.h"
 
 G_DEFINE_TYPE_WITH_PRIVATE (GeglTileBackend, gegl_tile_backend,
@@ -319,6 +320,31 @@ gegl_tile_backend_peek_storage (GeglTileBackend *backend)
   return backend->priv->storage;
 }
 
+gboolean
+gegl_tile_backend_is_cached (GeglTileBackend *tile_backend,
+                             gint             x,
+                             gint             y,
+                             gint             z)
+{
+  GeglTileStorage *storage;
+  gboolean         cached;
+
+  g_return_val_if_fail (GEGL_IS_TILE_BACKEND (tile_backend), FALSE);
+
+  storage = tile_backend->priv->storage;
+
+  if (! storage)
+    return FALSE;
+
+  g_rec_mutex_lock (&storage->mutex);
+
+  cached = gegl_tile_source_is_cached (GEGL_TILE_SOURCE (storage), x, y, z);
+
+  g_rec_mutex_unlock (&storage->mutex);
+
+  return cached;
+}
+
 void
 gegl_tile_backend_set_flush_on_destroy (GeglTileBackend *tile_backend,
                                         gboolean         flush_on_destroy)
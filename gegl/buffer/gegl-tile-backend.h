@@ -94,6 +94,25 @@ const Babl *gegl_tile_backend_get_format    (GeglTileBackend *tile_backend);
  */
 GeglTileSource *gegl_tile_backend_peek_storage  (GeglTileBackend *tile_backend);
 
+/**
+ * gegl_tile_backend_is_cached:
+ * @tile_backend: a #GeglTileBackend
+ * @x: x coordinate of the tile
+ * @y: y coordinate of the tile
+ * @z: mipmap level of the tile
+ *
+ * Checks whether the storage that uses the backend has the tile in its
+ * cache, in which case the backend won't be asked for it.  This takes the
+ * storage lock, which is held while the backend's commands are called, so
+ * the backend must not hold any lock of its own when calling it.
+ *
+ * Return value: TRUE if the tile is cached.
+ */
+gboolean gegl_tile_backend_is_cached  (GeglTileBackend *tile_backend,
+                                       gint             x,
+                                       gint             y,
+                                       gint             z);
+
 /**
  * gegl_tile_backend_set_extent:
  * @tile_backend: a #GeglTileBackend
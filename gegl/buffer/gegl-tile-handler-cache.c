@@ -18,6 +18,8 @@
 
 #include "config.h"
 
+#include <string.h>
+
 #include <glib.h>
 #include <glib-object.h>
 
@@ -28,6 +30,7 @@
 #include "gegl-tile-handler-cache.h"
 #include "gegl-tile-storage.h"
 #include "gegl-debug.h"
+#include "gegl-instrument.h"
 
 /*
 #define GEGL_DEBUG_CACHE_HITS
@@ -37,18 +40,75 @@
 #define GEGL_CACHE_TRIM_RATIO_MIN  0.01
 #define GEGL_CACHE_TRIM_RATIO_MAX  0.50
 #define GEGL_CACHE_TRIM_RATIO_RATE 2.0
+#define GEGL_CACHE_TRIM_MAX_PASSES 4
+
+#define GEGL_CACHE_CLOCK_PRO_COLD_RATIO_INIT 0.50
+#define GEGL_CACHE_CLOCK_PRO_COLD_RATIO_MIN  0.01
+
+/* the item lists.  see the comment above GEGL_TILE_HANDLER_CACHE_N_LISTS */
+#define LIST_RECENT   0 /* ARC's T1, CLOCK-Pro's cold list */
+#define LIST_FREQUENT 1 /* ARC's T2, CLOCK-Pro's hot list  */
 
 typedef struct CacheItem
 {
-  GeglTile *tile; /* The tile */
-  GList     link; /*  Link in the cache queue, to avoid
-                   *  queue lookups involving g_list_find() */
+  GeglTile *tile;       /* The tile */
+  GList     link;       /*  Link in the cache queue, to avoid
+                         *  queue lookups involving g_list_find() */
 
-  gint      x;    /* The coordinates this tile was cached for */
+  gint      x;          /* The coordinates this tile was cached for */
   gint      y;
   gint      z;
+
+  gint      list;       /* The list the item belongs to */
+  gboolean  referenced; /* Whether the item was accessed since the last
+                         * time it was scanned (CLOCK-Pro) */
 } CacheItem;
 
+/* a ghost is the record of a recently-evicted tile, used by the adaptive
+ * policies to detect that the cache is too small for a working set.  ghosts
+ * are keyed by the serial of their cache and their tile coordinates.  they
+ * outlive their cache until trimmed, and a serial, unlike the address of
+ * the storage, is never reused by a later cache.
+ */
+typedef struct CacheGhost
+{
+  guintptr      serial;
+  gint          x;
+  gint          y;
+  gint          z;
+
+  gint          list;   /* The list the tile was evicted from */
+  gsize         size;
+  GList         link;   /* Link in the ghost queue of the list */
+} CacheGhost;
+
+/* the eviction-policy interface.  all functions are called with the storage
+ * mutex of the cache held.
+ */
+typedef struct CachePolicy
+{
+  const gchar *name;
+
+  /* returns the list a newly-inserted item should be added to */
+  gint         (* insert) (GeglTileHandlerCache *cache,
+                           CacheItem            *item);
+  /* called when an item is hit */
+  void         (* hit)    (GeglTileHandlerCache *cache,
+                           CacheItem            *item);
+  /* returns the list the next victim should be taken from */
+  gint         (* victim) (guint64               cache_size);
+  /* called for each evictable item during trimming.  returns the list the
+   * item should be moved to, to give it another chance, or -1 if the item
+   * should be evicted.
+   */
+  gint         (* scan)   (CacheItem            *item,
+                           guint64               cache_size);
+  /* called when an item is evicted, or NULL */
+  void         (* evict)  (GeglTileHandlerCache *cache,
+                           CacheItem            *item,
+                           guint64               cache_size);
+} CachePolicy;
+
 #define LINK_GET_CACHE(l) \
         ((GeglTileHandlerCache *) ((guchar *) l - G_STRUCT_OFFSET (GeglTileHandlerCache, link)))
 #define LINK_GET_ITEM(l) \
@@ -85,6 +145,61 @@ static gboolean   gegl_tile_handler_cache_copy       (GeglTileHandlerCache     *
                                                       gint                      z,
                                                       const GeglTileCopyParams *params);
 
+static gint       cache_policy_lru_insert            (GeglTileHandlerCache     *cache,
+                                                      CacheItem                *item);
+static void       cache_policy_lru_hit               (GeglTileHandlerCache     *cache,
+                                                      CacheItem                *item);
+static gint       cache_policy_lru_victim            (guint64                   cache_size);
+static gint       cache_policy_lru_scan              (CacheItem                *item,
+                                                      guint64                   cache_size);
+static void       cache_policy_ghost_evict           (GeglTileHandlerCache     *cache,
+                                                      CacheItem                *item,
+                                                      guint64                   cache_size);
+static gint       cache_policy_arc_insert            (GeglTileHandlerCache     *cache,
+                                                      CacheItem                *item);
+static void       cache_policy_arc_hit               (GeglTileHandlerCache     *cache,
+                                                      CacheItem                *item);
+static gint       cache_policy_arc_victim            (guint64                   cache_size);
+static gint       cache_policy_clock_pro_insert      (GeglTileHandlerCache     *cache,
+                                                      CacheItem                *item);
+static void       cache_policy_clock_pro_hit         (GeglTileHandlerCache     *cache,
+                                                      CacheItem                *item);
+static gint       cache_policy_clock_pro_victim      (guint64                   cache_size);
+static gint       cache_policy_clock_pro_scan        (CacheItem                *item,
+                                                      guint64                   cache_size);
+
+
+static const CachePolicy cache_policies[GEGL_TILE_CACHE_N_POLICIES] =
+{
+  [GEGL_TILE_CACHE_POLICY_LRU] =
+  {
+    .name   = "lru",
+    .insert = cache_policy_lru_insert,
+    .hit    = cache_policy_lru_hit,
+    .victim = cache_policy_lru_victim,
+    .scan   = cache_policy_lru_scan,
+    .evict  = NULL
+  },
+  [GEGL_TILE_CACHE_POLICY_ARC] =
+  {
+    .name   = "arc",
+    .insert = cache_policy_arc_insert,
+    .hit    = cache_policy_arc_hit,
+    .victim = cache_policy_arc_victim,
+    .scan   = cache_policy_lru_scan,
+    .evict  = cache_policy_ghost_evict
+  },
+  [GEGL_TILE_CACHE_POLICY_CLOCK_PRO] =
+  {
+    .name   = "clock-pro",
+    .insert = cache_policy_clock_pro_insert,
+    .hit    = cache_policy_clock_pro_hit,
+    .victim = cache_policy_clock_pro_victim,
+    .scan   = cache_policy_clock_pro_scan,
+    .evict  = cache_policy_ghost_evict
+  }
+};
+
 
 static GMutex             mutex                 = { 0, };
 static GQueue             cache_queue           = G_QUEUE_INIT;
@@ -96,6 +211,29 @@ static gint               cache_hits            = 0;
 static gint               cache_misses          = 0;
 static guintptr           cache_time            = 0;
 
+static volatile gint      cache_policy          = GEGL_TILE_CACHE_POLICY_LRU;
+static gint               cache_policy_hits[GEGL_TILE_CACHE_N_POLICIES];
+static gint               cache_policy_misses[GEGL_TILE_CACHE_N_POLICIES];
+/* approximate amount of uncloned bytes stored in each list */
+static volatile guintptr  cache_list_total[GEGL_TILE_HANDLER_CACHE_N_LISTS];
+
+/* the adaptive state of the policies, protected by policy_mutex.  no other
+ * lock may be acquired while holding policy_mutex.
+ */
+static GMutex             policy_mutex          = { 0, };
+static gdouble            policy_target         = 0.0; /* ARC's target size of
+                                                        * the recent list, or
+                                                        * CLOCK-Pro's target
+                                                        * size of the cold
+                                                        * list, as a fraction
+                                                        * of the cache size
+                                                        */
+static GHashTable        *ghosts                = NULL;
+static GQueue             ghost_queues[GEGL_TILE_HANDLER_CACHE_N_LISTS] = { G_QUEUE_INIT, G_QUEUE_INIT };
+static gsize              ghost_total[GEGL_TILE_HANDLER_CACHE_N_LISTS];
+static gint               ghost_hits            = 0;
+static guintptr           cache_serial          = 0;
+
 
 G_DEFINE_TYPE (GeglTileHandlerCache, gegl_tile_handler_cache, GEGL_TYPE_TILE_HANDLER)
 
@@ -113,11 +251,56 @@ gegl_tile_handler_cache_init (GeglTileHandlerCache *cache)
 {
   ((GeglTileSource*)cache)->command = gegl_tile_handler_cache_command;
   cache->items = g_hash_table_new (gegl_tile_handler_cache_hashfunc, gegl_tile_handler_cache_equalfunc);
-  g_queue_init (&cache->queue);
+  cache->serial = g_atomic_pointer_add (&cache_serial, 1);
+  g_queue_init (&cache->queues[LIST_RECENT]);
+  g_queue_init (&cache->queues[LIST_FREQUENT]);
 
   gegl_tile_handler_cache_connect (cache);
 }
 
+static inline gboolean
+cache_is_empty (GeglTileHandlerCache *cache)
+{
+  return g_queue_is_empty (&cache->queues[LIST_RECENT]) &&
+         g_queue_is_empty (&cache->queues[LIST_FREQUENT]);
+}
+
+static inline void
+cache_list_push (GeglTileHandlerCache *cache,
+                 CacheItem            *item,
+                 gint                  list)
+{
+  item->list = list;
+
+  g_queue_push_head_link (&cache->queues[list], &item->link);
+  g_atomic_pointer_add (&cache_list_total[list], item->tile->size);
+}
+
+static inline void
+cache_list_unlink (GeglTileHandlerCache *cache,
+                   CacheItem            *item)
+{
+  g_queue_unlink (&cache->queues[item->list], &item->link);
+  g_atomic_pointer_add (&cache_list_total[item->list], -item->tile->size);
+}
+
+static inline void
+cache_list_move (GeglTileHandlerCache *cache,
+                 CacheItem            *item,
+                 gint                  list)
+{
+  if (list == item->list)
+    {
+      g_queue_unlink (&cache->queues[list], &item->link);
+      g_queue_push_head_link (&cache->queues[list], &item->link);
+    }
+  else
+    {
+      cache_list_unlink (cache, item);
+      cache_list_push (cache, item, list);
+    }
+}
+
 static void
 drop_hot_tile (GeglTile *tile)
 {
@@ -148,11 +331,15 @@ gegl_tile_handler_cache_reinit (GeglTileHandlerCache *cache)
 
   g_hash_table_remove_all (cache->items);
 
-  while ((link = g_queue_pop_head_link (&cache->queue)))
+  while ((link = g_queue_peek_head_link (&cache->queues[LIST_RECENT])) ||
+         (link = g_queue_peek_head_link (&cache->queues[LIST_FREQUENT])))
     {
       item = LINK_GET_ITEM (link);
+      g_queue_unlink (&cache->queues[item->list], link);
       if (item->tile)
         {
+          g_atomic_pointer_add (&cache_list_total[item->list],
+                                -item->tile->size);
           if (g_atomic_int_dec_and_test (gegl_tile_n_cached_clones (item->tile)))
             g_atomic_pointer_add (&cache_total, -item->tile->size);
           g_atomic_pointer_add (&cache_total_uncloned, -item->tile->size);
@@ -198,12 +385,34 @@ gegl_tile_handler_cache_get_tile_command (GeglTileSource *tile_store,
        * needed for GeglStats.
        */
       cache_hits++;
+      cache_policy_hits[cache_policy]++;
+
+      gegl_instrument_trace ("tile-cache", "hit", gegl_ticks (), -1,
+                             "\"x\":%d,\"y\":%d,\"z\":%d", x, y, z);
+
       return tile;
     }
   cache_misses++;
+  cache_policy_misses[cache_policy]++;
 
   if (source)
-    tile = gegl_tile_source_get_tile (source, x, y, z);
+    {
+      if (gegl_instrument_trace_enabled)
+        {
+          long start = gegl_ticks ();
+
+          tile = gegl_tile_source_get_tile (source, x, y, z);
+
+          real_gegl_instrument_trace ("tile-cache", "miss",
+                                      start, gegl_ticks (),
+                                      "\"x\":%d,\"y\":%d,\"z\":%d",
+                                      x, y, z);
+        }
+      else
+        {
+          tile = gegl_tile_source_get_tile (source, x, y, z);
+        }
+    }
 
   if (tile)
     gegl_tile_handler_cache_insert (cache, tile, x, y, z);
@@ -227,18 +436,22 @@ gegl_tile_handler_cache_command (GeglTileSource  *tile_store,
       case GEGL_TILE_FLUSH:
         {
           GList *link;
+          gint   list;
 
           if (gegl_tile_handler_cache_ext_flush)
             gegl_tile_handler_cache_ext_flush (cache, NULL);
 
-          for (link = g_queue_peek_head_link (&cache->queue);
-               link;
-               link = g_list_next (link))
+          for (list = 0; list < GEGL_TILE_HANDLER_CACHE_N_LISTS; list++)
             {
-              CacheItem *item = LINK_GET_ITEM (link);
-
-              if (item->tile)
-                gegl_tile_store (item->tile);
+              for (link = g_queue_peek_head_link (&cache->queues[list]);
+                   link;
+                   link = g_list_next (link))
+                {
+                  CacheItem *item = LINK_GET_ITEM (link);
+
+                  if (item->tile)
+                    gegl_tile_store (item->tile);
+                }
             }
         }
         break;
@@ -257,6 +470,11 @@ gegl_tile_handler_cache_command (GeglTileSource  *tile_store,
             return (gpointer)TRUE;
         }
         break;
+      case GEGL_TILE_PREFETCH:
+        /* no need to prefetch tiles we already have */
+        if (gegl_tile_handler_cache_has_tile (cache, x, y, z))
+          return NULL;
+        break;
       case GEGL_TILE_IDLE:
         {
           gboolean action = gegl_tile_handler_cache_wash (cache);
@@ -400,6 +618,7 @@ gegl_tile_handler_cache_wash (GeglTileHandlerCache *cache)
   while (size < wash_size)
     {
       GList *link;
+      gint   list;
 
       cache = gegl_tile_handler_cache_find_oldest_cache (cache);
 
@@ -411,24 +630,30 @@ gegl_tile_handler_cache_wash (GeglTileHandlerCache *cache)
           continue;
         }
 
-      for (link = g_queue_peek_tail_link (&cache->queue);
-           link && size < wash_size;
-           link = g_list_previous (link))
+      /* the recent list is the first to be evicted under all policies */
+      for (list = LIST_RECENT;
+           list < GEGL_TILE_HANDLER_CACHE_N_LISTS && size < wash_size;
+           list++)
         {
-          CacheItem *item = LINK_GET_ITEM (link);
-          GeglTile  *tile = item->tile;
-
-          if (tile->tile_storage && ! gegl_tile_is_stored (tile))
+          for (link = g_queue_peek_tail_link (&cache->queues[list]);
+               link && size < wash_size;
+               link = g_list_previous (link))
             {
-              last_dirty = tile;
-              g_object_ref (last_dirty->tile_storage);
-              gegl_tile_ref (last_dirty);
+              CacheItem *item = LINK_GET_ITEM (link);
+              GeglTile  *tile = item->tile;
 
-              size = wash_size;
-              break;
-            }
+              if (tile->tile_storage && ! gegl_tile_is_stored (tile))
+                {
+                  last_dirty = tile;
+                  g_object_ref (last_dirty->tile_storage);
+                  gegl_tile_ref (last_dirty);
 
-          size += tile->size;
+                  size = wash_size;
+                  break;
+                }
+
+              size += tile->size;
+            }
         }
 
       g_rec_mutex_unlock (&cache->tile_storage->mutex);
@@ -471,14 +696,13 @@ gegl_tile_handler_cache_get_tile (GeglTileHandlerCache *cache,
 {
   CacheItem *result;
 
-  if (g_queue_is_empty (&cache->queue))
+  if (cache_is_empty (cache))
     return NULL;
 
   result = cache_lookup (cache, x, y, z);
   if (result)
     {
-      g_queue_unlink (&cache->queue, &result->link);
-      g_queue_push_head_link (&cache->queue, &result->link);
+      cache_policies[cache_policy].hit (cache, result);
       cache->time = ++cache_time;
       if (result->tile == NULL)
       {
@@ -498,33 +722,404 @@ gegl_tile_handler_cache_has_tile (GeglTileHandlerCache *cache,
                                   gint                  y,
                                   gint                  z)
 {
-  GeglTile *tile = gegl_tile_handler_cache_get_tile (cache, x, y, z);
+  /* don't count existence checks as hits, so that they don't affect the
+   * eviction policy.  in particular, prefetching checks for the existence of
+   * tiles right before fetching them, which would otherwise make tiles that
+   * are only accessed once look frequently-used.
+   */
+  return cache_lookup (cache, x, y, z) != NULL;
+}
+
+static guint
+ghost_hashfunc (gconstpointer key)
+{
+  const CacheGhost *ghost = key;
 
-  if (tile)
+  return (guint) ghost->serial ^
+         (ghost->x * 73856093u) ^
+         (ghost->y * 19349663u) ^
+         (ghost->z * 83492791u);
+}
+
+static gboolean
+ghost_equalfunc (gconstpointer a,
+                 gconstpointer b)
+{
+  const CacheGhost *ga = a;
+  const CacheGhost *gb = b;
+
+  return ga->serial == gb->serial &&
+         ga->x      == gb->x      &&
+         ga->y      == gb->y      &&
+         ga->z      == gb->z;
+}
+
+/* the following ghost functions must be called with policy_mutex held */
+
+static CacheGhost *
+ghost_lookup (GeglTileHandlerCache *cache,
+              CacheItem            *item)
+{
+  CacheGhost key;
+
+  if (! g_hash_table_size (ghosts))
+    return NULL;
+
+  key.serial = cache->serial;
+  key.x      = item->x;
+  key.y      = item->y;
+  key.z      = item->z;
+
+  return g_hash_table_lookup (ghosts, &key);
+}
+
+static void
+ghost_drop (CacheGhost *ghost)
+{
+  g_queue_unlink (&ghost_queues[ghost->list], &ghost->link);
+  ghost_total[ghost->list] -= ghost->size;
+
+  g_hash_table_remove (ghosts, ghost);
+
+  g_slice_free (CacheGhost, ghost);
+}
+
+static void
+ghost_drop_all (void)
+{
+  GList *link;
+  gint   list;
+
+  for (list = 0; list < GEGL_TILE_HANDLER_CACHE_N_LISTS; list++)
     {
-      gegl_tile_unref (tile);
-      return TRUE;
+      while ((link = g_queue_peek_tail_link (&ghost_queues[list])))
+        ghost_drop (link->data);
     }
+}
 
-  return FALSE;
+/* limit the total size of the ghosts to the size of the cache, dropping the
+ * oldest ghosts first.  following ARC, we drop ghosts of the recent list
+ * once the recent list and its ghosts fill up the cache.
+ */
+static void
+ghost_trim (guint64 cache_size)
+{
+  while (ghost_total[LIST_RECENT] + ghost_total[LIST_FREQUENT] > cache_size)
+    {
+      CacheGhost *ghost;
+      gint        list;
+
+      if (ghost_total[LIST_RECENT] &&
+          (cache_list_total[LIST_RECENT] + ghost_total[LIST_RECENT] >=
+           cache_size ||
+           ! ghost_total[LIST_FREQUENT]))
+        {
+          list = LIST_RECENT;
+        }
+      else
+        {
+          list = LIST_FREQUENT;
+        }
+
+      ghost = g_queue_peek_tail (&ghost_queues[list]);
+
+      /* for CLOCK-Pro, a ghost is a non-resident cold tile in its test
+       * period.  if the test period expires without the tile being
+       * accessed, the cold list is large enough, and we shrink it.
+       */
+      if (cache_policy == GEGL_TILE_CACHE_POLICY_CLOCK_PRO && cache_size)
+        {
+          policy_target = MAX (policy_target -
+                               (gdouble) ghost->size / cache_size,
+                               GEGL_CACHE_CLOCK_PRO_COLD_RATIO_MIN);
+        }
+
+      ghost_drop (ghost);
+    }
+}
+
+static void
+cache_policy_ghost_evict (GeglTileHandlerCache *cache,
+                          CacheItem            *item,
+                          guint64               cache_size)
+{
+  CacheGhost *ghost;
+
+  g_mutex_lock (&policy_mutex);
+
+  ghost = ghost_lookup (cache, item);
+
+  if (ghost)
+    ghost_drop (ghost);
+
+  ghost = g_slice_new (CacheGhost);
+
+  ghost->serial    = cache->serial;
+  ghost->x         = item->x;
+  ghost->y         = item->y;
+  ghost->z         = item->z;
+  ghost->list      = item->list;
+  ghost->size      = item->tile->size;
+  ghost->link.data = ghost;
+  ghost->link.next = NULL;
+  ghost->link.prev = NULL;
+
+  g_hash_table_add (ghosts, ghost);
+  g_queue_push_head_link (&ghost_queues[ghost->list], &ghost->link);
+  ghost_total[ghost->list] += ghost->size;
+
+  ghost_trim (cache_size);
+
+  g_mutex_unlock (&policy_mutex);
+}
+
+/* LRU:  a single list, ordered by recency */
+
+static gint
+cache_policy_lru_insert (GeglTileHandlerCache *cache,
+                         CacheItem            *item)
+{
+  return LIST_RECENT;
+}
+
+static void
+cache_policy_lru_hit (GeglTileHandlerCache *cache,
+                      CacheItem            *item)
+{
+  cache_list_move (cache, item, item->list);
+}
+
+static gint
+cache_policy_lru_victim (guint64 cache_size)
+{
+  return LIST_RECENT;
+}
+
+static gint
+cache_policy_lru_scan (CacheItem *item,
+                       guint64    cache_size)
+{
+  return -1;
+}
+
+/* ARC:  tiles accessed once live in the recent list, and are promoted to the
+ * frequent list when accessed again.  the target size of the recent list
+ * adapts according to hits on the ghosts of either list, so that a scan
+ * over a large buffer only ever displaces tiles of the recent list.
+ */
+
+static gint
+cache_policy_arc_insert (GeglTileHandlerCache *cache,
+                         CacheItem            *item)
+{
+  CacheGhost *ghost;
+  gint        list = LIST_RECENT;
+
+  g_mutex_lock (&policy_mutex);
+
+  ghost = ghost_lookup (cache, item);
+
+  if (ghost)
+    {
+      guint64 cache_size = gegl_buffer_config ()->tile_cache_size;
+
+      if (cache_size)
+        {
+          gint    other = LIST_FREQUENT - ghost->list;
+          gdouble delta;
+
+          delta = MAX ((gdouble) ghost_total[other] / ghost_total[ghost->list],
+                       1.0) *
+                  ghost->size / cache_size;
+
+          if (ghost->list == LIST_RECENT)
+            policy_target = MIN (policy_target + delta, 1.0);
+          else
+            policy_target = MAX (policy_target - delta, 0.0);
+        }
+
+      ghost_drop (ghost);
+      ghost_hits++;
+
+      list = LIST_FREQUENT;
+    }
+
+  g_mutex_unlock (&policy_mutex);
+
+  return list;
+}
+
+static void
+cache_policy_arc_hit (GeglTileHandlerCache *cache,
+                      CacheItem            *item)
+{
+  cache_list_move (cache, item, LIST_FREQUENT);
+}
+
+static gint
+cache_policy_arc_victim (guint64 cache_size)
+{
+  gdouble target;
+
+  g_mutex_lock (&policy_mutex);
+  target = policy_target;
+  g_mutex_unlock (&policy_mutex);
+
+  if ((guintptr) g_atomic_pointer_get (&cache_list_total[LIST_RECENT]) >
+        target * cache_size ||
+      ! g_atomic_pointer_get (&cache_list_total[LIST_FREQUENT]))
+    {
+      return LIST_RECENT;
+    }
+
+  return LIST_FREQUENT;
+}
+
+/* CLOCK-Pro:  an approximation of CLOCK-Pro, using the tail of the lists as
+ * the clock hands.  tiles start out cold, and hits only set their reference
+ * bit.  the cold hand promotes referenced cold tiles to the hot list, and
+ * evicts unreferenced ones, keeping a ghost during their test period; the hot
+ * hand demotes unreferenced hot tiles to the cold list.  the target size of
+ * the cold list grows on ghost hits, and shrinks when test periods expire.
+ */
+
+static gint
+cache_policy_clock_pro_insert (GeglTileHandlerCache *cache,
+                               CacheItem            *item)
+{
+  CacheGhost *ghost;
+  gint        list = LIST_RECENT;
+
+  g_mutex_lock (&policy_mutex);
+
+  ghost = ghost_lookup (cache, item);
+
+  if (ghost)
+    {
+      guint64 cache_size = gegl_buffer_config ()->tile_cache_size;
+
+      if (cache_size)
+        {
+          policy_target = MIN (policy_target +
+                               (gdouble) ghost->size / cache_size,
+                               1.0);
+        }
+
+      ghost_drop (ghost);
+      ghost_hits++;
+
+      list = LIST_FREQUENT;
+    }
+
+  g_mutex_unlock (&policy_mutex);
+
+  return list;
+}
+
+static void
+cache_policy_clock_pro_hit (GeglTileHandlerCache *cache,
+                            CacheItem            *item)
+{
+  item->referenced = TRUE;
+}
+
+static gint
+cache_policy_clock_pro_victim (guint64 cache_size)
+{
+  gdouble target;
+
+  g_mutex_lock (&policy_mutex);
+  target = policy_target;
+  g_mutex_unlock (&policy_mutex);
+
+  if ((guintptr) g_atomic_pointer_get (&cache_list_total[LIST_FREQUENT]) >
+      (1.0 - target) * cache_size)
+    {
+      return LIST_FREQUENT;
+    }
+
+  return LIST_RECENT;
+}
+
+static gint
+cache_policy_clock_pro_scan (CacheItem *item,
+                             guint64    cache_size)
+{
+  if (item->referenced)
+    {
+      /* promote a referenced cold tile, or give a referenced hot tile
+       * another round
+       */
+      item->referenced = FALSE;
+
+      return LIST_FREQUENT;
+    }
+  else if (item->list == LIST_FREQUENT)
+    {
+      /* demote an unreferenced hot tile */
+      return LIST_RECENT;
+    }
+
+  return -1;
+}
+
+static void
+gegl_tile_handler_cache_set_policy (const gchar *name)
+{
+  GeglTileCachePolicy policy;
+
+  for (policy = 0; policy < GEGL_TILE_CACHE_N_POLICIES; policy++)
+    {
+      if (! strcmp (name ? name : "", cache_policies[policy].name))
+        break;
+    }
+
+  if (policy == GEGL_TILE_CACHE_N_POLICIES)
+    {
+      if (name && *name)
+        g_warning ("unknown tile-cache policy '%s', using lru", name);
+
+      policy = GEGL_TILE_CACHE_POLICY_LRU;
+    }
+
+  g_mutex_lock (&policy_mutex);
+
+  cache_policy = policy;
+
+  if (policy == GEGL_TILE_CACHE_POLICY_CLOCK_PRO)
+    policy_target = GEGL_CACHE_CLOCK_PRO_COLD_RATIO_INIT;
+  else
+    policy_target = 0.0;
+
+  ghost_drop_all ();
+
+  g_mutex_unlock (&policy_mutex);
 }
 
 static gboolean
 gegl_tile_handler_cache_trim (GeglTileHandlerCache *cache)
 {
-  GList          *link;
-  gint64          time;
-  static gint64   last_time;
-  static gdouble  ratio  = GEGL_CACHE_TRIM_RATIO_MIN;
-  guint64         target_size;
-  static guint    counter;
+  const CachePolicy *policy;
+  GList             *link;
+  gint               list;
+  gint               force_list = -1;
+  gint               n_passes   = 0;
+  gboolean           moved      = FALSE;
+  gint64             time;
+  static gint64      last_time;
+  static gdouble     ratio  = GEGL_CACHE_TRIM_RATIO_MIN;
+  guint64            cache_size;
+  guint64            target_size;
+  static guint       counter;
 
   cache = NULL;
   link  = NULL;
+  list  = LIST_RECENT;
 
   g_mutex_lock (&mutex);
 
-  target_size = gegl_buffer_config ()->tile_cache_size;
+  cache_size  = gegl_buffer_config ()->tile_cache_size;
+  target_size = cache_size;
 
   if ((guintptr) g_atomic_pointer_get (&cache_total) <= target_size)
     {
@@ -549,17 +1144,31 @@ gegl_tile_handler_cache_trim (GeglTileHandlerCache *cache)
 
   g_mutex_unlock (&mutex);
 
+  policy = &cache_policies[cache_policy];
+
   while ((guintptr) g_atomic_pointer_get (&cache_total) > target_size)
     {
       CacheItem *last_writable;
       GeglTile  *tile;
       GList     *prev_link;
+      gint       victim_list;
+      gint       new_list;
 
 #ifdef GEGL_DEBUG_CACHE_HITS
       GEGL_NOTE(GEGL_DEBUG_CACHE, "cache_total:"G_GUINT64_FORMAT" > cache_size:"G_GUINT64_FORMAT, cache_total, gegl_buffer_config()->tile_cache_size);
       GEGL_NOTE(GEGL_DEBUG_CACHE, "%f%% hit:%i miss:%i  %i]", cache_hits*100.0/(cache_hits+cache_misses), cache_hits, cache_misses, g_queue_get_length (&cache_queue));
 #endif
 
+      victim_list = force_list >= 0 ? force_list : policy->victim (cache_size);
+
+      /* the policy switched lists; continue with the new list of the current
+       * cache.
+       */
+      if (link && victim_list != list)
+        link = g_queue_peek_tail_link (&cache->queues[victim_list]);
+
+      list = victim_list;
+
       if (! link)
         {
           if (cache)
@@ -585,9 +1194,35 @@ gegl_tile_handler_cache_trim (GeglTileHandlerCache *cache)
           g_mutex_unlock (&mutex);
 
           if (! cache)
-            break;
+            {
+              /* we went through all the caches.  if the policy moved tiles
+               * between the lists, some of them might be evictable now, so
+               * take another pass.  otherwise, if there are tiles in the
+               * other list, take a final pass over it, regardless of the
+               * policy.
+               */
+              if (n_passes++ < GEGL_CACHE_TRIM_MAX_PASSES)
+                {
+                  if (moved)
+                    {
+                      moved = FALSE;
+
+                      continue;
+                    }
+                  else if (force_list < 0 &&
+                           g_atomic_pointer_get (
+                             &cache_list_total[LIST_FREQUENT - list]))
+                    {
+                      force_list = LIST_FREQUENT - list;
+
+                      continue;
+                    }
+                }
+
+              break;
+            }
 
-          link = g_queue_peek_tail_link (&cache->queue);
+          link = g_queue_peek_tail_link (&cache->queues[list]);
         }
 
       for (; link; link = g_list_previous (link))
@@ -636,9 +1271,27 @@ gegl_tile_handler_cache_trim (GeglTileHandlerCache *cache)
         continue;
 
       prev_link = g_list_previous (link);
-      g_queue_unlink (&cache->queue, link);
+
+      /* give the policy a chance to keep the tile, by moving it to another
+       * list.
+       */
+      new_list = policy->scan (last_writable, cache_size);
+
+      if (new_list >= 0)
+        {
+          cache_list_move (cache, last_writable, new_list);
+          moved = TRUE;
+
+          link = prev_link;
+          continue;
+        }
+
+      if (policy->evict)
+        policy->evict (cache, last_writable, cache_size);
+
+      cache_list_unlink (cache, last_writable);
       g_hash_table_remove (cache->items, last_writable);
-      if (g_queue_is_empty (&cache->queue))
+      if (cache_is_empty (cache))
         cache->time = cache->stamp = 0;
       if (g_atomic_int_dec_and_test (gegl_tile_n_cached_clones (tile)))
         g_atomic_pointer_add (&cache_total, -tile->size);
@@ -683,10 +1336,10 @@ gegl_tile_handler_cache_invalidate (GeglTileHandlerCache *cache,
         g_atomic_pointer_add (&cache_total, -item->tile->size);
       g_atomic_pointer_add (&cache_total_uncloned, -item->tile->size);
 
-      g_queue_unlink (&cache->queue, &item->link);
+      cache_list_unlink (cache, item);
       g_hash_table_remove (cache->items, item);
 
-      if (g_queue_is_empty (&cache->queue))
+      if (cache_is_empty (cache))
         cache->time = cache->stamp = 0;
 
       drop_hot_tile (item->tile);
@@ -813,10 +1466,10 @@ gegl_tile_handler_cache_remove_item (GeglTileHandlerCache *cache,
     g_atomic_pointer_add (&cache_total, -item->tile->size);
   g_atomic_pointer_add (&cache_total_uncloned, -item->tile->size);
 
-  g_queue_unlink (&cache->queue, &item->link);
+  cache_list_unlink (cache, item);
   g_hash_table_remove (cache->items, item);
 
-  if (g_queue_is_empty (&cache->queue))
+  if (cache_is_empty (cache))
     cache->time = cache->stamp = 0;
 
   item->tile->tile_storage = NULL;
@@ -877,13 +1530,14 @@ gegl_tile_handler_cache_insert (GeglTileHandlerCache *cache,
   CacheItem *item = g_slice_new (CacheItem);
   guintptr   total;
 
-  item->tile      = gegl_tile_ref (tile);
-  item->link.data = item;
-  item->link.next = NULL;
-  item->link.prev = NULL;
-  item->x         = x;
-  item->y         = y;
-  item->z         = z;
+  item->tile       = gegl_tile_ref (tile);
+  item->link.data  = item;
+  item->link.next  = NULL;
+  item->link.prev  = NULL;
+  item->x          = x;
+  item->y          = y;
+  item->z          = z;
+  item->referenced = FALSE;
 
   // XXX : remove entry if it already exists
   gegl_tile_handler_cache_remove (cache, x, y, z);
@@ -903,7 +1557,8 @@ gegl_tile_handler_cache_insert (GeglTileHandlerCache *cache,
     total = (guintptr) g_atomic_pointer_get (&cache_total);
   g_atomic_pointer_add (&cache_total_uncloned, tile->size);
   g_hash_table_add (cache->items, item);
-  g_queue_push_head_link (&cache->queue, &item->link);
+  cache_list_push (cache, item,
+                   cache_policies[cache_policy].insert (cache, item));
 
   if (total > gegl_buffer_config ()->tile_cache_size)
     gegl_tile_handler_cache_trim (cache);
@@ -999,12 +1654,43 @@ gegl_tile_handler_cache_get_misses (void)
   return cache_misses;
 }
 
+gint
+gegl_tile_handler_cache_get_policy_hits (GeglTileCachePolicy policy)
+{
+  g_return_val_if_fail (policy < GEGL_TILE_CACHE_N_POLICIES, 0);
+
+  return cache_policy_hits[policy];
+}
+
+gint
+gegl_tile_handler_cache_get_policy_misses (GeglTileCachePolicy policy)
+{
+  g_return_val_if_fail (policy < GEGL_TILE_CACHE_N_POLICIES, 0);
+
+  return cache_policy_misses[policy];
+}
+
+gint
+gegl_tile_handler_cache_get_ghost_hits (void)
+{
+  return ghost_hits;
+}
+
 void
 gegl_tile_handler_cache_reset_stats (void)
 {
+  GeglTileCachePolicy policy;
+
   cache_total_max = cache_total;
   cache_hits      = 0;
   cache_misses    = 0;
+  ghost_hits      = 0;
+
+  for (policy = 0; policy < GEGL_TILE_CACHE_N_POLICIES; policy++)
+    {
+      cache_policy_hits[policy]   = 0;
+      cache_policy_misses[policy] = 0;
+    }
 }
 
 
@@ -1060,11 +1746,27 @@ gegl_buffer_config_tile_cache_size_notify (GObject    *gobject,
     }
 }
 
+static void
+gegl_buffer_config_tile_cache_policy_notify (GObject    *gobject,
+                                             GParamSpec *pspec,
+                                             gpointer    user_data)
+{
+  gegl_tile_handler_cache_set_policy (
+    gegl_buffer_config ()->tile_cache_policy);
+}
+
 void
 gegl_tile_cache_init (void)
 {
+  ghosts = g_hash_table_new (ghost_hashfunc, ghost_equalfunc);
+
   g_signal_connect (gegl_buffer_config (), "notify::tile-cache-size",
                     G_CALLBACK (gegl_buffer_config_tile_cache_size_notify), NULL);
+  g_signal_connect (gegl_buffer_config (), "notify::tile-cache-policy",
+                    G_CALLBACK (gegl_buffer_config_tile_cache_policy_notify), NULL);
+
+  gegl_buffer_config_tile_cache_policy_notify (
+    G_OBJECT (gegl_buffer_config ()), NULL, NULL);
 }
 
 void
@@ -1073,6 +1775,15 @@ gegl_tile_cache_destroy (void)
   g_signal_handlers_disconnect_by_func (gegl_buffer_config(),
                                         gegl_buffer_config_tile_cache_size_notify,
                                         NULL);
+  g_signal_handlers_disconnect_by_func (gegl_buffer_config(),
+                                        gegl_buffer_config_tile_cache_policy_notify,
+                                        NULL);
+
+  g_mutex_lock (&policy_mutex);
+  ghost_drop_all ();
+  g_mutex_unlock (&policy_mutex);
+
+  g_clear_pointer (&ghosts, g_hash_table_destroy);
   g_warn_if_fail (g_queue_is_empty (&cache_queue));
 
 
@@ -36,15 +36,36 @@
 typedef struct _GeglTileHandlerCache      GeglTileHandlerCache;
 typedef struct _GeglTileHandlerCacheClass GeglTileHandlerCacheClass;
 
+/* the eviction policies of the tile cache, selected using the
+ * "tile-cache-policy" config property
+ */
+typedef enum
+{
+  GEGL_TILE_CACHE_POLICY_LRU,
+  GEGL_TILE_CACHE_POLICY_ARC,
+  GEGL_TILE_CACHE_POLICY_CLOCK_PRO,
+
+  GEGL_TILE_CACHE_N_POLICIES
+} GeglTileCachePolicy;
+
+/* each cache keeps its items in two lists, whose meaning depends on the
+ * policy:  LRU only uses the first list; ARC uses the first list for
+ * recently-used items, and the second list for frequently-used items; and
+ * CLOCK-Pro uses the first list for cold items, and the second list for hot
+ * items.
+ */
+#define GEGL_TILE_HANDLER_CACHE_N_LISTS 2
+
 struct _GeglTileHandlerCache
 {
   GeglTileHandler  parent_instance;
   GeglTileStorage *tile_storage;
   GList            link;
   GHashTable      *items;
-  GQueue           queue;
+  GQueue           queues[GEGL_TILE_HANDLER_CACHE_N_LISTS];
   guintptr         time;
   guintptr         stamp;
+  guintptr         serial;
 };
 
 struct _GeglTileHandlerCacheClass
@@ -80,6 +101,9 @@ gsize             gegl_tile_handler_cache_get_total_max          (void);
 gsize             gegl_tile_handler_cache_get_total_uncompressed (void);
 gint              gegl_tile_handler_cache_get_hits               (void);
 gint              gegl_tile_handler_cache_get_misses             (void);
+gint              gegl_tile_handler_cache_get_policy_hits        (GeglTileCachePolicy policy);
+gint              gegl_tile_handler_cache_get_policy_misses      (GeglTileCachePolicy policy);
+gint              gegl_tile_handler_cache_get_ghost_hits         (void);
 
 void              gegl_tile_handler_cache_reset_stats            (void);
 
@@ -37,8 +37,9 @@ static const char *commands[] =
   "-", /*void*/
   "flush",
   "refetch",
-  "last command",
-  "eeek",
+  "reinit",
+  "copy",
+  "prefetch",
   NULL
 };
 
@@ -32,13 +32,82 @@
 #include "gegl-tile-storage.h"
 #include "gegl-buffer-private.h"
 #include "gegl-algorithms.h"
+#include "gegl-parallel.h"
 
 
 G_DEFINE_TYPE (GeglTileHandlerZoom, gegl_tile_handler_zoom,
                GEGL_TYPE_TILE_HANDLER)
 
+/* the number of tiles gegl_tile_handler_zoom_build() prepares under the
+ * storage mutex, and then renders in parallel.  this also bounds the number
+ * of lower-level tiles held at a time.
+ */
+#define BUILD_BATCH_SIZE  64
+/* the cost of an additional thread, relative to rendering a single tile */
+#define BUILD_THREAD_COST 1.0
+
+typedef struct
+{
+  gint x;
+  gint y;
+  gint z;
+} TileKey;
+
+typedef struct
+{
+  TileKey   key;
+  GeglTile *tile;
+  GeglTile *source_tile[2][2];
+  guint64   damage;
+  guint64   size;
+} RenderJob;
+
+typedef struct
+{
+  GeglTileHandlerZoom *zoom;
+  RenderJob           *jobs;
+} RenderTilesData;
+
 static guint64 total_size = 0;
 
+static guint
+tile_key_hash (const TileKey *key)
+{
+  return (key->x * 73856093) ^ (key->y * 19349663) ^ (key->z * 83492791);
+}
+
+static gboolean
+tile_key_equal (const TileKey *key1,
+                const TileKey *key2)
+{
+  return key1->x == key2->x &&
+         key1->y == key2->y &&
+         key1->z == key2->z;
+}
+
+/* waits until the tile at x,y,z, if it's being rendered by
+ * gegl_tile_handler_zoom_build(), is complete.  this is called with the
+ * storage mutex held, which the rendering never takes.
+ */
+static void
+wait_for_tile (GeglTileHandlerZoom *zoom,
+               gint                 x,
+               gint                 y,
+               gint                 z)
+{
+  TileKey key = {x, y, z};
+
+  if (! g_atomic_int_get (&zoom->n_building))
+    return;
+
+  g_mutex_lock (&zoom->build_mutex);
+
+  while (g_hash_table_contains (zoom->building, &key))
+    g_cond_wait (&zoom->build_cond, &zoom->build_mutex);
+
+  g_mutex_unlock (&zoom->build_mutex);
+}
+
 static void
 downscale (GeglTileHandlerZoom *zoom,
            const Babl          *format,
@@ -51,7 +120,8 @@ downscale (GeglTileHandlerZoom *zoom,
            gint                 width,
            gint                 height,
            guint                damage,
-           gint                 i)
+           gint                 i,
+           guint64             *size)
 {
   gint  n    = 1 << i;
   guint mask = (1 << n) - 1;
@@ -60,9 +130,6 @@ downscale (GeglTileHandlerZoom *zoom,
     {
       if (src)
         {
-          if (!zoom->downscale_2x2)
-            zoom->downscale_2x2 = gegl_downscale_2x2_get_fun (format);
-
           zoom->downscale_2x2 (format,
                                width, height,
                                src +   y      * stride +  x      * bpp, stride,
@@ -83,7 +150,7 @@ downscale (GeglTileHandlerZoom *zoom,
             }
         }
 
-      total_size += (width / 2) * (height / 2) * bpp;
+      *size += (width / 2) * (height / 2) * bpp;
     }
   else
     {
@@ -99,7 +166,7 @@ downscale (GeglTileHandlerZoom *zoom,
                          format, bpp, src, dest, stride,
                          x, y,
                          width, height / 2,
-                         damage, i);
+                         damage, i, size);
             }
           else
             {
@@ -107,7 +174,7 @@ downscale (GeglTileHandlerZoom *zoom,
                          format, bpp, src, dest, stride,
                          x, y,
                          width / 2, height,
-                         damage, i);
+                         damage, i, size);
 
             }
         }
@@ -122,7 +189,7 @@ downscale (GeglTileHandlerZoom *zoom,
                          format, bpp, src, dest, stride,
                          x, y + height / 2,
                          width, height / 2,
-                         damage, i);
+                         damage, i, size);
             }
           else
             {
@@ -130,162 +197,349 @@ downscale (GeglTileHandlerZoom *zoom,
                          format, bpp, src, dest, stride,
                          x + width / 2, y,
                          width / 2, height,
-                         damage, i);
+                         damage, i, size);
             }
         }
     }
 }
 
-static GeglTile *
-get_tile (GeglTileSource *gegl_tile_source,
-          gint            x,
-          gint            y,
-          gint            z)
+/* fetches the tile at x,y,z and, when it is missing or damaged, the tiles
+ * of the level below that it is rendered from.  returns TRUE if the tile
+ * still has to be rendered with render_tile(); otherwise job->tile is the
+ * final tile, or NULL if there is no data.
+ *
+ * must be called with the storage mutex held.
+ */
+static gboolean
+prepare_tile (GeglTileHandlerZoom *zoom,
+              gint                 x,
+              gint                 y,
+              gint                 z,
+              RenderJob           *job)
 {
-  GeglTileSource      *source = ((GeglTileHandler *) gegl_tile_source)->source;
-  GeglTileHandlerZoom *zoom   = (GeglTileHandlerZoom *) gegl_tile_source;
-  GeglTile            *tile   = NULL;
-  GeglTileStorage     *tile_storage;
-  gint                 tile_width;
-  gint                 tile_height;
+  GeglTileSource  *source = ((GeglTileHandler *) zoom)->source;
+  GeglTile        *tile   = NULL;
+  GeglTileStorage *tile_storage;
+  gint             i, j;
+  guint64          damage;
+  gboolean         empty  = TRUE;
+
+  memset (job, 0, sizeof (RenderJob));
+
+  job->key.x = x;
+  job->key.y = y;
+  job->key.z = z;
+
+  if (z > 0)
+    wait_for_tile (zoom, x, y, z);
 
   if (source)
     tile = gegl_tile_source_get_tile (source, x, y, z);
 
   if (z == 0 || (tile && ! tile->damage))
-    return tile;
+    {
+      job->tile = tile;
+
+      return FALSE;
+    }
 
   tile_storage = _gegl_tile_handler_get_tile_storage ((GeglTileHandler *) zoom);
 
   if (z > tile_storage->seen_zoom)
     tile_storage->seen_zoom = z;
 
-  tile_width = tile_storage->tile_width;
+  if (tile)
+    damage = tile->damage;
+  else
+    damage = ~(guint64) 0;
+
+  for (i = 0; i < 2; i++)
+    for (j = 0; j < 2; j++)
+      {
+        if ((damage >> (32 * j + 16 * i)) & 0xffff)
+          {
+            /* clear the tile damage region before fetching each lower-level
+             * tile, so that if this results in the corresponding portion of
+             * the pyramid being voided, our damage region never covers the
+             * entire tile, and we're not getting dropped from the cache.
+             *
+             * note that our damage region is cleared at the end of the
+             * process by gegl_tile_unlock() anyway, so clearing it here is
+             * harmless.
+             */
+            if (tile)
+              tile->damage = 0;
+
+            /* we get the tile from ourselves, to make successive rescales
+             * work correctly */
+            job->source_tile[i][j] = gegl_tile_source_get_tile (
+              (GeglTileSource *) zoom, x * 2 + i, y * 2 + j, z - 1);
+
+            if (job->source_tile[i][j])
+              {
+                if (job->source_tile[i][j]->is_zero_tile)
+                  {
+                    gegl_tile_unref (job->source_tile[i][j]);
+
+                    job->source_tile[i][j] = NULL;
+                  }
+                else
+                  {
+                    empty = FALSE;
+                  }
+              }
+          }
+        else
+          {
+            empty = FALSE;
+          }
+      }
+
+  if (empty)
+    {
+      if (tile)
+        gegl_tile_unref (tile);
+
+      return FALSE;   /* no data from level below, return NULL and let GeglTileHandlerEmpty
+                         fill in the shared empty tile */
+    }
+
+  if (! zoom->downscale_2x2)
+    {
+      zoom->downscale_2x2 = gegl_downscale_2x2_get_fun (
+        gegl_tile_backend_get_format (zoom->backend));
+    }
+
+  if (! tile)
+    tile = gegl_tile_handler_create_tile (GEGL_TILE_HANDLER (zoom), x, y, z);
+
+  /* restore the original damage mask, so that fully-damaged tiles aren't
+   * copied during uncloning.
+   */
+  tile->damage = damage;
+
+  gegl_tile_lock (tile);
+
+  job->tile   = tile;
+  job->damage = damage;
+
+  return TRUE;
+}
+
+/* renders the damaged parts of a tile prepared by prepare_tile() from the
+ * level below.  this only touches the tiles of the job, and doesn't need the
+ * storage mutex.
+ */
+static void
+render_tile (GeglTileHandlerZoom *zoom,
+             RenderJob           *job)
+{
+  GeglTileStorage *tile_storage;
+  const Babl      *format;
+  gint             tile_width;
+  gint             tile_height;
+  gint             bpp;
+  gint             stride;
+  gint             i, j;
+
+  tile_storage = _gegl_tile_handler_get_tile_storage ((GeglTileHandler *) zoom);
+
+  tile_width  = tile_storage->tile_width;
   tile_height = tile_storage->tile_height;
 
-  {
-    gint        i, j;
-    const Babl *format;
-    gint        bpp;
-    gint        stride;
-    guint64     damage;
-    GeglTile   *source_tile[2][2] = { { NULL, NULL }, { NULL, NULL } };
-    gboolean    empty             = TRUE;
-
-    if (tile)
-      damage = tile->damage;
-    else
-      damage = ~(guint64) 0;
-
-    for (i = 0; i < 2; i++)
-      for (j = 0; j < 2; j++)
-        {
-          if ((damage >> (32 * j + 16 * i)) & 0xffff)
-            {
-              /* clear the tile damage region before fetching each lower-level
-               * tile, so that if this results in the corresponding portion of
-               * the pyramid being voided, our damage region never covers the
-               * entire tile, and we're not getting dropped from the cache.
-               *
-               * note that our damage region is cleared at the end of the
-               * process by gegl_tile_unlock() anyway, so clearing it here is
-               * harmless.
-               */
-              if (tile)
-                tile->damage = 0;
-
-              /* we get the tile from ourselves, to make successive rescales
-               * work correctly */
-              source_tile[i][j] = gegl_tile_source_get_tile (
-                gegl_tile_source, x * 2 + i, y * 2 + j, z - 1);
-
-              if (source_tile[i][j])
-                {
-                  if (source_tile[i][j]->is_zero_tile)
-                    {
-                      gegl_tile_unref (source_tile[i][j]);
-
-                      source_tile[i][j] = NULL;
-                    }
-                  else
-                    {
-                      empty = FALSE;
-                    }
-                }
-            }
-          else
-            {
-              empty = FALSE;
-            }
-        }
+  format = gegl_tile_backend_get_format (zoom->backend);
+  bpp    = babl_format_get_bytes_per_pixel (format);
+  stride = tile_width * bpp;
 
-    if (empty)
+  for (i = 0; i < 2; i++)
+    for (j = 0; j < 2; j++)
       {
-        if (tile)
-          gegl_tile_unref (tile);
+        guint dmg = (job->damage >> (32 * j + 16 * i)) & 0xffff;
+
+        if (dmg)
+          {
+            gint x = i * tile_width / 2;
+            gint y = j * tile_height / 2;
+            guchar *src;
+            guchar *dest;
+
+            if (job->source_tile[i][j])
+              {
+                gegl_tile_read_lock (job->source_tile[i][j]);
+
+                src = gegl_tile_get_data (job->source_tile[i][j]);
+              }
+            else
+              {
+                src = NULL;
+              }
+
+            dest = gegl_tile_get_data (job->tile) + y * stride + x * bpp;
+
+            downscale (zoom,
+                       format, bpp, src, dest, stride,
+                       0, 0,
+                       tile_width, tile_height,
+                       dmg, 4, &job->size);
+
+            if (job->source_tile[i][j])
+              gegl_tile_read_unlock (job->source_tile[i][j]);
+          }
+      }
 
-        return NULL;   /* no data from level below, return NULL and let GeglTileHandlerEmpty
-                          fill in the shared empty tile */
+  gegl_tile_unlock (job->tile);
+}
+
+/* releases the lower-level tiles of a rendered job.  dropping the last
+ * reference to a tile may store it, which takes the storage mutex, so this
+ * is kept out of render_tile().
+ */
+static void
+release_job (RenderJob *job)
+{
+  gint i, j;
+
+  for (i = 0; i < 2; i++)
+    for (j = 0; j < 2; j++)
+      {
+        if (job->source_tile[i][j])
+          gegl_tile_unref (job->source_tile[i][j]);
       }
 
-    format = gegl_tile_backend_get_format (zoom->backend);
-    bpp    = babl_format_get_bytes_per_pixel (format);
-    stride = tile_width * bpp;
+  total_size += job->size;
+}
+
+static GeglTile *
+get_tile (GeglTileSource *gegl_tile_source,
+          gint            x,
+          gint            y,
+          gint            z)
+{
+  GeglTileHandlerZoom *zoom = (GeglTileHandlerZoom *) gegl_tile_source;
+  RenderJob            job;
+
+  if (prepare_tile (zoom, x, y, z, &job))
+    {
+      render_tile (zoom, &job);
+      release_job (&job);
+    }
+
+  return job.tile;
+}
+
+static void
+render_tiles (gsize            offset,
+              gsize            size,
+              RenderTilesData *data)
+{
+  GeglTileHandlerZoom *zoom = data->zoom;
+  gsize                i;
+
+  for (i = offset; i < offset + size; i++)
+    {
+      render_tile (zoom, &data->jobs[i]);
+
+      g_mutex_lock (&zoom->build_mutex);
+
+      g_hash_table_remove (zoom->building, &data->jobs[i].key);
+      g_atomic_int_add (&zoom->n_building, -1);
+
+      g_cond_broadcast (&zoom->build_cond);
+
+      g_mutex_unlock (&zoom->build_mutex);
+    }
+}
+
+void
+gegl_tile_handler_zoom_build (GeglTileHandlerZoom *zoom,
+                              const GeglRectangle *rect,
+                              gint                 max_z)
+{
+  GeglTileStorage *tile_storage;
+  RenderTilesData  data;
+  RenderJob        jobs[BUILD_BATCH_SIZE];
+  gint             z;
 
-    if (! tile)
-      tile = gegl_tile_handler_create_tile (GEGL_TILE_HANDLER (zoom), x, y, z);
+  g_return_if_fail (GEGL_IS_TILE_HANDLER_ZOOM (zoom));
+  g_return_if_fail (rect != NULL);
 
-    /* restore the original damage mask, so that fully-damaged tiles aren't
-     * copied during uncloning.
-     */
-    tile->damage = damage;
+  if (gegl_rectangle_is_empty (rect))
+    return;
 
-    gegl_tile_lock (tile);
+  tile_storage = _gegl_tile_handler_get_tile_storage ((GeglTileHandler *) zoom);
 
-    for (i = 0; i < 2; i++)
-      for (j = 0; j < 2; j++)
+  data.zoom = zoom;
+  data.jobs = jobs;
+
+  /* each level is built from the one below it, which is complete by then,
+   * so the tiles of a level only depend on tiles that are already cached
+   */
+  for (z = 1; z <= max_z; z++)
+    {
+      gint tile_width  = tile_storage->tile_width  << z;
+      gint tile_height = tile_storage->tile_height << z;
+      gint x1          = gegl_tile_indice (rect->x, tile_width);
+      gint y1          = gegl_tile_indice (rect->y, tile_height);
+      gint x2          = gegl_tile_indice (rect->x + rect->width  - 1,
+                                           tile_width);
+      gint y2          = gegl_tile_indice (rect->y + rect->height - 1,
+                                           tile_height);
+      gint n_columns   = x2 - x1 + 1;
+      gint n_tiles     = n_columns * (y2 - y1 + 1);
+      gint first;
+
+      for (first = 0; first < n_tiles; first += BUILD_BATCH_SIZE)
         {
-          guint dmg = (damage >> (32 * j + 16 * i)) & 0xffff;
+          gint last   = MIN (first + BUILD_BATCH_SIZE, n_tiles);
+          gint n_jobs = 0;
+          gint i;
+
+          g_rec_mutex_lock (&tile_storage->mutex);
 
-          if (dmg)
+          for (i = first; i < last; i++)
             {
-              gint x = i * tile_width / 2;
-              gint y = j * tile_height / 2;
-              guchar *src;
-              guchar *dest;
+              RenderJob *job = &jobs[n_jobs];
 
-              if (source_tile[i][j])
+              if (prepare_tile (zoom,
+                                x1 + i % n_columns, y1 + i / n_columns, z,
+                                job))
                 {
-                  gegl_tile_read_lock (source_tile[i][j]);
-
-                  src = gegl_tile_get_data (source_tile[i][j]);
+                  n_jobs++;
                 }
-              else
+              else if (job->tile)
                 {
-                  src = NULL;
+                  gegl_tile_unref (job->tile);
                 }
+            }
 
-              dest = gegl_tile_get_data (tile) + y * stride + x * bpp;
+          /* the prepared tiles are in the cache, but still have to be
+           * rendered.  mark them, so that getting them from another thread
+           * once we release the storage mutex waits for them.
+           */
+          g_mutex_lock (&zoom->build_mutex);
 
-              downscale (zoom,
-                         format, bpp, src, dest, stride,
-                         0, 0,
-                         tile_width, tile_height,
-                         dmg, 4);
+          for (i = 0; i < n_jobs; i++)
+            g_hash_table_add (zoom->building, &jobs[i].key);
 
-              if (source_tile[i][j])
-                {
-                  gegl_tile_read_unlock (source_tile[i][j]);
+          g_atomic_int_add (&zoom->n_building, n_jobs);
 
-                  gegl_tile_unref (source_tile[i][j]);
-                }
-            }
-        }
+          g_mutex_unlock (&zoom->build_mutex);
+
+          g_rec_mutex_unlock (&tile_storage->mutex);
+
+          gegl_parallel_distribute_range (
+            n_jobs, BUILD_THREAD_COST,
+            (GeglParallelDistributeRangeFunc) render_tiles,
+            &data);
 
-    gegl_tile_unlock (tile);
-  }
+          for (i = 0; i < n_jobs; i++)
+            {
+              release_job (&jobs[i]);
 
-  return tile;
+              gegl_tile_unref (jobs[i].tile);
+            }
+        }
+    }
 }
 
 static gpointer
@@ -300,19 +554,47 @@ gegl_tile_handler_zoom_command (GeglTileSource  *tile_store,
 
   if (command == GEGL_TILE_GET)
     return get_tile (tile_store, x, y, z);
-  else
-    return gegl_tile_handler_source_command (handler, command, x, y, z, data);
+
+  /* don't let a tile being built lose the damage, when its rendering
+   * finishes.
+   */
+  if (command == GEGL_TILE_VOID && z > 0)
+    wait_for_tile ((GeglTileHandlerZoom *) tile_store, x, y, z);
+
+  return gegl_tile_handler_source_command (handler, command, x, y, z, data);
+}
+
+static void
+gegl_tile_handler_zoom_finalize (GObject *object)
+{
+  GeglTileHandlerZoom *zoom = GEGL_TILE_HANDLER_ZOOM (object);
+
+  g_hash_table_unref (zoom->building);
+
+  g_cond_clear (&zoom->build_cond);
+  g_mutex_clear (&zoom->build_mutex);
+
+  G_OBJECT_CLASS (gegl_tile_handler_zoom_parent_class)->finalize (object);
 }
 
 static void
 gegl_tile_handler_zoom_class_init (GeglTileHandlerZoomClass *klass)
 {
+  GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
+
+  gobject_class->finalize = gegl_tile_handler_zoom_finalize;
 }
 
 static void
 gegl_tile_handler_zoom_init (GeglTileHandlerZoom *self)
 {
   ((GeglTileSource *) self)->command = gegl_tile_handler_zoom_command;
+
+  g_mutex_init (&self->build_mutex);
+  g_cond_init (&self->build_cond);
+
+  self->building = g_hash_table_new ((GHashFunc) tile_key_hash,
+                                     (GEqualFunc) tile_key_equal);
 }
 
 GeglTileHandler *
@@ -53,6 +53,14 @@ struct _GeglTileHandlerZoom
   GeglTileBackend      *backend;
   GeglTileStorage      *tile_storage;
   GeglDownscale2x2Fun   downscale_2x2;
+
+  /* the tiles gegl_tile_handler_zoom_build() is rendering outside of the
+   * storage mutex; getting or voiding them waits until they're done.
+   */
+  GMutex                build_mutex;
+  GCond                 build_cond;
+  GHashTable           *building;
+  gint                  n_building;
 };
 
 struct _GeglTileHandlerZoomClass
@@ -64,6 +72,13 @@ GType             gegl_tile_handler_zoom_get_type (void) G_GNUC_CONST;
 
 GeglTileHandler * gegl_tile_handler_zoom_new      (GeglTileBackend *backend);
 
+/* builds the mipmap levels 1 to max_z of rect, which is given in level-0
+ * storage coordinates, rendering the tiles of each level in parallel.
+ */
+void              gegl_tile_handler_zoom_build    (GeglTileHandlerZoom *zoom,
+                                                   const GeglRectangle *rect,
+                                                   gint                 max_z);
+
 guint64           gegl_tile_handler_zoom_get_total   (void);
 void              gegl_tile_handler_zoom_reset_stats (void);
 
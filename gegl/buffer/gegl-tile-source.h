@@ -259,6 +259,26 @@ gegl_tile_source_refetch (GeglTileSource *source,
 {
   gegl_tile_source_command (source, GEGL_TILE_REFETCH, x, y, z, NULL);
 }
+/*    INTERNAL API
+ * gegl_tile_source_prefetch:
+ * @source: a GeglTileSource *
+ * @x: x coordinate
+ * @y: y coordinate
+ * @z: tile zoom level
+ *
+ * A hint that the tile at the given coordinates is going to be requested
+ * soon.  Backends that store tiles out of memory may use it to start loading
+ * the tile in the background.  Handlers that have the tile at hand should
+ * not forward the command.
+ */
+static inline void
+gegl_tile_source_prefetch (GeglTileSource *source,
+                           gint            x,
+                           gint            y,
+                           gint            z)
+{
+  gegl_tile_source_command (source, GEGL_TILE_PREFETCH, x, y, z, NULL);
+}
 /*   INTERNAL API
  * gegl_tile_source_idle:
  * @source: a GeglTileSource *
@@ -482,6 +482,36 @@ gboolean gegl_tile_store (GeglTile *tile)
   return ret;
 }
 
+GeglTile *
+gegl_tile_ref_for_store (GeglTile *tile,
+                         gint      x,
+                         gint      y,
+                         gint      z)
+{
+  if (g_atomic_int_get (&tile->ref_count) == 0)
+    {
+      /* at this stage in gegl_tile_unref() it's still safe to duplicate the
+       * tile, which keeps its data from being freed
+       */
+      tile = gegl_tile_dup (tile);
+
+      tile->x = x;
+      tile->y = y;
+      tile->z = z;
+
+      return tile;
+    }
+
+  return gegl_tile_ref (tile);
+}
+
+void
+gegl_tile_set_damage (GeglTile *tile,
+                      guint64   damage)
+{
+  tile->damage = damage;
+}
+
 guchar *gegl_tile_get_data (GeglTile *tile)
 {
   return tile->data;
@@ -55,6 +55,23 @@ gboolean     gegl_tile_store          (GeglTile         *tile);
 void         gegl_tile_void           (GeglTile         *tile);
 GeglTile    *gegl_tile_dup            (GeglTile         *tile);
 
+/* returns a reference to a tile handed to a backend by GEGL_TILE_SET, for
+ * backends that keep the tile itself rather than a copy of its data.  when
+ * the tile is being freed, which is when gegl_tile_unref() stores it, the
+ * reference is to a duplicate of it at x, y, z instead.
+ */
+GeglTile    *gegl_tile_ref_for_store  (GeglTile         *tile,
+                                       gint              x,
+                                       gint              y,
+                                       gint              z);
+
+/* marks the parts of the tile set in damage, one bit per 1/64th of the tile,
+ * as not valid.  a backend can hand out a tile of a mipmap level it doesn't
+ * have fully damaged, to have it rendered from the level below.
+ */
+void         gegl_tile_set_damage     (GeglTile         *tile,
+                                       guint64           damage);
+
 void         gegl_tile_set_rev        (GeglTile         *tile,
                                        guint             rev);
 guint        gegl_tile_get_rev        (GeglTile         *tile);
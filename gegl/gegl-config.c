@@ -67,7 +67,11 @@ enum
   PROP_USE_OPENCL,
   PROP_QUEUE_SIZE,
   PROP_APPLICATION_LICENSE,
-  PROP_MIPMAP_RENDERING
+  PROP_MIPMAP_RENDERING,
+  PROP_SWAP_PREFETCH,
+  PROP_TILE_CACHE_POLICY,
+  PROP_TILE_ALLOC_NUMA,
+  PROP_SHARED_CACHE
 };
 
 gint _gegl_threads = 1;
@@ -130,6 +134,22 @@ gegl_config_get_property (GObject    *gobject,
         g_value_set_boolean (value, config->mipmap_rendering);
         break;
 
+      case PROP_SWAP_PREFETCH:
+        g_value_set_int (value, config->swap_prefetch);
+        break;
+
+      case PROP_TILE_CACHE_POLICY:
+        g_value_set_string (value, config->tile_cache_policy);
+        break;
+
+      case PROP_TILE_ALLOC_NUMA:
+        g_value_set_boolean (value, config->tile_alloc_numa);
+        break;
+
+      case PROP_SHARED_CACHE:
+        g_value_set_boolean (value, config->shared_cache);
+        break;
+
       default:
         G_OBJECT_WARN_INVALID_PROPERTY_ID (gobject, property_id, pspec);
         break;
@@ -181,6 +201,19 @@ gegl_config_set_property (GObject      *gobject,
       case PROP_QUEUE_SIZE:
         config->queue_size = g_value_get_int (value);
         break;
+      case PROP_SWAP_PREFETCH:
+        config->swap_prefetch = g_value_get_int (value);
+        break;
+      case PROP_TILE_CACHE_POLICY:
+        g_free (config->tile_cache_policy);
+        config->tile_cache_policy = g_value_dup_string (value);
+        break;
+      case PROP_TILE_ALLOC_NUMA:
+        config->tile_alloc_numa = g_value_get_boolean (value);
+        break;
+      case PROP_SHARED_CACHE:
+        config->shared_cache = g_value_get_boolean (value);
+        break;
       case PROP_APPLICATION_LICENSE:
         g_free (config->application_license);
         config->application_license = g_value_dup_string (value);
@@ -198,6 +231,7 @@ gegl_config_finalize (GObject *gobject)
 
   g_free (config->swap);
   g_free (config->swap_compression);
+  g_free (config->tile_cache_policy);
   g_free (config->application_license);
 
   G_OBJECT_CLASS (gegl_config_parent_class)->finalize (gobject);
@@ -394,6 +428,15 @@ gegl_config_class_init (GeglConfigClass *klass)
                                                          G_PARAM_STATIC_STRINGS |
                                                          G_PARAM_CONSTRUCT));
 
+  g_object_class_install_property (gobject_class, PROP_SHARED_CACHE,
+                                   g_param_spec_boolean ("shared-cache",
+                                                         "Shared cache",
+                                                         "Share the cached results of nodes with identical operations, properties and inputs across graphs",
+                                                         FALSE,
+                                                         G_PARAM_READWRITE |
+                                                         G_PARAM_STATIC_STRINGS |
+                                                         G_PARAM_CONSTRUCT));
+
   g_object_class_install_property (gobject_class, PROP_USE_OPENCL,
                                    g_param_spec_boolean ("use-opencl",
                                                          "Use OpenCL",
@@ -411,6 +454,30 @@ gegl_config_class_init (GeglConfigClass *klass)
                                                      G_PARAM_READWRITE |
                                                      G_PARAM_STATIC_STRINGS));
 
+  g_object_class_install_property (gobject_class, PROP_SWAP_PREFETCH,
+                                   g_param_spec_int ("swap-prefetch",
+                                                     "Swap prefetch",
+                                                     "number of tiles buffer iterators read ahead from the swap, 0 disables prefetching",
+                                                     0, G_MAXINT, 4,
+                                                     G_PARAM_READWRITE |
+                                                     G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_TILE_CACHE_POLICY,
+                                   g_param_spec_string ("tile-cache-policy",
+                                                        "Tile cache policy",
+                                                        "eviction policy of the tile cache: lru, arc or clock-pro",
+                                                        "lru",
+                                                        G_PARAM_READWRITE |
+                                                        G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_TILE_ALLOC_NUMA,
+                                   g_param_spec_boolean ("tile-alloc-numa",
+                                                         "Tile alloc NUMA",
+                                                         "allocate tile data on the NUMA node of the allocating thread, through per-thread caches",
+                                                         FALSE,
+                                                         G_PARAM_READWRITE |
+                                                         G_PARAM_STATIC_STRINGS));
+
   g_object_class_install_property (gobject_class, PROP_APPLICATION_LICENSE,
                                    g_param_spec_string ("application-license",
                                                         "Application license",
@@ -430,6 +497,9 @@ gegl_config_init (GeglConfig *self)
                          "tile-width",
                          "tile-height",
                          "tile-cache-size",
+                         "swap-prefetch",
+                         "tile-cache-policy",
+                         "tile-alloc-numa",
                          NULL};
   GeglBufferConfig *bconf = gegl_buffer_config ();
   for (int i = 0; forward_props[i]; i++)
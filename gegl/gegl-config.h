@@ -46,6 +46,10 @@ struct _GeglConfig
   gint     queue_size;
   gboolean mipmap_rendering;
   gchar   *application_license;
+  gint     swap_prefetch;
+  gchar   *tile_cache_policy;
+  gboolean tile_alloc_numa;
+  gboolean shared_cache;
 };
 
 struct _GeglConfigClass
@@ -116,11 +116,19 @@ enum
 
 enum
 {
-  ARCH_X86_INTEL_FEATURE_PNI      = 1 << 0
+  ARCH_X86_INTEL_FEATURE_PNI      = 1 << 0,
+  ARCH_X86_INTEL_FEATURE_OSXSAVE  = 1 << 27,
+  ARCH_X86_INTEL_FEATURE_AVX      = 1 << 28,
+  ARCH_X86_INTEL_FEATURE_F16C     = 1 << 29
+};
+
+enum
+{
+  ARCH_X86_INTEL_FEATURE_AVX2     = 1 << 5
 };
 
 #if !defined(ARCH_X86_64) && (defined(PIC) || defined(__PIC__))
-#define cpuid(op,eax,ebx,ecx,edx)  \
+#define cpuid_count(op,count,eax,ebx,ecx,edx) \
   __asm__ ("movl %%ebx, %%esi\n\t" \
            "cpuid\n\t"             \
            "xchgl %%ebx,%%esi"     \
@@ -128,17 +136,21 @@ enum
              "=S" (ebx),           \
              "=c" (ecx),           \
              "=d" (edx)            \
-           : "0" (op))
+           : "0" (op),             \
+             "2" (count))
 #else
-#define cpuid(op,eax,ebx,ecx,edx)  \
+#define cpuid_count(op,count,eax,ebx,ecx,edx) \
   __asm__ ("cpuid"                 \
            : "=a" (eax),           \
              "=b" (ebx),           \
              "=c" (ecx),           \
              "=d" (edx)            \
-           : "0" (op))
+           : "0" (op),             \
+             "2" (count))
 #endif
 
+#define cpuid(op,eax,ebx,ecx,edx) cpuid_count (op, 0, eax, ebx, ecx, edx)
+
 
 static X86Vendor
 arch_get_vendor (void)
@@ -215,6 +227,22 @@ arch_get_vendor (void)
   return ARCH_X86_VENDOR_UNKNOWN;
 }
 
+#ifdef USE_SSE
+static guint32
+arch_xgetbv (void)
+{
+  guint32 eax, edx;
+
+  /* xgetbv, spelled out for assemblers that don't know it */
+  __asm__ (".byte 0x0f, 0x01, 0xd0"
+           : "=a" (eax),
+             "=d" (edx)
+           : "c" (0));
+
+  return eax;
+}
+#endif /* USE_SSE */
+
 static guint32
 arch_accel_intel (void)
 {
@@ -240,6 +268,27 @@ arch_accel_intel (void)
 
     if (ecx & ARCH_X86_INTEL_FEATURE_PNI)
       caps |= GEGL_CPU_ACCEL_X86_SSE3;
+
+    /* the OS has to save the ymm registers for us to use them */
+    if ((ecx & ARCH_X86_INTEL_FEATURE_OSXSAVE) &&
+        (ecx & ARCH_X86_INTEL_FEATURE_AVX)     &&
+        (arch_xgetbv () & 0x6) == 0x6)
+      {
+        caps |= GEGL_CPU_ACCEL_X86_AVX;
+
+        if (ecx & ARCH_X86_INTEL_FEATURE_F16C)
+          caps |= GEGL_CPU_ACCEL_X86_F16C;
+
+        cpuid (0, eax, ebx, ecx, edx);
+
+        if (eax >= 7)
+          {
+            cpuid_count (7, 0, eax, ebx, ecx, edx);
+
+            if (ebx & ARCH_X86_INTEL_FEATURE_AVX2)
+              caps |= GEGL_CPU_ACCEL_X86_AVX2;
+          }
+      }
 #endif /* USE_SSE */
   }
 #endif /* USE_MMX */
@@ -406,7 +455,9 @@ arch_accel (void)
 
 #ifdef USE_SSE
   if ((caps & GEGL_CPU_ACCEL_X86_SSE) && !arch_accel_sse_os_support ())
-    caps &= ~(GEGL_CPU_ACCEL_X86_SSE | GEGL_CPU_ACCEL_X86_SSE2);
+    caps &= ~(GEGL_CPU_ACCEL_X86_SSE  | GEGL_CPU_ACCEL_X86_SSE2 |
+              GEGL_CPU_ACCEL_X86_SSE3 | GEGL_CPU_ACCEL_X86_AVX  |
+              GEGL_CPU_ACCEL_X86_AVX2 | GEGL_CPU_ACCEL_X86_F16C);
 #endif
 
   return caps;
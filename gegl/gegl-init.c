@@ -81,6 +81,7 @@ guint gegl_debug_flags = 0;
 #include "gegl-config.h"
 #include "gegl-stats.h"
 #include "graph/gegl-node-private.h"
+#include "graph/gegl-result-cache.h"
 #include "gegl-random-private.h"
 #include "gegl-parallel-private.h"
 
@@ -279,6 +280,17 @@ gegl_config_parse_env (GeglConfig *config)
         g_object_set (config, "mipmap-rendering", FALSE, NULL);
     }
 
+  if (g_getenv ("GEGL_SHARED_CACHE"))
+    {
+      const gchar *value = g_getenv ("GEGL_SHARED_CACHE");
+      if (!strcmp (value, "1")||
+          !strcmp (value, "true")||
+          !strcmp (value, "yes"))
+        g_object_set (config, "shared-cache", TRUE, NULL);
+      else
+        g_object_set (config, "shared-cache", FALSE, NULL);
+    }
+
 
   if (g_getenv ("GEGL_QUALITY"))
     {
@@ -362,6 +374,31 @@ gegl_config_parse_env (GeglConfig *config)
                     "swap-compression", g_getenv ("GEGL_SWAP_COMPRESSION"),
                     NULL);
     }
+
+  if (g_getenv ("GEGL_SWAP_PREFETCH"))
+    {
+      g_object_set (config,
+                    "swap-prefetch", atoi (g_getenv ("GEGL_SWAP_PREFETCH")),
+                    NULL);
+    }
+
+  if (g_getenv ("GEGL_TILE_CACHE_POLICY"))
+    {
+      g_object_set (config,
+                    "tile-cache-policy", g_getenv ("GEGL_TILE_CACHE_POLICY"),
+                    NULL);
+    }
+
+  if (g_getenv ("GEGL_TILE_ALLOC_NUMA"))
+    {
+      const gchar *value = g_getenv ("GEGL_TILE_ALLOC_NUMA");
+      if (!strcmp (value, "1")||
+          !strcmp (value, "true")||
+          !strcmp (value, "yes"))
+        g_object_set (config, "tile-alloc-numa", TRUE, NULL);
+      else
+        g_object_set (config, "tile-alloc-numa", FALSE, NULL);
+    }
 }
 
 GeglConfig *
@@ -402,6 +439,7 @@ gegl_exit (void)
 
   GEGL_INSTRUMENT_START()
 
+  gegl_result_cache_cleanup ();
   gegl_tile_backend_swap_cleanup ();
   gegl_tile_cache_destroy ();
   gegl_operation_gtype_cleanup ();
@@ -436,6 +474,8 @@ gegl_exit (void)
       g_printf ("\n%s", gegl_instrument_utf8 ());
     }
 
+  gegl_instrument_trace_finish ();
+
   if (gegl_buffer_leaks ())
     {
       g_printf ("EEEEeEeek! %i GeglBuffers leaked\n", gegl_buffer_leaks ());
@@ -533,6 +573,9 @@ gegl_post_parse_hook (GOptionContext *context,
   if (g_getenv ("GEGL_DEBUG_TIME") != NULL)
     gegl_instrument_enable ();
 
+  if (g_getenv ("GEGL_TRACE") != NULL)
+    gegl_instrument_trace_enable (g_getenv ("GEGL_TRACE"));
+
   gegl_instrument ("gegl", "gegl_init", 0);
 
   config = gegl_config ();
@@ -17,7 +17,11 @@
  */
 
 #include "config.h"
+#include <errno.h>
+#include <stdarg.h>
+#include <stdio.h>
 #include <glib.h>
+#include <glib/gstdio.h>
 #include <string.h>
 #include "gegl-instrument.h"
 
@@ -356,3 +360,250 @@ gegl_instrument_utf8 (void)
   g_string_free (s, TRUE);
   return ret;
 }
+
+
+typedef struct _TraceEvent  TraceEvent;
+typedef struct _TraceThread TraceThread;
+
+struct _TraceEvent
+{
+  const gchar *category; /* static string */
+  gchar       *name;
+  gchar       *args;
+  long         ts;
+  long         dur;      /* negative for instant events */
+};
+
+struct _TraceThread
+{
+  gint     tid;
+  gboolean main;
+  GArray  *events;
+};
+
+gboolean gegl_instrument_trace_enabled = FALSE;
+
+static gchar   *trace_path        = NULL;
+static GThread *trace_main_thread = NULL;
+static GMutex   trace_mutex;
+static GSList  *trace_threads     = NULL;
+static gint     trace_n_threads   = 0;
+static GPrivate trace_thread_key;
+static GPrivate trace_scope_key;
+
+/* events are recorded into per-thread arrays, so that tracing doesn't
+ * serialize the threads being traced.  the arrays are only merged when the
+ * trace is written.
+ */
+static TraceThread *
+trace_get_thread (void)
+{
+  TraceThread *thread = g_private_get (&trace_thread_key);
+
+  if (! thread)
+    {
+      thread         = g_slice_new0 (TraceThread);
+      thread->main   = g_thread_self () == trace_main_thread;
+      thread->events = g_array_new (FALSE, FALSE, sizeof (TraceEvent));
+
+      g_mutex_lock (&trace_mutex);
+
+      thread->tid   = ++trace_n_threads;
+      trace_threads = g_slist_prepend (trace_threads, thread);
+
+      g_mutex_unlock (&trace_mutex);
+
+      g_private_set (&trace_thread_key, thread);
+    }
+
+  return thread;
+}
+
+void
+gegl_instrument_trace_enable (const gchar *path)
+{
+  g_return_if_fail (path != NULL);
+
+  g_mutex_lock (&trace_mutex);
+
+  g_free (trace_path);
+  trace_path        = g_strdup (path);
+  trace_main_thread = g_thread_self ();
+
+  g_mutex_unlock (&trace_mutex);
+
+  gegl_instrument_trace_enabled = TRUE;
+}
+
+const gchar *
+gegl_instrument_trace_set_scope (const gchar *scope)
+{
+  const gchar *old_scope = g_private_get (&trace_scope_key);
+
+  g_private_set (&trace_scope_key, (gpointer) scope);
+
+  return old_scope;
+}
+
+const gchar *
+gegl_instrument_trace_get_scope (void)
+{
+  return g_private_get (&trace_scope_key);
+}
+
+void
+real_gegl_instrument_trace (const gchar *category,
+                            const gchar *name,
+                            long         start,
+                            long         end,
+                            const gchar *args_format,
+                            ...)
+{
+  TraceThread *thread = trace_get_thread ();
+  TraceEvent   event;
+
+  event.category = category;
+  event.name     = g_strdup (name);
+  event.args     = NULL;
+  event.ts       = start;
+  event.dur      = end >= 0 ? MAX (end - start, 0) : -1;
+
+  if (args_format)
+    {
+      va_list args;
+
+      va_start (args, args_format);
+      event.args = g_strdup_vprintf (args_format, args);
+      va_end (args);
+    }
+
+  g_array_append_val (thread->events, event);
+}
+
+gchar *
+gegl_instrument_trace_escape (const gchar *str)
+{
+  GString *s = g_string_sized_new (strlen (str));
+
+  for (; *str; str++)
+    {
+      switch (*str)
+        {
+        case '"':
+          g_string_append (s, "\\\"");
+          break;
+
+        case '\\':
+          g_string_append (s, "\\\\");
+          break;
+
+        default:
+          if ((guchar) *str < 0x20)
+            g_string_append_printf (s, "\\u%04x", (guchar) *str);
+          else
+            g_string_append_c (s, *str);
+          break;
+        }
+    }
+
+  return g_string_free (s, FALSE);
+}
+
+void
+gegl_instrument_trace_finish (void)
+{
+  FILE   *file;
+  GSList *iter;
+
+  if (! trace_path)
+    return;
+
+  gegl_instrument_trace_enabled = FALSE;
+
+  g_mutex_lock (&trace_mutex);
+
+  file = g_fopen (trace_path, "w");
+
+  if (! file)
+    {
+      g_warning ("unable to open trace file '%s': %s",
+                 trace_path, g_strerror (errno));
+    }
+  else
+    {
+      fputs ("{\"traceEvents\":[\n", file);
+
+      for (iter = trace_threads; iter; iter = g_slist_next (iter))
+        {
+          TraceThread *thread = iter->data;
+
+          fprintf (file,
+                   "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,"
+                   "\"tid\":%d,\"args\":{\"name\":\"%s%d\"}},\n",
+                   thread->tid,
+                   thread->main ? "main " : "thread ", thread->tid);
+        }
+
+      for (iter = trace_threads; iter; iter = g_slist_next (iter))
+        {
+          TraceThread *thread = iter->data;
+          guint        i;
+
+          for (i = 0; i < thread->events->len; i++)
+            {
+              const TraceEvent *event = &g_array_index (thread->events,
+                                                        TraceEvent, i);
+              gchar            *name;
+
+              name = gegl_instrument_trace_escape (event->name);
+
+              fprintf (file,
+                       "{\"name\":\"%s\",\"cat\":\"%s\",\"pid\":1,"
+                       "\"tid\":%d,\"ts\":%ld",
+                       name, event->category, thread->tid, event->ts);
+
+              if (event->dur >= 0)
+                fprintf (file, ",\"ph\":\"X\",\"dur\":%ld", event->dur);
+              else
+                fputs (",\"ph\":\"i\",\"s\":\"t\"", file);
+
+              if (event->args)
+                fprintf (file, ",\"args\":{%s}", event->args);
+
+              fputs ("},\n", file);
+
+              g_free (name);
+            }
+        }
+
+      /* the trailing metadata event saves us from tracking whether a comma
+       * is needed after each event.
+       */
+      fputs ("{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,"
+             "\"args\":{\"name\":\"gegl\"}}\n"
+             "],\"displayTimeUnit\":\"ms\"}\n",
+             file);
+
+      fclose (file);
+    }
+
+  for (iter = trace_threads; iter; iter = g_slist_next (iter))
+    {
+      TraceThread *thread = iter->data;
+      guint        i;
+
+      for (i = 0; i < thread->events->len; i++)
+        {
+          TraceEvent *event = &g_array_index (thread->events, TraceEvent, i);
+
+          g_free (event->name);
+          g_free (event->args);
+        }
+
+      g_array_set_size (thread->events, 0);
+    }
+
+  g_clear_pointer (&trace_path, g_free);
+
+  g_mutex_unlock (&trace_mutex);
+}
@@ -52,4 +52,44 @@ void real_gegl_instrument     (const gchar *parent,
  */
 gchar * gegl_instrument_utf8 (void);
 
+
+extern gboolean gegl_instrument_trace_enabled;
+
+/* start recording a Chrome trace-event file (viewable in chrome://tracing
+ * or Perfetto), which is written to path by gegl_instrument_trace_finish()
+ */
+void gegl_instrument_trace_enable (const gchar *path);
+
+/* write the recorded trace to disk, and stop recording */
+void gegl_instrument_trace_finish (void);
+
+/* set the name of the current thread's innermost traced scope (normally,
+ * the operation being processed), returning the previous one, so that work
+ * it hands to other threads can be attributed to it
+ */
+const gchar * gegl_instrument_trace_set_scope (const gchar *scope);
+const gchar * gegl_instrument_trace_get_scope (void);
+
+/* record an event spanning the ticks from start to end, or an instant event
+ * at start if end is negative.  args_format, if not NULL, is a printf-style
+ * format of a comma-separated list of JSON object members, attached to the
+ * event as its arguments.
+ */
+#define gegl_instrument_trace(category, name, start, end, ...) \
+  { if (gegl_instrument_trace_enabled) { \
+real_gegl_instrument_trace (category, name, start, end, __VA_ARGS__); \
+                                       } }
+
+void real_gegl_instrument_trace (const gchar *category,
+                                 const gchar *name,
+                                 long         start,
+                                 long         end,
+                                 const gchar *args_format,
+                                 ...) G_GNUC_PRINTF (5, 6);
+
+/* escape str for inclusion in a JSON string, returning a newly allocated
+ * string
+ */
+gchar * gegl_instrument_trace_escape (const gchar *str);
+
 #endif
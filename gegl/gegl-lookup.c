@@ -18,11 +18,26 @@
 
 #include "config.h"
 
+#include <math.h>
+#include <string.h>
+
 #include <glib-object.h>
 
 #include "gegl.h"
+#include "gegl-cpuaccel.h"
 #include "gegl-lookup.h"
 
+#if defined(ARCH_X86) && defined(__GNUC__)
+#define LOOKUP_SIMD 1
+#include <immintrin.h>
+#endif
+
+typedef union
+{
+  gfloat  f;
+  guint32 i;
+} GeglLookupValue;
+
 GeglLookup *
 gegl_lookup_new_full (GeglLookupFunction function,
                       gpointer           data,
@@ -159,3 +174,315 @@ gegl_lookup_free (GeglLookup *lookup)
 {
   g_free (lookup);
 }
+
+void
+gegl_lookup_build (GeglLookup *lookup)
+{
+  guint32 n_positive;
+  guint32 n_negative;
+  guint32 half;
+  guint32 i;
+
+  g_return_if_fail (lookup != NULL);
+
+  n_positive = lookup->positive_max - lookup->positive_min;
+  n_negative = lookup->negative_max - lookup->negative_min;
+
+  /* the bits below the shift, set to the middle of each entry */
+  half = lookup->shift ? 1u << (lookup->shift - 1) : 0;
+
+  for (i = 0; i < n_positive + n_negative; i++)
+    {
+      GeglLookupValue u;
+
+      if (i < n_positive)
+        u.i = i + lookup->positive_min;
+      else
+        u.i = i - n_positive + lookup->negative_min;
+
+      u.i = (u.i << lookup->shift) | half;
+
+      lookup->table[i] = lookup->function (u.f, lookup->data);
+    }
+
+  for (i = 0; i < (n_positive + n_negative + 31) / 32; i++)
+    lookup->bitmask[i] = ~0u;
+}
+
+#ifdef LOOKUP_SIMD
+
+/* looks up eight values at a time, as long as all of them are within the
+ * range of the table and already filled in, and leaves the rest to
+ * gegl_lookup().
+ */
+__attribute__ ((target ("avx2")))
+static void
+gegl_lookup_map_array_avx2 (GeglLookup   *lookup,
+                            const gfloat *src,
+                            gfloat       *dest,
+                            gint          n)
+{
+  const __m128i shift        = _mm_cvtsi32_si128 (lookup->shift);
+  const __m256i positive_min = _mm256_set1_epi32 (lookup->positive_min);
+  const __m256i positive_max = _mm256_set1_epi32 (lookup->positive_max);
+  const __m256i negative_min = _mm256_set1_epi32 (lookup->negative_min);
+  const __m256i negative_max = _mm256_set1_epi32 (lookup->negative_max);
+  const __m256i negative_offset =
+    _mm256_set1_epi32 ((gint) (lookup->positive_max - lookup->positive_min) -
+                       (gint) lookup->negative_min);
+  const __m256i one          = _mm256_set1_epi32 (1);
+  const __m256i bit_index    = _mm256_set1_epi32 (31);
+  gint          i;
+
+  for (i = 0; i + 8 <= n; i += 8)
+    {
+      __m256i v;
+      __m256i positive;
+      __m256i negative;
+      __m256i index;
+      __m256i bits;
+
+      /* with a non-zero shift, the shifted values fit in 24 bits, so signed
+       * comparisons are fine.
+       */
+      v = _mm256_srl_epi32 (_mm256_loadu_si256 ((const __m256i *) (src + i)),
+                            shift);
+
+      positive = _mm256_and_si256 (_mm256_cmpgt_epi32 (v, positive_min),
+                                   _mm256_cmpgt_epi32 (positive_max, v));
+      negative = _mm256_and_si256 (_mm256_cmpgt_epi32 (v, negative_min),
+                                   _mm256_cmpgt_epi32 (negative_max, v));
+
+      if (_mm256_movemask_epi8 (_mm256_or_si256 (positive, negative)) != -1)
+        goto scalar;
+
+      index = _mm256_blendv_epi8 (_mm256_add_epi32 (v, negative_offset),
+                                  _mm256_sub_epi32 (v, positive_min),
+                                  positive);
+
+      bits = _mm256_i32gather_epi32 ((const gint *) lookup->bitmask,
+                                     _mm256_srli_epi32 (index, 5), 4);
+      bits = _mm256_and_si256 (bits,
+                               _mm256_sllv_epi32 (one,
+                                                  _mm256_and_si256 (index,
+                                                                    bit_index)));
+
+      if (_mm256_movemask_epi8 (_mm256_cmpeq_epi32 (bits,
+                                                    _mm256_setzero_si256 ())))
+        goto scalar;
+
+      _mm256_storeu_ps (dest + i,
+                        _mm256_i32gather_ps (lookup->table, index, 4));
+
+      continue;
+
+scalar:
+      {
+        gint j;
+
+        for (j = i; j < i + 8; j++)
+          dest[j] = gegl_lookup (lookup, src[j]);
+      }
+    }
+
+  for (; i < n; i++)
+    dest[i] = gegl_lookup (lookup, src[i]);
+}
+
+#endif /* LOOKUP_SIMD */
+
+void
+gegl_lookup_map_array (GeglLookup   *lookup,
+                       const gfloat *src,
+                       gfloat       *dest,
+                       gint          n)
+{
+  gint i;
+
+  g_return_if_fail (lookup != NULL);
+
+#ifdef LOOKUP_SIMD
+  /* with a zero shift, the table is empty */
+  if (lookup->shift &&
+      (gegl_cpu_accel_get_support () & GEGL_CPU_ACCEL_X86_AVX2))
+    {
+      gegl_lookup_map_array_avx2 (lookup, src, dest, n);
+
+      return;
+    }
+#endif
+
+  for (i = 0; i < n; i++)
+    dest[i] = gegl_lookup (lookup, src[i]);
+}
+
+GeglLookup3D *
+gegl_lookup_3d_new (GeglLookup3DFunction function,
+                    gpointer             data,
+                    gint                 size)
+{
+  GeglLookup3D *lookup;
+  gfloat       *entry;
+  gint          r, g, b;
+
+  g_return_val_if_fail (function != NULL, NULL);
+  g_return_val_if_fail (size >= 2, NULL);
+
+  lookup = g_malloc (sizeof (GeglLookup3D) +
+                     sizeof (gfloat) * 3 * size * size * size);
+
+  lookup->size = size;
+
+  entry = lookup->table;
+
+  for (b = 0; b < size; b++)
+    for (g = 0; g < size; g++)
+      for (r = 0; r < size; r++)
+        {
+          gfloat rgb[3] = {(gfloat) r / (size - 1),
+                           (gfloat) g / (size - 1),
+                           (gfloat) b / (size - 1)};
+
+          function (rgb, entry, data);
+
+          entry += 3;
+        }
+
+  return lookup;
+}
+
+GeglLookup3D *
+gegl_lookup_3d_new_from_table (const gfloat *table,
+                               gint          size)
+{
+  GeglLookup3D *lookup;
+  gsize         table_size;
+
+  g_return_val_if_fail (table != NULL, NULL);
+  g_return_val_if_fail (size >= 2, NULL);
+
+  table_size = sizeof (gfloat) * 3 * size * size * size;
+
+  lookup = g_malloc (sizeof (GeglLookup3D) + table_size);
+
+  lookup->size = size;
+  memcpy (lookup->table, table, table_size);
+
+  return lookup;
+}
+
+void
+gegl_lookup_3d_free (GeglLookup3D *lookup)
+{
+  g_free (lookup);
+}
+
+/* finds the lattice cell of @value, and the position within it */
+static inline gint
+gegl_lookup_3d_cell (gfloat  value,
+                     gint    size,
+                     gfloat *frac)
+{
+  gfloat x;
+  gint   i;
+
+  x = CLAMP (value, 0.0f, 1.0f) * (size - 1);
+  i = MIN ((gint) x, size - 2);
+
+  *frac = x - i;
+
+  return i;
+}
+
+void
+gegl_lookup_3d_map_array (GeglLookup3D            *lookup,
+                          const gfloat            *src,
+                          gfloat                  *dest,
+                          gint                     n_pixels,
+                          gint                     components,
+                          GeglLookupInterpolation  interpolation)
+{
+  const gint size = lookup->size;
+  /* the offsets of the next lattice point along each axis */
+  const gint dr   = 3;
+  const gint dg   = 3 * size;
+  const gint db   = 3 * size * size;
+  gint       i;
+
+  g_return_if_fail (components == 3 || components == 4);
+
+  for (i = 0; i < n_pixels; i++)
+    {
+      const gfloat *p;
+      gfloat        fr, fg, fb;
+      gfloat        rgb[3];
+      gint          c;
+
+      p = lookup->table + gegl_lookup_3d_cell (src[0], size, &fr) * dr +
+                          gegl_lookup_3d_cell (src[1], size, &fg) * dg +
+                          gegl_lookup_3d_cell (src[2], size, &fb) * db;
+
+      if (interpolation == GEGL_LOOKUP_INTERPOLATION_TETRAHEDRAL)
+        {
+          gint   d1, d2;
+          gfloat f1, f2, f3;
+
+          /* walk from the base corner of the cell to the opposite one,
+           * along the axes ordered by decreasing fraction.
+           */
+          if (fr >= fg)
+            {
+              if (fg >= fb)
+                { d1 = dr; d2 = dr + dg; f1 = fr; f2 = fg; f3 = fb; }
+              else if (fr >= fb)
+                { d1 = dr; d2 = dr + db; f1 = fr; f2 = fb; f3 = fg; }
+              else
+                { d1 = db; d2 = db + dr; f1 = fb; f2 = fr; f3 = fg; }
+            }
+          else
+            {
+              if (fb >= fg)
+                { d1 = db; d2 = db + dg; f1 = fb; f2 = fg; f3 = fr; }
+              else if (fb >= fr)
+                { d1 = dg; d2 = dg + db; f1 = fg; f2 = fb; f3 = fr; }
+              else
+                { d1 = dg; d2 = dg + dr; f1 = fg; f2 = fr; f3 = fb; }
+            }
+
+          for (c = 0; c < 3; c++)
+            {
+              rgb[c] = (1.0f - f1) * p[c]           +
+                       (f1 - f2)   * p[d1 + c]      +
+                       (f2 - f3)   * p[d2 + c]      +
+                       f3          * p[dr + dg + db + c];
+            }
+        }
+      else
+        {
+          for (c = 0; c < 3; c++)
+            {
+              gfloat c00, c10, c01, c11;
+
+              c00 = p[c]                + fr * (p[dr + c]           - p[c]);
+              c10 = p[dg + c]           + fr * (p[dg + dr + c]      - p[dg + c]);
+              c01 = p[db + c]           + fr * (p[db + dr + c]      - p[db + c]);
+              c11 = p[db + dg + c]      + fr * (p[db + dg + dr + c] - p[db + dg + c]);
+
+              c00 += fg * (c10 - c00);
+              c01 += fg * (c11 - c01);
+
+              rgb[c] = c00 + fb * (c01 - c00);
+            }
+        }
+
+      if (components == 4)
+        dest[3] = src[3];
+
+      dest[0] = rgb[0];
+      dest[1] = rgb[1];
+      dest[2] = rgb[2];
+
+      src  += components;
+      dest += components;
+    }
+}
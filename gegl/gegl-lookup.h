@@ -23,8 +23,18 @@ G_BEGIN_DECLS
 
 #ifndef __cplusplus
 
-typedef     gfloat (* GeglLookupFunction) (gfloat   value,
-                                           gpointer data);
+typedef     gfloat (* GeglLookupFunction)   (gfloat        value,
+                                             gpointer      data);
+
+typedef     void   (* GeglLookup3DFunction) (const gfloat *rgb_in,
+                                             gfloat       *rgb_out,
+                                             gpointer      data);
+
+typedef enum
+{
+  GEGL_LOOKUP_INTERPOLATION_TRILINEAR,
+  GEGL_LOOKUP_INTERPOLATION_TETRAHEDRAL
+} GeglLookupInterpolation;
 
 #define GEGL_LOOKUP_MAX_ENTRIES   (819200)
 
@@ -38,6 +48,15 @@ typedef struct GeglLookup
   gfloat             table[];
 } GeglLookup;
 
+/* a lattice of @size^3 RGB triplets over the unit cube, with red varying
+ * fastest, like in .cube files.
+ */
+typedef struct GeglLookup3D
+{
+  gint               size;
+  gfloat             table[];
+} GeglLookup3D;
+
 
 /**
  * gegl_lookup_new_full: (skip)
@@ -70,6 +89,84 @@ GeglLookup *gegl_lookup_new       (GeglLookupFunction  function,
  */
 void        gegl_lookup_free      (GeglLookup         *lookup);
 
+/**
+ * gegl_lookup_build: (skip)
+ * @lookup: #GeglLookup to fill
+ *
+ * Fills all the entries of @lookup up front, evaluating the function at the
+ * middle of each entry, instead of lazily at the first value looked up in
+ * it.  Afterwards, looking up values never calls the function for values
+ * within the range of @lookup, and @lookup may be used from multiple
+ * threads even if the function is not thread-safe.
+ */
+void        gegl_lookup_build     (GeglLookup         *lookup);
+
+/**
+ * gegl_lookup_map_array: (skip)
+ * @lookup: #GeglLookup to use
+ * @src: the values to look up
+ * @dest: the results, may be the same as @src
+ * @n: the number of values
+ *
+ * Looks up @n values at once, like calling gegl_lookup() for each of them,
+ * using vector gathers where available.
+ */
+void        gegl_lookup_map_array (GeglLookup         *lookup,
+                                   const gfloat       *src,
+                                   gfloat             *dest,
+                                   gint                n);
+
+/**
+ * gegl_lookup_3d_new: (skip)
+ * @function: The function to build a lookup for
+ * @data: A user data pointer passed to the function
+ * @size: The number of lattice points along each axis
+ *
+ * Samples an RGB to RGB function over the unit cube.
+ *
+ * Return value: a #GeglLookup3D
+ */
+GeglLookup3D *gegl_lookup_3d_new            (GeglLookup3DFunction     function,
+                                             gpointer                 data,
+                                             gint                     size);
+
+/**
+ * gegl_lookup_3d_new_from_table: (skip)
+ * @table: @size^3 RGB triplets, red varying fastest
+ * @size: The number of lattice points along each axis
+ *
+ * Return value: a #GeglLookup3D, holding a copy of @table
+ */
+GeglLookup3D *gegl_lookup_3d_new_from_table (const gfloat            *table,
+                                             gint                     size);
+
+/**
+ * gegl_lookup_3d_free: (skip)
+ * @lookup: #GeglLookup3D to free
+ */
+void          gegl_lookup_3d_free           (GeglLookup3D            *lookup);
+
+/**
+ * gegl_lookup_3d_map_array: (skip)
+ * @lookup: #GeglLookup3D to use
+ * @src: the pixels to map
+ * @dest: the mapped pixels, may be the same as @src
+ * @n_pixels: the number of pixels
+ * @components: 3 for RGB pixels, or 4 for RGBA pixels, whose alpha is
+ *              copied as is
+ * @interpolation: how to interpolate between lattice points
+ *
+ * Maps pixels through @lookup, clamping them to the unit cube.
+ * Tetrahedral interpolation uses four lattice points per pixel instead of
+ * eight, and does not blur the neutral axis.
+ */
+void          gegl_lookup_3d_map_array      (GeglLookup3D            *lookup,
+                                             const gfloat            *src,
+                                             gfloat                  *dest,
+                                             gint                     n_pixels,
+                                             gint                     components,
+                                             GeglLookupInterpolation  interpolation);
+
 
 static inline gfloat
 gegl_lookup (GeglLookup *lookup,
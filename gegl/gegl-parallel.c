@@ -25,12 +25,14 @@
 
 #include "gegl.h"
 #include "gegl-config.h"
+#include "gegl-instrument.h"
 #include "gegl-parallel.h"
 #include "gegl-parallel-private.h"
 
 
 #define GEGL_PARALLEL_DISTRIBUTE_MAX_THREADS           GEGL_MAX_THREADS
 #define GEGL_PARALLEL_DISTRIBUTE_THREAD_TIME_N_SAMPLES 10
+#define GEGL_PARALLEL_DISTRIBUTE_CHUNKS_PER_THREAD     8
 
 
 typedef struct
@@ -52,6 +54,38 @@ typedef struct
   volatile gint               i;
 } GeglParallelDistributeThread;
 
+/* a work-stealing deque.  since the chunks of a job are consecutive
+ * indices, each deque is simply a range of chunks; its owner pops chunks
+ * from the front, while thieves split off the back half.  begin and end
+ * are only changed while holding the lock, but are read without it to find
+ * a victim, so they're always accessed atomically.
+ */
+typedef struct
+{
+  gint                        lock;
+  volatile gint               begin;
+  volatile gint               end;
+  gboolean                    owned;
+
+  /* keep each deque on its own cache line */
+  gint                        padding[12];
+} GeglParallelDistributeDeque;
+
+typedef struct _GeglParallelDistributeJob GeglParallelDistributeJob;
+
+struct _GeglParallelDistributeJob
+{
+  GeglParallelDistributeFunc   func;
+  gint                         n_chunks;
+  gpointer                     user_data;
+
+  GeglParallelDistributeDeque *deques;
+  gint                         n_deques;
+
+  gint                         n_helpers;
+  GeglParallelDistributeJob   *next;
+};
+
 
 /*  local function prototypes  */
 
@@ -64,6 +98,15 @@ static void          gegl_parallel_distribute_set_n_threads         (gint
 static gpointer      gegl_parallel_distribute_thread_func           (GeglParallelDistributeThread *thread);
 static void          gegl_parallel_distribute_update_thread_time    (void);
 
+static void          gegl_parallel_distribute_chunks                (gint                          n_chunks,
+                                                                     gint                          n_threads,
+                                                                     GeglParallelDistributeFunc    func,
+                                                                     gpointer                      user_data);
+static gint          gegl_parallel_distribute_get_n_chunks          (gdouble                       n_elements,
+                                                                     gint                          max_n_chunks,
+                                                                     gdouble                       thread_cost,
+                                                                     gint                          n_threads);
+
 
 /*  local variables  */
 
@@ -78,6 +121,10 @@ static gint                         gegl_parallel_distribute_n_assigned_threads;
 
 static gdouble                      gegl_parallel_distribute_thread_time;
 
+static GMutex                       gegl_parallel_distribute_jobs_mutex;
+static GCond                        gegl_parallel_distribute_jobs_cond;
+static GeglParallelDistributeJob   *gegl_parallel_distribute_jobs;
+
 
 /*  public functions  */
 
@@ -242,6 +289,7 @@ gegl_parallel_distribute_range (gsize                           size,
 {
   GeglParallelDistributeRangeData data;
   gint                            n_threads;
+  gint                            n_chunks;
 
   g_return_if_fail (func != NULL);
 
@@ -261,11 +309,18 @@ gegl_parallel_distribute_range (gsize                           size,
       return;
     }
 
+  n_chunks = gegl_parallel_distribute_get_n_chunks (
+    size,
+    MIN (size, G_MAXINT),
+    thread_cost,
+    n_threads);
+
   data.size      = size;
   data.func      = func;
   data.user_data = user_data;
 
-  gegl_parallel_distribute (
+  gegl_parallel_distribute_chunks (
+    n_chunks,
     n_threads,
     (GeglParallelDistributeFunc) gegl_parallel_distribute_range_func,
     &data);
@@ -277,6 +332,7 @@ typedef struct
   GeglSplitStrategy               split_strategy;
   GeglParallelDistributeAreaFunc  func;
   gpointer                        user_data;
+  const gchar                    *trace_scope;
 } GeglParallelDistributeAreaData;
 
 static void
@@ -316,7 +372,29 @@ gegl_parallel_distribute_area_func (gint                            i,
       g_return_if_reached ();
     }
 
-  data->func (&sub_area, data->user_data);
+  if (data->trace_scope)
+    {
+      const gchar *trace_scope;
+      long         trace_start;
+
+      trace_scope = gegl_instrument_trace_set_scope (data->trace_scope);
+      trace_start = gegl_ticks ();
+
+      data->func (&sub_area, data->user_data);
+
+      gegl_instrument_trace ("chunk", data->trace_scope,
+                             trace_start, gegl_ticks (),
+                             "\"roi\":[%d,%d,%d,%d],\"chunk\":%d",
+                             sub_area.x, sub_area.y,
+                             sub_area.width, sub_area.height,
+                             i);
+
+      gegl_instrument_trace_set_scope (trace_scope);
+    }
+  else
+    {
+      data->func (&sub_area, data->user_data);
+    }
 }
 
 void
@@ -328,6 +406,7 @@ gegl_parallel_distribute_area (const GeglRectangle            *area,
 {
   GeglParallelDistributeAreaData data;
   gint                           n_threads;
+  gint                           n_chunks;
 
   g_return_if_fail (area != NULL);
   g_return_if_fail (func != NULL);
@@ -368,12 +447,33 @@ gegl_parallel_distribute_area (const GeglRectangle            *area,
       return;
     }
 
+  n_chunks = gegl_parallel_distribute_get_n_chunks (
+    (gdouble) area->width * (gdouble) area->height,
+    split_strategy == GEGL_SPLIT_STRATEGY_HORIZONTAL ? area->height :
+                                                       area->width,
+    thread_cost,
+    n_threads);
+
   data.area           = area;
   data.split_strategy = split_strategy;
   data.func           = func;
   data.user_data      = user_data;
+  data.trace_scope    = NULL;
 
-  gegl_parallel_distribute (
+  /* record a span for each chunk, attributed to the operation that
+   * distributed the work, so that it's clear how well it was spread over the
+   * worker threads.
+   */
+  if (gegl_instrument_trace_enabled)
+    {
+      data.trace_scope = gegl_instrument_trace_get_scope ();
+
+      if (! data.trace_scope)
+        data.trace_scope = "distribute-area";
+    }
+
+  gegl_parallel_distribute_chunks (
+    n_chunks,
     n_threads,
     (GeglParallelDistributeFunc) gegl_parallel_distribute_area_func,
     &data);
@@ -580,3 +680,282 @@ gegl_parallel_distribute_update_thread_time (void)
     G_TIME_SPAN_SECOND                                                    /
     (gegl_parallel_distribute_n_threads - 1);
 }
+
+/* returns the number of chunks to split a job of n_elements elements into,
+ * when distributing it across n_threads threads.  we split the job into more
+ * chunks than threads, so that threads that finish early can steal the
+ * remaining chunks of slower threads, but avoid creating chunks whose
+ * processing cost is lower than the cost of splitting them off.
+ */
+static gint
+gegl_parallel_distribute_get_n_chunks (gdouble n_elements,
+                                       gint    max_n_chunks,
+                                       gdouble thread_cost,
+                                       gint    n_threads)
+{
+  gdouble n_chunks;
+
+  n_chunks = (gdouble) n_threads * GEGL_PARALLEL_DISTRIBUTE_CHUNKS_PER_THREAD;
+
+  if (thread_cost > 0.0)
+    n_chunks = MIN (n_chunks, floor (n_elements / thread_cost));
+
+  n_chunks = MIN (n_chunks, max_n_chunks);
+
+  return MAX (n_chunks, n_threads);
+}
+
+static gboolean
+gegl_parallel_distribute_job_pop (GeglParallelDistributeJob *job,
+                                  gint                       deque_i,
+                                  gint                      *chunk)
+{
+  GeglParallelDistributeDeque *deque  = &job->deques[deque_i];
+  gboolean                     result = FALSE;
+
+  g_bit_lock (&deque->lock, 0);
+
+  if (deque->begin < deque->end)
+    {
+      *chunk = deque->begin;
+
+      g_atomic_int_set (&deque->begin, *chunk + 1);
+
+      result = TRUE;
+    }
+
+  g_bit_unlock (&deque->lock, 0);
+
+  return result;
+}
+
+static gboolean
+gegl_parallel_distribute_job_steal (GeglParallelDistributeJob *job,
+                                    gint                       deque_i)
+{
+  GeglParallelDistributeDeque *deque = &job->deques[deque_i];
+
+  while (TRUE)
+    {
+      GeglParallelDistributeDeque *victim   = NULL;
+      gint                         max_size = 0;
+      gint                         begin;
+      gint                         end;
+      gint                         size;
+      gint                         i;
+
+      /* pick the deque with the most remaining chunks as the victim */
+      for (i = 0; i < job->n_deques; i++)
+        {
+          size = g_atomic_int_get (&job->deques[i].end) -
+                 g_atomic_int_get (&job->deques[i].begin);
+
+          if (size > max_size)
+            {
+              victim   = &job->deques[i];
+              max_size = size;
+            }
+        }
+
+      if (! victim)
+        return FALSE;
+
+      g_bit_lock (&victim->lock, 0);
+
+      size  = victim->end - victim->begin;
+      end   = victim->end;
+      begin = end - (size + 1) / 2;
+
+      if (size > 0)
+        g_atomic_int_set (&victim->end, begin);
+
+      g_bit_unlock (&victim->lock, 0);
+
+      /* the victim's deque has been emptied in the meantime; try again */
+      if (size <= 0)
+        continue;
+
+      g_bit_lock (&deque->lock, 0);
+
+      g_atomic_int_set (&deque->begin, begin);
+      g_atomic_int_set (&deque->end,   end);
+
+      g_bit_unlock (&deque->lock, 0);
+
+      return TRUE;
+    }
+}
+
+static void
+gegl_parallel_distribute_job_participate (GeglParallelDistributeJob *job,
+                                          gint                       deque_i)
+{
+  gint chunk;
+
+  do
+    {
+      while (gegl_parallel_distribute_job_pop (job, deque_i, &chunk))
+        job->func (chunk, job->n_chunks, job->user_data);
+    }
+  while (gegl_parallel_distribute_job_steal (job, deque_i));
+}
+
+static gboolean
+gegl_parallel_distribute_job_has_work (GeglParallelDistributeJob *job)
+{
+  gint i;
+
+  for (i = 0; i < job->n_deques; i++)
+    {
+      if (g_atomic_int_get (&job->deques[i].begin) <
+          g_atomic_int_get (&job->deques[i].end))
+        {
+          return TRUE;
+        }
+    }
+
+  return FALSE;
+}
+
+/* lets an idle worker thread help with the jobs of nested (or concurrent)
+ * distribution calls, which couldn't acquire the worker pool themselves.
+ * this way, such calls still make use of otherwise-idle workers, without
+ * spawning any additional threads.
+ */
+static void
+gegl_parallel_distribute_help (void)
+{
+  while (TRUE)
+    {
+      GeglParallelDistributeJob *job;
+      gint                       deque_i = -1;
+
+      g_mutex_lock (&gegl_parallel_distribute_jobs_mutex);
+
+      for (job = gegl_parallel_distribute_jobs; job; job = job->next)
+        {
+          if (! gegl_parallel_distribute_job_has_work (job))
+            continue;
+
+          for (deque_i = 0; deque_i < job->n_deques; deque_i++)
+            {
+              if (! job->deques[deque_i].owned)
+                break;
+            }
+
+          if (deque_i < job->n_deques)
+            break;
+        }
+
+      if (! job)
+        {
+          g_mutex_unlock (&gegl_parallel_distribute_jobs_mutex);
+
+          return;
+        }
+
+      job->deques[deque_i].owned = TRUE;
+      job->n_helpers++;
+
+      g_mutex_unlock (&gegl_parallel_distribute_jobs_mutex);
+
+      gegl_parallel_distribute_job_participate (job, deque_i);
+
+      g_mutex_lock (&gegl_parallel_distribute_jobs_mutex);
+
+      job->deques[deque_i].owned = FALSE;
+
+      if (--job->n_helpers == 0)
+        g_cond_broadcast (&gegl_parallel_distribute_jobs_cond);
+
+      g_mutex_unlock (&gegl_parallel_distribute_jobs_mutex);
+    }
+}
+
+static void
+gegl_parallel_distribute_job_func (gint                       i,
+                                   gint                       n,
+                                   GeglParallelDistributeJob *job)
+{
+  if (n > 1 || job->n_deques == 1)
+    {
+      gegl_parallel_distribute_job_participate (job, i);
+
+      gegl_parallel_distribute_help ();
+    }
+  else
+    {
+      GeglParallelDistributeJob **iter;
+
+      /* we couldn't acquire the worker pool, since this is either a nested
+       * call, or a concurrent call from another thread.  process the job on
+       * the current thread, but publish it, so that idle workers can steal
+       * from it.
+       */
+      g_mutex_lock (&gegl_parallel_distribute_jobs_mutex);
+
+      job->deques[0].owned = TRUE;
+
+      job->next                     = gegl_parallel_distribute_jobs;
+      gegl_parallel_distribute_jobs = job;
+
+      g_mutex_unlock (&gegl_parallel_distribute_jobs_mutex);
+
+      gegl_parallel_distribute_job_participate (job, 0);
+
+      g_mutex_lock (&gegl_parallel_distribute_jobs_mutex);
+
+      for (iter = &gegl_parallel_distribute_jobs;
+           *iter != job;
+           iter = &(*iter)->next);
+
+      *iter = job->next;
+
+      /* wait for any helpers to finish processing their chunks */
+      while (job->n_helpers > 0)
+        {
+          g_cond_wait (&gegl_parallel_distribute_jobs_cond,
+                       &gegl_parallel_distribute_jobs_mutex);
+        }
+
+      g_mutex_unlock (&gegl_parallel_distribute_jobs_mutex);
+    }
+}
+
+/* calls func() for each of the n_chunks chunks, across n_threads threads,
+ * using work stealing to balance the load between the threads.
+ */
+static void
+gegl_parallel_distribute_chunks (gint                       n_chunks,
+                                 gint                       n_threads,
+                                 GeglParallelDistributeFunc func,
+                                 gpointer                   user_data)
+{
+  GeglParallelDistributeJob job;
+  gint                      i;
+
+  job.func      = func;
+  job.n_chunks  = n_chunks;
+  job.user_data = user_data;
+
+  job.deques    = g_newa (GeglParallelDistributeDeque, n_threads);
+  job.n_deques  = n_threads;
+
+  job.n_helpers = 0;
+  job.next      = NULL;
+
+  for (i = 0; i < n_threads; i++)
+    {
+      GeglParallelDistributeDeque *deque = &job.deques[i];
+
+      deque->lock  = 0;
+      deque->begin = (gint64) i       * n_chunks / n_threads;
+      deque->end   = (gint64) (i + 1) * n_chunks / n_threads;
+      deque->owned = FALSE;
+    }
+
+  gegl_parallel_distribute (
+    n_threads,
+    (GeglParallelDistributeFunc) gegl_parallel_distribute_job_func,
+    &job);
+}
@@ -94,6 +94,13 @@ void   gegl_parallel_distribute       (gint                             max_n,
  * Distributes the processing of a linear data-structure across
  * multiple threads, by calling the given function with different
  * sub-ranges on different threads.
+ *
+ * The data is split into more sub-ranges than threads, which are
+ * balanced between the threads using work stealing; the function may
+ * therefore be called more than once on each thread, with sub-ranges
+ * of varying sizes.  When called from within another distributed
+ * function, the sub-ranges are processed by the calling thread, and
+ * by any idle worker threads.
  */
 void   gegl_parallel_distribute_range (gsize                            size,
                                        gdouble                          thread_cost,
@@ -112,6 +119,10 @@ void   gegl_parallel_distribute_range (gsize                            size,
  * Distributes the processing of a planar data-structure across
  * multiple threads, by calling the given function with different
  * sub-areas on different threads.
+ *
+ * Like gegl_parallel_distribute_range(), the area is split into more
+ * sub-areas than threads, which are balanced between the threads using
+ * work stealing.
  */
 void   gegl_parallel_distribute_area  (const GeglRectangle             *area,
                                        gdouble                          thread_cost,
@@ -40,6 +40,7 @@ enum
   PROP_TILE_CACHE_TOTAL_UNCOMPRESSED,
   PROP_TILE_CACHE_HITS,
   PROP_TILE_CACHE_MISSES,
+  PROP_TILE_CACHE_GHOST_HITS,
   PROP_SWAP_TOTAL,
   PROP_SWAP_TOTAL_UNCOMPRESSED,
   PROP_SWAP_FILE_SIZE,
@@ -51,6 +52,7 @@ enum
   PROP_SWAP_READ_TOTAL,
   PROP_SWAP_WRITING,
   PROP_SWAP_WRITE_TOTAL,
+  PROP_SWAP_PREFETCH_HITS,
   PROP_ZOOM_TOTAL,
   PROP_TILE_ALLOC_TOTAL,
   PROP_SCRATCH_TOTAL,
@@ -115,6 +117,14 @@ gegl_stats_class_init (GeglStatsClass *klass)
                                                      0, G_MAXINT, 0,
                                                      G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
 
+  g_object_class_install_property (object_class, PROP_TILE_CACHE_GHOST_HITS,
+                                   g_param_spec_int ("tile-cache-ghost-hits",
+                                                     "Tile Cache ghost hits",
+                                                     "Number of tile cache misses on recently-evicted tiles, "
+                                                     "as tracked by the adaptive eviction policies",
+                                                     0, G_MAXINT, 0,
+                                                     G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+
   g_object_class_install_property (object_class, PROP_SWAP_TOTAL,
                                    g_param_spec_uint64 ("swap-total",
                                                         "Swap total size",
@@ -197,6 +207,13 @@ gegl_stats_class_init (GeglStatsClass *klass)
                                                         0, G_MAXUINT64, 0,
                                                         G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
 
+  g_object_class_install_property (object_class, PROP_SWAP_PREFETCH_HITS,
+                                   g_param_spec_int ("swap-prefetch-hits",
+                                                     "Swap prefetch hits",
+                                                     "Number of tiles read from the swap that had already been prefetched",
+                                                     0, G_MAXINT, 0,
+                                                     G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+
   g_object_class_install_property (object_class, PROP_ZOOM_TOTAL,
                                    g_param_spec_uint64 ("zoom-total",
                                                         "Zoom total",
@@ -280,6 +297,10 @@ gegl_stats_get_property (GObject    *object,
         g_value_set_int (value, gegl_tile_handler_cache_get_misses ());
         break;
 
+      case PROP_TILE_CACHE_GHOST_HITS:
+        g_value_set_int (value, gegl_tile_handler_cache_get_ghost_hits ());
+        break;
+
       case PROP_SWAP_TOTAL:
         g_value_set_uint64 (value, gegl_tile_backend_swap_get_total ());
         break;
@@ -324,6 +345,10 @@ gegl_stats_get_property (GObject    *object,
         g_value_set_uint64 (value, gegl_tile_backend_swap_get_write_total ());
         break;
 
+      case PROP_SWAP_PREFETCH_HITS:
+        g_value_set_int (value, gegl_tile_backend_swap_get_prefetch_hits ());
+        break;
+
       case PROP_ZOOM_TOTAL:
         g_value_set_uint64 (value, gegl_tile_handler_zoom_get_total ());
         break;
@@ -29,6 +29,8 @@
 #include "gegl-cache.h"
 #include "gegl-region.h"
 #include "gegl-buffer.h" /* for GeglRectangle XXX ... */
+#include "gegl-tile-storage.h"
+#include "gegl-tile-handler-cache.h"
 
 enum
 {
@@ -315,6 +317,74 @@ gegl_cache_computed (GeglCache           *self,
   g_signal_emit (self, gegl_cache_signals[COMPUTED], 0, rect, NULL);
 }
 
+/* forgets the content of the whole tiles within roi at the given level,
+ * releasing their memory.  unlike gegl_cache_invalidate() the content is
+ * not considered changed, so no "invalidated" signal is emitted; partially
+ * covered tiles are kept.
+ */
+void
+gegl_cache_release (GeglCache           *self,
+                    const GeglRectangle *roi,
+                    gint                 level)
+{
+  GeglBuffer    *buffer = GEGL_BUFFER (self);
+  GeglRectangle  rect;
+  GeglRegion    *temp_region;
+  gint           tile_width;
+  gint           tile_height;
+  gint           shift_x;
+  gint           shift_y;
+  gint           x0, y0;
+  gint           x1, y1;
+  gint           x, y;
+
+  g_return_if_fail (GEGL_IS_CACHE (self));
+  g_return_if_fail (roi != NULL);
+
+  if (level < 0 || level >= GEGL_CACHE_VALID_MIPMAPS)
+    return;
+
+  tile_width  = buffer->tile_width;
+  tile_height = buffer->tile_height;
+  shift_x     = buffer->shift_x / (1 << level);
+  shift_y     = buffer->shift_y / (1 << level);
+
+  /* only the tiles entirely within roi */
+  x0 = gegl_tile_indice (roi->x + shift_x + tile_width - 1, tile_width);
+  y0 = gegl_tile_indice (roi->y + shift_y + tile_height - 1, tile_height);
+  x1 = gegl_tile_indice (roi->x + roi->width + shift_x, tile_width);
+  y1 = gegl_tile_indice (roi->y + roi->height + shift_y, tile_height);
+
+  if (x0 >= x1 || y0 >= y1)
+    return;
+
+  rect.x      = x0 * tile_width - shift_x;
+  rect.y      = y0 * tile_height - shift_y;
+  rect.width  = (x1 - x0) * tile_width;
+  rect.height = (y1 - y0) * tile_height;
+
+  temp_region = gegl_region_rectangle (&rect);
+  g_mutex_lock (&self->mutex);
+  gegl_region_subtract (self->valid_region[level], temp_region);
+  g_mutex_unlock (&self->mutex);
+  gegl_region_destroy (temp_region);
+
+  g_rec_mutex_lock (&buffer->tile_storage->mutex);
+
+  for (y = y0; y < y1; y++)
+    for (x = x0; x < x1; x++)
+      {
+        gegl_tile_handler_cache_remove (buffer->tile_storage->cache,
+                                        x, y, level);
+
+        gegl_tile_handler_source_command (buffer->tile_storage->cache,
+                                          GEGL_TILE_VOID,
+                                          x, y, level, NULL);
+      }
+
+  g_rec_mutex_unlock (&buffer->tile_storage->mutex);
+}
+
 gboolean
 gegl_buffer_list_valid_rectangles (GeglBuffer     *buffer,
                                    GeglRectangle **rectangles,
@@ -56,6 +56,9 @@ void     gegl_cache_invalidate  (GeglCache           *self,
 void     gegl_cache_computed    (GeglCache           *self,
                                  const GeglRectangle *rect,
                                  gint                 level);
+void     gegl_cache_release     (GeglCache           *self,
+                                 const GeglRectangle *roi,
+                                 gint                 level);
 
 G_END_DECLS
 
@@ -91,6 +91,12 @@ struct _GeglNode
 
   gint            passthrough;
 
+  /* Hash of the operation, properties and inputs of this node, which
+   * identifies its result in the shared result cache (NULL if unhashable)
+   */
+  gchar          *result_key;
+  gboolean        valid_result_key;
+
   /*< private >*/
   GeglNodePrivate *priv;
 };
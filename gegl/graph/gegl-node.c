@@ -32,6 +32,7 @@
 #include "gegl-node-private.h"
 #include "gegl-connection.h"
 #include "gegl-pad.h"
+#include "gegl-result-cache.h"
 #include "gegl-visitable.h"
 #include "gegl-config.h"
 
@@ -274,6 +275,7 @@ gegl_node_dispose (GObject *gobject)
     }
 
   gegl_node_remove_children (self);
+  gegl_result_cache_forget (self);
   g_clear_object (&self->cache);
   g_clear_object (&self->priv->eval_manager);
 
@@ -296,6 +298,7 @@ gegl_node_finalize (GObject *gobject)
   g_clear_object (&self->output_visitable);
   g_free (self->priv->name);
   g_free (self->priv->debug_name);
+  g_free (self->result_key);
 
   g_mutex_clear (&self->mutex);
 
@@ -639,6 +642,8 @@ gegl_node_invalidated_invalidate_node (GeglNode *node,
 
   node->valid_have_rect = FALSE;
 
+  gegl_result_cache_forget (node);
+
   gegl_region_get_rectangles (region,
                               &rects, &n_rects);
 
@@ -732,6 +737,8 @@ gegl_node_invalidated_invalidate_node (GeglNode *node,
 
   node->valid_have_rect = FALSE;
 
+  gegl_result_cache_forget (node);
+
   if (node->cache)
     gegl_cache_invalidate (node->cache, rect);
 
@@ -1374,18 +1381,29 @@ gegl_node_property_changed (GObject    *gobject,
         }
       else
         {
-          /* we were called due to a property change */
+          /* we were called due to a property change, let the operation
+           * tell which part of its output, before or after the change, is
+           * affected by it
+           */
           GeglRectangle dirty_rect;
+          GeglRectangle old_have_rect;
           GeglRectangle new_have_rect;
 
-          dirty_rect    = self->have_rect;
+          old_have_rect = self->have_rect;
+
+          self->valid_have_rect = FALSE;
           new_have_rect = gegl_node_get_bounding_box (self);
 
-          gegl_rectangle_bounding_box (&dirty_rect,
-                                       &dirty_rect,
-                                       &new_have_rect);
+          dirty_rect = gegl_operation_get_invalidated_by_property_change (
+            self->operation, arg1, &old_have_rect, &new_have_rect);
 
           gegl_node_invalidated (self, &dirty_rect, FALSE);
+
+          /* our bounding box was computed after the change, so it stays
+           * valid, and is what the next change is compared against
+           */
+          self->have_rect       = new_have_rect;
+          self->valid_have_rect = TRUE;
         }
     }
 
@@ -1048,6 +1048,214 @@ miRegionOp (GeglRegion       *newReg,
 }
 
 
+/*======================================================================
+ *	    Band Searching
+ *====================================================================*/
+
+/*
+ * Since boxes are sorted by band, both y1 and y2 are non-decreasing over
+ * the array of boxes, and within a band x1 and x2 are strictly increasing.
+ * The following helpers binary search these sequences, which lets the
+ * queries and the single-rectangle operations below skip straight to the
+ * bands they touch.
+ */
+
+/* returns the first box in [pBox, pBoxEnd) whose y2 is past y */
+static GeglRegionBox *
+miSearchY2 (GeglRegionBox *pBox,
+            GeglRegionBox *pBoxEnd,
+            gint           y)
+{
+  while (pBox < pBoxEnd)
+    {
+      GeglRegionBox *pMid = pBox + (pBoxEnd - pBox) / 2;
+
+      if (pMid->y2 <= y)
+        pBox = pMid + 1;
+      else
+        pBoxEnd = pMid;
+    }
+
+  return pBox;
+}
+
+/* returns the first box in [pBox, pBoxEnd) whose y1 is at or past y */
+static GeglRegionBox *
+miSearchY1 (GeglRegionBox *pBox,
+            GeglRegionBox *pBoxEnd,
+            gint           y)
+{
+  while (pBox < pBoxEnd)
+    {
+      GeglRegionBox *pMid = pBox + (pBoxEnd - pBox) / 2;
+
+      if (pMid->y1 < y)
+        pBox = pMid + 1;
+      else
+        pBoxEnd = pMid;
+    }
+
+  return pBox;
+}
+
+/* returns the first box of the band [pBox, pBandEnd) whose x2 is past x */
+static GeglRegionBox *
+miSearchX2 (GeglRegionBox *pBox,
+            GeglRegionBox *pBandEnd,
+            gint           x)
+{
+  while (pBox < pBandEnd)
+    {
+      GeglRegionBox *pMid = pBox + (pBandEnd - pBox) / 2;
+
+      if (pMid->x2 <= x)
+        pBox = pMid + 1;
+      else
+        pBandEnd = pMid;
+    }
+
+  return pBox;
+}
+
+/*-
+ *-----------------------------------------------------------------------
+ * miRegionOpRect --
+ *	Apply an operation between a region and a single rectangle,
+ *	touching only the bands of the region which the rectangle spans.
+ *
+ * Results:
+ *	None.
+ *
+ * Side Effects:
+ *	The bands of pReg overlapping the rectangle are replaced by the
+ *	result of the operation, and the neighboring bands are coalesced
+ *	with it. pReg->extents is left alone.
+ *
+ * Notes:
+ *	miRegionOp always rebuilds the whole destination region, which
+ *	makes adding or removing a small rectangle linear in the number
+ *	of boxes, with a large constant. Here only the affected bands go
+ *	through miRegionOp; the bands above and below are kept in place
+ *	and only moved when the number of boxes in between changes.
+ *
+ *-----------------------------------------------------------------------
+ */
+static void
+miRegionOpRect (GeglRegion       *pReg,
+                const GeglRegion *rect,
+                overlapFunc       overlapFn,
+                nonOverlapFunc    nonOverlap1Fn,
+                nonOverlapFunc    nonOverlap2Fn)
+{
+  GeglRegionBox *pRegEnd;
+  GeglRegionBox *pFirst;
+  GeglRegionBox *pLast;
+  GeglRegion     band;
+  GeglRegion     result;
+  gint           first;
+  gint           nNew;
+  gint           nTail;
+  gint           numRects;
+  gint           i;
+
+  pRegEnd = pReg->rects + pReg->numRects;
+  pFirst  = miSearchY2 (pReg->rects, pRegEnd, rect->extents.y1);
+  pLast   = miSearchY1 (pFirst, pRegEnd, rect->extents.y2);
+
+  first = pFirst - pReg->rects;
+  nTail = pRegEnd - pLast;
+
+  result.rects      = &result.extents;
+  result.numRects   = 0;
+  result.size       = 1;
+  result.extents.x1 = 0;
+  result.extents.y1 = 0;
+  result.extents.x2 = 0;
+  result.extents.y2 = 0;
+
+  if (pFirst != pLast)
+    {
+      /* a view of the affected bands, as a region of its own; miRegionOp
+       * only looks at the top of its extents.
+       */
+      band.rects      = pFirst;
+      band.numRects   = pLast - pFirst;
+      band.size       = band.numRects;
+      band.extents.x1 = rect->extents.x1;
+      band.extents.y1 = pFirst->y1;
+      band.extents.x2 = rect->extents.x2;
+      band.extents.y2 = pLast[-1].y2;
+
+      miRegionOp (&result, &band, rect, overlapFn,
+                  nonOverlap1Fn, nonOverlap2Fn);
+    }
+  else if (nonOverlap2Fn != (nonOverlapFunc) NULL)
+    {
+      (*nonOverlap2Fn)(&result, rect->rects, rect->rects + 1,
+                       rect->extents.y1, rect->extents.y2);
+    }
+  else
+    {
+      return;
+    }
+
+  nNew     = result.numRects;
+  numRects = first + nNew + nTail;
+
+  if (pReg->rects == &pReg->extents || numRects > pReg->size)
+    GROWREGION (pReg, MAX (numRects, 2 * pReg->size));
+
+  memmove (pReg->rects + first + nNew,
+           pReg->rects + pReg->numRects - nTail,
+           nTail * sizeof (GeglRegionBox));
+  memcpy (pReg->rects + first, result.rects,
+          nNew * sizeof (GeglRegionBox));
+
+  pReg->numRects = numRects;
+
+  if (result.rects != &result.extents)
+    g_free (result.rects);
+
+  /*
+   * The bands above and below are coalesced as far as they go, and so is
+   * the result, so at most the last band above can merge with the first
+   * new one, and the last new band with the first band below.
+   */
+  for (i = 0; i < (nNew ? 2 : 1); i++)
+    {
+      gint curStart = i ? pReg->numRects - nTail : first;
+      gint prevStart;
+
+      if (curStart <= 0 || curStart >= pReg->numRects)
+        continue;
+
+      for (prevStart = curStart - 1;
+           prevStart > 0 &&
+           pReg->rects[prevStart - 1].y1 == pReg->rects[curStart - 1].y1;
+           prevStart--);
+
+      (void) miCoalesce (pReg, prevStart, curStart);
+    }
+
+  /*
+   * Like miRegionOp, give memory back when the region shrank a lot.
+   */
+  if (pReg->numRects == 0)
+    {
+      if (pReg->rects != &pReg->extents)
+        g_free (pReg->rects);
+
+      pReg->rects = &pReg->extents;
+      pReg->size  = 1;
+    }
+  else if (pReg->numRects < (pReg->size >> 2))
+    {
+      pReg->size  = pReg->numRects * 2;
+      pReg->rects = g_renew (GeglRegionBox, pReg->rects, pReg->size);
+    }
+}
+
+
 /*======================================================================
  *	    Region Union
  *====================================================================*/
@@ -1235,8 +1443,27 @@ gegl_region_union (GeglRegion       *source1,
       return;
     }
 
-  miRegionOp (source1, source1, source2, miUnionO,
-              miUnionNonO, miUnionNonO);
+  if (source2->numRects == 1)
+    {
+      GeglRectangle rect = {source2->extents.x1,
+                            source2->extents.y1,
+                            source2->extents.x2 - source2->extents.x1,
+                            source2->extents.y2 - source2->extents.y1};
+
+      /*
+       * source1 already covers the rectangle
+       */
+      if (gegl_region_rect_in (source1, &rect) == GEGL_OVERLAP_RECTANGLE_IN)
+        return;
+
+      miRegionOpRect (source1, source2, miUnionO,
+                      miUnionNonO, miUnionNonO);
+    }
+  else
+    {
+      miRegionOp (source1, source1, source2, miUnionO,
+                  miUnionNonO, miUnionNonO);
+    }
 
   source1->extents.x1 = MIN (source1->extents.x1, source2->extents.x1);
   source1->extents.y1 = MIN (source1->extents.y1, source2->extents.y1);
@@ -1461,16 +1688,39 @@ gegl_region_subtract (GeglRegion       *source1,
       (!EXTENTCHECK (&source1->extents, &source2->extents)))
     return;
 
-  miRegionOp (source1, source1, source2, miSubtractO,
-              miSubtractNonO1, (nonOverlapFunc) NULL);
+  if (source2->numRects == 1)
+    {
+      miRegionOpRect (source1, source2, miSubtractO,
+                      miSubtractNonO1, (nonOverlapFunc) NULL);
 
-  /*
-   * Can't alter source1's extents before we call miRegionOp because miRegionOp
-   * depends on the extents of those regions being the unaltered. Besides, this
-   * way there's no checking against rectangles that will be nuked
-   * due to coalescing, so we have to examine fewer rectangles.
-   */
-  miSetExtents (source1);
+      /*
+       * Everything left of, right of, above and below the rectangle is
+       * kept, so an edge of the extents can only have moved if the
+       * rectangle reached it.
+       */
+      if (source1->numRects == 0 ||
+          source2->extents.x1 <= source1->extents.x1 ||
+          source2->extents.x2 >= source1->extents.x2 ||
+          source2->extents.y1 <= source1->extents.y1 ||
+          source2->extents.y2 >= source1->extents.y2)
+        {
+          miSetExtents (source1);
+        }
+    }
+  else
+    {
+      miRegionOp (source1, source1, source2, miSubtractO,
+                  miSubtractNonO1, (nonOverlapFunc) NULL);
+
+      /*
+       * Can't alter source1's extents before we call miRegionOp because
+       * miRegionOp depends on the extents of those regions being the
+       * unaltered. Besides, this way there's no checking against rectangles
+       * that will be nuked due to coalescing, so we have to examine fewer
+       * rectangles.
+       */
+      miSetExtents (source1);
+    }
 }
 
 /**
@@ -1570,7 +1820,9 @@ gegl_region_point_in (const GeglRegion *region,
                       gint              x,
                       gint              y)
 {
-  int i;
+  GeglRegionBox *pbox;
+  GeglRegionBox *pboxEnd;
+  GeglRegionBox *pbandEnd;
 
   g_return_val_if_fail (region != NULL, FALSE);
 
@@ -1578,12 +1830,18 @@ gegl_region_point_in (const GeglRegion *region,
     return FALSE;
   if (!INBOX (region->extents, x, y))
     return FALSE;
-  for (i = 0; i < region->numRects; i++)
-    {
-      if (INBOX (region->rects[i], x, y))
-        return TRUE;
-    }
-  return FALSE;
+
+  pboxEnd = region->rects + region->numRects;
+
+  /* find the band containing y, then the box containing x within it */
+  pbox = miSearchY2 (region->rects, pboxEnd, y);
+  if (pbox == pboxEnd || pbox->y1 > y)
+    return FALSE;
+
+  pbandEnd = miSearchY1 (pbox, pboxEnd, pbox->y1 + 1);
+  pbox     = miSearchX2 (pbox, pbandEnd, x);
+
+  return pbox != pbandEnd && pbox->x1 <= x;
 }
 
 /**
@@ -1603,6 +1861,7 @@ gegl_region_rect_in (const GeglRegion    *region,
 {
   GeglRegionBox *pbox;
   GeglRegionBox *pboxEnd;
+  GeglRegionBox *pbandEnd;
   GeglRegionBox  rect;
   GeglRegionBox *prect = &rect;
   gboolean       partIn, partOut;
@@ -1626,13 +1885,17 @@ gegl_region_rect_in (const GeglRegion    *region,
   partOut = FALSE;
   partIn  = FALSE;
 
-  /* can stop when both partOut and partIn are TRUE, or we reach prect->y2 */
-  for (pbox = region->rects, pboxEnd = pbox + region->numRects;
+  /* can stop when both partOut and partIn are TRUE, or we reach prect->y2.
+   * the bands above the rectangle, and the boxes of each band left of it,
+   * are skipped by binary search.
+   */
+  pboxEnd = region->rects + region->numRects;
+
+  for (pbox = miSearchY2 (region->rects, pboxEnd, ry);
        pbox < pboxEnd;
-       pbox++)
+       pbox = pbandEnd)
     {
-      if (pbox->y2 <= ry)
-        continue;/* getting up to speed or skipping remainder of band */
+      pbandEnd = miSearchY1 (pbox, pboxEnd, pbox->y1 + 1);
 
       if (pbox->y1 > ry)
         {
@@ -1642,8 +1905,10 @@ gegl_region_rect_in (const GeglRegion    *region,
           ry = pbox->y1;        /* x guaranteed to be == prect->x1 */
         }
 
-      if (pbox->x2 <= rx)
-        continue;/* not far enough over yet */
+      pbox = miSearchX2 (pbox, pbandEnd, rx);
+
+      if (pbox == pbandEnd)
+        continue;               /* nothing in this band reaches rx */
 
       if (pbox->x1 > rx)
         {
@@ -1664,7 +1929,6 @@ gegl_region_rect_in (const GeglRegion    *region,
           ry = pbox->y2;        /* finished with this band */
           if (ry >= prect->y2)
             break;
-          rx = prect->x1;       /* reset x out to left again */
         }
       else
         {
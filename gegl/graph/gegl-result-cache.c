@@ -0,0 +1,432 @@
+/* This file is part of GEGL.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <glib-object.h>
+#include <glib/gstdio.h>
+
+#include <babl/babl.h>
+
+#include "gegl-types-internal.h"
+#include "gegl.h"
+#include "gegl-config.h"
+#include "gegl-region.h"
+#include "gegl-result-cache.h"
+#include "gegl-node-private.h"
+#include "gegl-pad.h"
+#include "gegl-cache.h"
+#include "property-types/gegl-paramspecs.h"
+
+/* the entries are keyed by the result key and the format of the cache, and
+ * only hold weak references, so that sharing never keeps a cache alive
+ */
+static GMutex      result_cache_mutex;
+static GHashTable *result_cache_entries = NULL;
+
+#define GEGL_RESULT_CACHE_ENTRY "gegl-result-cache-entry"
+
+static gboolean
+gegl_result_cache_append_value (GString      *str,
+                                GParamSpec   *pspec,
+                                const GValue *value)
+{
+  GType type = G_PARAM_SPEC_VALUE_TYPE (pspec);
+
+  if (GEGL_IS_PARAM_SPEC_FORMAT (pspec))
+    {
+      const Babl *format = g_value_get_pointer (value);
+
+      g_string_append (str, format ? babl_get_name (format) : "-");
+    }
+  else if (GEGL_IS_PARAM_SPEC_FILE_PATH (pspec))
+    {
+      const gchar *path = g_value_get_string (value);
+      GStatBuf     st;
+
+      g_string_append_printf (str, "'%s'", path ? path : "");
+
+      /* so that a file changing on disk changes the key as well */
+      if (path && g_stat (path, &st) == 0)
+        {
+          g_string_append_printf (str, ":%" G_GINT64_FORMAT
+                                       ":%" G_GINT64_FORMAT,
+                                  (gint64) st.st_mtime,
+                                  (gint64) st.st_size);
+        }
+    }
+  else if (type == G_TYPE_DOUBLE)
+    {
+      g_string_append_printf (str, "%a", g_value_get_double (value));
+    }
+  else if (type == G_TYPE_FLOAT)
+    {
+      g_string_append_printf (str, "%a", (gdouble) g_value_get_float (value));
+    }
+  else if (G_TYPE_IS_ENUM (type)            ||
+           G_TYPE_IS_FLAGS (type)           ||
+           type == G_TYPE_BOOLEAN           ||
+           type == G_TYPE_CHAR              ||
+           type == G_TYPE_UCHAR             ||
+           type == G_TYPE_INT               ||
+           type == G_TYPE_UINT              ||
+           type == G_TYPE_LONG              ||
+           type == G_TYPE_ULONG             ||
+           type == G_TYPE_INT64             ||
+           type == G_TYPE_UINT64            ||
+           type == G_TYPE_STRING)
+    {
+      gchar *contents = g_strdup_value_contents (value);
+
+      g_string_append (str, contents);
+      g_free (contents);
+    }
+  else if (type == GEGL_TYPE_COLOR)
+    {
+      GeglColor *color = g_value_get_object (value);
+
+      if (color)
+        {
+          gdouble rgba[4];
+
+          gegl_color_get_pixel (color, babl_format ("RGBA double"), rgba);
+
+          g_string_append_printf (str, "%a,%a,%a,%a",
+                                  rgba[0], rgba[1], rgba[2], rgba[3]);
+        }
+      else
+        {
+          g_string_append (str, "-");
+        }
+    }
+  else if (type == GEGL_TYPE_PATH)
+    {
+      GeglPath *path = g_value_get_object (value);
+
+      if (path)
+        {
+          gchar *path_str = gegl_path_to_string (path);
+
+          g_string_append (str, path_str);
+          g_free (path_str);
+        }
+      else
+        {
+          g_string_append (str, "-");
+        }
+    }
+  else
+    {
+      /* buffers, curves, pointers and other objects, which can change
+       * without the node being told, or can't be compared by value
+       */
+      return FALSE;
+    }
+
+  return TRUE;
+}
+
+static const gchar *
+gegl_result_cache_get_key_unlocked (GeglNode *node)
+{
+  GString     *str;
+  GParamSpec **pspecs;
+  guint        n_pspecs;
+  GSList      *iter;
+  gboolean     hashable = TRUE;
+  guint        i;
+
+  if (node->valid_result_key)
+    return node->result_key;
+
+  node->valid_result_key = TRUE;
+
+  g_clear_pointer (&node->result_key, g_free);
+
+  if (! node->operation)
+    return NULL;
+
+  str = g_string_new (gegl_node_get_operation (node));
+
+  if (node->passthrough)
+    g_string_append (str, " passthrough");
+
+  pspecs = g_object_class_list_properties (G_OBJECT_GET_CLASS (node->operation),
+                                           &n_pspecs);
+
+  for (i = 0; i < n_pspecs && hashable; i++)
+    {
+      GValue value = G_VALUE_INIT;
+
+      if (! (pspecs[i]->flags & G_PARAM_READABLE))
+        {
+          hashable = FALSE;
+          break;
+        }
+
+      g_value_init (&value, G_PARAM_SPEC_VALUE_TYPE (pspecs[i]));
+      g_object_get_property (G_OBJECT (node->operation),
+                             g_param_spec_get_name (pspecs[i]), &value);
+
+      g_string_append_printf (str, " %s=", g_param_spec_get_name (pspecs[i]));
+
+      hashable = gegl_result_cache_append_value (str, pspecs[i], &value);
+
+      g_value_unset (&value);
+    }
+
+  g_free (pspecs);
+
+  for (iter = node->input_pads; iter && hashable; iter = g_slist_next (iter))
+    {
+      GeglPad *pad        = iter->data;
+      GeglPad *source_pad = gegl_pad_get_connected_to (pad);
+
+      g_string_append_printf (str, " %s<", gegl_pad_get_name (pad));
+
+      if (source_pad)
+        {
+          const gchar *source_key;
+
+          source_key = gegl_result_cache_get_key_unlocked (
+            gegl_pad_get_node (source_pad));
+
+          if (source_key)
+            {
+              g_string_append_printf (str, "%s.%s",
+                                      source_key,
+                                      gegl_pad_get_name (source_pad));
+            }
+          else
+            {
+              hashable = FALSE;
+            }
+        }
+      else
+        {
+          g_string_append (str, "-");
+        }
+    }
+
+  if (hashable)
+    {
+      node->result_key = g_compute_checksum_for_string (G_CHECKSUM_SHA256,
+                                                        str->str, str->len);
+    }
+
+  g_string_free (str, TRUE);
+
+  return node->result_key;
+}
+
+static void
+gegl_result_cache_free_entry (GWeakRef *ref)
+{
+  g_weak_ref_clear (ref);
+  g_free (ref);
+}
+
+/* stops offering @cache to other nodes */
+static void
+gegl_result_cache_withdraw_unlocked (GeglCache *cache)
+{
+  const gchar *entry = g_object_get_data (G_OBJECT (cache),
+                                          GEGL_RESULT_CACHE_ENTRY);
+
+  if (entry && result_cache_entries)
+    {
+      GWeakRef  *ref   = g_hash_table_lookup (result_cache_entries, entry);
+      GeglCache *other = ref ? g_weak_ref_get (ref) : NULL;
+
+      if (other == cache || (ref && ! other))
+        g_hash_table_remove (result_cache_entries, entry);
+
+      if (other)
+        g_object_unref (other);
+    }
+
+  g_object_set_data (G_OBJECT (cache), GEGL_RESULT_CACHE_ENTRY, NULL);
+}
+
+static void
+gegl_result_cache_publish_unlocked (GeglCache   *cache,
+                                    const gchar *entry)
+{
+  GWeakRef *ref;
+
+  gegl_result_cache_withdraw_unlocked (cache);
+
+  if (! result_cache_entries)
+    {
+      result_cache_entries = g_hash_table_new_full (
+        g_str_hash, g_str_equal,
+        g_free, (GDestroyNotify) gegl_result_cache_free_entry);
+    }
+
+  ref = g_new (GWeakRef, 1);
+  g_weak_ref_init (ref, cache);
+
+  g_hash_table_replace (result_cache_entries, g_strdup (entry), ref);
+
+  g_object_set_data_full (G_OBJECT (cache), GEGL_RESULT_CACHE_ENTRY,
+                          g_strdup (entry), g_free);
+}
+
+const gchar *
+gegl_result_cache_get_key (GeglNode *node)
+{
+  const gchar *key;
+
+  g_return_val_if_fail (GEGL_IS_NODE (node), NULL);
+
+  g_mutex_lock (&result_cache_mutex);
+
+  key = gegl_result_cache_get_key_unlocked (node);
+
+  g_mutex_unlock (&result_cache_mutex);
+
+  return key;
+}
+
+void
+gegl_result_cache_forget (GeglNode *node)
+{
+  g_mutex_lock (&result_cache_mutex);
+
+  if (node->cache)
+    gegl_result_cache_withdraw_unlocked (node->cache);
+
+  g_clear_pointer (&node->result_key, g_free);
+  node->valid_result_key = FALSE;
+
+  g_mutex_unlock (&result_cache_mutex);
+}
+
+gboolean
+gegl_result_cache_fetch (GeglNode            *node,
+                         const GeglRectangle *roi,
+                         gint                 level)
+{
+  GeglCache     *cache;
+  GeglCache     *source = NULL;
+  const gchar   *key;
+  GeglRectangle  rect;
+  gboolean       fetched = FALSE;
+
+  /* mipmap levels are rendered on demand, and not worth sharing */
+  if (! gegl_config ()->shared_cache || level != 0 ||
+      ! gegl_node_use_cache (node))
+    {
+      return FALSE;
+    }
+
+  cache = gegl_node_get_cache (node);
+
+  g_mutex_lock (&result_cache_mutex);
+
+  key = gegl_result_cache_get_key_unlocked (node);
+
+  if (key)
+    {
+      const Babl *format = gegl_buffer_get_format (GEGL_BUFFER (cache));
+      gchar      *entry;
+      GWeakRef   *ref    = NULL;
+
+      entry = g_strdup_printf ("%s %s", key, babl_get_name (format));
+
+      if (result_cache_entries)
+        ref = g_hash_table_lookup (result_cache_entries, entry);
+
+      if (ref)
+        source = g_weak_ref_get (ref);
+
+      /* nothing with the same result is around, offer ours instead */
+      if (! source)
+        gegl_result_cache_publish_unlocked (cache, entry);
+
+      g_free (entry);
+    }
+
+  g_mutex_unlock (&result_cache_mutex);
+
+  if (! source)
+    return FALSE;
+
+  if (source == cache)
+    {
+      g_object_unref (source);
+
+      return FALSE;
+    }
+
+  g_mutex_lock (&cache->mutex);
+
+  if (gegl_region_rect_in (cache->valid_region[0], roi) ==
+      GEGL_OVERLAP_RECTANGLE_IN)
+    {
+      g_mutex_unlock (&cache->mutex);
+      g_object_unref (source);
+
+      return FALSE;
+    }
+
+  g_mutex_unlock (&cache->mutex);
+
+  /* holding the mutex of the source keeps it from being invalidated, and
+   * rendered into, halfway through the copy
+   */
+  g_mutex_lock (&source->mutex);
+
+  /* prefer whole tiles, which are shared rather than copied */
+  gegl_rectangle_align_to_buffer (&rect, roi, GEGL_BUFFER (cache),
+                                  GEGL_RECTANGLE_ALIGNMENT_SUPERSET);
+  gegl_rectangle_intersect (&rect, &rect,
+                            gegl_buffer_get_extent (GEGL_BUFFER (cache)));
+
+  if (gegl_region_rect_in (source->valid_region[0], &rect) !=
+      GEGL_OVERLAP_RECTANGLE_IN)
+    {
+      rect = *roi;
+    }
+
+  if (gegl_region_rect_in (source->valid_region[0], &rect) ==
+      GEGL_OVERLAP_RECTANGLE_IN)
+    {
+      gegl_buffer_copy (GEGL_BUFFER (source), &rect, GEGL_ABYSS_NONE,
+                        GEGL_BUFFER (cache), &rect);
+
+      fetched = TRUE;
+    }
+
+  g_mutex_unlock (&source->mutex);
+
+  if (fetched)
+    gegl_cache_computed (cache, &rect, 0);
+
+  g_object_unref (source);
+
+  return fetched;
+}
+
+void
+gegl_result_cache_cleanup (void)
+{
+  g_mutex_lock (&result_cache_mutex);
+
+  g_clear_pointer (&result_cache_entries, g_hash_table_destroy);
+
+  g_mutex_unlock (&result_cache_mutex);
+}
@@ -0,0 +1,53 @@
+/* This file is part of GEGL.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef __GEGL_RESULT_CACHE_H__
+#define __GEGL_RESULT_CACHE_H__
+
+#include "gegl-types-internal.h"
+
+G_BEGIN_DECLS
+
+/* the result cache lets nodes in different graphs, or in different places
+ * of the same graph, share the content of their caches when they compute
+ * the same thing: the same operation, with the same properties, fed by
+ * inputs that are themselves the same.  matching tiles are shared
+ * copy-on-write, so they only take up room in the tile cache once.
+ */
+
+/* returns a stable hash identifying the result of @node, or NULL if it
+ * depends on state that can not be hashed, like buffer or object properties
+ */
+const gchar * gegl_result_cache_get_key (GeglNode            *node);
+
+/* drops the key of @node, and withdraws its cache from sharing.  called
+ * whenever @node is invalidated.
+ */
+void          gegl_result_cache_forget  (GeglNode            *node);
+
+/* makes the cache of @node valid for @roi by sharing the tiles of a
+ * matching node, returning TRUE if it did.  the cache of @node is offered
+ * to other nodes in turn.
+ */
+gboolean      gegl_result_cache_fetch   (GeglNode            *node,
+                                         const GeglRectangle *roi,
+                                         gint                 level);
+
+void          gegl_result_cache_cleanup (void);
+
+G_END_DECLS
+
+#endif /* __GEGL_RESULT_CACHE_H__ */
@@ -24,6 +24,20 @@ G_BEGIN_DECLS
 
 gboolean   gegl_operation_use_cache (GeglOperation *operation);
 
+/* records the processing of an operation that was run as part of a larger
+ * pass, such as a fused run of point operations, rather than through
+ * gegl_operation_process().  t is the time, in seconds, spent on the
+ * operation's share of the pass, summed over all threads; trace_start and
+ * trace_end delimit its span in the trace.
+ */
+void       gegl_operation_record_process (GeglOperation       *operation,
+                                          const gchar         *output_pad,
+                                          const GeglRectangle *result,
+                                          gint                 level,
+                                          gdouble              t,
+                                          long                 trace_start,
+                                          long                 trace_end);
+
 
 G_END_DECLS
 
@@ -25,6 +25,7 @@
 
 #include "gegl.h"
 #include "gegl-config.h"
+#include "gegl-instrument.h"
 #include "gegl-types-internal.h"
 #include "gegl-parallel-private.h"
 #include "gegl-operation.h"
@@ -57,6 +58,11 @@ static GeglRectangle   get_bounding_box                 (GeglOperation       *se
 static GeglRectangle   get_invalidated_by_change        (GeglOperation       *self,
                                                          const gchar         *input_pad,
                                                          const GeglRectangle *input_region);
+static GeglRectangle   get_invalidated_by_property_change
+                                                        (GeglOperation       *self,
+                                                         GParamSpec          *pspec,
+                                                         const GeglRectangle *old_rect,
+                                                         const GeglRectangle *new_rect);
 static GeglRectangle   get_required_for_output          (GeglOperation       *self,
                                                          const gchar         *input_pad,
                                                          const GeglRectangle *region);
@@ -65,6 +71,13 @@ static void            gegl_operation_update_pixel_time (GeglOperation       *se
                                                          const GeglRectangle *roi,
                                                          gdouble              t);
 
+static void            gegl_operation_trace_process     (GeglOperation       *self,
+                                                         const gchar         *output_pad,
+                                                         const GeglRectangle *result,
+                                                         gint                 level,
+                                                         long                 start,
+                                                         long                 end);
+
 
 G_DEFINE_TYPE_WITH_PRIVATE (GeglOperation, gegl_operation, G_TYPE_OBJECT)
 
@@ -86,6 +99,8 @@ gegl_operation_class_init (GeglOperationClass *klass)
   klass->cache_policy              = GEGL_CACHE_POLICY_AUTO;
   klass->get_bounding_box          = get_bounding_box;
   klass->get_invalidated_by_change = get_invalidated_by_change;
+  klass->get_invalidated_by_property_change =
+    get_invalidated_by_property_change;
   klass->get_required_for_output   = get_required_for_output;
   klass->cl_data                   = NULL;
 }
@@ -139,6 +154,9 @@ gegl_operation_process (GeglOperation        *operation,
   gint64              t;
   gint64              n_pixels;
   gboolean            update_pixel_time;
+  gboolean            trace;
+  long                trace_start = 0;
+  const gchar        *trace_scope = NULL;
   gboolean            success;
 
   g_return_val_if_fail (GEGL_IS_OPERATION (operation), FALSE);
@@ -173,8 +191,25 @@ gegl_operation_process (GeglOperation        *operation,
   if (update_pixel_time)
     t = g_get_monotonic_time ();
 
+  trace = gegl_instrument_trace_enabled;
+
+  if (trace)
+    {
+      trace_start = gegl_ticks ();
+      trace_scope = gegl_instrument_trace_set_scope (
+        klass->name ? klass->name : G_OBJECT_TYPE_NAME (operation));
+    }
+
   success = klass->process (operation, context, output_pad, result, level);
 
+  if (trace)
+    {
+      gegl_operation_trace_process (operation, output_pad, result, level,
+                                    trace_start, gegl_ticks ());
+
+      gegl_instrument_trace_set_scope (trace_scope);
+    }
+
   if (success && update_pixel_time)
     {
       t = g_get_monotonic_time () - t;
@@ -186,6 +221,46 @@ gegl_operation_process (GeglOperation        *operation,
   return success;
 }
 
+void
+gegl_operation_record_process (GeglOperation       *operation,
+                               const gchar         *output_pad,
+                               const GeglRectangle *result,
+                               gint                 level,
+                               gdouble              t,
+                               long                 trace_start,
+                               long                 trace_end)
+{
+  GeglOperationPrivate *priv;
+  gint64                n_pixels;
+
+  g_return_if_fail (GEGL_IS_OPERATION (operation));
+  g_return_if_fail (result != NULL);
+
+  priv = gegl_operation_get_instance_private (operation);
+
+  n_pixels = (gint64) result->width * (gint64) result->height;
+
+  /* t is summed over all the threads the operation ran on, so, unlike in
+   * gegl_operation_update_pixel_time(), there's no thread overhead to
+   * account for.
+   */
+  if (n_pixels >= GEGL_OPERATION_MIN_PIXELS_PER_PIXEL_TIME_UPDATE)
+    priv->pixel_time = MAX (t, 0.0) / n_pixels;
+
+  if (gegl_instrument_trace_enabled)
+    {
+      GeglOperationClass *klass = GEGL_OPERATION_GET_CLASS (operation);
+      const gchar        *trace_scope;
+
+      trace_scope = gegl_instrument_trace_set_scope (
+        klass->name ? klass->name : G_OBJECT_TYPE_NAME (operation));
+
+      gegl_operation_trace_process (operation, output_pad, result, level,
+                                    trace_start, trace_end);
+
+      gegl_instrument_trace_set_scope (trace_scope);
+    }
+}
 
 /* Calls an extending class' get_bound_box method if defined otherwise
  * just returns a zero-initialised bounding box
@@ -241,6 +316,33 @@ gegl_operation_get_invalidated_by_change (GeglOperation       *self,
   return *input_region;
 }
 
+GeglRectangle
+gegl_operation_get_invalidated_by_property_change (GeglOperation       *self,
+                                                   GParamSpec          *pspec,
+                                                   const GeglRectangle *old_rect,
+                                                   const GeglRectangle *new_rect)
+{
+  GeglOperationClass *klass;
+  GeglRectangle       retval = { 0, };
+
+  g_return_val_if_fail (GEGL_IS_OPERATION (self), retval);
+  g_return_val_if_fail (pspec != NULL, retval);
+  g_return_val_if_fail (old_rect != NULL, retval);
+  g_return_val_if_fail (new_rect != NULL, retval);
+
+  klass = GEGL_OPERATION_GET_CLASS (self);
+
+  if ((self->node && self->node->passthrough) ||
+      ! klass->get_invalidated_by_property_change)
+    {
+      return get_invalidated_by_property_change (self, pspec,
+                                                 old_rect, new_rect);
+    }
+
+  return klass->get_invalidated_by_property_change (self, pspec,
+                                                    old_rect, new_rect);
+}
+
 static GeglRectangle
 get_required_for_output (GeglOperation        *operation,
                          const gchar         *input_pad,
@@ -464,6 +566,19 @@ get_invalidated_by_change (GeglOperation        *self,
   return *input_region;
 }
 
+static GeglRectangle
+get_invalidated_by_property_change (GeglOperation       *self,
+                                    GParamSpec          *pspec,
+                                    const GeglRectangle *old_rect,
+                                    const GeglRectangle *new_rect)
+{
+  GeglRectangle result;
+
+  gegl_rectangle_bounding_box (&result, old_rect, new_rect);
+
+  return result;
+}
+
 /* returns a freshly allocated list of the properties of the object, does not list
  * the regular gobject properties of GeglNode ('name' and 'operation') */
 GParamSpec **
@@ -961,6 +1076,67 @@ gegl_operation_update_pixel_time (GeglOperation       *self,
   priv->pixel_time = MAX (priv->pixel_time, 0.0);
 }
 
+/* records a trace span for a process() call, including an estimate of the
+ * number of bytes it touched: its output, plus the parts of its inputs it
+ * requires.
+ */
+static void
+gegl_operation_trace_process (GeglOperation       *self,
+                              const gchar         *output_pad,
+                              const GeglRectangle *result,
+                              gint                 level,
+                              long                 start,
+                              long                 end)
+{
+  static const gchar *input_pads[] = {"input", "aux", "aux2"};
+  const Babl         *format;
+  gint64              bytes = 0;
+  gchar              *node_name;
+  gint                i;
+
+  format = gegl_operation_get_format (self, output_pad);
+
+  if (format)
+    {
+      bytes += (gint64) result->width * (gint64) result->height *
+               babl_format_get_bytes_per_pixel (format);
+    }
+
+  for (i = 0; i < G_N_ELEMENTS (input_pads); i++)
+    {
+      GeglRectangle rect;
+
+      if (! gegl_node_has_pad (self->node, input_pads[i]))
+        continue;
+
+      format = gegl_operation_get_format (self, input_pads[i]);
+
+      if (! format)
+        continue;
+
+      rect = gegl_operation_get_required_for_output (self, input_pads[i],
+                                                     result);
+
+      bytes += (gint64) rect.width * (gint64) rect.height *
+               babl_format_get_bytes_per_pixel (format);
+    }
+
+  node_name = gegl_instrument_trace_escape (
+    gegl_node_get_debug_name (self->node));
+
+  real_gegl_instrument_trace (
+    "process",
+    gegl_instrument_trace_get_scope (),
+    start, end,
+    "\"node\":\"%s\",\"pad\":\"%s\",\"roi\":[%d,%d,%d,%d],"
+    "\"level\":%d,\"bytes\":%" G_GINT64_FORMAT,
+    node_name, output_pad,
+    result->x, result->y, result->width, result->height,
+    level, bytes);
+
+  g_free (node_name);
+}
+
 static guchar *gegl_temp_alloc[GEGL_MAX_THREADS * 4]={NULL,};
 static gint    gegl_temp_size[GEGL_MAX_THREADS * 4]={0,};
 
@@ -154,13 +154,30 @@ struct _GeglOperationClass
 
   GeglClRunData *cl_data;
 
-  gpointer      pad[9];
+  /* The output region that is made invalid by a change of the property
+   * pspec, given the bounding box of the output before (old_rect) and
+   * after (new_rect) the change. Defaults to the bounding box of both,
+   * operations where a property only affects part of the output can
+   * return less.
+   */
+  GeglRectangle (*get_invalidated_by_property_change)
+                                             (GeglOperation       *operation,
+                                              GParamSpec          *pspec,
+                                              const GeglRectangle *old_rect,
+                                              const GeglRectangle *new_rect);
+
+  gpointer      pad[8];
 };
 
 GeglRectangle   gegl_operation_get_invalidated_by_change
                                              (GeglOperation *operation,
                                               const gchar   *input_pad,
                                               const GeglRectangle *roi);
+GeglRectangle   gegl_operation_get_invalidated_by_property_change
+                                             (GeglOperation       *operation,
+                                              GParamSpec          *pspec,
+                                              const GeglRectangle *old_rect,
+                                              const GeglRectangle *new_rect);
 GeglRectangle   gegl_operation_get_bounding_box  (GeglOperation *operation);
 
 /* retrieves the bounding box of an input pad */
@@ -25,6 +25,8 @@ struct _GeglGraphTraversal
   GQueue      path;
   gboolean    rects_dirty;
   GeglBuffer *shared_empty;
+  GPtrArray  *fusions;
+  GHashTable *fused_nodes;
 };
 
 #endif /* __GEGL_GRAPH_TRAVERSAL_PRIVATE_H__ */
@@ -19,6 +19,8 @@
 
 #include "config.h"
 
+#include <string.h>
+
 #include <glib-object.h>
 
 #include "gegl-types-internal.h"
@@ -30,6 +32,7 @@
 
 #include "graph/gegl-node-private.h"
 #include "graph/gegl-pad.h"
+#include "graph/gegl-result-cache.h"
 #include "graph/gegl-visitor.h"
 #include "graph/gegl-callback-visitor.h"
 #include "graph/gegl-visitable.h"
@@ -39,8 +42,14 @@
 #include "process/gegl-graph-traversal-private.h"
 
 #include "operation/gegl-operation.h"
+#include "operation/gegl-operation-private.h"
 #include "operation/gegl-operation-context.h"
 #include "operation/gegl-operation-context-private.h"
+#include "operation/gegl-operation-point-composer.h"
+#include "operation/gegl-operation-point-filter.h"
+
+/* the maximal number of aux inputs read by a single fused run */
+#define GEGL_GRAPH_FUSION_MAX_AUX 8
 
 typedef struct
 {
@@ -48,12 +57,48 @@ typedef struct
   GeglOperationContext *context;
 } ContextConnection;
 
+/* a run of point operations, each consuming the output of the previous one,
+ * which is processed in a single pass when the last one (the tail) is
+ * reached, without materializing the intermediate results.
+ */
+typedef struct
+{
+  GPtrArray *nodes;
+  gint       n_aux;
+} GeglGraphFusion;
+
+typedef struct
+{
+  GeglOperation *operation;
+  gboolean       composer;
+  const Babl    *fish;
+  GeglBuffer    *aux;
+  const Babl    *aux_format;
+  gint           aux_index;
+  gint64         time;
+} GeglGraphFusionStage;
+
+typedef struct
+{
+  GeglGraphFusionStage *stages;
+  gint                  n_stages;
+  gint                  n_aux;
+  GeglBuffer           *input;
+  const Babl           *input_format;
+  GeglBuffer           *output;
+  const Babl           *output_format;
+  gint                  max_bpp;
+  gint                  level;
+  GMutex                mutex;
+} GeglGraphFusionData;
+
 static void   free_context_connection                  (gpointer concon);
 static GList *gegl_graph_get_connected_output_contexts (GeglGraphTraversal *path,
                                                         GeglPad            *output_pad);
 static void   _gegl_graph_do_build                     (GeglGraphTraversal *path,
                                                         GeglNode           *node);
 static GeglBuffer *gegl_graph_get_shared_empty         (GeglGraphTraversal *path);
+static void   gegl_graph_clear_fusions                 (GeglGraphTraversal *path);
 
 static gboolean
 _gegl_graph_do_build_add_node (GeglNode *node,
@@ -131,6 +176,7 @@ gegl_graph_rebuild (GeglGraphTraversal *path, GeglNode *node)
 {
   g_queue_clear (&path->path);
   g_hash_table_unref (path->contexts);
+  gegl_graph_clear_fusions (path);
 
   /* Replaces everything but shared_empty */
   _gegl_graph_do_build (path, node);
@@ -141,6 +187,7 @@ gegl_graph_free (GeglGraphTraversal *path)
 {
   g_queue_clear (&path->path);
   g_hash_table_unref (path->contexts);
+  gegl_graph_clear_fusions (path);
   g_clear_object (&path->shared_empty);
   g_free (path);
 }
@@ -166,6 +213,164 @@ gegl_graph_get_bounding_box (GeglGraphTraversal *path)
   return *GEGL_RECTANGLE(0, 0, 0, 0);
 }
 
+static void
+gegl_graph_fusion_free (GeglGraphFusion *fusion)
+{
+  g_ptr_array_unref (fusion->nodes);
+  g_slice_free (GeglGraphFusion, fusion);
+}
+
+static void
+gegl_graph_clear_fusions (GeglGraphTraversal *path)
+{
+  g_clear_pointer (&path->fused_nodes, g_hash_table_unref);
+  g_clear_pointer (&path->fusions, g_ptr_array_unref);
+}
+
+/* only point operations which use the stock processing path can be fused,
+ * since we call their per-pixel process() function directly.
+ */
+static gboolean
+gegl_graph_node_is_fusible (GeglNode *node)
+{
+  GeglOperation      *operation = node->operation;
+  GeglOperationClass *klass;
+  GeglOperationClass *base_class;
+
+  if (! operation || node->passthrough)
+    return FALSE;
+
+  klass = GEGL_OPERATION_GET_CLASS (operation);
+
+  if (GEGL_IS_OPERATION_POINT_FILTER (operation))
+    {
+      base_class = g_type_class_peek (GEGL_TYPE_OPERATION_POINT_FILTER);
+
+      if (GEGL_OPERATION_FILTER_CLASS (klass)->process !=
+          GEGL_OPERATION_FILTER_CLASS (base_class)->process ||
+          ! GEGL_OPERATION_POINT_FILTER_CLASS (klass)->process)
+        {
+          return FALSE;
+        }
+    }
+  else if (GEGL_IS_OPERATION_POINT_COMPOSER (operation))
+    {
+      base_class = g_type_class_peek (GEGL_TYPE_OPERATION_POINT_COMPOSER);
+
+      if (GEGL_OPERATION_COMPOSER_CLASS (klass)->process !=
+          GEGL_OPERATION_COMPOSER_CLASS (base_class)->process ||
+          ! GEGL_OPERATION_POINT_COMPOSER_CLASS (klass)->process)
+        {
+          return FALSE;
+        }
+    }
+  else
+    {
+      return FALSE;
+    }
+
+  if (klass->process != base_class->process)
+    return FALSE;
+
+  if (gegl_operation_use_opencl (operation))
+    return FALSE;
+
+  return TRUE;
+}
+
+/* find the point operation feeding the input pad of @node, if its output
+ * goes nowhere else, and so doesn't need to be materialized.
+ */
+static GeglNode *
+gegl_graph_get_fusible_source (GeglNode *node)
+{
+  GeglPad  *input_pad;
+  GeglPad  *output_pad;
+  GeglNode *source;
+
+  input_pad = gegl_node_get_pad (node, "input");
+
+  if (! input_pad)
+    return NULL;
+
+  output_pad = gegl_pad_get_connected_to (input_pad);
+
+  if (! output_pad || strcmp (gegl_pad_get_name (output_pad), "output"))
+    return NULL;
+
+  source = gegl_pad_get_node (output_pad);
+
+  if (g_slist_length (gegl_pad_get_connections (output_pad)) != 1 ||
+      gegl_node_use_cache (source)                                ||
+      ! gegl_graph_node_is_fusible (source))
+    {
+      return NULL;
+    }
+
+  return source;
+}
+
+static void
+gegl_graph_find_fusions (GeglGraphTraversal *path)
+{
+  GList *list_iter;
+
+  gegl_graph_clear_fusions (path);
+
+  for (list_iter = g_queue_peek_head_link (&path->path);
+       list_iter;
+       list_iter = list_iter->next)
+    {
+      GeglNode        *node = GEGL_NODE (list_iter->data);
+      GeglNode        *source;
+      GeglGraphFusion *fusion;
+      gint             n_aux;
+
+      if (! gegl_graph_node_is_fusible (node))
+        continue;
+
+      source = gegl_graph_get_fusible_source (node);
+
+      if (! source || ! g_hash_table_contains (path->contexts, source))
+        continue;
+
+      n_aux = gegl_node_get_pad (node, "aux") ? 1 : 0;
+
+      if (! path->fused_nodes)
+        {
+          path->fusions     = g_ptr_array_new_with_free_func (
+            (GDestroyNotify) gegl_graph_fusion_free);
+          path->fused_nodes = g_hash_table_new (NULL, NULL);
+        }
+
+      fusion = g_hash_table_lookup (path->fused_nodes, source);
+
+      if (! fusion)
+        {
+          fusion        = g_slice_new0 (GeglGraphFusion);
+          fusion->nodes = g_ptr_array_new ();
+          fusion->n_aux = gegl_node_get_pad (source, "aux") ? 1 : 0;
+
+          g_ptr_array_add (fusion->nodes, source);
+          g_ptr_array_add (path->fusions, fusion);
+
+          g_hash_table_insert (path->fused_nodes, source, fusion);
+        }
+      else if (fusion->n_aux + n_aux > GEGL_GRAPH_FUSION_MAX_AUX)
+        {
+          continue;
+        }
+
+      /* the path is in topological order, so the source is always the
+       * current tail of its run.
+       */
+      g_ptr_array_add (fusion->nodes, node);
+      fusion->n_aux += n_aux;
+
+      g_hash_table_insert (path->fused_nodes, node, fusion);
+    }
+}
+
 /**
  * gegl_graph_prepare:
  * @path: The traversal path
@@ -232,6 +437,8 @@ gegl_graph_prepare (GeglGraphTraversal *path)
                              context);
       }
   }
+
+  gegl_graph_find_fusions (path);
 }
 
 /**
@@ -309,7 +516,10 @@ gegl_graph_prepare_request (GeglGraphTraversal  *path,
           gegl_operation_context_set_result_rect (context, &empty_rect);
           continue;
         }
-      
+
+      /* another node may already have computed the same result */
+      gegl_result_cache_fetch (node, request, level);
+
       if (node->cache)
         {
           gint i;
@@ -409,6 +619,410 @@ gegl_graph_get_shared_empty (GeglGraphTraversal *path)
 }
 
 
+static GeglBuffer *
+gegl_graph_process_node (GeglGraphTraversal   *path,
+                         GeglNode             *node,
+                         GeglOperationContext *context,
+                         gint                  level)
+{
+  GeglOperation *operation        = node->operation;
+  GeglBuffer    *operation_result = NULL;
+
+  GEGL_NOTE (GEGL_DEBUG_PROCESS,
+             "Will process %s result_rect = %d, %d %d×%d",
+             gegl_node_get_debug_name (node),
+             context->result_rect.x, context->result_rect.y, context->result_rect.width, context->result_rect.height);
+
+  if (context->need_rect.width > 0 && context->need_rect.height > 0)
+    {
+      if (context->cached)
+        {
+          GEGL_NOTE (GEGL_DEBUG_PROCESS,
+                     "Using cached result for %s",
+                     gegl_node_get_debug_name (node));
+          operation_result = GEGL_BUFFER (node->cache);
+        }
+      else
+        {
+          /* provide something on input pad, always - this makes having
+             behavior depending on it not being set.. not work, is
+             sacrifising that worth it?
+           */
+          if (gegl_node_has_pad (node, "input") &&
+              !gegl_operation_context_get_object (context, "input"))
+            {
+              gegl_operation_context_set_object (context, "input", G_OBJECT (gegl_graph_get_shared_empty(path)));
+            }
+
+          context->level = level;
+
+          /* note: this hard-coding of "output" makes some more custom
+           * graph topologies harder than necessary.
+           */
+          gegl_operation_process (operation, context, "output", &context->need_rect, context->level);
+          operation_result = GEGL_BUFFER (gegl_operation_context_get_object (context, "output"));
+
+          if (operation_result && operation_result == (GeglBuffer *)operation->node->cache)
+            gegl_cache_computed (operation->node->cache, &context->need_rect, level);
+        }
+    }
+
+  return operation_result;
+}
+
+static void
+gegl_graph_deliver (GeglGraphTraversal *path,
+                    GeglNode           *node,
+                    GeglBuffer         *operation_result)
+{
+  GeglPad *output_pad;
+  GList   *targets;
+  GList   *targets_iter;
+
+  if (! operation_result)
+    return;
+
+  output_pad = gegl_node_get_pad (node, "output");
+  targets    = gegl_graph_get_connected_output_contexts (path, output_pad);
+
+  GEGL_NOTE (GEGL_DEBUG_PROCESS,
+             "Will deliver the results of %s:%s to %d targets",
+             gegl_node_get_debug_name (node),
+             "output",
+             g_list_length (targets));
+
+  if (g_list_length (targets) > 1)
+    gegl_object_set_has_forked (G_OBJECT (operation_result));
+
+  for (targets_iter = targets; targets_iter; targets_iter = g_list_next (targets_iter))
+    {
+      ContextConnection *target_con = targets_iter->data;
+      gegl_operation_context_set_object (target_con->context, target_con->name, G_OBJECT (operation_result));
+    }
+  g_list_free_full (targets, free_context_connection);
+}
+
+static void
+gegl_graph_fusion_process_area (const GeglRectangle *area,
+                                GeglGraphFusionData *data)
+{
+  GeglBufferIterator *iter;
+  guint8             *scratch    = NULL;
+  glong               max_length = 0;
+  gint64             *times;
+  gint                read;
+  gint                i;
+
+  /* the time spent on each stage, which stands in for the time its
+   * operation's process() would have taken.
+   */
+  times = g_newa (gint64, data->n_stages);
+  memset (times, 0, data->n_stages * sizeof (gint64));
+
+  iter = gegl_buffer_iterator_new (data->output, area, data->level,
+                                   data->output_format,
+                                   GEGL_ACCESS_WRITE, GEGL_ABYSS_NONE,
+                                   2 + data->n_aux);
+
+  read = gegl_buffer_iterator_add (iter, data->input, area, data->level,
+                                   data->input_format,
+                                   GEGL_ACCESS_READ, GEGL_ABYSS_NONE);
+
+  for (i = 0; i < data->n_stages; i++)
+    {
+      const GeglGraphFusionStage *stage = &data->stages[i];
+
+      if (stage->aux)
+        {
+          gegl_buffer_iterator_add (iter, stage->aux, area, data->level,
+                                    stage->aux_format,
+                                    GEGL_ACCESS_READ, GEGL_ABYSS_NONE);
+        }
+    }
+
+  while (gegl_buffer_iterator_next (iter))
+    {
+      glong    length = iter->length;
+      gpointer src    = iter->items[read].data;
+      gpointer bufs[3];
+      gint64   t;
+
+      /* two buffers for ping-ponging the intermediate results between
+       * stages, and one for converting them between formats.
+       */
+      if (length > max_length)
+        {
+          if (scratch)
+            gegl_scratch_free (scratch);
+
+          max_length = length;
+          scratch    = gegl_scratch_alloc (3 * max_length * data->max_bpp);
+        }
+
+      bufs[0] = scratch;
+      bufs[1] = scratch + 1 * max_length * data->max_bpp;
+      bufs[2] = scratch + 2 * max_length * data->max_bpp;
+
+      t = g_get_monotonic_time ();
+
+      for (i = 0; i < data->n_stages; i++)
+        {
+          const GeglGraphFusionStage *stage = &data->stages[i];
+          gpointer                    dst;
+
+          if (stage->fish)
+            {
+              babl_process (stage->fish, src, bufs[2], length);
+
+              src = bufs[2];
+            }
+
+          if (i == data->n_stages - 1)
+            dst = iter->items[0].data;
+          else
+            dst = bufs[i & 1];
+
+          if (stage->composer)
+            {
+              GEGL_OPERATION_POINT_COMPOSER_GET_CLASS (stage->operation)->process (
+                stage->operation,
+                src,
+                stage->aux ? iter->items[stage->aux_index].data : NULL,
+                dst, length, &iter->items[0].roi, data->level);
+            }
+          else
+            {
+              GEGL_OPERATION_POINT_FILTER_GET_CLASS (stage->operation)->process (
+                stage->operation,
+                src,
+                dst, length, &iter->items[0].roi, data->level);
+            }
+
+          src = dst;
+
+          times[i] -= t;
+          t         = g_get_monotonic_time ();
+          times[i] += t;
+        }
+    }
+
+  if (scratch)
+    gegl_scratch_free (scratch);
+
+  g_mutex_lock (&data->mutex);
+
+  for (i = 0; i < data->n_stages; i++)
+    data->stages[i].time += times[i];
+
+  g_mutex_unlock (&data->mutex);
+}
+
+/* processes a fused run of point operations in a single pass over its
+ * input, passing each chunk of pixels through all of the operations while
+ * it's still in cache.  returns FALSE if the run can't be processed as a
+ * whole this time around, in which case its nodes should be processed
+ * separately.
+ */
+static gboolean
+gegl_graph_process_fusion (GeglGraphTraversal  *path,
+                           GeglGraphFusion     *fusion,
+                           gint                 level,
+                           GeglBuffer         **operation_result)
+{
+  GeglNode             *tail;
+  GeglOperationContext *tail_context;
+  GeglOperationContext *head_context;
+  GeglGraphFusionData   data;
+  GeglRectangle         roi;
+  const Babl           *format;
+  gdouble               pixel_cost = 0.0;
+  gboolean              success    = FALSE;
+  long                  trace_start = 0;
+  long                  trace_end   = 0;
+  gint64                total_time  = 0;
+  gint64                elapsed     = 0;
+  guint                 i;
+
+  tail         = g_ptr_array_index (fusion->nodes, fusion->nodes->len - 1);
+  tail_context = g_hash_table_lookup (path->contexts, tail);
+  head_context = g_hash_table_lookup (path->contexts,
+                                      g_ptr_array_index (fusion->nodes, 0));
+
+  roi = tail_context->need_rect;
+
+  if (roi.width <= 0 || roi.height <= 0)
+    return FALSE;
+
+  /* all the nodes of the run must need the same area, and none of them can
+   * be satisfied from a cache.
+   */
+  for (i = 0; i < fusion->nodes->len; i++)
+    {
+      GeglOperationContext *context;
+
+      context = g_hash_table_lookup (path->contexts,
+                                     g_ptr_array_index (fusion->nodes, i));
+
+      if (context->cached ||
+          ! gegl_rectangle_equal (&context->need_rect, &roi))
+        {
+          return FALSE;
+        }
+    }
+
+  if (gegl_instrument_trace_enabled)
+    trace_start = gegl_ticks ();
+
+  memset (&data, 0, sizeof (data));
+
+  data.stages   = g_new0 (GeglGraphFusionStage, fusion->nodes->len);
+  data.n_stages = fusion->nodes->len;
+  data.level    = level;
+
+  g_mutex_init (&data.mutex);
+
+  format = NULL;
+
+  for (i = 0; i < fusion->nodes->len; i++)
+    {
+      GeglNode             *node    = g_ptr_array_index (fusion->nodes, i);
+      GeglOperationContext *context = g_hash_table_lookup (path->contexts,
+                                                           node);
+      GeglGraphFusionStage *stage   = &data.stages[i];
+      const Babl           *input_format;
+      const Babl           *output_format;
+
+      stage->operation = node->operation;
+      stage->composer  = GEGL_IS_OPERATION_POINT_COMPOSER (node->operation);
+
+      input_format  = gegl_operation_get_format (node->operation, "input");
+      output_format = gegl_operation_get_format (node->operation, "output");
+
+      if (! input_format || ! output_format)
+        goto cleanup;
+
+      if (i == 0)
+        data.input_format = input_format;
+      else if (input_format != format)
+        stage->fish = babl_fish (format, input_format);
+
+      if (stage->composer)
+        {
+          stage->aux = GEGL_BUFFER (
+            gegl_operation_context_dup_object (context, "aux"));
+
+          if (stage->aux)
+            {
+              stage->aux_format = gegl_operation_get_format (node->operation,
+                                                             "aux");
+              stage->aux_index  = 2 + data.n_aux++;
+            }
+        }
+
+      data.max_bpp = MAX (data.max_bpp,
+                          babl_format_get_bytes_per_pixel (input_format));
+      data.max_bpp = MAX (data.max_bpp,
+                          babl_format_get_bytes_per_pixel (output_format));
+
+      pixel_cost += 1.0 / gegl_operation_get_pixels_per_thread (node->operation);
+
+      format = output_format;
+    }
+
+  data.output_format = format;
+
+  if (gegl_node_has_pad (g_ptr_array_index (fusion->nodes, 0), "input") &&
+      ! gegl_operation_context_get_object (head_context, "input"))
+    {
+      gegl_operation_context_set_object (head_context, "input",
+                                         G_OBJECT (gegl_graph_get_shared_empty (path)));
+    }
+
+  data.input = GEGL_BUFFER (
+    gegl_operation_context_dup_object (head_context, "input"));
+
+  if (! data.input)
+    goto cleanup;
+
+  tail_context->level = level;
+
+  data.output = gegl_operation_context_get_target (tail_context, "output");
+
+  if (level)
+    {
+      roi.x      >>= level;
+      roi.y      >>= level;
+      roi.width  >>= level;
+      roi.height >>= level;
+    }
+
+  if (gegl_operation_use_threading (tail->operation, &roi))
+    {
+      gegl_parallel_distribute_area (
+        &roi,
+        1.0 / pixel_cost,
+        GEGL_SPLIT_STRATEGY_AUTO,
+        (GeglParallelDistributeAreaFunc) gegl_graph_fusion_process_area,
+        &data);
+    }
+  else
+    {
+      gegl_graph_fusion_process_area (&roi, &data);
+    }
+
+  if (data.output == (GeglBuffer *) tail->cache)
+    gegl_cache_computed (tail->cache, &tail_context->need_rect, level);
+
+  if (gegl_instrument_trace_enabled)
+    trace_end = gegl_ticks ();
+
+  for (i = 0; i < data.n_stages; i++)
+    total_time += data.stages[i].time;
+
+  /* record each stage on its operation, as if it had been processed on its
+   * own.  the stages are interleaved over the whole run, so their trace
+   * spans split the run's span in proportion to the time each one took.
+   */
+  for (i = 0; i < data.n_stages; i++)
+    {
+      const GeglGraphFusionStage *stage = &data.stages[i];
+      long                        span_start;
+      long                        span_end;
+
+      span_start  = trace_start +
+                    (trace_end - trace_start) * elapsed / MAX (total_time, 1);
+      elapsed    += stage->time;
+      span_end    = trace_start +
+                    (trace_end - trace_start) * elapsed / MAX (total_time, 1);
+
+      gegl_operation_record_process (stage->operation, "output",
+                                     &tail_context->need_rect, level,
+                                     (gdouble) stage->time / G_TIME_SPAN_SECOND,
+                                     span_start, span_end);
+    }
+
+  gegl_instrument_trace ("process", "fusion", trace_start, trace_end,
+                         "\"head\":\"%s\",\"tail\":\"%s\",\"n-nodes\":%u",
+                         gegl_node_get_operation (
+                           g_ptr_array_index (fusion->nodes, 0)),
+                         gegl_node_get_operation (tail),
+                         fusion->nodes->len);
+
+  *operation_result = data.output;
+  success           = TRUE;
+
+cleanup:
+  for (i = 0; i < data.n_stages; i++)
+    g_clear_object (&data.stages[i].aux);
+
+  g_clear_object (&data.input);
+  g_free (data.stages);
+
+  g_mutex_clear (&data.mutex);
+
+  return success;
+}
+
 /**
  * gegl_graph_process:
  * @path: The traversal path
@@ -439,9 +1053,18 @@ gegl_graph_process (GeglGraphTraversal *path,
     {
       GeglNode *node = GEGL_NODE (list_iter->data);
       GeglOperation *operation = node->operation;
+      GeglGraphFusion *fusion = NULL;
       g_return_val_if_fail (node, NULL);
       g_return_val_if_fail (operation, NULL);
-      
+
+      if (path->fused_nodes)
+        fusion = g_hash_table_lookup (path->fused_nodes, node);
+
+      /* the nodes of a fused run are processed along with its tail */
+      if (fusion &&
+          node != g_ptr_array_index (fusion->nodes, fusion->nodes->len - 1))
+        continue;
+
       GEGL_INSTRUMENT_START();
 
       operation_result = NULL;
@@ -452,71 +1075,42 @@ gegl_graph_process (GeglGraphTraversal *path,
       context = g_hash_table_lookup (path->contexts, node);
       g_return_val_if_fail (context, NULL);
 
-      GEGL_NOTE (GEGL_DEBUG_PROCESS,
-                 "Will process %s result_rect = %d, %d %d×%d",
-                 gegl_node_get_debug_name (node),
-                 context->result_rect.x, context->result_rect.y, context->result_rect.width, context->result_rect.height);
-      
-      if (context->need_rect.width > 0 && context->need_rect.height > 0)
+      if (fusion)
         {
-          if (context->cached)
-            {
-              GEGL_NOTE (GEGL_DEBUG_PROCESS,
-                         "Using cached result for %s",
-                         gegl_node_get_debug_name (node));
-              operation_result = GEGL_BUFFER (node->cache);
-            }
-          else
+          gboolean fused;
+          guint    i;
+
+          fused = gegl_graph_process_fusion (path, fusion, level,
+                                             &operation_result);
+
+          for (i = 0; i < fusion->nodes->len - 1; i++)
             {
-              /* provide something on input pad, always - this makes having
-                 behavior depending on it not being set.. not work, is
-                 sacrifising that worth it?
-               */
-              if (gegl_node_has_pad (node, "input") &&
-                  !gegl_operation_context_get_object (context, "input"))
-                {
-                  gegl_operation_context_set_object (context, "input", G_OBJECT (gegl_graph_get_shared_empty(path)));
-                }
+              GeglNode             *member = g_ptr_array_index (fusion->nodes, i);
+              GeglOperationContext *member_context;
 
-              context->level = level;
+              member_context = g_hash_table_lookup (path->contexts, member);
 
-              /* note: this hard-coding of "output" makes some more custom
-               * graph topologies harder than necessary.
-               */
-              gegl_operation_process (operation, context, "output", &context->need_rect, context->level);
-              operation_result = GEGL_BUFFER (gegl_operation_context_get_object (context, "output"));
+              if (! fused)
+                {
+                  gegl_graph_deliver (path, member,
+                                      gegl_graph_process_node (path, member,
+                                                               member_context,
+                                                               level));
+                }
 
-              if (operation_result && operation_result == (GeglBuffer *)operation->node->cache)
-                gegl_cache_computed (operation->node->cache, &context->need_rect, level);
+              gegl_operation_context_purge (member_context);
             }
+
+          if (! fused)
+            operation_result = gegl_graph_process_node (path, node, context, level);
         }
       else
         {
-          operation_result = NULL;
+          operation_result = gegl_graph_process_node (path, node, context, level);
         }
 
-      if (operation_result)
-        {
-          GeglPad *output_pad = gegl_node_get_pad (node, "output");
-          GList   *targets = gegl_graph_get_connected_output_contexts (path, output_pad);
-          GList   *targets_iter;
-
-          GEGL_NOTE (GEGL_DEBUG_PROCESS,
-                     "Will deliver the results of %s:%s to %d targets",
-                     gegl_node_get_debug_name (node),
-                     "output",
-                     g_list_length (targets));
-
-          if (g_list_length (targets) > 1)
-            gegl_object_set_has_forked (G_OBJECT (operation_result));
+      gegl_graph_deliver (path, node, operation_result);
 
-          for (targets_iter = targets; targets_iter; targets_iter = g_list_next (targets_iter))
-            {
-              ContextConnection *target_con = targets_iter->data;
-              gegl_operation_context_set_object (target_con->context, target_con->name, G_OBJECT (operation_result));
-            }
-          g_list_free_full (targets, free_context_connection);
-        }
       last_context = context;
 
       GEGL_INSTRUMENT_END ("process", gegl_node_get_operation (node));
@@ -26,6 +26,7 @@
 #include "gegl-debug.h"
 #include "gegl-region.h"
 #include "graph/gegl-node-private.h"
+#include "graph/gegl-pad.h"
 
 #include "operation/gegl-operation-context.h"
 #include "operation/gegl-operation-context-private.h"
@@ -39,6 +40,9 @@
 #include "graph/gegl-callback-visitor.h"
 #include "graph/gegl-visitable.h"
 
+#include "process/gegl-graph-traversal.h"
+#include "process/gegl-graph-traversal-private.h"
+
 #include "opencl/gegl-cl.h"
 
 enum
@@ -47,7 +51,8 @@ enum
   PROP_NODE,
   PROP_CHUNK_SIZE,
   PROP_PROGRESS,
-  PROP_RECTANGLE
+  PROP_RECTANGLE,
+  PROP_STREAMING
 };
 
 
@@ -67,6 +72,12 @@ static void      gegl_processor_set_node     (GeglProcessor         *processor,
 static void      gegl_processor_constructed  (GObject               *object);
 static gdouble   gegl_processor_progress     (GeglProcessor         *processor);
 static gint      gegl_processor_get_band_size(gint                   size) G_GNUC_CONST;
+static gint      gegl_processor_get_streaming_band_size
+                                             (const GeglRectangle   *rect,
+                                              gint                   max_area);
+static void      gegl_processor_release_streamed
+                                             (GeglProcessor         *processor,
+                                              gboolean               buffered);
 
 
 struct _GeglProcessor
@@ -84,6 +95,8 @@ struct _GeglProcessor
   GeglRegion      *queued_region;
   GSList          *dirty_rectangles;
   gint             chunk_size;
+  gboolean         streaming;
+  GeglGraphTraversal *streamed_path; /* used to find what streaming still needs */
 
   gdouble          progress;
 };
@@ -134,6 +147,14 @@ gegl_processor_class_init (GeglProcessorClass *klass)
                                                      G_PARAM_READWRITE |
                                                      G_PARAM_STATIC_STRINGS |
                                                      G_PARAM_CONSTRUCT_ONLY));
+
+  g_object_class_install_property (gobject_class, PROP_STREAMING,
+                                   g_param_spec_boolean ("streaming",
+                                                         "streaming",
+                                                         "Render in full-width bands from top to bottom, releasing the tiles of intermediate caches as soon as no later band needs them; this bounds peak memory use by the band size rather than the image size.",
+                                                         FALSE,
+                                                         G_PARAM_READWRITE |
+                                                         G_PARAM_STATIC_STRINGS));
 }
 
 static void
@@ -166,6 +187,7 @@ gegl_processor_finalize (GObject *self_object)
   GeglProcessor *processor = GEGL_PROCESSOR (self_object);
 
   g_clear_pointer (&processor->context, gegl_operation_context_destroy);
+  g_clear_pointer (&processor->streamed_path, gegl_graph_free);
 
   g_clear_object (&processor->node);
   g_clear_object (&processor->real_node);
@@ -199,6 +221,10 @@ gegl_processor_set_property (GObject      *gobject,
         gegl_processor_set_rectangle (self, g_value_get_pointer (value));
         break;
 
+      case PROP_STREAMING:
+        self->streaming = g_value_get_boolean (value);
+        break;
+
       default:
         G_OBJECT_WARN_INVALID_PROPERTY_ID (gobject, property_id, pspec);
         break;
@@ -230,6 +256,10 @@ gegl_processor_get_property (GObject    *gobject,
         g_value_set_double (value, gegl_processor_progress (self));
         break;
 
+      case PROP_STREAMING:
+        g_value_set_boolean (value, self->streaming);
+        break;
+
       default:
         G_OBJECT_WARN_INVALID_PROPERTY_ID (gobject, property_id, pspec);
         break;
@@ -245,6 +275,7 @@ gegl_processor_set_node (GeglProcessor *processor,
 
   g_set_object (&processor->node, node);
   g_clear_object (&processor->real_node);
+  g_clear_pointer (&processor->streamed_path, gegl_graph_free);
 
   /* nodes with meta operations are also graphs and can be sinks, so
    * we don't use their output proxy */
@@ -357,6 +388,9 @@ gegl_processor_set_rectangle (GeglProcessor       *processor,
         }
       g_slist_free (processor->dirty_rectangles);
       processor->dirty_rectangles = NULL;
+
+      /* the graph may have changed since the last render */
+      g_clear_pointer (&processor->streamed_path, gegl_graph_free);
     }
 
   /* if the node's operation is a sink and it needs the full content then
@@ -424,6 +458,162 @@ gegl_processor_get_band_size (gint size)
   return band_size;
 }
 
+/* Will generate full-width bands for streaming, as tall as max_area allows,
+ * with the band ending on a tile row boundary so that the next band starts
+ * at the top of a tile row */
+static gint
+gegl_processor_get_streaming_band_size (const GeglRectangle *rect,
+                                        gint                 max_area)
+{
+  gint tile_height = gegl_config ()->tile_height;
+  gint band_size;
+
+  band_size = max_area / MAX (rect->width, 1);
+
+  if (band_size >= tile_height)
+    {
+      gint end = rect->y + band_size;
+
+      end -= end % tile_height;
+      if (end < rect->y + band_size && end > rect->y)
+        band_size = end - rect->y;
+    }
+
+  band_size = CLAMP (band_size, 1, rect->height);
+
+  return band_size;
+}
+
+/* Releases the tiles of intermediate caches that none of the remaining
+ * dirty rectangles depend on. The area each node still has to provide is
+ * found by propagating the remaining rectangles through the graph, which
+ * takes the context margins of all operations into account; everything
+ * above the top of that area is done with, since we render top to bottom.
+ *
+ * The nodes were prepared when the band was rendered, so this only walks
+ * a traversal built once per processor, like gegl_graph_prepare_request()
+ * does, but without preparing the nodes again or consulting their caches.
+ */
+static void
+gegl_processor_release_streamed (GeglProcessor *processor,
+                                 gboolean       buffered)
+{
+  static const GeglRectangle  empty_rect   = {0, 0, 0, 0};
+  GeglGraphTraversal         *path;
+  GeglCache                  *output_cache = NULL;
+  GeglRectangle               remaining    = {0, 0, 0, 0};
+  GSList                     *iter;
+  GList                      *list_iter;
+  gint                        level;
+
+  level = MIN (processor->level, GEGL_CACHE_VALID_MIPMAPS - 1);
+
+  /* the cache of the input is where a buffered processor renders to */
+  if (buffered)
+    output_cache = gegl_node_get_cache (processor->input);
+
+  for (iter = processor->dirty_rectangles; iter; iter = g_slist_next (iter))
+    gegl_rectangle_bounding_box (&remaining, &remaining, iter->data);
+
+  if (! processor->streamed_path)
+    processor->streamed_path =
+      gegl_graph_build (buffered ? processor->input : processor->real_node);
+
+  path = processor->streamed_path;
+
+  for (list_iter = g_queue_peek_head_link (&path->path);
+       list_iter;
+       list_iter = list_iter->next)
+    {
+      GeglOperationContext *context;
+
+      context = g_hash_table_lookup (path->contexts, list_iter->data);
+      gegl_operation_context_set_need_rect (context, &empty_rect);
+    }
+
+  {
+    GeglNode             *node    = GEGL_NODE (g_queue_peek_tail (&path->path));
+    GeglOperationContext *context = g_hash_table_lookup (path->contexts, node);
+    GeglRectangle         need;
+
+    gegl_rectangle_intersect (&need, &node->have_rect, &remaining);
+    gegl_operation_context_set_need_rect (context, &need);
+  }
+
+  for (list_iter = g_queue_peek_tail_link (&path->path);
+       list_iter;
+       list_iter = list_iter->prev)
+    {
+      GeglNode             *node = GEGL_NODE (list_iter->data);
+      GeglOperationContext *context;
+      GeglRectangle         full_need;
+      GSList               *input_pads;
+
+      context = g_hash_table_lookup (path->contexts, node);
+
+      if (gegl_rectangle_is_empty (gegl_operation_context_get_need_rect (context)))
+        continue;
+
+      full_need = gegl_operation_get_cached_region (
+        node->operation, gegl_operation_context_get_need_rect (context));
+
+      for (input_pads = node->input_pads;
+           input_pads;
+           input_pads = input_pads->next)
+        {
+          GeglPad              *source_pad;
+          GeglNode             *source_node;
+          GeglOperationContext *source_context;
+          GeglRectangle         need;
+
+          source_pad = gegl_pad_get_connected_to (input_pads->data);
+
+          if (! source_pad)
+            continue;
+
+          source_node    = gegl_pad_get_node (source_pad);
+          source_context = g_hash_table_lookup (path->contexts, source_node);
+
+          need = gegl_operation_get_required_for_output (
+            node->operation, gegl_pad_get_name (input_pads->data), &full_need);
+
+          gegl_rectangle_bounding_box (
+            &need, &need,
+            gegl_operation_context_get_need_rect (source_context));
+          gegl_rectangle_intersect (&need, &source_node->have_rect, &need);
+
+          gegl_operation_context_set_need_rect (source_context, &need);
+        }
+    }
+
+  for (list_iter = g_queue_peek_head_link (&path->path);
+       list_iter;
+       list_iter = list_iter->next)
+    {
+      GeglNode             *node = GEGL_NODE (list_iter->data);
+      GeglOperationContext *context;
+      const GeglRectangle  *need;
+      GeglRectangle         release;
+
+      if (! node->cache || node->cache == output_cache)
+        continue;
+
+      context = g_hash_table_lookup (path->contexts, node);
+      need    = gegl_operation_context_get_need_rect (context);
+
+      gegl_region_get_clipbox (node->cache->valid_region[level], &release);
+
+      if (! gegl_rectangle_is_empty (need))
+        release.height = MIN (release.y + release.height, need->y) - release.y;
+
+      if (release.width > 0 && release.height > 0)
+        gegl_cache_release (node->cache, &release, level);
+    }
+
+  if (! processor->dirty_rectangles)
+    g_clear_pointer (&processor->streamed_path, gegl_graph_free);
+}
+
 /* If the processor's dirty rectangle is too big then it will be cut, added
  * to the processor's list of dirty rectangles and TRUE will be returned.
  * If the rectangle is small enough it will be processed, using a buffer or
@@ -452,7 +642,8 @@ render_rectangle (GeglProcessor *processor)
 
       /* If a dirty rectangle is bigger than the max area, then cut it
        * to smaller pieces */
-      if (dr->height * dr->width > max_area && 1)
+      if (dr->height * dr->width > max_area &&
+          (! processor->streaming || dr->height > 1))
         {
           gint band_size;
 
@@ -461,8 +652,17 @@ render_rectangle (GeglProcessor *processor)
 
             fragment = g_slice_dup (GeglRectangle, dr);
 
-            /* When splitting a rectangle, we'll do it on the biggest side */
-            if (dr->width > dr->height)
+            /* When streaming, we always cut off a full-width band at the
+             * top, otherwise we split on the biggest side */
+            if (processor->streaming)
+              {
+                band_size = gegl_processor_get_streaming_band_size (dr, max_area);
+
+                fragment->height = band_size;
+                dr->height      -= band_size;
+                dr->y           += band_size;
+              }
+            else if (dr->width > dr->height)
               {
                 band_size = gegl_processor_get_band_size ( dr->width );
 
@@ -527,6 +727,9 @@ render_rectangle (GeglProcessor *processor)
            gegl_region_union_with_rect (processor->valid_region, dr);
            g_slice_free (GeglRectangle, dr);
         }
+
+      if (processor->streaming)
+        gegl_processor_release_streamed (processor, buffered);
     }
 
   return processor->dirty_rectangles != NULL;
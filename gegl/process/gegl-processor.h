@@ -29,6 +29,11 @@ G_BEGIN_DECLS
  * non GUI tasks using #gegl_node_blit and #gegl_node_process directly
  * should be sufficient. See #gegl_processor_work for a code sample.
  *
+ * Setting the "streaming" property makes the processor render in
+ * full-width bands from top to bottom, releasing the tiles of intermediate
+ * node caches once no later band depends on them, so that peak memory use
+ * is bounded by the band size rather than the size of the image.
+ *
  */
 
 /**
@@ -0,0 +1,314 @@
+/* This file is an image processing operation for GEGL
+ *
+ * GEGL is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * GEGL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GEGL; if not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+#include <glib/gi18n-lib.h>
+
+#ifdef GEGL_PROPERTIES
+
+enum_start (gegl_color_lut_interpolation)
+  enum_value (GEGL_COLOR_LUT_INTERPOLATION_TRILINEAR,   "trilinear",
+              N_("Trilinear"))
+  enum_value (GEGL_COLOR_LUT_INTERPOLATION_TETRAHEDRAL, "tetrahedral",
+              N_("Tetrahedral"))
+enum_end (GeglColorLutInterpolation)
+
+property_file_path (path, _("File"), "")
+  description (_("Path of the .cube file holding the lookup table"))
+
+property_enum (interpolation, _("Interpolation"),
+               GeglColorLutInterpolation, gegl_color_lut_interpolation,
+               GEGL_COLOR_LUT_INTERPOLATION_TETRAHEDRAL)
+  description (_("How to interpolate between the entries of the table"))
+
+#else
+
+#define GEGL_OP_POINT_FILTER
+#define GEGL_OP_NAME     color_lut
+#define GEGL_OP_C_SOURCE color-lut.c
+
+#include "gegl-op.h"
+#include "gegl-lookup.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct
+{
+  gchar        *path;
+  GeglLookup3D *lookup;
+  gfloat        domain_min[3];
+  gfloat        domain_max[3];
+} ColorLut;
+
+static gboolean
+parse_floats (const gchar *str,
+              gfloat      *values,
+              gint         n_values)
+{
+  gint i;
+
+  for (i = 0; i < n_values; i++)
+    {
+      gchar *end;
+
+      values[i] = g_ascii_strtod (str, &end);
+
+      if (end == str)
+        return FALSE;
+
+      str = end;
+    }
+
+  return TRUE;
+}
+
+/* loads a 3D table in the .cube format, as written by Resolve and others */
+static gboolean
+color_lut_load (ColorLut    *lut,
+                const gchar *path)
+{
+  gchar   *contents;
+  gchar  **lines;
+  gfloat  *table  = NULL;
+  gint     size   = 0;
+  gint     n      = 0;
+  gboolean result = FALSE;
+  gint     i;
+
+  if (! g_file_get_contents (path, &contents, NULL, NULL))
+    {
+      g_warning ("color-lut: failed to read '%s'", path);
+
+      return FALSE;
+    }
+
+  lines = g_strsplit (contents, "\n", -1);
+
+  for (i = 0; i < 3; i++)
+    {
+      lut->domain_min[i] = 0.0f;
+      lut->domain_max[i] = 1.0f;
+    }
+
+  for (i = 0; lines[i]; i++)
+    {
+      gchar *line = g_strstrip (lines[i]);
+
+      if (! *line || *line == '#' || g_str_has_prefix (line, "TITLE"))
+        continue;
+
+      if (g_str_has_prefix (line, "LUT_3D_SIZE"))
+        {
+          size = atoi (line + strlen ("LUT_3D_SIZE"));
+
+          if (size < 2 || size > 256 || table)
+            break;
+
+          table = g_new (gfloat, 3 * size * size * size);
+        }
+      else if (g_str_has_prefix (line, "DOMAIN_MIN"))
+        {
+          if (! parse_floats (line + strlen ("DOMAIN_MIN"),
+                              lut->domain_min, 3))
+            break;
+        }
+      else if (g_str_has_prefix (line, "DOMAIN_MAX"))
+        {
+          if (! parse_floats (line + strlen ("DOMAIN_MAX"),
+                              lut->domain_max, 3))
+            break;
+        }
+      else if (g_str_has_prefix (line, "LUT_3D_INPUT_RANGE"))
+        {
+          gfloat range[2];
+
+          if (! parse_floats (line + strlen ("LUT_3D_INPUT_RANGE"),
+                              range, 2))
+            break;
+
+          lut->domain_min[0] = lut->domain_min[1] = lut->domain_min[2] =
+            range[0];
+          lut->domain_max[0] = lut->domain_max[1] = lut->domain_max[2] =
+            range[1];
+        }
+      else if (g_ascii_isalpha (*line))
+        {
+          /* including LUT_1D_SIZE, since 1D tables are not supported */
+          break;
+        }
+      else if (! table                        ||
+               n == size * size * size        ||
+               ! parse_floats (line, table + 3 * n, 3))
+        {
+          break;
+        }
+      else
+        {
+          n++;
+        }
+    }
+
+  if (! lines[i] && table && n == size * size * size &&
+      lut->domain_min[0] < lut->domain_max[0]         &&
+      lut->domain_min[1] < lut->domain_max[1]         &&
+      lut->domain_min[2] < lut->domain_max[2])
+    {
+      lut->lookup = gegl_lookup_3d_new_from_table (table, size);
+
+      result = TRUE;
+    }
+  else
+    {
+      g_warning ("color-lut: '%s' is not a valid 3D .cube file", path);
+    }
+
+  g_free (table);
+  g_strfreev (lines);
+  g_free (contents);
+
+  return result;
+}
+
+static void
+color_lut_clear (ColorLut *lut)
+{
+  g_clear_pointer (&lut->lookup, gegl_lookup_3d_free);
+  g_clear_pointer (&lut->path, g_free);
+}
+
+static void
+prepare (GeglOperation *operation)
+{
+  GeglProperties *o      = GEGL_PROPERTIES (operation);
+  const Babl     *space  = gegl_operation_get_source_space (operation, "input");
+  const Babl     *format = babl_format_with_space ("R'G'B'A float", space);
+  ColorLut       *lut;
+
+  gegl_operation_set_format (operation, "input", format);
+  gegl_operation_set_format (operation, "output", format);
+
+  if (o->user_data == NULL)
+    o->user_data = g_slice_new0 (ColorLut);
+  lut = o->user_data;
+
+  /* only reload the table when the path changes */
+  if (g_strcmp0 (lut->path, o->path))
+    {
+      color_lut_clear (lut);
+
+      lut->path = g_strdup (o->path);
+
+      if (o->path && *o->path)
+        color_lut_load (lut, o->path);
+    }
+}
+
+static void
+finalize (GObject *object)
+{
+  GeglProperties *o = GEGL_PROPERTIES (object);
+
+  if (o->user_data)
+    {
+      color_lut_clear (o->user_data);
+      g_slice_free (ColorLut, o->user_data);
+      o->user_data = NULL;
+    }
+
+  G_OBJECT_CLASS (gegl_op_parent_class)->finalize (object);
+}
+
+static gboolean
+process (GeglOperation       *op,
+         void                *in_buf,
+         void                *out_buf,
+         glong                n_pixels,
+         const GeglRectangle *roi,
+         gint                 level)
+{
+  GeglProperties *o   = GEGL_PROPERTIES (op);
+  ColorLut       *lut = o->user_data;
+  gfloat         *in  = in_buf;
+  gfloat         *out = out_buf;
+  gint            c;
+
+  if (! lut || ! lut->lookup)
+    {
+      if (in != out)
+        memcpy (out, in, sizeof (gfloat) * 4 * n_pixels);
+
+      return TRUE;
+    }
+
+  for (c = 0; c < 3; c++)
+    {
+      if (lut->domain_min[c] != 0.0f || lut->domain_max[c] != 1.0f)
+        break;
+    }
+
+  /* map the domain of the table to the unit cube first */
+  if (c < 3)
+    {
+      glong i;
+
+      for (i = 0; i < n_pixels; i++)
+        {
+          for (c = 0; c < 3; c++)
+            {
+              out[4 * i + c] = (in[4 * i + c] - lut->domain_min[c]) /
+                               (lut->domain_max[c] - lut->domain_min[c]);
+            }
+
+          out[4 * i + 3] = in[4 * i + 3];
+        }
+
+      in = out;
+    }
+
+  gegl_lookup_3d_map_array (lut->lookup, in, out, n_pixels, 4,
+                            o->interpolation ==
+                            GEGL_COLOR_LUT_INTERPOLATION_TETRAHEDRAL ?
+                              GEGL_LOOKUP_INTERPOLATION_TETRAHEDRAL :
+                              GEGL_LOOKUP_INTERPOLATION_TRILINEAR);
+
+  return TRUE;
+}
+
+static void
+gegl_op_class_init (GeglOpClass *klass)
+{
+  GObjectClass                  *object_class;
+  GeglOperationClass            *operation_class;
+  GeglOperationPointFilterClass *point_filter_class;
+
+  object_class       = G_OBJECT_CLASS (klass);
+  operation_class    = GEGL_OPERATION_CLASS (klass);
+  point_filter_class = GEGL_OPERATION_POINT_FILTER_CLASS (klass);
+
+  object_class->finalize      = finalize;
+  operation_class->prepare    = prepare;
+  point_filter_class->process = process;
+
+  gegl_operation_class_set_keys (operation_class,
+    "name",        "gegl:color-lut",
+    "title",       _("Color LUT"),
+    "categories",  "color",
+    "description", _("Maps colors through a 3D lookup table, loaded from a .cube file, in one pass instead of a chain of per-channel adjustments."),
+    NULL);
+}
+
+#endif
@@ -70,18 +70,28 @@ property_boolean (high_precision, _("High precision"), FALSE)
 #include "gegl-op.h"
 
 #define DEFAULT_N_BINS   256
+#define WIDE_N_BINS      65536
+#define WIDE_COARSE_BITS 8
 #define MAX_CHUNK_WIDTH  128
 #define MAX_CHUNK_HEIGHT 128
 
+#define COLUMN_COARSE_BITS 4
+#define MAX_LINE_SETS      5
+
 #define SAFE_CLAMP(x, min, max) ((x) > (min) ? (x) < (max) ? (x) : (max) : (min))
 
 static gfloat        default_bin_values[DEFAULT_N_BINS];
 static gint          default_alpha_values[DEFAULT_N_BINS];
 static volatile gint default_values_initialized = FALSE;
 
+static gfloat        wide_bin_values[WIDE_N_BINS];
+static gint          wide_alpha_values[WIDE_N_BINS];
+static volatile gint wide_values_initialized = FALSE;
+
 typedef struct
 {
   gboolean  quantize;
+  gint      n_bins;
   gint     *neighborhood_outline;
 } UserData;
 
@@ -94,6 +104,7 @@ typedef struct
 typedef struct
 {
   gint   *bins;
+  gint   *coarse_bins;
   gfloat *bin_values;
   gint    last_median;
   gint    last_median_sum;
@@ -135,6 +146,26 @@ histogram_get_median (Histogram *hist,
   count = (gint) ceil (count * percentile);
   count = MAX (count, 1);
 
+  if (comp->coarse_bins)
+    {
+      /* with 16-bit bins the median moves too far between pixels for the
+       * incremental search below, look it up through the coarse bins.
+       */
+      gint k = 0;
+
+      sum = 0;
+
+      while (sum + comp->coarse_bins[k] < count)
+        sum += comp->coarse_bins[k++];
+
+      i = k << WIDE_COARSE_BITS;
+
+      while ((sum += comp->bins[i]) < count)
+        i++;
+
+      return comp->bin_values[i];
+    }
+
   if (sum < count)
     {
       while ((sum += comp->bins[++i]) < count);
@@ -171,6 +202,9 @@ histogram_modify_val (Histogram    *hist,
 
       comp->bins[bin] += alpha;
 
+      if (comp->coarse_bins)
+        comp->coarse_bins[bin >> WIDE_COARSE_BITS] += alpha;
+
       /* this is shorthand for:
        *
        *   if (bin <= comp->last_median)
@@ -188,6 +222,9 @@ histogram_modify_val (Histogram    *hist,
 
       comp->bins[bin] += diff;
 
+      if (comp->coarse_bins)
+        comp->coarse_bins[bin >> WIDE_COARSE_BITS] += diff;
+
       comp->last_median_sum += (bin <= comp->last_median) * diff;
     }
 
@@ -512,7 +549,8 @@ static void
 convert_values_to_bins (Histogram *hist,
                         gint32    *src,
                         gint       n_pixels,
-                        gboolean   quantize)
+                        gboolean   quantize,
+                        gint       n_bins)
 {
   gint     n_components       = hist->n_components;
   gint     n_color_components = hist->n_color_components;
@@ -522,10 +560,19 @@ convert_values_to_bins (Histogram *hist,
 
   if (quantize)
     {
+      gboolean wide = n_bins > DEFAULT_N_BINS;
+
       for (c = 0; c < n_components; c++)
         {
-          hist->components[c].bins       = g_new0 (gint, DEFAULT_N_BINS);
-          hist->components[c].bin_values = default_bin_values;
+          hist->components[c].bins       = g_new0 (gint, n_bins);
+          hist->components[c].bin_values = wide ? wide_bin_values :
+                                                  default_bin_values;
+
+          if (wide)
+            {
+              hist->components[c].coarse_bins =
+                g_new0 (gint, n_bins >> WIDE_COARSE_BITS);
+            }
         }
 
       while (n_pixels--)
@@ -535,7 +582,7 @@ convert_values_to_bins (Histogram *hist,
               gfloat value = ((gfloat *) src)[c];
               gint   bin;
 
-              bin = floorf (SAFE_CLAMP (value, 0.0f, 1.0f) * (DEFAULT_N_BINS - 1) + 0.5f);
+              bin = floorf (SAFE_CLAMP (value, 0.0f, 1.0f) * (n_bins - 1) + 0.5f);
 
               src[c] = bin;
             }
@@ -543,7 +590,7 @@ convert_values_to_bins (Histogram *hist,
           src += n_components;
         }
 
-      hist->alpha_values = default_alpha_values;
+      hist->alpha_values = wide ? wide_alpha_values : default_alpha_values;
     }
   else
     {
@@ -612,6 +659,784 @@ convert_values_to_bins (Histogram *hist,
     }
 }
 
+/* Constant-time median for quantized data, after Perreault and Hébert,
+ * "Median Filtering in Constant Time".  the window histogram moves along a
+ * row by adding the pixels entering at its right edge, and removing the
+ * ones leaving at its left edge.  rather than pixel by pixel, the edges are
+ * added and removed as segments of lines of the input, each of which keeps
+ * a histogram that moves down one row per output row:
+ *
+ *   - each edge of a square window is a column of the window height;
+ *   - each edge of a diamond window is made of two diagonals, one for the
+ *     center row and the rows above it, the other for the rows below it;
+ *   - the edges of a circle are not made of a bounded number of straight
+ *     lines, so they are added and removed one pixel per row, which costs
+ *     O(radius) per pixel like the outline update does, and only spares
+ *     the median search.
+ *
+ * the histograms have a coarse level, along which the median is searched
+ * first, and a fine level.  for 8-bit data the line histograms keep both
+ * levels.  for 16-bit data, whose 65536 bins are split into 256 coarse
+ * bins, the line histograms only keep the coarse level, and each line links
+ * its pixels that fall in the same coarse bin, so that only those are
+ * visited.  when the window can be rebuilt from columns of its height, its
+ * fine bins under a coarse bin are only brought up to date when the median
+ * falls in that coarse bin: by replaying the edges since they last were,
+ * or, when the window moved further than that, from the columns.  this is
+ * always the case with 16-bit data; otherwise all the fine bins of the
+ * window move along with it.
+ *
+ * each output row starts from the window at its first pixel, which moves
+ * down one row per output row by adding its bottom edge and removing its
+ * top edge pixel by pixel.
+ */
+typedef struct
+{
+  /* the lines go along X - slope * Y = key, and their segments span the
+   * rows from top to bottom relative to the center row of the window
+   */
+  gint  slope;
+  gint  top;
+  gint  bottom;
+  gint  key_offset;
+
+  gint *coarse;
+  gint *fine;
+
+  /* 16-bit data only: for each line, component and coarse bin, the first
+   * pixel of the segment in that coarse bin, and for each pixel and
+   * component, the next pixel down the line in the same coarse bin, or -1.
+   */
+  gint *first;
+  gint *next;
+} LineHistograms;
+
+typedef struct
+{
+  gint *coarse;
+  gint *fine;
+  gint *fine_x;
+  gint  count;
+
+  /* the coarse bin of the last median, and the count below it */
+  gint  median_k;
+  gint  median_sum;
+} WindowHistogram;
+
+typedef struct
+{
+  const gint32   *src;
+  gint            width;
+  gint            height;
+  gint            n_components;
+  gint            n_color_components;
+  const gint     *alpha_values;
+  const gfloat   *bin_values;
+  gint            n_bins;
+  gint            n_coarse_bins;
+  gint            coarse_bits;
+  gint            radius;
+  const gint     *outline;
+
+  LineHistograms  line_sets[MAX_LINE_SETS];
+  gint            n_line_sets;
+
+  /* the line sets making up the right and left edges of the window, or
+   * none when the edges are added pixel by pixel
+   */
+  LineHistograms *right[2];
+  LineHistograms *left[2];
+  gint            n_edge_sets;
+
+  /* the columns of the window height, from which the fine bins of the
+   * window are rebuilt, if any
+   */
+  LineHistograms *columns;
+} MedianWindow;
+
+static inline gint
+median_window_alpha (const MedianWindow *mw,
+                     const gint32       *src,
+                     gint                diff)
+{
+  if (mw->n_color_components < mw->n_components)
+    return diff * mw->alpha_values[src[mw->n_color_components]];
+
+  return diff;
+}
+
+static void
+line_histograms_modify_row (MedianWindow   *mw,
+                            LineHistograms *lines,
+                            gint            row,
+                            gint            diff)
+{
+  const gint    n_components = mw->n_components;
+  const gint32 *src          = mw->src + row * mw->width * n_components;
+  gint          p            = row * mw->width;
+  gint          key          = lines->key_offset - lines->slope * row;
+  gint          x;
+  gint          c;
+
+  for (x = 0; x < mw->width; x++, p++, key++, src += n_components)
+    {
+      gint alpha = median_window_alpha (mw, src, diff);
+
+      for (c = 0; c < n_components; c++)
+        {
+          gint bin    = src[c];
+          gint line   = key * n_components + c;
+          gint weight = c < mw->n_color_components ? alpha : diff;
+
+          lines->coarse[line * mw->n_coarse_bins +
+                        (bin >> mw->coarse_bits)] += weight;
+
+          if (lines->fine)
+            {
+              lines->fine[line * mw->n_bins + bin] += weight;
+            }
+          else if (diff < 0)
+            {
+              /* the row leaving the segments is their top row */
+              gint *first = &lines->first[line * mw->n_coarse_bins +
+                                          (bin >> mw->coarse_bits)];
+
+              if (*first == p)
+                *first = lines->next[p * n_components + c];
+            }
+        }
+    }
+}
+
+static void
+line_histograms_init (MedianWindow   *mw,
+                      LineHistograms *lines,
+                      gint            slope,
+                      gint            top,
+                      gint            bottom)
+{
+  const gint n_components = mw->n_components;
+  const gint first_row    = mw->radius + top;
+  gint       n_lines;
+  gint       row;
+
+  lines->slope      = slope;
+  lines->top        = top;
+  lines->bottom     = bottom;
+  lines->key_offset = slope > 0 ? mw->height - 1 : 0;
+
+  n_lines = slope ? mw->width + mw->height - 1 : mw->width;
+
+  lines->coarse = g_new0 (gint, n_lines * n_components * mw->n_coarse_bins);
+
+  if (mw->n_bins == DEFAULT_N_BINS)
+    {
+      lines->fine = g_new0 (gint, n_lines * n_components * mw->n_bins);
+    }
+  else
+    {
+      gint i;
+
+      lines->first = g_new (gint, n_lines * n_components * mw->n_coarse_bins);
+      lines->next  = g_new (gint, mw->width * mw->height * n_components);
+
+      for (i = 0; i < n_lines * n_components * mw->n_coarse_bins; i++)
+        lines->first[i] = -1;
+
+      /* link each line's pixels from the bottom up, so that first ends up
+       * at the top of the first segments
+       */
+      for (row = mw->height - 1; row >= first_row; row--)
+        {
+          const gint32 *src = mw->src + row * mw->width * n_components;
+          gint          p   = row * mw->width;
+          gint          key = lines->key_offset - slope * row;
+          gint          x;
+          gint          c;
+
+          for (x = 0; x < mw->width; x++, p++, key++, src += n_components)
+            {
+              for (c = 0; c < n_components; c++)
+                {
+                  gint *first = &lines->first[(key * n_components + c) *
+                                              mw->n_coarse_bins +
+                                              (src[c] >> mw->coarse_bits)];
+
+                  lines->next[p * n_components + c] = *first;
+                  *first = p;
+                }
+            }
+        }
+    }
+
+  for (row = first_row; row <= mw->radius + bottom; row++)
+    line_histograms_modify_row (mw, lines, row, +1);
+}
+
+static void
+line_histograms_free (LineHistograms *lines)
+{
+  g_free (lines->coarse);
+  g_free (lines->fine);
+  g_free (lines->first);
+  g_free (lines->next);
+}
+
+static inline void
+window_histogram_modify_pixel (MedianWindow    *mw,
+                               WindowHistogram *win,
+                               gint             x,
+                               gint             y,
+                               gint             diff)
+{
+  const gint32 *src   = mw->src + (y * mw->width + x) * mw->n_components;
+  gint          alpha = median_window_alpha (mw, src, diff);
+  gint          c;
+
+  for (c = 0; c < mw->n_components; c++)
+    {
+      gint bin    = src[c];
+      gint k      = bin >> mw->coarse_bits;
+      gint weight = c < mw->n_color_components ? alpha : diff;
+
+      win[c].coarse[k]  += weight;
+      win[c].fine[bin]  += weight;
+      win[c].count      += weight;
+      win[c].median_sum += (k < win[c].median_k) * weight;
+    }
+}
+
+/* moves all the fine bins of the window from center (cx - 1, cy) to
+ * (cx, cy), when they are not rebuilt from columns
+ */
+static void
+window_histogram_step_fine (MedianWindow    *mw,
+                            WindowHistogram *win,
+                            gint             cx,
+                            gint             cy)
+{
+  const gint  n_components = mw->n_components;
+  const gint  n_bins       = mw->n_bins;
+  const gint *add[2];
+  const gint *sub[2];
+  gint        i;
+  gint        c;
+  gint        j;
+
+  for (i = 0; i < mw->n_edge_sets; i++)
+    {
+      LineHistograms *right = mw->right[i];
+      LineHistograms *left  = mw->left[i];
+
+      add[i] = right->fine + (cx + mw->radius - right->slope * cy +
+                              right->key_offset) * n_components * n_bins;
+      sub[i] = left->fine  + (cx - 1 - mw->radius - left->slope * cy +
+                              left->key_offset) * n_components * n_bins;
+    }
+
+  for (c = 0; c < n_components; c++)
+    {
+      gint *fine = win[c].fine;
+
+      if (mw->n_edge_sets == 1)
+        {
+          for (j = 0; j < n_bins; j++)
+            fine[j] += add[0][j] - sub[0][j];
+        }
+      else
+        {
+          for (j = 0; j < n_bins; j++)
+            fine[j] += add[0][j] + add[1][j] - sub[0][j] - sub[1][j];
+        }
+
+      for (i = 0; i < mw->n_edge_sets; i++)
+        {
+          add[i] += n_bins;
+          sub[i] += n_bins;
+        }
+    }
+}
+
+/* moves the window from center (cx - 1, cy) to (cx, cy) */
+static void
+window_histogram_step (MedianWindow    *mw,
+                       WindowHistogram *win,
+                       gint             cx,
+                       gint             cy)
+{
+  const gint n_components = mw->n_components;
+  const gint n_coarse     = mw->n_coarse_bins;
+  const gint radius       = mw->radius;
+  gint       i;
+  gint       c;
+  gint       k;
+
+  if (mw->n_edge_sets)
+    {
+      const gint *add[2];
+      const gint *sub[2];
+
+      for (i = 0; i < mw->n_edge_sets; i++)
+        {
+          LineHistograms *right = mw->right[i];
+          LineHistograms *left  = mw->left[i];
+
+          add[i] = right->coarse + (cx + radius - right->slope * cy +
+                                    right->key_offset) *
+                                   n_components * n_coarse;
+          sub[i] = left->coarse  + (cx - 1 - radius - left->slope * cy +
+                                    left->key_offset) *
+                                   n_components * n_coarse;
+        }
+
+      for (c = 0; c < n_components; c++)
+        {
+          gint *coarse = win[c].coarse;
+          gint  below  = 0;
+          gint  above  = 0;
+
+          if (mw->n_edge_sets == 1)
+            {
+              for (k = 0; k < win[c].median_k; k++)
+                {
+                  gint d = add[0][k] - sub[0][k];
+
+                  coarse[k] += d;
+                  below     += d;
+                }
+              for (; k < n_coarse; k++)
+                {
+                  gint d = add[0][k] - sub[0][k];
+
+                  coarse[k] += d;
+                  above     += d;
+                }
+            }
+          else
+            {
+              for (k = 0; k < win[c].median_k; k++)
+                {
+                  gint d = add[0][k] + add[1][k] - sub[0][k] - sub[1][k];
+
+                  coarse[k] += d;
+                  below     += d;
+                }
+              for (; k < n_coarse; k++)
+                {
+                  gint d = add[0][k] + add[1][k] - sub[0][k] - sub[1][k];
+
+                  coarse[k] += d;
+                  above     += d;
+                }
+            }
+
+          win[c].median_sum += below;
+          win[c].count      += below + above;
+
+          for (i = 0; i < mw->n_edge_sets; i++)
+            {
+              add[i] += n_coarse;
+              sub[i] += n_coarse;
+            }
+        }
+
+      if (! mw->columns)
+        window_histogram_step_fine (mw, win, cx, cy);
+    }
+  else
+    {
+      for (i = -radius; i <= radius; i++)
+        {
+          gint w = mw->outline[abs (i)];
+
+          window_histogram_modify_pixel (mw, win, cx + w,     cy + i, +1);
+          window_histogram_modify_pixel (mw, win, cx - 1 - w, cy + i, -1);
+        }
+    }
+}
+
+/* adds or removes the fine bins under coarse bin k of one component of the
+ * right or left edge of the window centered at (cx, cy)
+ */
+static void
+window_histogram_modify_edge_fine (MedianWindow    *mw,
+                                   WindowHistogram *win,
+                                   gint             component,
+                                   gint             k,
+                                   gint             cx,
+                                   gint             cy,
+                                   gboolean         right,
+                                   gint             diff)
+{
+  const gint    n_components = mw->n_components;
+  const gint32 *src          = mw->src;
+  const gint    x            = right ? cx + mw->radius : cx - mw->radius;
+  gint          i;
+
+  for (i = 0; i < mw->n_edge_sets; i++)
+    {
+      LineHistograms *lines = right ? mw->right[i] : mw->left[i];
+      gint            line  = (x - lines->slope * cy + lines->key_offset) *
+                              n_components + component;
+
+      if (lines->fine)
+        {
+          const gint *fine     = lines->fine + line * mw->n_bins +
+                                 (k << mw->coarse_bits);
+          gint       *win_fine = win->fine + (k << mw->coarse_bits);
+          gint        j;
+
+          for (j = 0; j < 1 << mw->coarse_bits; j++)
+            win_fine[j] += diff * fine[j];
+        }
+      else
+        {
+          gint end = (cy + lines->bottom + 1) * mw->width;
+          gint p;
+
+          for (p = lines->first[line * mw->n_coarse_bins + k];
+               p >= 0 && p < end;
+               p = lines->next[p * n_components + component])
+            {
+              gint weight = diff;
+
+              if (component < mw->n_color_components)
+                weight = median_window_alpha (mw, src + p * n_components,
+                                              diff);
+
+              win->fine[src[p * n_components + component]] += weight;
+            }
+        }
+    }
+}
+
+/* rebuilds the fine bins under coarse bin k of one component of the window
+ * centered at (cx, cy) from its columns
+ */
+static void
+window_histogram_rebuild_fine (MedianWindow    *mw,
+                               WindowHistogram *win,
+                               gint             component,
+                               gint             k,
+                               gint             cx,
+                               gint             cy)
+{
+  const gint      n_components = mw->n_components;
+  const gint32   *src          = mw->src;
+  LineHistograms *columns      = mw->columns;
+  gint           *win_fine     = win->fine + (k << mw->coarse_bits);
+  gint            i;
+  gint            j;
+
+  memset (win_fine, 0, (1 << mw->coarse_bits) * sizeof (gint));
+
+  if (columns->fine)
+    {
+      /* the columns are the window height, which only square windows have
+       * throughout
+       */
+      for (i = -mw->radius; i <= mw->radius; i++)
+        {
+          const gint *fine = columns->fine +
+                             ((cx + i) * n_components + component) *
+                             mw->n_bins + (k << mw->coarse_bits);
+
+          for (j = 0; j < 1 << mw->coarse_bits; j++)
+            win_fine[j] += fine[j];
+        }
+
+      return;
+    }
+
+  for (i = -mw->radius; i <= mw->radius; i++)
+    {
+      gint h     = mw->outline[abs (i)];
+      gint line  = (cx + i) * n_components + component;
+      gint start = (cy - h) * mw->width;
+      gint end   = (cy + h + 1) * mw->width;
+      gint p;
+
+      for (p = columns->first[line * mw->n_coarse_bins + k];
+           p >= 0 && p < end;
+           p = columns->next[p * n_components + component])
+        {
+          gint weight = 1;
+
+          if (p < start)
+            continue;
+
+          if (component < mw->n_color_components)
+            weight = median_window_alpha (mw, src + p * n_components, 1);
+
+          win->fine[src[p * n_components + component]] += weight;
+        }
+    }
+}
+
+static inline gfloat
+window_histogram_get_median (MedianWindow    *mw,
+                             WindowHistogram *win,
+                             gint             component,
+                             gint             x,
+                             gint             cy,
+                             gdouble          percentile)
+{
+  const gint n_fine_bins = 1 << mw->coarse_bits;
+  gint       count       = win->count;
+  gint       sum         = win->median_sum;
+  gint       k           = win->median_k;
+  gint       i;
+
+  if (count == 0)
+    return 0.0f;
+
+  count = (gint) ceil (count * percentile);
+  count = MAX (count, 1);
+
+  while (sum >= count)
+    sum -= win->coarse[--k];
+
+  while (sum + win->coarse[k] < count)
+    sum += win->coarse[k++];
+
+  win->median_k   = k;
+  win->median_sum = sum;
+
+  /* bring the fine bins under k up to date with the window at x, by
+   * replaying the edges since they last were, or rebuilding them when that
+   * would visit more pixels
+   */
+  if (mw->columns)
+    {
+      const gint cx = x + mw->radius;
+
+      if (win->fine_x[k] < 0 ||
+          (x - win->fine_x[k]) * mw->n_edge_sets > mw->radius)
+        {
+          window_histogram_rebuild_fine (mw, win, component, k, cx, cy);
+        }
+      else
+        {
+          gint fx;
+
+          for (fx = win->fine_x[k] + 1; fx <= x; fx++)
+            {
+              window_histogram_modify_edge_fine (mw, win, component, k,
+                                                 fx + mw->radius, cy,
+                                                 TRUE, +1);
+              window_histogram_modify_edge_fine (mw, win, component, k,
+                                                 fx + mw->radius - 1, cy,
+                                                 FALSE, -1);
+            }
+        }
+
+      win->fine_x[k] = x;
+    }
+
+  for (i = k * n_fine_bins; sum + win->fine[i] < count; i++)
+    sum += win->fine[i];
+
+  return mw->bin_values[i];
+}
+
+/* the radius from which column histograms beat the outline update, whose
+ * cost grows with the radius, but which needs no setup.
+ */
+static gint
+column_histograms_min_radius (GeglMedianBlurNeighborhood neighborhood,
+                              gint                       n_bins)
+{
+  switch (neighborhood)
+    {
+    case GEGL_MEDIAN_BLUR_NEIGHBORHOOD_SQUARE:
+      return n_bins == DEFAULT_N_BINS ? 8 : 40;
+
+    case GEGL_MEDIAN_BLUR_NEIGHBORHOOD_DIAMOND:
+      return n_bins == DEFAULT_N_BINS ? 40 : 96;
+
+    case GEGL_MEDIAN_BLUR_NEIGHBORHOOD_CIRCLE:
+      break;
+    }
+
+  return 8;
+}
+
+static void
+median_blur_column_histograms (Histogram                  *hist,
+                               const gint32               *src_buf,
+                               const GeglRectangle        *src_rect,
+                               gfloat                     *dst_buf,
+                               const GeglRectangle        *roi,
+                               GeglMedianBlurNeighborhood  neighborhood,
+                               gint                        radius,
+                               const gint                 *neighborhood_outline,
+                               gint                        n_bins,
+                               gdouble                     percentile,
+                               gdouble                     alpha_percentile)
+{
+  const gint       n_components       = hist->n_components;
+  const gint       n_color_components = hist->n_color_components;
+  MedianWindow     mw                 = { 0, };
+  WindowHistogram  win[4]             = { { 0, }, };
+  WindowHistogram  row_start[4]       = { { 0, }, };
+  gfloat          *dst                = dst_buf;
+  gint             x;
+  gint             y;
+  gint             c;
+  gint             i;
+
+  mw.src                = src_buf;
+  mw.width              = src_rect->width;
+  mw.height             = src_rect->height;
+  mw.n_components       = n_components;
+  mw.n_color_components = n_color_components;
+  mw.alpha_values       = hist->alpha_values;
+  mw.bin_values         = hist->components[0].bin_values;
+  mw.n_bins             = n_bins;
+  mw.coarse_bits        = n_bins == DEFAULT_N_BINS ? COLUMN_COARSE_BITS :
+                                                     WIDE_COARSE_BITS;
+  mw.n_coarse_bins      = n_bins >> mw.coarse_bits;
+  mw.radius             = radius;
+  mw.outline            = neighborhood_outline;
+
+  switch (neighborhood)
+    {
+    case GEGL_MEDIAN_BLUR_NEIGHBORHOOD_SQUARE:
+      line_histograms_init (&mw, &mw.line_sets[0], 0, -radius, radius);
+
+      mw.n_line_sets = 1;
+      mw.right[0]    = &mw.line_sets[0];
+      mw.left[0]     = &mw.line_sets[0];
+      mw.n_edge_sets = 1;
+      mw.columns     = &mw.line_sets[0];
+      break;
+
+    case GEGL_MEDIAN_BLUR_NEIGHBORHOOD_DIAMOND:
+      line_histograms_init (&mw, &mw.line_sets[0], +1, -radius, 0);
+      line_histograms_init (&mw, &mw.line_sets[1], -1, 1, radius);
+      line_histograms_init (&mw, &mw.line_sets[2], -1, -radius, 0);
+      line_histograms_init (&mw, &mw.line_sets[3], +1, 1, radius);
+
+      mw.n_line_sets = 4;
+      mw.right[0]    = &mw.line_sets[0];
+      mw.right[1]    = &mw.line_sets[1];
+      mw.left[0]     = &mw.line_sets[2];
+      mw.left[1]     = &mw.line_sets[3];
+      mw.n_edge_sets = 2;
+
+      if (n_bins != DEFAULT_N_BINS)
+        {
+          line_histograms_init (&mw, &mw.line_sets[4], 0, -radius, radius);
+
+          mw.n_line_sets = 5;
+          mw.columns     = &mw.line_sets[4];
+        }
+      break;
+
+    case GEGL_MEDIAN_BLUR_NEIGHBORHOOD_CIRCLE:
+      break;
+    }
+
+  for (c = 0; c < n_components; c++)
+    {
+      win[c].coarse       = g_new (gint, mw.n_coarse_bins);
+      win[c].fine         = g_new (gint, n_bins);
+      win[c].fine_x       = g_new (gint, mw.n_coarse_bins);
+      row_start[c].coarse = g_new0 (gint, mw.n_coarse_bins);
+      row_start[c].fine   = g_new0 (gint, n_bins);
+    }
+
+  for (i = -radius; i <= radius; i++)
+    {
+      for (x = -neighborhood_outline[abs (i)];
+           x <= neighborhood_outline[abs (i)];
+           x++)
+        {
+          window_histogram_modify_pixel (&mw, row_start,
+                                         radius + x, radius + i, +1);
+        }
+    }
+
+  for (y = 0; y < roi->height; y++)
+    {
+      const gint cy = y + radius;
+
+      if (y > 0)
+        {
+          for (i = 0; i < mw.n_line_sets; i++)
+            {
+              LineHistograms *lines = &mw.line_sets[i];
+
+              line_histograms_modify_row (&mw, lines, cy + lines->bottom, +1);
+              line_histograms_modify_row (&mw, lines, cy - 1 + lines->top, -1);
+            }
+
+          for (i = -radius; i <= radius; i++)
+            {
+              gint h = neighborhood_outline[abs (i)];
+
+              window_histogram_modify_pixel (&mw, row_start,
+                                             radius + i, cy + h, +1);
+              window_histogram_modify_pixel (&mw, row_start,
+                                             radius + i, cy - 1 - h, -1);
+            }
+        }
+
+      for (c = 0; c < n_components; c++)
+        {
+          memcpy (win[c].coarse, row_start[c].coarse,
+                  mw.n_coarse_bins * sizeof (gint));
+
+          if (mw.columns)
+            {
+              for (i = 0; i < mw.n_coarse_bins; i++)
+                win[c].fine_x[i] = -1;
+            }
+          else
+            {
+              memcpy (win[c].fine, row_start[c].fine, n_bins * sizeof (gint));
+            }
+
+          win[c].count      = row_start[c].count;
+          win[c].median_sum = 0;
+
+          for (i = 0; i < win[c].median_k; i++)
+            win[c].median_sum += win[c].coarse[i];
+        }
+
+      for (x = 0; x < roi->width; x++, dst += n_components)
+        {
+          if (x > 0)
+            window_histogram_step (&mw, win, x + radius, cy);
+
+          for (c = 0; c < n_color_components; c++)
+            {
+              dst[c] = window_histogram_get_median (&mw, &win[c],
+                                                    c,
+                                                    x, cy, percentile);
+            }
+          if (c < n_components)
+            {
+              dst[c] = window_histogram_get_median (&mw, &win[c],
+                                                    c,
+                                                    x, cy, alpha_percentile);
+            }
+        }
+    }
+
+  for (c = 0; c < n_components; c++)
+    {
+      g_free (win[c].coarse);
+      g_free (win[c].fine);
+      g_free (win[c].fine_x);
+      g_free (row_start[c].coarse);
+      g_free (row_start[c].fine);
+    }
+
+  for (i = 0; i < mw.n_line_sets; i++)
+    line_histograms_free (&mw.line_sets[i]);
+}
+
 static void
 prepare (GeglOperation *operation)
 {
@@ -632,6 +1457,7 @@ prepare (GeglOperation *operation)
 
   data                       = o->user_data;
   data->quantize             = ! o->high_precision;
+  data->n_bins               = DEFAULT_N_BINS;
   data->neighborhood_outline = g_renew (gint, data->neighborhood_outline,
                                         radius + 1);
   init_neighborhood_outline (o->neighborhood, radius,
@@ -660,16 +1486,24 @@ prepare (GeglOperation *operation)
           else if (babl_model_is (model, "R'G'B'A") || babl_model_is (model, "R'aG'aB'aA"))
             format = babl_format_with_space ("R'G'B'A float", in_format);
 
+          /* 8- and 16-bit data can be binned without loss */
           if (format)
             {
               gint n_components = babl_format_get_n_components (in_format);
               gint i;
 
               data->quantize = TRUE;
+              data->n_bins   = DEFAULT_N_BINS;
 
               for (i = 0; i < n_components; i++)
                 {
-                  if (babl_format_get_type (in_format, i) != babl_type ("u8"))
+                  const Babl *type = babl_format_get_type (in_format, i);
+
+                  if (type == babl_type ("u16"))
+                    {
+                      data->n_bins = WIDE_N_BINS;
+                    }
+                  else if (type != babl_type ("u8"))
                     {
                       data->quantize = FALSE;
                       break;
@@ -720,6 +1554,24 @@ prepare (GeglOperation *operation)
       g_atomic_int_set (&default_values_initialized, TRUE);
     }
 
+  if (data->quantize && data->n_bins == WIDE_N_BINS &&
+      ! g_atomic_int_get (&wide_values_initialized))
+    {
+      gint i;
+
+      /* alpha weights have the same 10-bit precision as in the unquantized
+       * case, which keeps the weighted counts of large windows in range
+       */
+      for (i = 0; i < WIDE_N_BINS; i++)
+        {
+          wide_bin_values[i]   = (gfloat) i / (gfloat) (WIDE_N_BINS - 1);
+          wide_alpha_values[i] = floorf ((gfloat) i / (gfloat) (WIDE_N_BINS - 1) *
+                                         (gfloat) (1 << 10) + 0.5f);
+        }
+
+      g_atomic_int_set (&wide_values_initialized, TRUE);
+    }
+
   gegl_operation_set_format (operation, "input", format);
   gegl_operation_set_format (operation, "output", format);
 }
@@ -852,95 +1704,108 @@ process (GeglOperation       *operation,
 
   gegl_buffer_get (input, &src_rect, 1.0, format, src_buf,
                    GEGL_AUTO_ROWSTRIDE, get_abyss_policy (operation, "input"));
-  convert_values_to_bins (hist, src_buf, n_src_pixels, data->quantize);
+  convert_values_to_bins (hist, src_buf, n_src_pixels,
+                          data->quantize, data->n_bins);
 
-  src = src_buf + radius * (src_rect.width + 1) * n_components;
-  dst = dst_buf;
+  if (data->quantize &&
+      radius >= column_histograms_min_radius (o->neighborhood, data->n_bins))
+    {
+      median_blur_column_histograms (hist, src_buf, &src_rect,
+                                     dst_buf, roi, o->neighborhood,
+                                     radius, neighborhood_outline,
+                                     data->n_bins,
+                                     percentile, alpha_percentile);
+    }
+  else
+    {
+      src = src_buf + radius * (src_rect.width + 1) * n_components;
+      dst = dst_buf;
 
-  /* compute the first window */
+      /* compute the first window */
 
-  for (i = -radius; i <= radius; i++)
-    {
-      histogram_modify_vals (hist, src, src_stride,
-                             i, -neighborhood_outline[abs (i)],
-                             i, +neighborhood_outline[abs (i)],
-                             +1);
+      for (i = -radius; i <= radius; i++)
+        {
+          histogram_modify_vals (hist, src, src_stride,
+                                 i, -neighborhood_outline[abs (i)],
+                                 i, +neighborhood_outline[abs (i)],
+                                 +1);
 
-      hist->size += 2 * neighborhood_outline[abs (i)] + 1;
-    }
+          hist->size += 2 * neighborhood_outline[abs (i)] + 1;
+        }
 
-  for (c = 0; c < n_color_components; c++)
-    dst[c] = histogram_get_median (hist, c, percentile);
-  if (has_alpha)
-    dst[c] = histogram_get_median (hist, c, alpha_percentile);
+      for (c = 0; c < n_color_components; c++)
+        dst[c] = histogram_get_median (hist, c, percentile);
+      if (has_alpha)
+        dst[c] = histogram_get_median (hist, c, alpha_percentile);
 
-  dst_x = 0;
-  dst_y = 0;
+      dst_x = 0;
+      dst_y = 0;
 
-  n_dst_pixels--;
-  dir = LEFT_TO_RIGHT;
+      n_dst_pixels--;
+      dir = LEFT_TO_RIGHT;
 
-  while (n_dst_pixels--)
-    {
-      /* move the src coords based on current direction and positions */
-      if (dir == LEFT_TO_RIGHT)
+      while (n_dst_pixels--)
         {
-          if (dst_x != roi->width - 1)
+          /* move the src coords based on current direction and positions */
+          if (dir == LEFT_TO_RIGHT)
             {
-              dst_x++;
-              src += n_components;
-              dst += n_components;
-            }
-          else
-            {
-              dst_y++;
-              src += src_stride;
-              dst += dst_stride;
-              dir = TOP_TO_BOTTOM;
-            }
-        }
-      else if (dir == TOP_TO_BOTTOM)
-        {
-          if (dst_x == 0)
-            {
-              dst_x++;
-              src += n_components;
-              dst += n_components;
-              dir = LEFT_TO_RIGHT;
-            }
-          else
-            {
-              dst_x--;
-              src -= n_components;
-              dst -= n_components;
-              dir = RIGHT_TO_LEFT;
+              if (dst_x != roi->width - 1)
+                {
+                  dst_x++;
+                  src += n_components;
+                  dst += n_components;
+                }
+              else
+                {
+                  dst_y++;
+                  src += src_stride;
+                  dst += dst_stride;
+                  dir = TOP_TO_BOTTOM;
+                }
             }
-        }
-      else if (dir == RIGHT_TO_LEFT)
-        {
-          if (dst_x != 0)
+          else if (dir == TOP_TO_BOTTOM)
             {
-              dst_x--;
-              src -= n_components;
-              dst -= n_components;
+              if (dst_x == 0)
+                {
+                  dst_x++;
+                  src += n_components;
+                  dst += n_components;
+                  dir = LEFT_TO_RIGHT;
+                }
+              else
+                {
+                  dst_x--;
+                  src -= n_components;
+                  dst -= n_components;
+                  dir = RIGHT_TO_LEFT;
+                }
             }
-          else
+          else if (dir == RIGHT_TO_LEFT)
             {
-              dst_y++;
-              src += src_stride;
-              dst += dst_stride;
-              dir = TOP_TO_BOTTOM;
+              if (dst_x != 0)
+                {
+                  dst_x--;
+                  src -= n_components;
+                  dst -= n_components;
+                }
+              else
+                {
+                  dst_y++;
+                  src += src_stride;
+                  dst += dst_stride;
+                  dir = TOP_TO_BOTTOM;
+                }
             }
-        }
 
-      histogram_update (hist, src, src_stride,
-                        o->neighborhood, radius, neighborhood_outline,
-                        dir);
+          histogram_update (hist, src, src_stride,
+                            o->neighborhood, radius, neighborhood_outline,
+                            dir);
 
-      for (c = 0; c < n_color_components; c++)
-        dst[c] = histogram_get_median (hist, c, percentile);
-      if (has_alpha)
-        dst[c] = histogram_get_median (hist, c, alpha_percentile);
+          for (c = 0; c < n_color_components; c++)
+            dst[c] = histogram_get_median (hist, c, percentile);
+          if (has_alpha)
+            dst[c] = histogram_get_median (hist, c, alpha_percentile);
+        }
     }
 
   gegl_buffer_set (output, roi, 0, format, dst_buf, GEGL_AUTO_ROWSTRIDE);
@@ -948,6 +1813,7 @@ process (GeglOperation       *operation,
   for (c = 0; c < n_components; c++)
     {
       g_free (hist->components[c].bins);
+      g_free (hist->components[c].coarse_bins);
 
       if (! data->quantize)
         g_free (hist->components[c].bin_values);
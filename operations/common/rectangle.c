@@ -74,12 +74,28 @@ static void attach (GeglOperation *operation)
   gegl_operation_meta_redirect (operation, "height", crop, "height");
 }
 
+/* every property is bound to an internal node, which invalidates the part
+ * of the output it changes by itself.
+ */
+static GeglRectangle
+get_invalidated_by_property_change (GeglOperation       *operation,
+                                    GParamSpec          *pspec,
+                                    const GeglRectangle *old_rect,
+                                    const GeglRectangle *new_rect)
+{
+  GeglRectangle result = { 0, };
+
+  return result;
+}
+
 static void
 gegl_op_class_init (GeglOpClass *klass)
 {
   GeglOperationClass *operation_class = GEGL_OPERATION_CLASS (klass);
 
   operation_class->attach = attach;
+  operation_class->get_invalidated_by_property_change =
+    get_invalidated_by_property_change;
 
   gegl_operation_class_set_keys (operation_class,
   "name",               "gegl:rectangle",
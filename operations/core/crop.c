@@ -186,6 +186,28 @@ gegl_crop_get_invalidated_by_change (GeglOperation       *operation,
   return result;
 }
 
+/* the pixels inside both the old and the new crop rectangle are the same
+ * input pixels before and after the change, only the area which entered
+ * or left the rectangle has to be redrawn.
+ */
+static GeglRectangle
+gegl_crop_get_invalidated_by_property_change (GeglOperation       *operation,
+                                              GParamSpec          *pspec,
+                                              const GeglRectangle *old_rect,
+                                              const GeglRectangle *new_rect)
+{
+  GeglRectangle entered;
+  GeglRectangle left;
+  GeglRectangle result;
+
+  gegl_rectangle_subtract_bounding_box (&entered, new_rect, old_rect);
+  gegl_rectangle_subtract_bounding_box (&left,    old_rect, new_rect);
+
+  gegl_rectangle_bounding_box (&result, &entered, &left);
+
+  return result;
+}
+
 static GeglRectangle
 gegl_crop_get_required_for_output (GeglOperation       *operation,
                                    const gchar         *input_pad,
@@ -291,6 +313,8 @@ gegl_op_class_init (GeglOpClass *klass)
   operation_class->get_bounding_box          = gegl_crop_get_bounding_box;
   operation_class->detect                    = gegl_crop_detect;
   operation_class->get_invalidated_by_change = gegl_crop_get_invalidated_by_change;
+  operation_class->get_invalidated_by_property_change =
+    gegl_crop_get_invalidated_by_property_change;
   operation_class->get_required_for_output   = gegl_crop_get_required_for_output;
 
   gegl_operation_class_set_keys (operation_class,
@@ -34,6 +34,9 @@ extern "C" {
 }
 
 #include <ImfInputFile.h>
+#include <ImfTiledInputFile.h>
+#include <ImfTestFile.h>
+#include <ImfThreading.h>
 #include <ImfChannelList.h>
 #include <ImfRgbaFile.h>
 #include <ImfRgbaYca.h>
@@ -43,6 +46,8 @@ extern "C" {
 #include <stdio.h>
 #include <string.h>
 
+#include "exr-threads.h"
+
 using namespace Imf;
 using namespace Imf::RgbaYca;
 using namespace Imath;
@@ -58,6 +63,17 @@ enum
   COLOR_FP32   = 1<<7
 };
 
+/* the header of the file at path, as read by query_exr() */
+typedef struct
+{
+  gchar      *path;
+  gboolean    ok;
+  gint        width;
+  gint        height;
+  gint        format_flags;
+  const Babl *format;
+} Priv;
+
 static gfloat chroma_sampling[] =
   {
      0.002128,   -0.007540,
@@ -82,6 +98,13 @@ import_exr             (GeglBuffer  *gegl_buffer,
                         const gchar *path,
                         gint         format_flags);
 
+static gboolean
+import_exr_region      (GeglBuffer          *gegl_buffer,
+                        const gchar         *path,
+                        gint                 format_flags,
+                        const GeglRectangle *roi,
+                        gint                 level);
+
 static void
 convert_yca_to_rgba    (GeglBuffer *buf,
                         gint        has_alpha,
@@ -126,7 +149,8 @@ insert_channels        (FrameBuffer  &fb,
                         char         *base,
                         gint          width,
                         gint          format_flags,
-                        gint          bpp);
+                        gint          bpp,
+                        gint          rowstride);
 
 
 
@@ -409,7 +433,8 @@ insert_channels (FrameBuffer  &fb,
                  char         *base,
                  gint          width,
                  gint          format_flags,
-                 gint          bpp)
+                 gint          bpp,
+                 gint          rowstride)
 {
   gint alpha_offset;
   PixelType tp;
@@ -430,24 +455,24 @@ insert_channels (FrameBuffer  &fb,
 
   if (format_flags & COLOR_RGB)
     {
-      fb.insert ("R", Slice (tp, base,          bpp, 0, 1,1, 0.0));
-      fb.insert ("G", Slice (tp, base+bpc,      bpp, 0, 1,1, 0.0));
-      fb.insert ("B", Slice (tp, base+bpc*2,    bpp, 0, 1,1, 0.0));
+      fb.insert ("R", Slice (tp, base,          bpp, rowstride, 1,1, 0.0));
+      fb.insert ("G", Slice (tp, base+bpc,      bpp, rowstride, 1,1, 0.0));
+      fb.insert ("B", Slice (tp, base+bpc*2,    bpp, rowstride, 1,1, 0.0));
     }
   else if (format_flags & COLOR_C)
     {
-      fb.insert ("Y",  Slice (tp, base,         bpp,   0, 1,1, 0.5));
-      fb.insert ("RY", Slice (tp, base+bpc,     bpp*2, 0, 2,2, 0.0));
-      fb.insert ("BY", Slice (tp, base+bpc*2,   bpp*2, 0, 2,2, 0.0));
+      fb.insert ("Y",  Slice (tp, base,         bpp,   rowstride, 1,1, 0.5));
+      fb.insert ("RY", Slice (tp, base+bpc,     bpp*2, rowstride, 2,2, 0.0));
+      fb.insert ("BY", Slice (tp, base+bpc*2,   bpp*2, rowstride, 2,2, 0.0));
     }
   else if (format_flags & COLOR_Y)
     {
-      fb.insert ("Y",  Slice (tp, base, bpp, 0, 1,1, 0.5));
+      fb.insert ("Y",  Slice (tp, base, bpp, rowstride, 1,1, 0.5));
       alpha_offset = bpc;
     }
 
   if (format_flags & COLOR_ALPHA)
-    fb.insert ("A", Slice (tp, base+alpha_offset, bpp, 0, 1,1, 1.0));
+    fb.insert ("A", Slice (tp, base+alpha_offset, bpp, rowstride, 1,1, 1.0));
 }
 
 
@@ -485,7 +510,8 @@ import_exr (GeglBuffer  *gegl_buffer,
                        base,
                        gegl_buffer_get_width (gegl_buffer),
                        format_flags,
-                       pxsize);
+                       pxsize,
+                       0);
 
       file.setFrameBuffer (frameBuffer);
 
@@ -529,6 +555,138 @@ import_exr (GeglBuffer  *gegl_buffer,
   return TRUE;
 }
 
+/* reads the part of the image covering roi, at mipmap level, leaving the
+ * rest of the file alone.  tiled files are read a tile at a time, from the
+ * matching level of their mipmap when they have one; scanline files are
+ * read a band of rows at a time, at full resolution.  not used for files
+ * with subsampled chroma, whose reconstruction needs the whole image.
+ */
+static gboolean
+import_exr_region (GeglBuffer          *gegl_buffer,
+                   const gchar         *path,
+                   gint                 format_flags,
+                   const GeglRectangle *roi,
+                   gint                 level)
+{
+  char *pixels = NULL;
+
+  try
+    {
+      FrameBuffer   frameBuffer;
+      Box2i         dw;
+      GeglRectangle rect;
+      gint          file_level = 0;
+      gint          pxsize;
+      gint          rowstride;
+      char         *base;
+
+      g_object_get (gegl_buffer, "px-size", &pxsize, NULL);
+
+      if (isTiledOpenExrFile (path))
+        {
+          TiledInputFile         tiled (path);
+          const TileDescription &td = tiled.header ().tileDescription ();
+          gint                   tx0, ty0, tx1, ty1;
+
+          if (level > 0 && td.mode == MIPMAP_LEVELS &&
+              level < tiled.numLevels ())
+            file_level = level;
+          else if (level > 0 && td.mode == RIPMAP_LEVELS &&
+                   level < tiled.numXLevels () && level < tiled.numYLevels ())
+            file_level = level;
+
+          /* levels the file lacks are read at full resolution, and left
+           * to the mipmap of the buffer
+           */
+          rect = *roi;
+          if (file_level != level)
+            {
+              rect.x      <<= level;
+              rect.y      <<= level;
+              rect.width  <<= level;
+              rect.height <<= level;
+            }
+
+          dw = tiled.dataWindowForLevel (file_level, file_level);
+
+          if (! gegl_rectangle_intersect (&rect, &rect,
+                                          GEGL_RECTANGLE (0, 0,
+                                            dw.max.x - dw.min.x + 1,
+                                            dw.max.y - dw.min.y + 1)))
+            return TRUE;
+
+          tx0 = rect.x / (gint) td.xSize;
+          ty0 = rect.y / (gint) td.ySize;
+          tx1 = (rect.x + rect.width  - 1) / (gint) td.xSize;
+          ty1 = (rect.y + rect.height - 1) / (gint) td.ySize;
+
+          /* whole tiles are decoded anyway, so keep all of them */
+          rect.x      = tx0 * td.xSize;
+          rect.y      = ty0 * td.ySize;
+          rect.width  = (tx1 + 1) * td.xSize - rect.x;
+          rect.height = (ty1 + 1) * td.ySize - rect.y;
+          gegl_rectangle_intersect (&rect, &rect,
+                                    GEGL_RECTANGLE (0, 0,
+                                      dw.max.x - dw.min.x + 1,
+                                      dw.max.y - dw.min.y + 1));
+
+          rowstride = rect.width * pxsize;
+          pixels    = (char*) g_malloc0 ((gsize) rowstride * rect.height);
+
+          /* see import_exr() for why base may point outside of pixels */
+          base = pixels - (gssize) (dw.min.y + rect.y) * rowstride
+                        - (gssize) (dw.min.x + rect.x) * pxsize;
+
+          insert_channels (frameBuffer, tiled.header (), base, rect.width,
+                           format_flags, pxsize, rowstride);
+
+          tiled.setFrameBuffer (frameBuffer);
+          tiled.readTiles (tx0, tx1, ty0, ty1, file_level, file_level);
+        }
+      else
+        {
+          InputFile file (path);
+
+          dw = file.header ().dataWindow ();
+
+          /* scanlines span the whole width */
+          rect.x      = 0;
+          rect.y      = roi->y << level;
+          rect.width  = dw.max.x - dw.min.x + 1;
+          rect.height = roi->height << level;
+
+          if (! gegl_rectangle_intersect (&rect, &rect,
+                                          GEGL_RECTANGLE (0, 0,
+                                            dw.max.x - dw.min.x + 1,
+                                            dw.max.y - dw.min.y + 1)))
+            return TRUE;
+
+          rowstride = rect.width * pxsize;
+          pixels    = (char*) g_malloc0 ((gsize) rowstride * rect.height);
+
+          base = pixels - (gssize) (dw.min.y + rect.y) * rowstride
+                        - (gssize) dw.min.x * pxsize;
+
+          insert_channels (frameBuffer, file.header (), base, rect.width,
+                           format_flags, pxsize, rowstride);
+
+          file.setFrameBuffer (frameBuffer);
+          file.readPixels (dw.min.y + rect.y,
+                           dw.min.y + rect.y + rect.height - 1);
+        }
+
+      gegl_buffer_set (gegl_buffer, &rect, file_level, NULL, pixels, rowstride);
+
+      g_free (pixels);
+    }
+  catch (...)
+    {
+      g_free (pixels);
+      g_warning ("failed to load `%s'", path);
+      return FALSE;
+    }
+  return TRUE;
+}
 
 static gboolean
 query_exr (const gchar *path,
@@ -639,19 +797,55 @@ query_exr (const gchar *path,
   return TRUE;
 }
 
+/* returns the header of the file, which is only parsed again when the path
+ * changes, rather than on every query
+ */
+static Priv *
+get_priv (GeglOperation *operation)
+{
+  GeglProperties *o = GEGL_PROPERTIES (operation);
+  Priv           *p = (Priv *) o->user_data;
+  gpointer        format;
+
+  if (! p)
+    {
+      p = g_new0 (Priv, 1);
+      o->user_data = (void *) p;
+    }
+
+  if (! p->path || g_strcmp0 (p->path, o->path))
+    {
+      g_free (p->path);
+      p->path = g_strdup (o->path);
+
+      p->ok = query_exr (o->path, &p->width, &p->height,
+                         &p->format_flags, &format);
+      p->format = p->ok ? (const Babl *) format : NULL;
+    }
+
+  return p;
+}
+
+static void
+prepare (GeglOperation *operation)
+{
+  Priv *p = get_priv (operation);
+
+  if (p->ok)
+    gegl_operation_set_format (operation, "output", p->format);
+}
+
 static GeglRectangle
 get_bounding_box (GeglOperation *operation)
 {
-  GeglProperties   *o = GEGL_PROPERTIES (operation);
   GeglRectangle result = {0, 0, 10, 10};
-  gint          w, h, ff;
-  gpointer      format;
+  Priv         *p      = get_priv (operation);
 
-  if (query_exr (o->path, &w, &h, &ff, &format))
+  if (p->ok)
     {
-      result.width = w;
-      result.height = h;
-      gegl_operation_set_format (operation, "output", (Babl*)format);
+      result.width = p->width;
+      result.height = p->height;
+      gegl_operation_set_format (operation, "output", p->format);
     }
 
   return result;
@@ -664,15 +858,18 @@ process (GeglOperation       *operation,
          int                  level)
 {
   GeglProperties *o = GEGL_PROPERTIES (operation);
-  gint        w,h,ff;
-  gpointer    format;
-  gboolean    ok;
-
-  ok = query_exr (o->path, &w, &h, &ff, &format);
+  Priv           *p = get_priv (operation);
 
-  if (ok)
+  if (p->ok)
     {
-      import_exr (output, o->path, ff);
+      exr_thread_pool_acquire ();
+
+      if (p->format_flags & COLOR_C)
+        import_exr (output, o->path, p->format_flags);
+      else
+        import_exr_region (output, o->path, p->format_flags, result, level);
+
+      exr_thread_pool_release ();
     }
   else
     {
@@ -686,19 +883,43 @@ static GeglRectangle
 get_cached_region (GeglOperation       *operation,
                    const GeglRectangle *roi)
 {
+  Priv *p = get_priv (operation);
+
+  /* only chroma subsampled files have to be loaded as a whole */
+  if (p->ok && ! (p->format_flags & COLOR_C))
+    return *roi;
+
   return get_bounding_box (operation);
 }
 
+static void
+finalize (GObject *object)
+{
+  GeglProperties *o = GEGL_PROPERTIES (object);
+  Priv           *p = (Priv *) o->user_data;
+
+  if (p)
+    {
+      g_free (p->path);
+      g_clear_pointer (&o->user_data, g_free);
+    }
+
+  G_OBJECT_CLASS (gegl_op_parent_class)->finalize (object);
+}
+
 static void
 gegl_op_class_init (GeglOpClass *klass)
 {
   GeglOperationClass       *operation_class;
   GeglOperationSourceClass *source_class;
 
+  G_OBJECT_CLASS (klass)->finalize = finalize;
+
   operation_class = GEGL_OPERATION_CLASS (klass);
   source_class    = GEGL_OPERATION_SOURCE_CLASS (klass);
 
   source_class->process = process;
+  operation_class->prepare = prepare;
   operation_class->get_bounding_box = get_bounding_box;
 
   operation_class->get_cached_region = get_cached_region;
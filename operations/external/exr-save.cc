@@ -27,6 +27,21 @@ property_int  (tile, "Tile", 0)
    description (_("tile size to use."))
    value_range (0, 2048)
 
+enum_start (gegl_exr_save_compression)
+  enum_value (GEGL_EXR_SAVE_COMPRESSION_NONE,  "none",  N_("None"))
+  enum_value (GEGL_EXR_SAVE_COMPRESSION_RLE,   "rle",   N_("RLE"))
+  enum_value (GEGL_EXR_SAVE_COMPRESSION_ZIPS,  "zips",  N_("ZIP, single scanline"))
+  enum_value (GEGL_EXR_SAVE_COMPRESSION_ZIP,   "zip",   N_("ZIP"))
+  enum_value (GEGL_EXR_SAVE_COMPRESSION_PIZ,   "piz",   N_("PIZ"))
+  enum_value (GEGL_EXR_SAVE_COMPRESSION_PXR24, "pxr24", N_("PXR24"))
+  enum_value (GEGL_EXR_SAVE_COMPRESSION_DWAA,  "dwaa",  N_("DWAA"))
+enum_end (GeglExrSaveCompression)
+
+property_enum (compression, _("Compression"),
+               GeglExrSaveCompression, gegl_exr_save_compression,
+               GEGL_EXR_SAVE_COMPRESSION_ZIP)
+   description (_("compression of the pixel data, DWAA is lossy."))
+
 #else
 
 #define GEGL_OP_SINK
@@ -39,6 +54,8 @@ extern "C" {
 } /* extern "C" */
 
 #include <exception>
+#include <OpenEXRConfig.h>
+#include <ImfThreading.h>
 #include <ImfTiledOutputFile.h>
 #include <ImfOutputFile.h>
 #include <ImfChannelList.h>
@@ -47,6 +64,8 @@ extern "C" {
 #include <ImfArray.h>
 #include "ImathRandom.h"
 
+#include "exr-threads.h"
+
 
 
 
@@ -79,6 +98,34 @@ create_header (int w,
   return header;
 }
 
+/**
+ * map the compression property to the compression of the header, DWAA
+ * falling back to ZIP where OpenEXR predates it.
+ */
+static Imf::Compression
+get_compression (GeglExrSaveCompression compression)
+{
+  switch (compression)
+    {
+      case GEGL_EXR_SAVE_COMPRESSION_NONE:  return Imf::NO_COMPRESSION;
+      case GEGL_EXR_SAVE_COMPRESSION_RLE:   return Imf::RLE_COMPRESSION;
+      case GEGL_EXR_SAVE_COMPRESSION_ZIPS:  return Imf::ZIPS_COMPRESSION;
+      case GEGL_EXR_SAVE_COMPRESSION_PIZ:   return Imf::PIZ_COMPRESSION;
+      case GEGL_EXR_SAVE_COMPRESSION_PXR24: return Imf::PXR24_COMPRESSION;
+      case GEGL_EXR_SAVE_COMPRESSION_DWAA:
+#if OPENEXR_VERSION_MAJOR > 2 || \
+    (OPENEXR_VERSION_MAJOR == 2 && OPENEXR_VERSION_MINOR >= 2)
+        return Imf::DWAA_COMPRESSION;
+#else
+        g_warning ("exr-save: DWAA compression needs OpenEXR 2.2, using ZIP.");
+        return Imf::ZIP_COMPRESSION;
+#endif
+      case GEGL_EXR_SAVE_COMPRESSION_ZIP:
+      default:
+        return Imf::ZIP_COMPRESSION;
+    }
+}
+
 /**
  * create an Imf::FrameBuffer object for w*h*d floats and return it.
  */
@@ -129,10 +176,12 @@ write_tiled_exr (const float       *pixels,
                  int                d,
                  int                tw,
                  int                th,
+                 Imf::Compression   compression,
                  const std::string &filename)
 {
   Imf::Header header (create_header (w, h, d));
   header.setTileDescription (Imf::TileDescription (tw, th, Imf::ONE_LEVEL));
+  header.compression () = compression;
 
   {
     double wp[2];
@@ -170,9 +219,11 @@ write_scanline_exr (const float       *pixels,
                     int                w,
                     int                h,
                     int                d,
+                    Imf::Compression   compression,
                     const std::string &filename)
 {
   Imf::Header header (create_header (w, h, d));
+  header.compression () = compression;
 
   {
     double wp[2];
@@ -209,17 +260,19 @@ exr_save_process (const float       *pixels,
                   int                h,
                   int                d,
                   int                tile_size,
+                  Imf::Compression   compression,
                   const std::string &filename)
 {
   if (tile_size == 0)
     {
       /* write a scanline exr image. */
-      write_scanline_exr (pixels, space, w, h, d, filename);
+      write_scanline_exr (pixels, space, w, h, d, compression, filename);
     }
   else
     {
       /* write a tiled exr image. */
-      write_tiled_exr (pixels, space, w, h, d, tile_size, tile_size, filename);
+      write_tiled_exr (pixels, space, w, h, d, tile_size, tile_size,
+                       compression, filename);
     }
 }
 
@@ -274,10 +327,12 @@ gegl_exr_save_process (GeglOperation       *operation,
   gegl_buffer_get (input, rect, 1.0, babl_format_with_space (output_format.c_str (), original_space),
                    pixels, GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
   bool status;
+  exr_thread_pool_acquire ();
   try
     {
       exr_save_process (pixels, original_space, rect->width, rect->height,
-                        n_components, tile_size, filename);
+                        n_components, tile_size,
+                        get_compression (o->compression), filename);
       status = TRUE;
     }
   catch (std::exception &e)
@@ -286,6 +341,7 @@ gegl_exr_save_process (GeglOperation       *operation,
          filename.c_str (), e.what ());
       status = FALSE;
     }
+  exr_thread_pool_release ();
   g_free (pixels);
   return status;
 }
@@ -0,0 +1,110 @@
+/* This file is part of GEGL
+ *
+ * GEGL is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * GEGL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GEGL; if not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef __EXR_THREADS_H__
+#define __EXR_THREADS_H__
+
+#include <ImfThreading.h>
+
+/* OpenEXR decodes and compresses with a single, process-wide thread pool,
+ * which is sized to the number of threads GEGL is configured to use.  the
+ * setting is checked again before every load and save, but the pool can only
+ * be resized while no other load or save is using it.
+ *
+ * exr-load and exr-save are separate modules, so the lock and the count of
+ * users are kept on the GeglConfig, where both find the same ones.
+ */
+typedef struct
+{
+  GMutex mutex;
+  gint   n_users;
+} ExrThreadPool;
+
+#define EXR_THREAD_POOL_KEY "gegl-exr-thread-pool"
+
+static ExrThreadPool *
+exr_thread_pool_get (void)
+{
+  GObject       *config = G_OBJECT (gegl_config ());
+  ExrThreadPool *pool;
+
+  pool = (ExrThreadPool *) g_object_get_data (config, EXR_THREAD_POOL_KEY);
+
+  if (! pool)
+    {
+      ExrThreadPool *new_pool = g_new0 (ExrThreadPool, 1);
+
+      g_mutex_init (&new_pool->mutex);
+
+      /* the first module to get here installs its pool, the other one
+       * uses that pool instead of its own.
+       */
+      if (g_object_replace_data (config, EXR_THREAD_POOL_KEY,
+                                 NULL, new_pool, NULL, NULL))
+        {
+          pool = new_pool;
+        }
+      else
+        {
+          g_mutex_clear (&new_pool->mutex);
+          g_free (new_pool);
+
+          pool = (ExrThreadPool *) g_object_get_data (config,
+                                                      EXR_THREAD_POOL_KEY);
+        }
+    }
+
+  return pool;
+}
+
+/* to be called before using OpenEXR, and paired with
+ * exr_thread_pool_release() afterwards.
+ */
+static void
+exr_thread_pool_acquire (void)
+{
+  ExrThreadPool *pool = exr_thread_pool_get ();
+  gint           threads;
+
+  g_object_get (gegl_config (), "threads", &threads, NULL);
+
+  /* a single thread is best left to the calling one */
+  if (threads <= 1)
+    threads = 0;
+
+  g_mutex_lock (&pool->mutex);
+
+  if (pool->n_users == 0 && Imf::globalThreadCount () != threads)
+    Imf::setGlobalThreadCount (threads);
+
+  pool->n_users++;
+
+  g_mutex_unlock (&pool->mutex);
+}
+
+static void
+exr_thread_pool_release (void)
+{
+  ExrThreadPool *pool = exr_thread_pool_get ();
+
+  g_mutex_lock (&pool->mutex);
+
+  pool->n_users--;
+
+  g_mutex_unlock (&pool->mutex);
+}
+
+#endif /* __EXR_THREADS_H__ */
@@ -267,6 +267,156 @@ gegl_png_space (png_structp load_png_ptr,
   return NULL;
 }
 
+/* decoded rows are handed to the buffer a band of tile rows at a time, so
+ * that the buffer is locked, and the pixels converted, once per band.  for
+ * images spanning several bands, the bands are written on a thread of
+ * their own, while the next one is decoded.
+ */
+#define N_BANDS 2
+
+typedef struct
+{
+  GeglRectangle  rect;
+  guchar        *pixels;
+  png_bytep     *rows;
+} PngBand;
+
+typedef struct
+{
+  GeglBuffer    *buffer;
+  const Babl    *format;
+  gint           rowstride;
+  gint           band_height;
+
+  PngBand        bands[N_BANDS];
+  gint           n_bands;
+
+  GAsyncQueue   *decoded;
+  GAsyncQueue   *written;
+  PngBand        end;
+  GThread       *thread;
+} PngWriter;
+
+static gpointer
+png_writer_thread (gpointer data)
+{
+  PngWriter *writer = data;
+  PngBand   *band;
+
+  while ((band = g_async_queue_pop (writer->decoded)) != &writer->end)
+    {
+      gegl_buffer_set (writer->buffer, &band->rect, 0, writer->format,
+                       band->pixels, writer->rowstride);
+
+      g_async_queue_push (writer->written, band);
+    }
+
+  return NULL;
+}
+
+static PngWriter *
+png_writer_new (GeglBuffer *buffer,
+                const Babl *format,
+                gint        width,
+                gint        height,
+                gint        bpp,
+                gboolean    threaded)
+{
+  PngWriter *writer = g_slice_new0 (PngWriter);
+  gint       i, j;
+
+  writer->buffer    = buffer;
+  writer->format    = format;
+  writer->rowstride = width * bpp;
+
+  g_object_get (buffer, "tile-height", &writer->band_height, NULL);
+  writer->band_height = CLAMP (writer->band_height, 1, MAX (height, 1));
+
+  writer->n_bands = threaded && height > writer->band_height ? N_BANDS : 1;
+
+  writer->written = g_async_queue_new ();
+
+  for (i = 0; i < writer->n_bands; i++)
+    {
+      PngBand *band = &writer->bands[i];
+
+      band->pixels = g_malloc0 ((gsize) writer->rowstride * writer->band_height);
+      band->rows   = g_new (png_bytep, writer->band_height);
+
+      for (j = 0; j < writer->band_height; j++)
+        band->rows[j] = band->pixels + (gsize) writer->rowstride * j;
+
+      g_async_queue_push (writer->written, band);
+    }
+
+  if (writer->n_bands > 1)
+    {
+      writer->decoded = g_async_queue_new ();
+      writer->thread  = g_thread_new ("png-load writer",
+                                      png_writer_thread, writer);
+    }
+
+  return writer;
+}
+
+/* returns a band whose previous content has been written */
+static PngBand *
+png_writer_get_band (PngWriter *writer,
+                     gint       x,
+                     gint       y,
+                     gint       width,
+                     gint       height)
+{
+  PngBand *band = g_async_queue_pop (writer->written);
+
+  gegl_rectangle_set (&band->rect, x, y, width,
+                      MIN (height, writer->band_height));
+
+  return band;
+}
+
+static void
+png_writer_put_band (PngWriter *writer,
+                     PngBand   *band)
+{
+  if (writer->thread)
+    {
+      g_async_queue_push (writer->decoded, band);
+    }
+  else
+    {
+      gegl_buffer_set (writer->buffer, &band->rect, 0, writer->format,
+                       band->pixels, writer->rowstride);
+
+      g_async_queue_push (writer->written, band);
+    }
+}
+
+/* waits for the pending bands to be written */
+static void
+png_writer_free (PngWriter *writer)
+{
+  gint i;
+
+  if (writer->thread)
+    {
+      g_async_queue_push (writer->decoded, &writer->end);
+      g_thread_join (writer->thread);
+
+      g_async_queue_unref (writer->decoded);
+    }
+
+  g_async_queue_unref (writer->written);
+
+  for (i = 0; i < writer->n_bands; i++)
+    {
+      g_free (writer->bands[i].rows);
+      g_free (writer->bands[i].pixels);
+    }
+
+  g_slice_free (PngWriter, writer);
+}
+
 static gint
 gegl_buffer_import_png (GeglBuffer  *gegl_buffer,
                         GInputStream *stream,
@@ -287,7 +437,7 @@ gegl_buffer_import_png (GeglBuffer  *gegl_buffer,
   png_uint_32    h;
   png_structp    load_png_ptr;
   png_infop      load_info_ptr;
-  guchar        *pixels;
+  PngWriter     *volatile writer = NULL;
   /*png_bytep     *rows;*/
 
 
@@ -319,6 +469,8 @@ gegl_buffer_import_png (GeglBuffer  *gegl_buffer,
 
   if (setjmp (png_jmpbuf (load_png_ptr)))
     {
+      if (writer)
+        png_writer_free (writer);
       png_destroy_read_struct (&load_png_ptr, &load_info_ptr, NULL);
       g_free (row_p);
       return -1;
@@ -451,34 +603,50 @@ gegl_buffer_import_png (GeglBuffer  *gegl_buffer,
       }
   }
 
-  pixels = g_malloc0 (width*bpp);
+  /* passes of interlaced images read back what the previous ones wrote,
+   * so their bands are written in order
+   */
+  writer = png_writer_new (gegl_buffer, format, width, h, bpp,
+                           number_of_passes == 1);
 
   {
     gint           pass;
-    GeglRectangle  rect;
 
     for (pass=0; pass<number_of_passes; pass++)
       {
-        for(i=0; i<h; i++)
+        for(i=0; i<h; i += writer->band_height)
           {
-            gegl_rectangle_set (&rect, 0, i, width, 1);
+            PngBand *band = png_writer_get_band (writer, dest_x, dest_y + i,
+                                                 width, h - i);
 
             if (pass != 0)
-              gegl_buffer_get (gegl_buffer, &rect, 1.0, format, pixels, GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
-
-            png_read_rows (load_png_ptr, &pixels, NULL, 1);
-            gegl_buffer_set (gegl_buffer, &rect, 0, format, pixels,
-                             GEGL_AUTO_ROWSTRIDE);
+              gegl_buffer_get (gegl_buffer, &band->rect, 1.0, format,
+                               band->pixels, writer->rowstride,
+                               GEGL_ABYSS_NONE);
+
+            /* rows of later passes are merged into the earlier ones, and
+             * the coarse passes of interlaced images are replicated over
+             * the rows they stand for, so that each pass written gives a
+             * complete, if blocky, image
+             */
+            if (number_of_passes == 1)
+              png_read_rows (load_png_ptr, band->rows, NULL,
+                             band->rect.height);
+            else
+              png_read_rows (load_png_ptr, NULL, band->rows,
+                             band->rect.height);
+
+            png_writer_put_band (writer, band);
           }
       }
   }
 
+  png_writer_free (writer);
+  writer = NULL;
 
   png_read_end (load_png_ptr, NULL);
   png_destroy_read_struct (&load_png_ptr, &load_info_ptr, NULL);
 
-  g_free (pixels);
-
   return 0;
 }
 
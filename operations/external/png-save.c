@@ -45,6 +45,43 @@ property_object(metadata, _("Metadata"), GEGL_TYPE_METADATA)
 #include <gegl-op.h>
 #include <gegl-gio-private.h>
 #include <png.h>
+#include <zlib.h>
+
+/* with more than one thread, rows are filtered and deflated in chunks of
+ * about PNG_CHUNK_SIZE bytes on all of them, each chunk primed with the
+ * window of data preceding it, and the chunks stitched back into a single
+ * zlib stream, the way pigz does it.
+ */
+#define PNG_CHUNK_SIZE  (128 * 1024)
+#define PNG_WINDOW_SIZE (32 * 1024)
+
+typedef struct
+{
+  guchar  *data;
+  gsize    length;
+  gsize    in_length;
+  uLong    adler;
+  gboolean failed;
+} PngChunk;
+
+typedef struct
+{
+  gint      compression;
+  gint      bpp;
+  gsize     row_bytes;
+  gint      rows_per_chunk;
+  gint      n_chunks;
+
+  /* the last row of the previous group, followed by the rows of this one */
+  guchar   *rows;
+  /* the window preceding this group, followed by its filtered rows */
+  guchar   *filtered;
+  gsize     history;
+
+  gint      n_rows;
+  gboolean  finish;
+  PngChunk *chunks;
+} PngEncoder;
 
 static void
 png_format_timestamp (const GValue *src_value, GValue *dest_value)
@@ -120,6 +157,359 @@ clear_png_text (gpointer data)
   g_free (text->text);
 }
 
+static PngEncoder *
+png_encoder_new (gsize row_bytes,
+                 gint  bpp,
+                 gint  compression,
+                 gint  n_chunks)
+{
+  PngEncoder *encoder = g_new0 (PngEncoder, 1);
+
+  encoder->compression    = compression;
+  encoder->bpp            = bpp;
+  encoder->row_bytes      = row_bytes;
+  encoder->rows_per_chunk = MAX (1, PNG_CHUNK_SIZE / (row_bytes + 1));
+  encoder->n_chunks       = n_chunks;
+
+  encoder->rows     = g_malloc0 (row_bytes * (encoder->rows_per_chunk *
+                                              n_chunks + 1));
+  encoder->filtered = g_malloc (PNG_WINDOW_SIZE +
+                                (row_bytes + 1) * encoder->rows_per_chunk *
+                                n_chunks);
+  encoder->chunks   = g_new0 (PngChunk, n_chunks);
+
+  return encoder;
+}
+
+static void
+png_encoder_free (PngEncoder *encoder)
+{
+  gint i;
+
+  for (i = 0; i < encoder->n_chunks; i++)
+    g_free (encoder->chunks[i].data);
+
+  g_free (encoder->chunks);
+  g_free (encoder->filtered);
+  g_free (encoder->rows);
+  g_free (encoder);
+}
+
+static inline gint
+png_paeth (gint a,
+           gint b,
+           gint c)
+{
+  gint p  = a + b - c;
+  gint pa = ABS (p - a);
+  gint pb = ABS (p - b);
+  gint pc = ABS (p - c);
+
+  if (pa <= pb && pa <= pc)
+    return a;
+  else if (pb <= pc)
+    return b;
+  else
+    return c;
+}
+
+/* picks the filter with the smallest sum of absolute differences, the same
+ * heuristic libpng uses, writing the filter type and the filtered row to
+ * @dest.  @scratch holds another filtered row.
+ */
+static void
+png_filter_row (const guchar *row,
+                const guchar *prev,
+                guchar       *dest,
+                guchar       *scratch,
+                gsize         row_bytes,
+                gint          bpp)
+{
+  guchar *best = NULL;
+  guint64 best_sum = G_MAXUINT64;
+  gint    filter;
+
+  for (filter = PNG_FILTER_VALUE_NONE; filter <= PNG_FILTER_VALUE_PAETH; filter++)
+    {
+      guchar *out = best == dest ? scratch : dest;
+      guint64 sum = 0;
+      gsize   i;
+
+      out[0] = filter;
+
+      for (i = 0; i < row_bytes && sum < best_sum; i++)
+        {
+          gint   a = i >= bpp ? row[i - bpp]  : 0;
+          gint   b = prev[i];
+          gint   c = i >= bpp ? prev[i - bpp] : 0;
+          gint   predicted;
+          guchar value;
+
+          switch (filter)
+            {
+            default:
+            case PNG_FILTER_VALUE_NONE:  predicted = 0;                      break;
+            case PNG_FILTER_VALUE_SUB:   predicted = a;                      break;
+            case PNG_FILTER_VALUE_UP:    predicted = b;                      break;
+            case PNG_FILTER_VALUE_AVG:   predicted = (a + b) >> 1;           break;
+            case PNG_FILTER_VALUE_PAETH: predicted = png_paeth (a, b, c);    break;
+            }
+
+          value = row[i] - predicted;
+          out[i + 1] = value;
+
+          sum += value < 128 ? value : 256 - value;
+        }
+
+      if (sum < best_sum)
+        {
+          best     = out;
+          best_sum = sum;
+        }
+    }
+
+  if (best != dest)
+    memcpy (dest, best, row_bytes + 1);
+}
+
+static void
+png_encoder_filter (gint     i,
+                    gint     n,
+                    gpointer data)
+{
+  PngEncoder *encoder    = data;
+  gsize       row_bytes  = encoder->row_bytes;
+  gint        first_row  = (gint64) encoder->n_rows * i / n;
+  gint        last_row   = (gint64) encoder->n_rows * (i + 1) / n;
+  guchar     *scratch    = g_malloc (row_bytes + 1);
+  gint        row;
+
+  for (row = first_row; row < last_row; row++)
+    {
+      png_filter_row (encoder->rows + (row + 1) * row_bytes,
+                      encoder->rows + row * row_bytes,
+                      encoder->filtered + PNG_WINDOW_SIZE +
+                      row * (row_bytes + 1),
+                      scratch, row_bytes, encoder->bpp);
+    }
+
+  g_free (scratch);
+}
+
+static void
+png_encoder_deflate_chunk (PngEncoder *encoder,
+                           gint        index)
+{
+  PngChunk *chunk       = &encoder->chunks[index];
+  gsize     chunk_bytes = (encoder->row_bytes + 1) * encoder->rows_per_chunk;
+  gsize     offset      = chunk_bytes * index;
+  gsize     window;
+  gboolean  last;
+  z_stream  stream      = { 0, };
+  gint      flush;
+  gint      status;
+
+  chunk->length    = 0;
+  chunk->in_length = 0;
+  chunk->failed    = FALSE;
+
+  if (index * encoder->rows_per_chunk >= encoder->n_rows)
+    return;
+
+  chunk->in_length = MIN (chunk_bytes,
+                          (encoder->row_bytes + 1) * encoder->n_rows - offset);
+
+  last  = encoder->finish &&
+          (index + 1) * encoder->rows_per_chunk >= encoder->n_rows;
+  flush = last ? Z_FINISH : Z_SYNC_FLUSH;
+
+  /* raw deflate, the zlib header and trailer are written around the chunks */
+  if (deflateInit2 (&stream, encoder->compression, Z_DEFLATED, -15, 8,
+                    Z_FILTERED) != Z_OK)
+    {
+      chunk->failed = TRUE;
+      return;
+    }
+
+  window = MIN (PNG_WINDOW_SIZE, encoder->history + offset);
+
+  if (window > 0)
+    {
+      deflateSetDictionary (&stream,
+                            encoder->filtered + PNG_WINDOW_SIZE + offset -
+                            window,
+                            window);
+    }
+
+  chunk->data = g_realloc (chunk->data,
+                           deflateBound (&stream, chunk->in_length) + 16);
+
+  stream.next_in   = encoder->filtered + PNG_WINDOW_SIZE + offset;
+  stream.avail_in  = chunk->in_length;
+  stream.next_out  = chunk->data;
+  stream.avail_out = deflateBound (&stream, chunk->in_length) + 16;
+
+  status = deflate (&stream, flush);
+
+  if ((last  && status != Z_STREAM_END) ||
+      (!last && (status != Z_OK || stream.avail_in != 0 ||
+                 stream.avail_out == 0)))
+    {
+      chunk->failed = TRUE;
+    }
+
+  chunk->length = stream.total_out;
+  chunk->adler  = adler32 (adler32 (0, NULL, 0),
+                           encoder->filtered + PNG_WINDOW_SIZE + offset,
+                           chunk->in_length);
+
+  deflateEnd (&stream);
+}
+
+static void
+png_encoder_deflate (gint     i,
+                     gint     n,
+                     gpointer data)
+{
+  PngEncoder *encoder = data;
+  gint        first   = encoder->n_chunks * i / n;
+  gint        last    = encoder->n_chunks * (i + 1) / n;
+  gint        index;
+
+  for (index = first; index < last; index++)
+    png_encoder_deflate_chunk (encoder, index);
+}
+
+static void
+png_write_u32 (png_structp png,
+               guint32     value)
+{
+  png_byte bytes[4];
+
+  png_save_uint_32 (bytes, value);
+  png_write_chunk_data (png, bytes, 4);
+}
+
+/* writes the rows of @result as IDAT chunks, deflated in parallel */
+static gint
+write_rows_parallel (png_structp          png,
+                     GeglBuffer          *input,
+                     const GeglRectangle *result,
+                     const Babl          *format,
+                     gint                 bit_depth,
+                     PngEncoder          *encoder)
+{
+  uLong adler = adler32 (0, NULL, 0);
+  gint  y;
+
+  for (y = 0; y < result->height; y += encoder->n_rows)
+    {
+      gsize filtered_bytes;
+      gsize idat_length = 0;
+      gsize history;
+      gint  i;
+
+      encoder->n_rows = MIN (encoder->rows_per_chunk * encoder->n_chunks,
+                             result->height - y);
+      encoder->finish = y + encoder->n_rows == result->height;
+
+      gegl_buffer_get (input,
+                       GEGL_RECTANGLE (result->x, result->y + y,
+                                       result->width, encoder->n_rows),
+                       1.0, format, encoder->rows + encoder->row_bytes,
+                       GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+
+#if BYTE_ORDER == LITTLE_ENDIAN
+      if (bit_depth > 8)
+        {
+          guint16 *samples   = (guint16 *) (encoder->rows + encoder->row_bytes);
+          gsize    n_samples = encoder->row_bytes / 2 * encoder->n_rows;
+          gsize    j;
+
+          for (j = 0; j < n_samples; j++)
+            samples[j] = GUINT16_SWAP_LE_BE (samples[j]);
+        }
+#endif
+
+      /* rows are filtered against the row above them, so all of them have to
+       * be filtered before any chunk can use the ones before it as window
+       */
+      gegl_parallel_distribute (encoder->n_chunks, png_encoder_filter, encoder);
+      gegl_parallel_distribute (encoder->n_chunks, png_encoder_deflate, encoder);
+
+      for (i = 0; i < encoder->n_chunks; i++)
+        {
+          if (encoder->chunks[i].failed)
+            return -1;
+
+          idat_length += encoder->chunks[i].length;
+        }
+
+      if (y == 0)
+        idat_length += 2;
+      if (encoder->finish)
+        idat_length += 4;
+
+      png_write_chunk_start (png, (png_const_bytep) "IDAT", idat_length);
+
+      if (y == 0)
+        {
+          /* a 32K window, and the level hint zlib itself would write */
+          png_byte header[2] = { 0x78, 0 };
+          gint     level;
+
+          if (encoder->compression < 2)
+            level = 0;
+          else if (encoder->compression < 6)
+            level = 1;
+          else if (encoder->compression == 6)
+            level = 2;
+          else
+            level = 3;
+
+          header[1] = level << 6;
+          header[1] += 31 - (header[0] * 256 + header[1]) % 31;
+
+          png_write_chunk_data (png, header, 2);
+        }
+
+      for (i = 0; i < encoder->n_chunks; i++)
+        {
+          PngChunk *chunk = &encoder->chunks[i];
+
+          if (chunk->in_length == 0)
+            continue;
+
+          png_write_chunk_data (png, chunk->data, chunk->length);
+
+          adler = adler32_combine (adler, chunk->adler, chunk->in_length);
+        }
+
+      if (encoder->finish)
+        png_write_u32 (png, adler);
+
+      png_write_chunk_end (png);
+
+      /* keep the last row, and the window, for the next group */
+      filtered_bytes = (encoder->row_bytes + 1) * encoder->n_rows;
+      history        = MIN (PNG_WINDOW_SIZE, encoder->history + filtered_bytes);
+
+      memcpy (encoder->rows,
+              encoder->rows + encoder->n_rows * encoder->row_bytes,
+              encoder->row_bytes);
+      memmove (encoder->filtered + PNG_WINDOW_SIZE - history,
+               encoder->filtered + PNG_WINDOW_SIZE + filtered_bytes - history,
+               history);
+
+      encoder->history = history;
+    }
+
+  png_write_chunk (png, (png_const_bytep) "IEND", NULL, 0);
+  png_write_flush (png);
+
+  return 0;
+}
+
 static gint
 export_png (GeglOperation       *operation,
             GeglBuffer          *input,
@@ -140,6 +530,8 @@ export_png (GeglOperation       *operation,
   const Babl    *space = babl_format_get_space (babl);
   const Babl    *format;
   GArray        *itxt = NULL;
+  PngEncoder    *volatile encoder = NULL;
+  gint           threads;
 
   src_x = result->x;
   src_y = result->y;
@@ -181,7 +573,12 @@ export_png (GeglOperation       *operation,
     strcat (format_string, "u8");
 
   if (setjmp (png_jmpbuf (png)))
-    return -1;
+    {
+      if (encoder)
+        png_encoder_free (encoder);
+
+      return -1;
+    }
 
   png_set_compression_level (png, compression);
 
@@ -317,6 +714,32 @@ export_png (GeglOperation       *operation,
 
   png_write_info (png, info);
 
+  g_object_get (gegl_config (), "threads", &threads, NULL);
+
+  if (threads > 1)
+    {
+      gint bpp = babl_format_get_bytes_per_pixel (format);
+
+      encoder = png_encoder_new ((gsize) width * bpp, bpp, compression,
+                                 threads);
+
+      /* a single chunk gains nothing from the threads */
+      if (height > encoder->rows_per_chunk)
+        {
+          gint status = write_rows_parallel (png, input, result, format,
+                                             bit_depth, encoder);
+
+          png_encoder_free (encoder);
+
+          if (itxt != NULL)
+            g_array_unref (itxt);
+          return status;
+        }
+
+      png_encoder_free (encoder);
+      encoder = NULL;
+    }
+
 #if BYTE_ORDER == LITTLE_ENDIAN
   if (bit_depth > 8)
     png_set_swap (png);
@@ -44,6 +44,7 @@ property_object(metadata, _("Metadata"), GEGL_TYPE_METADATA)
 #define GEGL_OP_SOURCE
 #define GEGL_OP_NAME     tiff_load
 #define GEGL_OP_C_SOURCE tiff-load.c
+#define GEGL_OP_BUNDLE
 
 
 #include <gegl-op.h>
@@ -51,6 +52,8 @@ property_object(metadata, _("Metadata"), GEGL_TYPE_METADATA)
 #include <glib/gprintf.h>
 #include <tiffio.h>
 
+#include <gegl-buffer-backend.h>
+
 typedef enum {
   TIFF_LOADING_RGBA,
   TIFF_LOADING_CONTIGUOUS,
@@ -77,6 +80,8 @@ typedef struct
 
   gint width;
   gint height;
+
+  GeglBuffer *output;
 } Priv;
 
 #ifdef HAVE_STRPTIME
@@ -138,6 +143,7 @@ cleanup(GeglOperation *operation)
       p->tiff = NULL;
 
       g_clear_object (&p->file);
+      g_clear_object (&p->output);
 
       p->width = p->height = 0;
       p->directory = 0;
@@ -390,6 +396,44 @@ get_file_size(thandle_t handle)
   return (toff_t) size;
 }
 
+static TIFF *
+tiff_open(Priv *p,
+          const gchar *uri,
+          const gchar *path)
+{
+  GError *error = NULL;
+
+  p->stream = gegl_gio_open_input_stream(uri, path, &p->file, &error);
+  if (p->stream != NULL && p->file != NULL)
+    p->can_seek = g_seekable_can_seek(G_SEEKABLE(p->stream));
+  if (p->stream == NULL)
+    {
+      if (error)
+      {
+        g_warning("%s", error->message);
+        g_error_free(error);
+      }
+      return NULL;
+    }
+
+  TIFFSetErrorHandler(error_handler);
+  TIFFSetWarningHandler(warning_handler);
+
+  p->tiff = TIFFClientOpen("GEGL-tiff-load", "r", (thandle_t) p,
+                           read_from_stream, write_to_stream,
+                           seek_in_stream, close_stream,
+                           get_file_size, NULL, NULL);
+  if (p->tiff == NULL)
+    {
+      if (uri != NULL && strlen(uri) > 0)
+        g_warning("failed to open TIFF from %s", uri);
+      else
+        g_warning("failed to open TIFF from %s", path);
+    }
+
+  return p->tiff;
+}
+
 static void
 set_meta_string (GObject *metadata, const gchar *name, const gchar *value)
 {
@@ -860,12 +904,989 @@ load_separated(GeglOperation *operation,
   return 0;
 }
 
+/* Lazy loading
+ *
+ * Unless libtiff has to convert the pixels itself, the loader hands out a
+ * buffer backed by a GeglTiffBackend, which only decodes the tiles, or
+ * strips, of the TIFF that overlap the tiles asked for.  Each thread
+ * decodes through a TIFF of its own, and the tiles a request is going to
+ * need are decoded ahead of time, in parallel.  Reduced resolution images,
+ * stored as SubIFDs or as the directories following the image, are handed
+ * out as its mipmap levels.
+ */
+
+#define GEGL_TIFF_MAX_LEVELS 32
+#define GEGL_TIFF_MAX_PLANES 16
+
+typedef struct
+{
+  gint directory;
+  toff_t subifd;          /* the offset of the level, if it is a SubIFD */
+
+  gint width;
+  gint height;
+
+  gboolean tiled;
+  gint block_width;       /* the size of its tiles, or strips */
+  gint block_height;
+
+  guint64 layout;         /* levels differing in layout are not used */
+} TiffLevel;
+
+typedef struct
+{
+  Priv priv;
+
+  gint level;             /* the level the TIFF is set to */
+  gint row_size;          /* the size of a row of a block of that level */
+
+  gboolean has_block;     /* the last block read */
+  guint32 block;
+  guchar *block_data;
+  gsize block_size;
+} TiffReader;
+
+typedef struct
+{
+  gint x;
+  gint y;
+  gint z;
+} TiffTileKey;
+
+#define GEGL_TYPE_TIFF_BACKEND (gegl_tiff_backend_get_type())
+#define GEGL_TIFF_BACKEND(obj) (G_TYPE_CHECK_INSTANCE_CAST((obj), GEGL_TYPE_TIFF_BACKEND, GeglTiffBackend))
+
+typedef struct
+{
+  GeglTileBackend parent_instance;
+
+  gchar *uri;
+  gchar *path;
+
+  TiffLevel levels[GEGL_TIFF_MAX_LEVELS];
+  gint n_levels;
+
+  /* one plane, or one per component for separated TIFFs */
+  gint n_planes;
+  gint plane_bpp[GEGL_TIFF_MAX_PLANES];
+  gint plane_offset[GEGL_TIFF_MAX_PLANES];
+  gint bpp;
+
+  GMutex mutex;
+  GSList *readers;        /* idle readers */
+  GHashTable *decoded;    /* tiles decoded ahead of being asked for */
+  GHashTable *stored;     /* level 0 tiles written to, or voided */
+  gboolean modified;
+} GeglTiffBackend;
+
+typedef struct
+{
+  GeglTileBackendClass parent_class;
+} GeglTiffBackendClass;
+
+G_DEFINE_DYNAMIC_TYPE(GeglTiffBackend, gegl_tiff_backend, GEGL_TYPE_TILE_BACKEND)
+
+static guint
+tiff_tile_key_hash(gconstpointer key)
+{
+  const TiffTileKey *k = key;
+
+  return (guint) k->x * 73856093u ^ (guint) k->y * 19349663u ^
+         (guint) k->z * 83492791u;
+}
+
+static gboolean
+tiff_tile_key_equal(gconstpointer a,
+                    gconstpointer b)
+{
+  const TiffTileKey *ka = a;
+  const TiffTileKey *kb = b;
+
+  return ka->x == kb->x && ka->y == kb->y && ka->z == kb->z;
+}
+
+static TiffTileKey *
+tiff_tile_key_new(gint x,
+                  gint y,
+                  gint z)
+{
+  TiffTileKey *key = g_new(TiffTileKey, 1);
+
+  key->x = x;
+  key->y = y;
+  key->z = z;
+
+  return key;
+}
+
+static void
+tiff_tile_free(GeglTile *tile)
+{
+  if (tile != NULL)
+    {
+      /* keep tile_unref from handing it back to us */
+      gegl_tile_mark_as_stored(tile);
+      gegl_tile_unref(tile);
+    }
+}
+
+static gboolean
+tiff_level_read(TIFF *tiff,
+                TiffLevel *level)
+{
+  guint32 width, height;
+  guint32 block_width = 0, block_height = 0;
+  gushort photometric = 0;
+  gushort samples_per_pixel, bits_per_sample;
+  gushort sample_format, planar_config;
+
+  if (!TIFFGetField(tiff, TIFFTAG_IMAGEWIDTH, &width) ||
+      !TIFFGetField(tiff, TIFFTAG_IMAGELENGTH, &height))
+    return FALSE;
+
+  level->tiled = TIFFIsTiled(tiff);
+  if (level->tiled)
+    {
+      TIFFGetField(tiff, TIFFTAG_TILEWIDTH, &block_width);
+      TIFFGetField(tiff, TIFFTAG_TILELENGTH, &block_height);
+    }
+  else
+    {
+      block_width = width;
+      TIFFGetFieldDefaulted(tiff, TIFFTAG_ROWSPERSTRIP, &block_height);
+      block_height = MIN(block_height, height);
+    }
+
+  if (width == 0 || height == 0 || block_width == 0 || block_height == 0 ||
+      width > G_MAXINT || height > G_MAXINT)
+    return FALSE;
+
+  level->width = (gint) width;
+  level->height = (gint) height;
+  level->block_width = (gint) block_width;
+  level->block_height = (gint) block_height;
+
+  TIFFGetField(tiff, TIFFTAG_PHOTOMETRIC, &photometric);
+  TIFFGetFieldDefaulted(tiff, TIFFTAG_SAMPLESPERPIXEL, &samples_per_pixel);
+  TIFFGetFieldDefaulted(tiff, TIFFTAG_BITSPERSAMPLE, &bits_per_sample);
+  TIFFGetFieldDefaulted(tiff, TIFFTAG_SAMPLEFORMAT, &sample_format);
+  TIFFGetFieldDefaulted(tiff, TIFFTAG_PLANARCONFIG, &planar_config);
+
+  level->layout = ((guint64) photometric << 48) |
+                  ((guint64) samples_per_pixel << 32) |
+                  ((guint64) bits_per_sample << 16) |
+                  ((guint64) sample_format << 8) |
+                  (guint64) planar_config;
+
+  return TRUE;
+}
+
+static TiffReader *
+tiff_reader_open(const gchar *uri,
+                 const gchar *path)
+{
+  TiffReader *reader = g_new0(TiffReader, 1);
+
+  reader->level = -1;
+
+  if (tiff_open(&reader->priv, uri, path) == NULL)
+    {
+      if (reader->priv.stream != NULL)
+        g_input_stream_close(G_INPUT_STREAM(reader->priv.stream), NULL, NULL);
+
+      g_clear_object(&reader->priv.stream);
+      g_clear_object(&reader->priv.file);
+      g_free(reader);
+      return NULL;
+    }
+
+  return reader;
+}
+
+static void
+tiff_reader_close(TiffReader *reader)
+{
+  TIFFClose(reader->priv.tiff);
+
+  g_clear_object(&reader->priv.file);
+  g_free(reader->block_data);
+  g_free(reader);
+}
+
+static gboolean
+tiff_reader_set_level(TiffReader *reader,
+                      GeglTiffBackend *self,
+                      gint level_index)
+{
+  TiffLevel *level = &self->levels[level_index];
+  TIFF *tiff = reader->priv.tiff;
+  gboolean set;
+
+  if (reader->level == level_index)
+    return TRUE;
+
+  reader->level = -1;
+  reader->has_block = FALSE;
+
+  if (level->subifd)
+    set = TIFFSetSubDirectory(tiff, level->subifd);
+  else
+    set = TIFFSetDirectory(tiff, level->directory);
+
+  if (!set)
+    return FALSE;
+
+  if (level->tiled)
+    reader->row_size = TIFFTileRowSize(tiff);
+  else
+    reader->row_size = TIFFScanlineSize(tiff);
+
+  if (reader->row_size <= 0)
+    return FALSE;
+
+  reader->level = level_index;
+
+  return TRUE;
+}
+
+/* returns the decoded block holding the pixel x,y of a plane of the level
+ * the reader is set to
+ */
+static const guchar *
+tiff_reader_read_block(TiffReader *reader,
+                       const TiffLevel *level,
+                       gint x,
+                       gint y,
+                       gint plane)
+{
+  TIFF *tiff = reader->priv.tiff;
+  guint32 block;
+  tmsize_t size;
+  tmsize_t read;
+
+  if (level->tiled)
+    block = TIFFComputeTile(tiff, x, y, 0, plane);
+  else
+    block = TIFFComputeStrip(tiff, y, plane);
+
+  if (reader->has_block && reader->block == block)
+    return reader->block_data;
+
+  reader->has_block = FALSE;
+
+  size = level->tiled ? TIFFTileSize(tiff) : TIFFStripSize(tiff);
+  if (size <= 0)
+    return NULL;
+
+  if ((gsize) size > reader->block_size)
+    {
+      g_free(reader->block_data);
+
+      reader->block_data = g_try_malloc(size);
+      reader->block_size = reader->block_data ? (gsize) size : 0;
+
+      if (reader->block_data == NULL)
+        return NULL;
+    }
+
+  if (level->tiled)
+    read = TIFFReadEncodedTile(tiff, block, reader->block_data, size);
+  else
+    read = TIFFReadEncodedStrip(tiff, block, reader->block_data, size);
+
+  if (read < 0)
+    return NULL;
+
+  reader->block = block;
+  reader->has_block = TRUE;
+
+  return reader->block_data;
+}
+
+/* decodes a rectangle of the level the reader is set to, interleaving the
+ * planes of separated TIFFs on the way
+ */
+static void
+tiff_reader_read_rectangle(TiffReader *reader,
+                           GeglTiffBackend *self,
+                           const GeglRectangle *rect,
+                           guchar *dest,
+                           gint dest_stride)
+{
+  const TiffLevel *level = &self->levels[reader->level];
+  gint bw = level->block_width;
+  gint bh = level->block_height;
+  gint src_bpp = reader->row_size / bw;
+  gint plane;
+
+  for (plane = 0; plane < self->n_planes; plane++)
+    {
+      gint plane_bpp = self->plane_bpp[plane];
+      gint bx, by;
+
+      for (by = rect->y / bh * bh; by < rect->y + rect->height; by += bh)
+        {
+          for (bx = rect->x / bw * bw; bx < rect->x + rect->width; bx += bw)
+            {
+              GeglRectangle block_rect = { bx, by, bw, bh };
+              GeglRectangle area;
+              const guchar *src;
+              guchar *d;
+              gint row;
+
+              gegl_rectangle_intersect(&area, &block_rect, rect);
+
+              src = tiff_reader_read_block(reader, level, bx, by, plane);
+              if (src == NULL)
+                continue;
+
+              src += (area.y - by) * reader->row_size + (area.x - bx) * src_bpp;
+              d = dest + (area.y - rect->y) * dest_stride +
+                  (area.x - rect->x) * self->bpp + self->plane_offset[plane];
+
+              for (row = 0; row < area.height; row++)
+                {
+                  if (src_bpp == self->bpp)
+                    {
+                      memcpy(d, src, area.width * self->bpp);
+                    }
+                  else
+                    {
+                      const guchar *s = src;
+                      guchar *p = d;
+                      gint i;
+
+                      for (i = 0; i < area.width; i++)
+                        {
+                          memcpy(p, s, plane_bpp);
+
+                          s += src_bpp;
+                          p += self->bpp;
+                        }
+                    }
+
+                  src += reader->row_size;
+                  d += dest_stride;
+                }
+            }
+        }
+    }
+}
+
+static TiffReader *
+gegl_tiff_backend_acquire_reader(GeglTiffBackend *self)
+{
+  TiffReader *reader = NULL;
+
+  g_mutex_lock(&self->mutex);
+
+  if (self->readers != NULL)
+    {
+      reader = self->readers->data;
+      self->readers = g_slist_delete_link(self->readers, self->readers);
+    }
+
+  g_mutex_unlock(&self->mutex);
+
+  if (reader == NULL)
+    reader = tiff_reader_open(self->uri, self->path);
+
+  return reader;
+}
+
+static void
+gegl_tiff_backend_release_reader(GeglTiffBackend *self,
+                                 TiffReader *reader)
+{
+  g_mutex_lock(&self->mutex);
+
+  self->readers = g_slist_prepend(self->readers, reader);
+
+  g_mutex_unlock(&self->mutex);
+}
+
+/* returns the level of the TIFF holding mipmap level z, or -1 */
+static gint
+gegl_tiff_backend_find_level(GeglTiffBackend *self,
+                             gint z)
+{
+  gint width, height;
+  gint i;
+
+  if (z == 0)
+    return 0;
+
+  if (z >= 31 || self->modified)
+    return -1;
+
+  width = (self->levels[0].width + (1 << z) - 1) >> z;
+  height = (self->levels[0].height + (1 << z) - 1) >> z;
+
+  for (i = 1; i < self->n_levels; i++)
+    {
+      if (ABS(self->levels[i].width - width) <= 1 &&
+          ABS(self->levels[i].height - height) <= 1)
+        return i;
+    }
+
+  return -1;
+}
+
+static void
+gegl_tiff_backend_scan_levels(GeglTiffBackend *self,
+                              TiffReader *reader)
+{
+  TIFF *tiff = reader->priv.tiff;
+  TiffLevel *base = &self->levels[0];
+  gushort n_subifds = 0;
+  toff_t *subifds = NULL;
+
+  base->directory = TIFFCurrentDirectory(tiff);
+  if (!tiff_level_read(tiff, base))
+    return;
+
+  self->n_levels = 1;
+
+  if (TIFFGetField(tiff, TIFFTAG_SUBIFD, &n_subifds, &subifds) &&
+      n_subifds > 0)
+    {
+      /* the array goes away with the directory */
+      toff_t *offsets = g_new(toff_t, n_subifds);
+      gint i;
+
+      memcpy(offsets, subifds, n_subifds * sizeof(toff_t));
+
+      for (i = 0; i < n_subifds && self->n_levels < GEGL_TIFF_MAX_LEVELS; i++)
+        {
+          TiffLevel *level = &self->levels[self->n_levels];
+          TiffLevel *previous = &self->levels[self->n_levels - 1];
+
+          if (!TIFFSetSubDirectory(tiff, offsets[i]) ||
+              !tiff_level_read(tiff, level))
+            break;
+
+          level->directory = base->directory;
+          level->subifd = offsets[i];
+
+          if (level->layout == base->layout && level->width < previous->width)
+            self->n_levels++;
+        }
+
+      g_free(offsets);
+    }
+  else
+    {
+      TIFFSetDirectory(tiff, base->directory);
+
+      while (self->n_levels < GEGL_TIFF_MAX_LEVELS && TIFFReadDirectory(tiff))
+        {
+          TiffLevel *level = &self->levels[self->n_levels];
+          TiffLevel *previous = &self->levels[self->n_levels - 1];
+          guint32 subfile_type = 0;
+
+          TIFFGetField(tiff, TIFFTAG_SUBFILETYPE, &subfile_type);
+
+          if (!(subfile_type & FILETYPE_REDUCEDIMAGE) ||
+              !tiff_level_read(tiff, level))
+            break;
+
+          level->directory = TIFFCurrentDirectory(tiff);
+          level->subifd = 0;
+
+          if (level->layout == base->layout && level->width < previous->width)
+            self->n_levels++;
+        }
+    }
+
+  reader->level = -1;
+}
+
+static GeglTile *
+gegl_tiff_backend_decode_tile(GeglTiffBackend *self,
+                              TiffReader *reader,
+                              gint x,
+                              gint y,
+                              gint z)
+{
+  GeglTileBackend *backend = GEGL_TILE_BACKEND(self);
+  gint tile_width = gegl_tile_backend_get_tile_width(backend);
+  gint tile_height = gegl_tile_backend_get_tile_height(backend);
+  GeglRectangle tile_rect = { x * tile_width, y * tile_height,
+                              tile_width, tile_height };
+  GeglRectangle rect;
+  TiffLevel *level;
+  GeglTile *tile;
+  guchar *data;
+  gint level_index;
+
+  level_index = gegl_tiff_backend_find_level(self, z);
+  if (level_index < 0)
+    return NULL;
+
+  level = &self->levels[level_index];
+
+  if (!gegl_rectangle_intersect(&rect, &tile_rect,
+                                GEGL_RECTANGLE(0, 0, level->width,
+                                               level->height)))
+    return NULL;
+
+  if (!tiff_reader_set_level(reader, self, level_index))
+    return NULL;
+
+  tile = gegl_tile_new(gegl_tile_backend_get_tile_size(backend));
+  data = gegl_tile_get_data(tile);
+
+  if (!gegl_rectangle_equal(&rect, &tile_rect))
+    memset(data, 0, gegl_tile_backend_get_tile_size(backend));
+
+  tiff_reader_read_rectangle(reader, self, &rect,
+                             data + ((rect.y - tile_rect.y) * tile_width +
+                                     (rect.x - tile_rect.x)) * self->bpp,
+                             tile_width * self->bpp);
+
+  gegl_tile_mark_as_stored(tile);
+
+  return tile;
+}
+
+static GeglTile *
+gegl_tiff_backend_get_tile(GeglTiffBackend *self,
+                           gint x,
+                           gint y,
+                           gint z)
+{
+  TiffTileKey key = { x, y, z };
+  TiffReader *reader;
+  GeglTile *tile = NULL;
+  gpointer stored_key;
+  gpointer value;
+
+  g_mutex_lock(&self->mutex);
+
+  if (g_hash_table_lookup_extended(self->stored, &key, NULL, &value))
+    {
+      tile = value ? gegl_tile_ref(value) : NULL;
+
+      g_mutex_unlock(&self->mutex);
+      return tile;
+    }
+
+  if (g_hash_table_lookup_extended(self->decoded, &key, &stored_key, &value))
+    {
+      g_hash_table_steal(self->decoded, &key);
+      g_free(stored_key);
+
+      g_mutex_unlock(&self->mutex);
+      return value;
+    }
+
+  g_mutex_unlock(&self->mutex);
+
+  if (gegl_tiff_backend_find_level(self, z) < 0)
+    {
+      GeglTileBackend *backend = GEGL_TILE_BACKEND(self);
+      gint tile_width = gegl_tile_backend_get_tile_width(backend);
+      gint tile_height = gegl_tile_backend_get_tile_height(backend);
+      GeglRectangle tile_rect;
+
+      if (z >= 31)
+        return NULL;
+
+      tile_rect.x = (x * tile_width) << z;
+      tile_rect.y = (y * tile_height) << z;
+      tile_rect.width = tile_width << z;
+      tile_rect.height = tile_height << z;
+
+      if (!gegl_rectangle_intersect(NULL, &tile_rect,
+                                    GEGL_RECTANGLE(0, 0, self->levels[0].width,
+                                                   self->levels[0].height)))
+        return NULL;
+
+      /* a level the file does not have; an empty tile would be taken as
+       * the final word, a fully damaged one gets rendered from the level
+       * below
+       */
+      tile = gegl_tile_new(gegl_tile_backend_get_tile_size(backend));
+      gegl_tile_set_damage(tile, ~(guint64) 0);
+      gegl_tile_mark_as_stored(tile);
+
+      return tile;
+    }
+
+  reader = gegl_tiff_backend_acquire_reader(self);
+  if (reader == NULL)
+    return NULL;
+
+  tile = gegl_tiff_backend_decode_tile(self, reader, x, y, z);
+
+  gegl_tiff_backend_release_reader(self, reader);
+
+  return tile;
+}
+
+static void
+gegl_tiff_backend_set_tile(GeglTiffBackend *self,
+                           GeglTile *tile,
+                           gint x,
+                           gint y,
+                           gint z)
+{
+  /* mipmap levels are rendered again from level 0 */
+  if (z != 0)
+    return;
+
+  tile = gegl_tile_ref_for_store(tile, x, y, z);
+
+  gegl_tile_mark_as_stored(tile);
+
+  g_mutex_lock(&self->mutex);
+
+  g_hash_table_replace(self->stored, tiff_tile_key_new(x, y, z), tile);
+  self->modified = TRUE;
+
+  g_mutex_unlock(&self->mutex);
+}
+
+static void
+gegl_tiff_backend_void_tile(GeglTiffBackend *self,
+                            gint x,
+                            gint y,
+                            gint z)
+{
+  TiffTileKey key = { x, y, z };
+
+  g_mutex_lock(&self->mutex);
+
+  g_hash_table_remove(self->decoded, &key);
+
+  if (z == 0)
+    {
+      g_hash_table_replace(self->stored, tiff_tile_key_new(x, y, z), NULL);
+      self->modified = TRUE;
+    }
+
+  g_mutex_unlock(&self->mutex);
+}
+
+static gpointer
+gegl_tiff_backend_command(GeglTileSource *tile_store,
+                          GeglTileCommand command,
+                          gint x,
+                          gint y,
+                          gint z,
+                          gpointer data)
+{
+  GeglTiffBackend *self = GEGL_TIFF_BACKEND(tile_store);
+
+  switch (command)
+    {
+    case GEGL_TILE_GET:
+      return gegl_tiff_backend_get_tile(self, x, y, z);
+
+    case GEGL_TILE_SET:
+      gegl_tiff_backend_set_tile(self, data, x, y, z);
+      return NULL;
+
+    case GEGL_TILE_IDLE:
+      return NULL;
+
+    case GEGL_TILE_VOID:
+      gegl_tiff_backend_void_tile(self, x, y, z);
+      return NULL;
+
+    case GEGL_TILE_EXIST:
+      {
+        GeglTileBackend *backend = GEGL_TILE_BACKEND(self);
+        gint tile_width = gegl_tile_backend_get_tile_width(backend);
+        gint tile_height = gegl_tile_backend_get_tile_height(backend);
+
+        return GINT_TO_POINTER(z == 0 &&
+                               gegl_rectangle_intersect(NULL,
+                                 GEGL_RECTANGLE(x * tile_width,
+                                                y * tile_height,
+                                                tile_width, tile_height),
+                                 GEGL_RECTANGLE(0, 0, self->levels[0].width,
+                                                self->levels[0].height)));
+      }
+
+    default:
+      break;
+    }
+
+  return gegl_tile_backend_command(GEGL_TILE_BACKEND(tile_store),
+                                   command, x, y, z, data);
+}
+
+typedef struct
+{
+  GeglTiffBackend *self;
+  TiffTileKey *tiles;
+  gint n_tiles;
+} TiffPrefetch;
+
+static void
+gegl_tiff_backend_prefetch_range(gint i,
+                                 gint n,
+                                 gpointer user_data)
+{
+  TiffPrefetch *prefetch = user_data;
+  GeglTiffBackend *self = prefetch->self;
+  gint first = (gint64) prefetch->n_tiles * i / n;
+  gint last = (gint64) prefetch->n_tiles * (i + 1) / n;
+  TiffReader *reader;
+
+  reader = gegl_tiff_backend_acquire_reader(self);
+  if (reader == NULL)
+    return;
+
+  for (; first < last; first++)
+    {
+      TiffTileKey *key = &prefetch->tiles[first];
+      GeglTile *tile;
+
+      tile = gegl_tiff_backend_decode_tile(self, reader,
+                                           key->x, key->y, key->z);
+      if (tile == NULL)
+        continue;
+
+      g_mutex_lock(&self->mutex);
+
+      if (!g_hash_table_contains(self->stored, key) &&
+          !g_hash_table_contains(self->decoded, key))
+        {
+          g_hash_table_insert(self->decoded,
+                              tiff_tile_key_new(key->x, key->y, key->z),
+                              tile);
+          tile = NULL;
+        }
+
+      g_mutex_unlock(&self->mutex);
+
+      tiff_tile_free(tile);
+    }
+
+  gegl_tiff_backend_release_reader(self, reader);
+}
+
+/* decodes the tiles of roi, at mipmap level z, which are neither cached
+ * nor decoded yet, across worker threads
+ */
+static void
+gegl_tiff_backend_prefetch(GeglTiffBackend *self,
+                           const GeglRectangle *roi,
+                           gint z)
+{
+  GeglTileBackend *backend = GEGL_TILE_BACKEND(self);
+  gint tile_width = gegl_tile_backend_get_tile_width(backend);
+  gint tile_height = gegl_tile_backend_get_tile_height(backend);
+  GeglRectangle rect = *roi;
+  TiffPrefetch prefetch;
+  GArray *tiles;
+  gint x, y;
+
+  /* levels missing from the file are rendered from the tiles of the
+   * closest level below that is not
+   */
+  while (gegl_tiff_backend_find_level(self, z) < 0)
+    {
+      rect.x *= 2;
+      rect.y *= 2;
+      rect.width *= 2;
+      rect.height *= 2;
+      z--;
+    }
+
+  if (!gegl_rectangle_intersect(&rect, &rect,
+                                GEGL_RECTANGLE(0, 0,
+                                  (self->levels[0].width + (1 << z) - 1) >> z,
+                                  (self->levels[0].height + (1 << z) - 1) >> z)))
+    return;
+
+  if (gegl_tile_backend_peek_storage(backend) == NULL)
+    return;
+
+  tiles = g_array_new(FALSE, FALSE, sizeof(TiffTileKey));
+
+  for (y = rect.y / tile_height;
+       y <= (rect.y + rect.height - 1) / tile_height; y++)
+    {
+      for (x = rect.x / tile_width;
+           x <= (rect.x + rect.width - 1) / tile_width; x++)
+        {
+          TiffTileKey key = { x, y, z };
+          gboolean known;
+
+          /* the storage lock is taken before our own when the storage
+           * calls into the backend, so the two are never held together
+           * here
+           */
+          if (gegl_tile_backend_is_cached(backend, x, y, z))
+            continue;
+
+          g_mutex_lock(&self->mutex);
+          known = g_hash_table_contains(self->stored, &key) ||
+                  g_hash_table_contains(self->decoded, &key);
+          g_mutex_unlock(&self->mutex);
+
+          if (!known)
+            g_array_append_val(tiles, key);
+        }
+    }
+
+  /* a single tile is decoded as quickly when it is asked for */
+  if (tiles->len > 1)
+    {
+      prefetch.self = self;
+      prefetch.tiles = (TiffTileKey *) tiles->data;
+      prefetch.n_tiles = tiles->len;
+
+      gegl_parallel_distribute(tiles->len,
+                               gegl_tiff_backend_prefetch_range,
+                               &prefetch);
+    }
+
+  g_array_free(tiles, TRUE);
+}
+
+static GeglBuffer *
+gegl_tiff_backend_buffer_new(GeglOperation *operation)
+{
+  GeglProperties *o = GEGL_PROPERTIES(operation);
+  Priv *p = (Priv*) o->user_data;
+  GeglTiffBackend *self;
+  GeglRectangle extent = { 0, 0, p->width, p->height };
+  GeglBuffer *buffer;
+  TiffReader *reader;
+  gint tile_width, tile_height;
+  gint i;
+
+  reader = tiff_reader_open(o->uri, o->path);
+  if (reader == NULL)
+    return NULL;
+
+  if (!TIFFSetDirectory(reader->priv.tiff, TIFFCurrentDirectory(p->tiff)))
+    {
+      tiff_reader_close(reader);
+      return NULL;
+    }
+
+  /* the tile size of the node caches, so that they can share our tiles */
+  g_object_get(gegl_config(),
+               "tile-width",  &tile_width,
+               "tile-height", &tile_height,
+               NULL);
+
+  self = g_object_new(GEGL_TYPE_TIFF_BACKEND,
+                      "tile-width",  tile_width,
+                      "tile-height", tile_height,
+                      "format",      p->format,
+                      NULL);
+
+  self->uri = g_strdup(o->uri);
+  self->path = g_strdup(o->path);
+  self->bpp = babl_format_get_bytes_per_pixel(p->format);
+
+  if (p->mode == TIFF_LOADING_SEPARATED)
+    {
+      gint offset = 0;
+
+      self->n_planes = MIN(babl_format_get_n_components(p->format),
+                           GEGL_TIFF_MAX_PLANES);
+
+      for (i = 0; i < self->n_planes; i++)
+        {
+          const Babl *component_type = babl_format_get_type(p->format, i);
+
+          self->plane_offset[i] = offset;
+          self->plane_bpp[i] =
+            babl_format_get_bytes_per_pixel(babl_format_n(component_type, 1));
+
+          offset += self->plane_bpp[i];
+        }
+    }
+  else
+    {
+      self->n_planes = 1;
+      self->plane_offset[0] = 0;
+      self->plane_bpp[0] = self->bpp;
+    }
+
+  gegl_tiff_backend_scan_levels(self, reader);
+  gegl_tiff_backend_release_reader(self, reader);
+
+  if (self->n_levels == 0)
+    {
+      g_object_unref(self);
+      return NULL;
+    }
+
+  gegl_tile_backend_set_extent(GEGL_TILE_BACKEND(self), &extent);
+
+  buffer = gegl_buffer_new_for_backend(&extent, GEGL_TILE_BACKEND(self));
+  g_object_unref(self);
+
+  return buffer;
+}
+
+static void
+gegl_tiff_backend_finalize(GObject *object)
+{
+  GeglTiffBackend *self = GEGL_TIFF_BACKEND(object);
+
+  g_hash_table_destroy(self->stored);
+  g_hash_table_destroy(self->decoded);
+  g_slist_free_full(self->readers, (GDestroyNotify) tiff_reader_close);
+  g_mutex_clear(&self->mutex);
+
+  g_free(self->uri);
+  g_free(self->path);
+
+  G_OBJECT_CLASS(gegl_tiff_backend_parent_class)->finalize(object);
+}
+
+static void
+gegl_tiff_backend_init(GeglTiffBackend *self)
+{
+  GEGL_TILE_SOURCE(self)->command = gegl_tiff_backend_command;
+
+  g_mutex_init(&self->mutex);
+
+  self->decoded = g_hash_table_new_full(tiff_tile_key_hash,
+                                        tiff_tile_key_equal,
+                                        g_free,
+                                        (GDestroyNotify) tiff_tile_free);
+  self->stored = g_hash_table_new_full(tiff_tile_key_hash,
+                                       tiff_tile_key_equal,
+                                       g_free,
+                                       (GDestroyNotify) tiff_tile_free);
+}
+
+static void
+gegl_tiff_backend_class_init(GeglTiffBackendClass *klass)
+{
+  G_OBJECT_CLASS(klass)->finalize = gegl_tiff_backend_finalize;
+}
+
+static void
+gegl_tiff_backend_class_finalize(GeglTiffBackendClass *klass)
+{
+}
+
+static gboolean
+is_lazy(Priv *p)
+{
+  /* libtiff converts the pixels of fallback TIFFs in one go, and a
+   * stream that can not seek can not be read twice
+   */
+  return p->tiff != NULL && p->mode != TIFF_LOADING_RGBA &&
+         p->can_seek && p->file != NULL;
+}
+
 static void
 prepare(GeglOperation *operation)
 {
   GeglProperties *o = GEGL_PROPERTIES(operation);
   Priv *p = (o->user_data) ? o->user_data : g_new0(Priv, 1);
-  GError *error = NULL;
   GFile *file = NULL;
   gint directories;
 
@@ -889,33 +1910,8 @@ prepare(GeglOperation *operation)
 
   if (p->stream == NULL)
     {
-      p->stream = gegl_gio_open_input_stream(o->uri, o->path, &p->file, &error);
-      if (p->stream != NULL && p->file != NULL)
-        p->can_seek = g_seekable_can_seek(G_SEEKABLE(p->stream));
-      if (p->stream == NULL)
-        {
-          if (error)
-          {
-            g_warning("%s", error->message);
-            g_error_free(error);
-          }
-          cleanup(operation);
-          return;
-        }
-
-      TIFFSetErrorHandler(error_handler);
-      TIFFSetWarningHandler(warning_handler);
-
-      p->tiff = TIFFClientOpen("GEGL-tiff-load", "r", (thandle_t) p,
-                               read_from_stream, write_to_stream,
-                               seek_in_stream, close_stream,
-                               get_file_size, NULL, NULL);
-      if (p->tiff == NULL)
+      if (tiff_open(p, o->uri, o->path) == NULL)
         {
-          if (o->uri != NULL && strlen(o->uri) > 0)
-            g_warning("failed to open TIFF from %s", o->uri);
-          else
-            g_warning("failed to open TIFF from %s", o->path);
           cleanup(operation);
           return;
         }
@@ -923,6 +1919,8 @@ prepare(GeglOperation *operation)
 
   if (o->directory != p->directory)
     {
+      g_clear_object(&p->output);
+
       directories = TIFFNumberOfDirectories(p->tiff);
       if (o->directory > 1 && o->directory <= directories)
         TIFFSetDirectory(p->tiff, o->directory - 1);
@@ -992,10 +1990,54 @@ process(GeglOperation *operation,
   return FALSE;
 }
 
+/* hands out the lazily decoded buffer where there is one, and lets the
+ * source process() above fill the output in otherwise
+ */
+static gboolean
+operation_process(GeglOperation *operation,
+                  GeglOperationContext *context,
+                  const gchar *output_pad,
+                  const GeglRectangle *result,
+                  gint level)
+{
+  GeglProperties *o = GEGL_PROPERTIES(operation);
+  Priv *p = (Priv*) o->user_data;
+
+  if (p != NULL && is_lazy(p))
+    {
+      if (p->output == NULL)
+        p->output = gegl_tiff_backend_buffer_new(operation);
+
+      if (p->output != NULL)
+        {
+          gegl_tiff_backend_prefetch(
+            GEGL_TIFF_BACKEND(gegl_buffer_backend(p->output)),
+            result, level);
+
+          gegl_operation_context_take_object(context, output_pad,
+                                             G_OBJECT(g_object_ref(p->output)));
+          return TRUE;
+        }
+    }
+
+  return GEGL_OPERATION_CLASS(gegl_op_parent_class)->process(operation,
+                                                             context,
+                                                             output_pad,
+                                                             result,
+                                                             level);
+}
+
 static GeglRectangle
 get_cached_region(GeglOperation       *operation,
                   const GeglRectangle *roi)
 {
+  GeglProperties *o = GEGL_PROPERTIES(operation);
+  Priv *p = (Priv*) o->user_data;
+
+  /* tiles are only decoded as they are asked for */
+  if (p != NULL && is_lazy(p))
+    return *roi;
+
   return get_bounding_box(operation);
 }
 
@@ -1025,6 +2067,7 @@ gegl_op_class_init(GeglOpClass *klass)
   source_class = GEGL_OPERATION_SOURCE_CLASS(klass);
 
   source_class->process = process;
+  operation_class->process = operation_process;
   operation_class->prepare = prepare;
   operation_class->get_bounding_box = get_bounding_box;
   operation_class->get_cached_region = get_cached_region;
@@ -1046,4 +2089,19 @@ gegl_op_class_init(GeglOpClass *klass)
     ".tif", "gegl:tiff-load");
 }
 
+G_MODULE_EXPORT const GeglModuleInfo *
+gegl_module_query(GTypeModule *module)
+{
+  return &modinfo;
+}
+
+G_MODULE_EXPORT gboolean
+gegl_module_register(GTypeModule *module)
+{
+  gegl_op_tiff_load_register_type(module);
+  gegl_tiff_backend_register_type(module);
+
+  return TRUE;
+}
+
 #endif
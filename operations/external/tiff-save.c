@@ -31,6 +31,17 @@ property_int (fp, _("use floating point"), -1)
   description (_("floating point -1 means auto, 0 means integer 1 meant float."))
   value_range (-1, 1)
 
+enum_start (gegl_tiff_save_compression)
+  enum_value (GEGL_TIFF_SAVE_COMPRESSION_NONE,    "none",    N_("None"))
+  enum_value (GEGL_TIFF_SAVE_COMPRESSION_LZW,     "lzw",     N_("LZW"))
+  enum_value (GEGL_TIFF_SAVE_COMPRESSION_DEFLATE, "deflate", N_("Deflate"))
+enum_end (GeglTiffSaveCompression)
+
+property_enum (compression, _("Compression"),
+               GeglTiffSaveCompression, gegl_tiff_save_compression,
+               GEGL_TIFF_SAVE_COMPRESSION_NONE)
+  description (_("compression of the strips, deflate is done on all threads"))
+
 property_object(metadata, _("Metadata"), GEGL_TYPE_METADATA)
   description (_("Object to receive image metadata"))
 
@@ -44,6 +55,33 @@ property_object(metadata, _("Metadata"), GEGL_TYPE_METADATA)
 #include <gegl-gio-private.h>
 #include <glib/gprintf.h>
 #include <tiffio.h>
+#include <zlib.h>
+
+/* the size of deflate strips, which are compressed on all threads, a strip
+ * each, and then written raw, in order
+ */
+#define TIFF_DEFLATE_STRIP_SIZE (128 * 1024)
+
+typedef struct
+{
+  guchar *data;
+  gsize length;
+  gsize allocated;
+  gboolean failed;
+} TiffStrip;
+
+typedef struct
+{
+  guchar *buffer;
+  gsize bytes_per_row;
+  gint rows_per_strip;
+  gint n_rows;
+  gint samples_per_pixel;
+  gint bytes_per_sample;
+  gboolean predictor;
+  gint n_strips;
+  TiffStrip *strips;
+} TiffEncoder;
 
 typedef struct
 {
@@ -342,59 +380,194 @@ get_file_size(thandle_t handle)
   return (toff_t) size;
 }
 
+/* horizontal differencing, as done by libtiff for PREDICTOR_HORIZONTAL */
+static void
+predict_row(guchar *row,
+            gint width,
+            gint samples_per_pixel,
+            gint bytes_per_sample)
+{
+  gint n_samples = width * samples_per_pixel;
+  gint i;
+
+  switch (bytes_per_sample)
+    {
+    case 1:
+      for (i = n_samples - 1; i >= samples_per_pixel; i--)
+        row[i] -= row[i - samples_per_pixel];
+      break;
+
+    case 2:
+      {
+        guint16 *samples = (guint16 *) row;
+
+        for (i = n_samples - 1; i >= samples_per_pixel; i--)
+          samples[i] -= samples[i - samples_per_pixel];
+      }
+      break;
+
+    case 4:
+      {
+        guint32 *samples = (guint32 *) row;
+
+        for (i = n_samples - 1; i >= samples_per_pixel; i--)
+          samples[i] -= samples[i - samples_per_pixel];
+      }
+      break;
+    }
+}
+
+static void
+encode_strips(gint i,
+              gint n,
+              gpointer data)
+{
+  TiffEncoder *encoder = data;
+  gint first = encoder->n_strips * i / n;
+  gint last = encoder->n_strips * (i + 1) / n;
+  gint index;
+
+  for (index = first; index < last; index++)
+    {
+      TiffStrip *strip = &encoder->strips[index];
+      gint first_row = index * encoder->rows_per_strip;
+      gint n_rows = MIN(encoder->rows_per_strip, encoder->n_rows - first_row);
+      guchar *rows = encoder->buffer + encoder->bytes_per_row * first_row;
+      gsize size = encoder->bytes_per_row * n_rows;
+      uLongf length;
+      gint row;
+
+      strip->length = 0;
+      strip->failed = FALSE;
+
+      if (n_rows <= 0)
+        continue;
+
+      if (encoder->predictor)
+        {
+          gint width = encoder->bytes_per_row /
+                       (encoder->samples_per_pixel * encoder->bytes_per_sample);
+
+          for (row = 0; row < n_rows; row++)
+            predict_row(rows + encoder->bytes_per_row * row, width,
+                        encoder->samples_per_pixel, encoder->bytes_per_sample);
+        }
+
+      length = compressBound(size);
+
+      if (length > strip->allocated)
+        {
+          strip->data = g_realloc(strip->data, length);
+          strip->allocated = length;
+        }
+
+      /* libtiff's deflate codec writes whole zlib streams as well */
+      if (compress2(strip->data, &length, rows, size,
+                    Z_DEFAULT_COMPRESSION) != Z_OK)
+        strip->failed = TRUE;
+      else
+        strip->length = length;
+    }
+}
+
 static gint
 save_contiguous(GeglOperation *operation,
                 GeglBuffer    *input,
                 const GeglRectangle *result,
-                const Babl *format)
+                const Babl *format,
+                gint rows_per_strip,
+                gushort compression,
+                gushort predictor)
 {
   GeglProperties *o = GEGL_PROPERTIES(operation);
   Priv *p = (Priv*) o->user_data;
+  TiffEncoder encoder = { 0, };
   gint bytes_per_pixel, bytes_per_row;
-  gint tile_width = result->width;
-  gint tile_height = result->height;
-  guchar *buffer;
-  gint x, y;
+  gint threads;
+  gint status = 0;
+  gint y, i;
 
   g_return_val_if_fail(p->tiff != NULL, -1);
 
   bytes_per_pixel = babl_format_get_bytes_per_pixel(format);
-  bytes_per_row = bytes_per_pixel * tile_width;
+  bytes_per_row = bytes_per_pixel * result->width;
+
+  g_object_get(gegl_config(), "threads", &threads, NULL);
+
+  encoder.bytes_per_row = bytes_per_row;
+  encoder.rows_per_strip = rows_per_strip;
+  encoder.samples_per_pixel = babl_format_get_n_components(format);
+  encoder.bytes_per_sample = bytes_per_pixel / encoder.samples_per_pixel;
+  encoder.predictor = predictor == 2;
+  encoder.n_strips = 1;
 
-  buffer = g_try_new(guchar, bytes_per_row * tile_height);
+  /* other codecs are left to libtiff, a strip at a time */
+  if (compression == COMPRESSION_ADOBE_DEFLATE && threads > 1)
+    encoder.n_strips = threads;
 
-  g_assert(buffer != NULL);
+  encoder.strips = g_new0(TiffStrip, encoder.n_strips);
+  encoder.buffer = g_try_malloc((gsize) bytes_per_row * rows_per_strip *
+                                encoder.n_strips);
 
-  for (y = result->y; y < result->y + tile_height; y += tile_height)
+  g_assert(encoder.buffer != NULL);
+
+  for (y = 0; y < result->height && status == 0; y += encoder.n_rows)
     {
-      for (x = result->x; x < result->x + tile_width; x += tile_width)
-        {
-          GeglRectangle tile = { x, y, tile_width, tile_height };
-          gint row;
+      GeglRectangle rect;
+      tstrip_t strip = y / rows_per_strip;
 
-          gegl_buffer_get(input, &tile, 1.0, format, buffer,
-                          GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+      encoder.n_rows = MIN(rows_per_strip * encoder.n_strips,
+                           result->height - y);
 
-          for (row = 0; row < tile_height; row++)
+      rect.x = result->x;
+      rect.y = result->y + y;
+      rect.width = result->width;
+      rect.height = encoder.n_rows;
+
+      gegl_buffer_get(input, &rect, 1.0, format, encoder.buffer,
+                      GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+
+      if (encoder.n_strips == 1)
+        {
+          if (TIFFWriteEncodedStrip(p->tiff, strip, encoder.buffer,
+                                    (tmsize_t) bytes_per_row *
+                                    encoder.n_rows) < 0)
             {
-              guchar *tile_row = buffer + (bytes_per_row * row);
-              gint written;
+              g_critical("failed a strip write on row %d", y);
+              status = -1;
+            }
+
+          continue;
+        }
+
+      gegl_parallel_distribute(encoder.n_strips, encode_strips, &encoder);
 
-              written = TIFFWriteScanline(p->tiff, tile_row, row, 0);
+      for (i = 0; i < encoder.n_strips && status == 0; i++)
+        {
+          TiffStrip *tiff_strip = &encoder.strips[i];
+
+          if (i * rows_per_strip >= encoder.n_rows)
+            break;
 
-              if (!written)
-                {
-                  g_critical("failed a scanline write on row %d", row);
-                  continue;
-                }
+          if (tiff_strip->failed ||
+              TIFFWriteRawStrip(p->tiff, strip + i, tiff_strip->data,
+                                (tmsize_t) tiff_strip->length) < 0)
+            {
+              g_critical("failed a strip write on row %d",
+                         y + i * rows_per_strip);
+              status = -1;
             }
         }
     }
 
   TIFFFlushData(p->tiff);
 
-  g_free(buffer);
-  return 0;
+  for (i = 0; i < encoder.n_strips; i++)
+    g_free(encoder.strips[i].data);
+
+  g_free(encoder.strips);
+  g_free(encoder.buffer);
+  return status;
 }
 
 static void
@@ -427,13 +600,29 @@ export_tiff (GeglOperation *operation,
   gushort sample_format, predictor = 0;
   gushort extra_types[1];
   glong rows_per_stripe = 1;
-  gint bytes_per_row;
+  gint bytes_per_row, strip_size;
   const Babl *type, *model;
   gchar format_string[32];
   const Babl *format;
 
   g_return_val_if_fail(p->tiff != NULL, -1);
 
+  switch (o->compression)
+    {
+    case GEGL_TIFF_SAVE_COMPRESSION_LZW:
+      compression = COMPRESSION_LZW;
+      break;
+
+    case GEGL_TIFF_SAVE_COMPRESSION_DEFLATE:
+      compression = COMPRESSION_ADOBE_DEFLATE;
+      break;
+
+    case GEGL_TIFF_SAVE_COMPRESSION_NONE:
+    default:
+      compression = COMPRESSION_NONE;
+      break;
+    }
+
   TIFFSetField(p->tiff, TIFFTAG_SUBFILETYPE, 0);
   TIFFSetField(p->tiff, TIFFTAG_ORIENTATION, ORIENTATION_TOPLEFT);
 
@@ -581,14 +770,6 @@ export_tiff (GeglOperation *operation,
       TIFFSetField(p->tiff, TIFFTAG_EXTRASAMPLES, 1, extra_types);
     }
 
-  if (predictor != 0)
-    {
-      if (compression == COMPRESSION_LZW)
-        TIFFSetField(p->tiff, TIFFTAG_PREDICTOR, predictor);
-      else if (compression == COMPRESSION_ADOBE_DEFLATE)
-        TIFFSetField(p->tiff, TIFFTAG_PREDICTOR, predictor);
-    }
-
   if (type == babl_type("u8"))
     {
       sample_format = SAMPLEFORMAT_UINT;
@@ -659,6 +840,15 @@ export_tiff (GeglOperation *operation,
 
   TIFFSetField(p->tiff, TIFFTAG_COMPRESSION, compression);
 
+  /* horizontal differencing only goes up to 32 bit samples */
+  if (bits_per_sample > 32 ||
+      (compression != COMPRESSION_LZW &&
+       compression != COMPRESSION_ADOBE_DEFLATE))
+    predictor = 0;
+
+  if (predictor != 0)
+    TIFFSetField(p->tiff, TIFFTAG_PREDICTOR, predictor);
+
   if ((compression == COMPRESSION_CCITTFAX3 ||
        compression == COMPRESSION_CCITTFAX4) &&
        (bits_per_sample != 1 || samples_per_pixel != 1))
@@ -692,9 +882,16 @@ export_tiff (GeglOperation *operation,
 
   format = babl_format_with_space (format_string, space);
 
-  /* "Choose RowsPerStrip such that each strip is about 8K bytes." */
+  /* "Choose RowsPerStrip such that each strip is about 8K bytes."  Deflate
+   * strips are compressed independently, and larger ones compress better.
+   */
+  if (compression == COMPRESSION_ADOBE_DEFLATE)
+    strip_size = TIFF_DEFLATE_STRIP_SIZE;
+  else
+    strip_size = 8192;
+
   bytes_per_row = babl_format_get_bytes_per_pixel(format) * result->width;
-  while (bytes_per_row * rows_per_stripe <= 8192)
+  while (bytes_per_row * rows_per_stripe <= strip_size)
     rows_per_stripe++;
 
   rows_per_stripe = MIN(rows_per_stripe, result->height);
@@ -752,7 +949,8 @@ export_tiff (GeglOperation *operation,
       gegl_metadata_unregister_map (GEGL_METADATA (o->metadata));
     }
 
-  return save_contiguous(operation, input, result, format);
+  return save_contiguous(operation, input, result, format,
+                         rows_per_stripe, compression, predictor);
 }
 
 static gboolean
@@ -1127,6 +1127,7 @@ transform_affine (GeglOperation       *operation,
                                          level);
 
   GeglSamplerGetFun sampler_get_fun = gegl_sampler_get_fun (sampler);
+  GeglSamplerGetSpanFun sampler_get_span_fun = gegl_sampler_get_span_fun (sampler);
 
   GeglRectangle  bounding_box = *gegl_buffer_get_abyss (src);
   GeglRectangle  context_rect = *gegl_sampler_get_context_rect (sampler);
@@ -1231,17 +1232,36 @@ transform_affine (GeglOperation       *operation,
               u_float += x1 * inverse_jacobian.coeff [0][0];
               v_float += x1 * inverse_jacobian.coeff [1][0];
 
-              for (x = x1; x < x2; x++)
+              /*
+               * the jacobian is constant across an affine scanline, so the
+               * whole run can be handed to the sampler at once.
+               */
+              if (sampler_get_span_fun)
                 {
-                  sampler_get_fun (sampler,
-                                   u_float, v_float,
-                                   &inverse_jacobian,
-                                   dest_ptr,
-                                   abyss_policy);
-                  dest_ptr += (gint) components;
-
-                  u_float += inverse_jacobian.coeff [0][0];
-                  v_float += inverse_jacobian.coeff [1][0];
+                  sampler_get_span_fun (sampler,
+                                        u_float, v_float,
+                                        inverse_jacobian.coeff [0][0],
+                                        inverse_jacobian.coeff [1][0],
+                                        &inverse_jacobian,
+                                        dest_ptr,
+                                        x2 - x1,
+                                        abyss_policy);
+                  dest_ptr += (gint) components * (x2 - x1);
+                }
+              else
+                {
+                  for (x = x1; x < x2; x++)
+                    {
+                      sampler_get_fun (sampler,
+                                       u_float, v_float,
+                                       &inverse_jacobian,
+                                       dest_ptr,
+                                       abyss_policy);
+                      dest_ptr += (gint) components;
+
+                      u_float += inverse_jacobian.coeff [0][0];
+                      v_float += inverse_jacobian.coeff [1][0];
+                    }
                 }
 
               memset (dest_ptr, 0, (gint) components * sizeof (gfloat) * (roi->width - x2));
@@ -1262,6 +1282,405 @@ transform_affine (GeglOperation       *operation,
   g_object_unref (sampler);
 }
 
+/*
+ * Separable resampling, used instead of transform_affine() when the matrix
+ * only scales and translates, and the sampler is linear or cubic.
+ *
+ * Both of these samplers are separable, and so is the box filtering they
+ * do when downscaling (see _gegl_sampler_box_get()), since for a scale
+ * matrix the sample grid is axis aligned.  So each output pixel is the
+ * product of a horizontal and a vertical filter, whose weights only depend
+ * on the output column and row respectively.  The weights are computed
+ * once per column and per row, the source is filtered horizontally row by
+ * row, and the filtered rows are then combined vertically.
+ */
+
+/* the number of source rows, and of output rows, a band may span */
+#define TRANSFORM_SCALE_BAND_ROWS 128
+
+/*
+ * The filter of an output index is the sum of the kernels of the samples
+ * the sampler takes for it, so its weights are kept sparse: each sample
+ * has a first source index and kernel_size weights, rather than one dense
+ * row of weights spanning the whole footprint, which would be mostly zero
+ * for large downscales.
+ */
+typedef struct
+{
+  gint    n_samples;    /* samples per output index */
+  gint    kernel_size;  /* weights per sample */
+  gint   *first;        /* first source index of each sample */
+  gfloat *weights;      /* kernel_size weights for each sample */
+  gint   *start;        /* first source index of each output index */
+  gint   *end;          /* one past the last source index of each */
+} TransformScaleFilter;
+
+static inline gfloat
+transform_scale_kernel (GeglSamplerType sampler,
+                        gfloat          x)
+{
+  const gfloat ax = fabsf (x);
+
+  if (sampler == GEGL_SAMPLER_LINEAR)
+    return ax < 1.0f ? 1.0f - ax : 0.0f;
+
+  /*
+   * The BC-spline of the cubic sampler, with its default b = 1/2 and
+   * c = (1 - b) / 2.
+   */
+  {
+    const gfloat b  = 0.5f;
+    const gfloat c  = 0.25f;
+    const gfloat x2 = x * x;
+
+    if (x2 <= 1.0f)
+      return ((12 - 9 * b - 6 * c) / 6 * ax +
+              (-18 + 12 * b + 6 * c) / 6) * x2 +
+             (6 - 2 * b) / 6;
+
+    if (x2 < 4.0f)
+      return ((-b - 6 * c) / 6 * ax +
+              (6 * b + 30 * c) / 6) * x2 +
+             (-12 * b - 48 * c) / 6 * ax +
+             (8 * b + 24 * c) / 6;
+
+    return 0.0f;
+  }
+}
+
+/*
+ * Compute the weights for @n_out output indices starting at @first_out,
+ * where output index i is centered on source coordinate
+ * scale * (i + 0.5) + offset.
+ */
+static void
+transform_scale_filter_init (TransformScaleFilter *filter,
+                             GeglSamplerType       sampler,
+                             gdouble               scale,
+                             gdouble               offset,
+                             gint                  first_out,
+                             gint                  n_out)
+{
+  const gint    max_n_samples = sampler == GEGL_SAMPLER_LINEAR ? 4 : 5;
+  const gint    kernel_first  = sampler == GEGL_SAMPLER_LINEAR ? 0 : -1;
+  const gint    kernel_size   = sampler == GEGL_SAMPLER_LINEAR ? 2 : 4;
+  const gint    n_samples     = CLAMP ((gint) floor (fabs (scale)),
+                                       1, max_n_samples);
+  const gdouble step          = scale / n_samples;
+  gint          i;
+
+  filter->n_samples   = n_samples;
+  filter->kernel_size = kernel_size;
+  filter->first       = g_new (gint, n_out * n_samples);
+  filter->weights     = g_new (gfloat, n_out * n_samples * kernel_size);
+  filter->start       = g_new (gint, n_out);
+  filter->end         = g_new (gint, n_out);
+
+  for (i = 0; i < n_out; i++)
+    {
+      gint    *first   = filter->first + i * n_samples;
+      gfloat  *weights = filter->weights + i * n_samples * kernel_size;
+      gdouble  center  = scale * (first_out + i + 0.5) + offset;
+      gdouble  x0      = center - (scale - step) / 2.0;
+      gint     s;
+      gint     k;
+
+      filter->start[i] = G_MAXINT;
+      filter->end[i]   = G_MININT;
+
+      /* sample positions are rounded like the samplers round them */
+      for (s = 0; s < n_samples; s++)
+        {
+          const gfloat x  = (gfloat) (x0 + s * step) - 0.5f;
+          const gint   ix = (gint) floorf (x);
+          const gfloat fx = x - ix;
+
+          first[s] = ix + kernel_first;
+
+          for (k = 0; k < kernel_size; k++)
+            {
+              weights[s * kernel_size + k] =
+                transform_scale_kernel (sampler, fx - (k + kernel_first)) /
+                n_samples;
+            }
+
+          filter->start[i] = MIN (filter->start[i], first[s]);
+          filter->end[i]   = MAX (filter->end[i], first[s] + kernel_size);
+        }
+    }
+}
+
+static void
+transform_scale_filter_clear (TransformScaleFilter *filter)
+{
+  g_free (filter->first);
+  g_free (filter->weights);
+  g_free (filter->start);
+  g_free (filter->end);
+}
+
+/*
+ * Resample output rows y0 to y1 - 1 of @roi into @out, whose rows are
+ * roi->width pixels wide, and whose first row is output row y0.
+ */
+static void
+transform_scale_band (GeglBuffer                 *src,
+                      const Babl                 *format,
+                      GeglAbyssPolicy             abyss_policy,
+                      const TransformScaleFilter *hfilter,
+                      const TransformScaleFilter *vfilter,
+                      const GeglRectangle        *roi,
+                      gint                        y0,
+                      gint                        y1,
+                      gfloat                     *out)
+{
+  gint           components = babl_format_get_n_components (format);
+  gint           row_stride = roi->width * components;
+  gint           n_taps     = hfilter->n_samples * hfilter->kernel_size;
+  GeglRectangle  src_rect;
+  gboolean      *row_needed;
+  gfloat        *in;
+  gfloat        *rows;
+  gint           x;
+  gint           y;
+
+  src_rect.x      = G_MAXINT;
+  src_rect.y      = G_MAXINT;
+  src_rect.width  = G_MININT;
+  src_rect.height = G_MININT;
+
+  for (x = 0; x < roi->width; x++)
+    {
+      src_rect.x     = MIN (src_rect.x, hfilter->start[x]);
+      src_rect.width = MAX (src_rect.width, hfilter->end[x]);
+    }
+  for (y = y0; y < y1; y++)
+    {
+      src_rect.y      = MIN (src_rect.y, vfilter->start[y]);
+      src_rect.height = MAX (src_rect.height, vfilter->end[y]);
+    }
+
+  src_rect.width  -= src_rect.x;
+  src_rect.height -= src_rect.y;
+
+  /*
+   * When downscaling by more than the samplers' box filter takes samples,
+   * some source rows get no weight at all; skip those.
+   */
+  row_needed = g_new0 (gboolean, src_rect.height);
+
+  for (y = y0; y < y1; y++)
+    {
+      const gint   *first   = vfilter->first + y * vfilter->n_samples;
+      const gfloat *weights = vfilter->weights +
+                              y * vfilter->n_samples * vfilter->kernel_size;
+      gint          s;
+      gint          k;
+
+      for (s = 0; s < vfilter->n_samples; s++)
+        {
+          for (k = 0; k < vfilter->kernel_size; k++)
+            {
+              if (weights[s * vfilter->kernel_size + k] != 0.0f)
+                row_needed[first[s] + k - src_rect.y] = TRUE;
+            }
+        }
+    }
+
+  in   = g_new (gfloat, src_rect.width * components);
+  rows = g_new0 (gfloat, src_rect.height * row_stride);
+
+  /* horizontal pass, one filtered row per needed source row */
+  for (y = 0; y < src_rect.height; y++)
+    {
+      GeglRectangle  row_rect = {src_rect.x, src_rect.y + y, src_rect.width, 1};
+      gfloat        *dst      = rows + y * row_stride;
+
+      if (! row_needed[y])
+        continue;
+
+      gegl_buffer_get (src, &row_rect, 1.0, format, in,
+                       GEGL_AUTO_ROWSTRIDE, abyss_policy);
+
+      for (x = 0; x < roi->width; x++)
+        {
+          const gint   *first   = hfilter->first + x * hfilter->n_samples;
+          const gfloat *weights = hfilter->weights + x * n_taps;
+          gint          s;
+          gint          k;
+          gint          c;
+
+          for (s = 0; s < hfilter->n_samples; s++)
+            {
+              const gfloat *src_ptr = in + (first[s] - src_rect.x) *
+                                           components;
+
+              for (k = 0; k < hfilter->kernel_size; k++)
+                {
+                  const gfloat weight = *weights++;
+
+                  for (c = 0; c < components; c++)
+                    dst[c] += weight * src_ptr[c];
+
+                  src_ptr += components;
+                }
+            }
+
+          dst += components;
+        }
+    }
+
+  /* vertical pass, a weighted sum of whole filtered rows */
+  for (y = y0; y < y1; y++)
+    {
+      const gint   *first   = vfilter->first + y * vfilter->n_samples;
+      const gfloat *weights = vfilter->weights +
+                              y * vfilter->n_samples * vfilter->kernel_size;
+      gfloat       *dst     = out + (y - y0) * row_stride;
+      gint          s;
+      gint          k;
+      gint          i;
+
+      for (s = 0; s < vfilter->n_samples; s++)
+        {
+          const gfloat *src_ptr = rows + (first[s] - src_rect.y) * row_stride;
+
+          for (k = 0; k < vfilter->kernel_size; k++)
+            {
+              const gfloat weight = *weights++;
+
+              if (weight != 0.0f)
+                {
+                  for (i = 0; i < row_stride; i++)
+                    dst[i] += weight * src_ptr[i];
+                }
+
+              src_ptr += row_stride;
+            }
+        }
+    }
+
+  g_free (rows);
+  g_free (in);
+  g_free (row_needed);
+}
+
+static void
+transform_scale (GeglOperation       *operation,
+                 GeglBuffer          *dest,
+                 GeglBuffer          *src,
+                 GeglMatrix3         *matrix,
+                 const GeglRectangle *roi,
+                 gint                 level)
+{
+  OpTransform          *transform      = (OpTransform *) operation;
+  const Babl           *format         = gegl_operation_get_format (operation, "output");
+  gint                  components     = babl_format_get_n_components (format);
+  GeglAbyssPolicy       abyss_policy   = gegl_transform_get_abyss_policy (transform);
+  gdouble               inverse_near_z = 1.0 / transform->near_z;
+  GeglSampler          *sampler;
+  GeglMatrix3           inverse;
+  GeglRectangle         bounding_box   = *gegl_buffer_get_abyss (src);
+  GeglRectangle         context_rect;
+  TransformScaleFilter  hfilter;
+  TransformScaleFilter  vfilter;
+  gfloat               *out;
+  gint                  y0;
+  gint                  y1;
+  gint                  y;
+
+  sampler = gegl_buffer_sampler_new_at_level (src, format,
+                                              transform->sampler, 0);
+  context_rect = *gegl_sampler_get_context_rect (sampler);
+  g_object_unref (sampler);
+
+  bounding_box.x      += context_rect.x;
+  bounding_box.y      += context_rect.y;
+  bounding_box.width  += context_rect.width  - 1;
+  bounding_box.height += context_rect.height - 1;
+
+  gegl_matrix3_copy_into (&inverse, matrix);
+  gegl_matrix3_invert (&inverse);
+
+  transform_scale_filter_init (&hfilter, transform->sampler,
+                               inverse.coeff [0][0], inverse.coeff [0][2],
+                               roi->x, roi->width);
+  transform_scale_filter_init (&vfilter, transform->sampler,
+                               inverse.coeff [1][1], inverse.coeff [1][2],
+                               roi->y, roi->height);
+
+  /* one band of output rows at a time, written out as soon as it is done */
+  out = g_new (gfloat, roi->width *
+                       MIN (roi->height, TRANSFORM_SCALE_BAND_ROWS) *
+                       components);
+
+  /*
+   * Process the output in bands of rows, so that the horizontally filtered
+   * source rows of a band, and the band itself, stay small.
+   */
+  for (y0 = 0; y0 < roi->height; y0 = y1)
+    {
+      GeglRectangle band;
+      gint          first = vfilter.start[y0];
+      gint          last  = vfilter.end[y0];
+
+      for (y1 = y0 + 1;
+           y1 < roi->height && y1 - y0 < TRANSFORM_SCALE_BAND_ROWS;
+           y1++)
+        {
+          first = MIN (first, vfilter.start[y1]);
+          last  = MAX (last, vfilter.end[y1]);
+
+          if (last - first > TRANSFORM_SCALE_BAND_ROWS)
+            break;
+        }
+
+      memset (out, 0, roi->width * (y1 - y0) * components * sizeof (gfloat));
+
+      transform_scale_band (src, format, abyss_policy, &hfilter, &vfilter,
+                            roi, y0, y1, out);
+
+      /* leave pixels transparent where transform_affine() would */
+      for (y = y0; y < y1; y++)
+        {
+          gfloat  *row = out + (y - y0) * roi->width * components;
+          gdouble  u_start;
+          gdouble  v_start;
+          gint     x1 = 0;
+          gint     x2 = roi->width;
+
+          u_start = inverse.coeff [0][0] * (roi->x + (gdouble) 0.5) +
+                    inverse.coeff [0][2];
+          v_start = inverse.coeff [1][1] * (roi->y + y + (gdouble) 0.5) +
+                    inverse.coeff [1][2];
+
+          if (! gegl_transform_scanline_limits (&inverse, inverse_near_z,
+                                                &bounding_box,
+                                                u_start, v_start, 1.0,
+                                                &x1, &x2))
+            {
+              x1 = x2 = 0;
+            }
+
+          memset (row, 0, x1 * components * sizeof (gfloat));
+          memset (row + x2 * components, 0,
+                  (roi->width - x2) * components * sizeof (gfloat));
+        }
+
+      band.x      = roi->x;
+      band.y      = roi->y + y0;
+      band.width  = roi->width;
+      band.height = y1 - y0;
+
+      gegl_buffer_set (dest, &band, 0, format, out, GEGL_AUTO_ROWSTRIDE);
+    }
+
+  g_free (out);
+
+  transform_scale_filter_clear (&vfilter);
+  transform_scale_filter_clear (&hfilter);
+}
+
 static void
 transform_generic (GeglOperation       *operation,
                    GeglBuffer          *dest,
@@ -1662,6 +2081,13 @@ gegl_transform_process (GeglOperation        *operation,
 
       if (transform->sampler == GEGL_SAMPLER_NEAREST)
         func = transform_nearest;
+      else if (level == 0 && ! is_cmyk &&
+               (transform->sampler == GEGL_SAMPLER_LINEAR ||
+                transform->sampler == GEGL_SAMPLER_CUBIC) &&
+               gegl_matrix3_is_scale (&matrix) &&
+               fabs (matrix.coeff [0][0]) > GEGL_TRANSFORM_CORE_EPSILON &&
+               fabs (matrix.coeff [1][1]) > GEGL_TRANSFORM_CORE_EPSILON)
+        func = transform_scale;
 
       input  = (GeglBuffer*) gegl_operation_context_dup_object (context, "input");
       output = gegl_operation_context_get_target (context, "output");
@@ -0,0 +1,130 @@
+#include "test-common.h"
+#include "graph/gegl-region.h"
+
+/* a fragmented region, like the valid region of a cache during a long
+ * brush stroke: dabs along a random walk over a large canvas.
+ */
+#define CANVAS  8192
+#define DAB     64
+#define DABS    10000
+#define QUERIES 100000
+
+static void
+stroke (GeglRegion *region,
+        gint        n_dabs)
+{
+  gint x = CANVAS / 2;
+  gint y = CANVAS / 2;
+  gint i;
+
+  for (i = 0; i < n_dabs; i++)
+    {
+      GeglRectangle dab;
+
+      x = CLAMP (x + g_random_int_range (-DAB, DAB + 1), 0, CANVAS - DAB);
+      y = CLAMP (y + g_random_int_range (-DAB, DAB + 1), 0, CANVAS - DAB);
+
+      dab.x      = x;
+      dab.y      = y;
+      dab.width  = DAB;
+      dab.height = DAB;
+
+      gegl_region_union_with_rect (region, &dab);
+    }
+}
+
+gint
+main (gint    argc,
+      gchar **argv)
+{
+  GeglRegion    *fragmented;
+  GeglRectangle *queries;
+  gint           i;
+
+  gegl_init (&argc, &argv);
+
+  g_random_set_seed (1234);
+
+  fragmented = gegl_region_new ();
+  stroke (fragmented, DABS);
+
+  queries = g_new (GeglRectangle, QUERIES);
+
+  for (i = 0; i < QUERIES; i++)
+    {
+      queries[i].x      = g_random_int_range (0, CANVAS);
+      queries[i].y      = g_random_int_range (0, CANVAS);
+      queries[i].width  = DAB / 2;
+      queries[i].height = DAB / 2;
+    }
+
+  test_start ();
+  for (i = 0; i < ITERATIONS && converged < BAIL_COUNT; i++)
+    {
+      GeglRegion *region = gegl_region_new ();
+
+      g_random_set_seed (1234);
+
+      test_start_iter ();
+      stroke (region, DABS);
+      test_end_iter ();
+
+      gegl_region_destroy (region);
+    }
+  test_end ("region union_with_rect",
+            1.0 * DABS * ITERATIONS * sizeof (GeglRectangle));
+
+  test_start ();
+  for (i = 0; i < ITERATIONS && converged < BAIL_COUNT; i++)
+    {
+      GeglRegion *region = gegl_region_copy (fragmented);
+      gint        j;
+
+      test_start_iter ();
+      for (j = 0; j < DABS; j++)
+        {
+          GeglRegion *dab = gegl_region_rectangle (&queries[j]);
+
+          gegl_region_subtract (region, dab);
+          gegl_region_destroy (dab);
+        }
+      test_end_iter ();
+
+      gegl_region_destroy (region);
+    }
+  test_end ("region subtract",
+            1.0 * DABS * ITERATIONS * sizeof (GeglRectangle));
+
+  test_start ();
+  for (i = 0; i < ITERATIONS && converged < BAIL_COUNT; i++)
+    {
+      gint j;
+
+      test_start_iter ();
+      for (j = 0; j < QUERIES; j++)
+        gegl_region_rect_in (fragmented, &queries[j]);
+      test_end_iter ();
+    }
+  test_end ("region rect_in",
+            1.0 * QUERIES * ITERATIONS * sizeof (GeglRectangle));
+
+  test_start ();
+  for (i = 0; i < ITERATIONS && converged < BAIL_COUNT; i++)
+    {
+      gint j;
+
+      test_start_iter ();
+      for (j = 0; j < QUERIES; j++)
+        gegl_region_point_in (fragmented, queries[j].x, queries[j].y);
+      test_end_iter ();
+    }
+  test_end ("region point_in",
+            1.0 * QUERIES * ITERATIONS * sizeof (GeglRectangle));
+
+  g_free (queries);
+  gegl_region_destroy (fragmented);
+
+  gegl_exit ();
+
+  return 0;
+}
@@ -2,6 +2,8 @@
 
 void scale(GeglBuffer *buffer);
 void scale_nearest(GeglBuffer *buffer);
+void scale_thumbnail(GeglBuffer *buffer);
+void scale_thumbnail_cubic(GeglBuffer *buffer);
 
 gint
 main (gint    argc,
@@ -14,6 +16,8 @@ main (gint    argc,
   buffer = test_buffer (2048, 1024, babl_format ("RGBA float"));
   bench ("scale", buffer, &scale);
   bench ("scale-nearest", buffer, &scale_nearest);
+  bench ("scale-thumbnail", buffer, &scale_thumbnail);
+  bench ("scale-thumbnail-cubic", buffer, &scale_thumbnail_cubic);
   g_object_unref (buffer);
 
   gegl_exit ();
@@ -59,3 +63,39 @@ void scale_nearest(GeglBuffer *buffer)
   g_object_unref (gegl);
   g_object_unref (buffer2);
 }
+
+/* a large downscale, which takes the separable path with a wide footprint
+ * per output pixel
+ */
+static void
+thumbnail (GeglBuffer      *buffer,
+           GeglSamplerType  sampler)
+{
+  GeglBuffer *buffer2;
+  GeglNode   *gegl, *source, *scale, *sink;
+
+  gegl = gegl_node_new ();
+  source = gegl_node_new_child (gegl, "operation", "gegl:buffer-source", "buffer", buffer, NULL);
+  scale = gegl_node_new_child (gegl,
+                               "operation", "gegl:scale-ratio",
+                               "x", 0.03,
+                               "y", 0.03,
+                               "sampler", sampler,
+                               NULL);
+  sink = gegl_node_new_child (gegl, "operation", "gegl:buffer-sink", "buffer", &buffer2, NULL);
+
+  gegl_node_link_many (source, scale, sink, NULL);
+  gegl_node_process (sink);
+  g_object_unref (gegl);
+  g_object_unref (buffer2);
+}
+
+void scale_thumbnail(GeglBuffer *buffer)
+{
+  thumbnail (buffer, GEGL_SAMPLER_LINEAR);
+}
+
+void scale_thumbnail_cubic(GeglBuffer *buffer)
+{
+  thumbnail (buffer, GEGL_SAMPLER_CUBIC);
+}
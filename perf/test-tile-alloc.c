@@ -0,0 +1,172 @@
+#include <string.h>
+
+#include "test-common.h"
+#include "buffer/gegl-tile-alloc.h"
+
+#ifdef __linux__
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+/* tiles of the default size, in "RGBA float" */
+#define TILE_SIZE (128 * 64 * 16)
+#define N_TILES   64
+#define N_ROUNDS  16
+#define N_PLACES  32
+
+#define MPOL_F_NODE (1 << 0)
+#define MPOL_F_ADDR (1 << 1)
+
+static gint n_local;
+static gint n_remote;
+
+/* returns the node the page at @ptr resides on, or -1 if unknown */
+static gint
+page_node (gpointer ptr)
+{
+#if defined (__linux__) && defined (SYS_get_mempolicy)
+  int node;
+
+  if (syscall (SYS_get_mempolicy, &node, NULL, 0, ptr,
+               MPOL_F_NODE | MPOL_F_ADDR) == 0)
+    {
+      return node;
+    }
+#endif
+
+  return -1;
+}
+
+static void
+alloc_tiles (gint     i,
+             gint     n,
+             gpointer user_data)
+{
+  gpointer tiles[N_TILES];
+  gint     round;
+  gint     t;
+
+  for (round = 0; round < N_ROUNDS; round++)
+    {
+      for (t = 0; t < N_TILES; t++)
+        {
+          tiles[t] = gegl_tile_alloc (TILE_SIZE);
+
+          *(gint *) tiles[t] = t;
+        }
+
+      for (t = 0; t < N_TILES; t++)
+        gegl_tile_free (tiles[t]);
+    }
+}
+
+/* fill a set of tiles, the way a worker thread renders into them, and
+ * check where their pages ended up.  since fresh pages are placed by the
+ * thread that first touches them, remote pages only come from tiles reused
+ * across threads, so this is done repeatedly.
+ */
+static void
+place_tiles (gint     i,
+             gint     n,
+             gpointer user_data)
+{
+  gpointer tiles[N_TILES];
+  gint     node = gegl_tile_alloc_get_current_node ();
+  gint     local  = 0;
+  gint     remote = 0;
+  gint     t;
+
+  for (t = 0; t < N_TILES; t++)
+    {
+      tiles[t] = gegl_tile_alloc (TILE_SIZE);
+
+      memset (tiles[t], i, TILE_SIZE);
+    }
+
+  for (t = 0; t < N_TILES; t++)
+    {
+      gint tile_node = page_node ((guint8 *) tiles[t] + TILE_SIZE / 2);
+
+      if (tile_node == node)
+        local++;
+      else if (tile_node >= 0)
+        remote++;
+
+      gegl_tile_free (tiles[t]);
+    }
+
+  g_atomic_int_add (&n_local,  local);
+  g_atomic_int_add (&n_remote, remote);
+}
+
+static void
+bench (gboolean numa)
+{
+  const gchar *suffix = numa ? " (numa)" : "";
+  gint         n_threads;
+  gint         i;
+
+  g_object_set (gegl_config (),
+                "tile-alloc-numa", numa,
+                NULL);
+
+  g_object_get (gegl_config (),
+                "threads", &n_threads,
+                NULL);
+
+  test_start ();
+  for (i = 0; i < ITERATIONS && converged < BAIL_COUNT; i++)
+    {
+      test_start_iter ();
+      gegl_parallel_distribute (-1, alloc_tiles, NULL);
+      test_end_iter ();
+    }
+  test_end_suffix ("tile-alloc", suffix,
+                   1.0 * n_threads * N_ROUNDS * N_TILES * TILE_SIZE *
+                   ITERATIONS);
+
+  n_local  = 0;
+  n_remote = 0;
+
+  for (i = 0; i < N_PLACES; i++)
+    gegl_parallel_distribute (-1, place_tiles, NULL);
+
+  if (n_local + n_remote)
+    {
+      g_print ("@ tile-alloc remote ratio%s: %.2f%%\n",
+               suffix, 100.0 * n_remote / (n_local + n_remote));
+    }
+}
+
+gint
+main (gint    argc,
+      gchar **argv)
+{
+  gint node;
+
+  gegl_init (&argc, &argv);
+
+  bench (FALSE);
+  bench (TRUE);
+
+  for (node = 0; node < gegl_tile_alloc_get_n_nodes (); node++)
+    {
+      GeglTileAllocNodeStats stats;
+
+      gegl_tile_alloc_get_node_stats (node, &stats);
+
+      g_print ("node %d: %" G_GUINT64_FORMAT " allocs "
+               "(%.2f%% from magazines), "
+               "%" G_GUINT64_FORMAT " frees "
+               "(%.2f%% remote)\n",
+               node,
+               stats.n_allocs,
+               100.0 * stats.n_magazine_allocs / MAX (stats.n_allocs, 1),
+               stats.n_frees,
+               100.0 * stats.n_remote_frees / MAX (stats.n_frees, 1));
+    }
+
+  gegl_exit ();
+
+  return 0;
+}
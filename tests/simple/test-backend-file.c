@@ -409,6 +409,105 @@ test_buffer_change_extent (void)
   return result;
 }
 
+static gboolean
+test_buffer_modify_mapped (void)
+{
+  gboolean         result = TRUE;
+  gchar           *tmpdir = NULL;
+  gchar           *buf_a_path = NULL;
+  GeglBuffer      *buf_a = NULL;
+  GeglBuffer      *buf_b = NULL;
+  const Babl      *format = babl_format ("Y u8");
+  GeglRectangle    roi = {0, 0, 256, 256};
+  guchar          *data;
+  gint             i;
+
+  tmpdir = g_dir_make_tmp ("test-backend-file-XXXXXX", NULL);
+  g_return_val_if_fail (tmpdir, FALSE);
+
+  buf_a_path = g_build_filename (tmpdir, "buf_a.gegl", NULL);
+
+  data = g_malloc (roi.width * roi.height);
+
+  buf_a = g_object_new (GEGL_TYPE_BUFFER,
+                        "format", format,
+                        "path", buf_a_path,
+                        "x", roi.x,
+                        "y", roi.y,
+                        "width", roi.width,
+                        "height", roi.height,
+                        NULL);
+
+  memset (data, 1, roi.width * roi.height);
+  gegl_buffer_set (buf_a, &roi, 0, format, data, GEGL_AUTO_ROWSTRIDE);
+
+  gegl_buffer_flush (buf_a);
+  g_object_unref (buf_a);
+
+  /* reopen the file, so that its tiles are mapped, and share them with
+   * another buffer
+   */
+  buf_a = g_object_new (GEGL_TYPE_BUFFER,
+                        "format", format,
+                        "path", buf_a_path,
+                        NULL);
+  buf_b = gegl_buffer_dup (buf_a);
+
+  /* modifying and storing the mapped tiles must not affect the shared
+   * tiles
+   */
+  memset (data, 2, roi.width * roi.height);
+  gegl_buffer_set (buf_a, &roi, 0, format, data, GEGL_AUTO_ROWSTRIDE);
+
+  gegl_buffer_flush (buf_a);
+  g_object_unref (buf_a);
+
+  gegl_buffer_get (buf_b, &roi, 1.0, format, data,
+                   GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+
+  for (i = 0; i < roi.width * roi.height; i++)
+    {
+      if (data[i] != 1)
+        {
+          printf ("Shared tile data was modified\n");
+          result = FALSE;
+          break;
+        }
+    }
+
+  g_object_unref (buf_b);
+
+  buf_a = g_object_new (GEGL_TYPE_BUFFER,
+                        "format", format,
+                        "path", buf_a_path,
+                        NULL);
+
+  gegl_buffer_get (buf_a, &roi, 1.0, format, data,
+                   GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+
+  for (i = 0; i < roi.width * roi.height; i++)
+    {
+      if (data[i] != 2)
+        {
+          printf ("Modified tile data was not stored\n");
+          result = FALSE;
+          break;
+        }
+    }
+
+  g_object_unref (buf_a);
+
+  g_free (data);
+
+  g_unlink (buf_a_path);
+  g_remove (tmpdir);
+
+  g_free (tmpdir);
+  g_free (buf_a_path);
+
+  return result;
+}
+
 #define RUN_TEST(test_name) \
 { \
   if (test_name()) \
@@ -442,6 +541,7 @@ int main(int argc, char **argv)
   RUN_TEST (test_buffer_same_path)
   RUN_TEST (test_buffer_open)
   RUN_TEST (test_buffer_change_extent)
+  RUN_TEST (test_buffer_modify_mapped)
 
   gegl_exit();
 
@@ -0,0 +1,240 @@
+/* This file is a test-case for GEGL
+ *
+ * GEGL is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * GEGL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GEGL; if not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+#include "gegl.h"
+
+#define SUCCESS    0
+#define FAILURE    -1
+
+#define WIDTH      320
+#define HEIGHT     200
+#define LEVELS     3
+
+static gfloat *
+read_level (GeglBuffer *buffer,
+            gint        level)
+{
+  gfloat *data;
+
+  data = g_new (gfloat, (WIDTH >> level) * (HEIGHT >> level) * 4);
+
+  gegl_buffer_get (buffer,
+                   GEGL_RECTANGLE (0, 0, WIDTH >> level, HEIGHT >> level),
+                   1.0 / (1 << level), babl_format ("RGBA float"), data,
+                   GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+
+  return data;
+}
+
+/* reads @level one level-1 tile's worth at a time, which renders the mipmaps
+ * tile by tile, as they're fetched, rather than building them up front.
+ */
+static gfloat *
+read_level_on_demand (GeglBuffer *buffer,
+                      gint        level)
+{
+  gfloat *data;
+  gint    width  = WIDTH  >> level;
+  gint    height = HEIGHT >> level;
+  gint    tile_width;
+  gint    tile_height;
+  gint    x;
+  gint    y;
+
+  g_object_get (buffer,
+                "tile-width",  &tile_width,
+                "tile-height", &tile_height,
+                NULL);
+
+  tile_width  = (tile_width  << 1) >> level;
+  tile_height = (tile_height << 1) >> level;
+
+  data = g_new (gfloat, width * height * 4);
+
+  for (y = 0; y < height; y += tile_height)
+    {
+      for (x = 0; x < width; x += tile_width)
+        {
+          gegl_buffer_get (buffer,
+                           GEGL_RECTANGLE (x, y,
+                                           MIN (tile_width,  width  - x),
+                                           MIN (tile_height, height - y)),
+                           1.0 / (1 << level), babl_format ("RGBA float"),
+                           data + (y * width + x) * 4,
+                           width * 4 * sizeof (gfloat), GEGL_ABYSS_NONE);
+        }
+    }
+
+  return data;
+}
+
+/* check that every pixel of @level is the average of the four pixels of
+ * @below it covers.
+ */
+static gboolean
+check_level (const gfloat *below,
+             const gfloat *level,
+             gint          width,
+             gint          height,
+             gfloat        tolerance)
+{
+  gint x;
+  gint y;
+  gint c;
+
+  for (y = 0; y < height; y++)
+    {
+      for (x = 0; x < width; x++)
+        {
+          for (c = 0; c < 4; c++)
+            {
+              gfloat expected;
+
+              expected = (below[((2 * y)     * 2 * width + 2 * x)     * 4 + c] +
+                          below[((2 * y)     * 2 * width + 2 * x + 1) * 4 + c] +
+                          below[((2 * y + 1) * 2 * width + 2 * x)     * 4 + c] +
+                          below[((2 * y + 1) * 2 * width + 2 * x + 1) * 4 + c]) /
+                         4.0f;
+
+              if (fabs (level[(y * width + x) * 4 + c] - expected) > tolerance)
+                {
+                  printf ("pixel %d, %d is %f, expected %f\n",
+                          x, y, level[(y * width + x) * 4 + c], expected);
+
+                  return FALSE;
+                }
+            }
+        }
+    }
+
+  return TRUE;
+}
+
+static gboolean
+test_format (const gchar  *format_name,
+             gfloat        tolerance,
+             const gfloat *source)
+{
+  const Babl *format = babl_format (format_name);
+  GeglBuffer *buffer;
+  GeglBuffer *reference;
+  gfloat     *levels[LEVELS + 1];
+  gfloat     *unbuilt;
+  gboolean    result = TRUE;
+  gint        level;
+
+  buffer    = gegl_buffer_new (GEGL_RECTANGLE (0, 0, WIDTH, HEIGHT), format);
+  reference = gegl_buffer_new (GEGL_RECTANGLE (0, 0, WIDTH, HEIGHT), format);
+
+  gegl_buffer_set (buffer, NULL, 0, babl_format ("RGBA float"), source,
+                   GEGL_AUTO_ROWSTRIDE);
+  gegl_buffer_set (reference, NULL, 0, babl_format ("RGBA float"), source,
+                   GEGL_AUTO_ROWSTRIDE);
+
+  /* reading the highest level first builds all of the levels below it */
+  for (level = LEVELS; level >= 0; level--)
+    levels[level] = read_level (buffer, level);
+
+  for (level = 1; level <= LEVELS && result; level++)
+    {
+      if (! check_level (levels[level - 1], levels[level],
+                         WIDTH >> level, HEIGHT >> level, tolerance))
+        {
+          printf ("%s: level %d is not the average of level %d\n",
+                  format_name, level, level - 1);
+          result = FALSE;
+        }
+    }
+
+  /* mipmaps rendered on demand have to be the same */
+  unbuilt = read_level_on_demand (reference, LEVELS);
+
+  if (result &&
+      memcmp (unbuilt, levels[LEVELS],
+              (WIDTH >> LEVELS) * (HEIGHT >> LEVELS) * 4 * sizeof (gfloat)))
+    {
+      printf ("%s: built and on-demand mipmaps differ\n", format_name);
+      result = FALSE;
+    }
+
+  g_free (unbuilt);
+
+  for (level = 0; level <= LEVELS; level++)
+    g_free (levels[level]);
+
+  g_object_unref (reference);
+  g_object_unref (buffer);
+
+  return result;
+}
+
+gint
+main (gint    argc,
+      gchar **argv)
+{
+  const struct
+  {
+    const gchar *format;
+    gfloat       tolerance;
+  } formats[] = {
+    {"RGBA float", 1e-6},
+    {"RGB float",  1e-6},
+    {"YA float",   1e-6},
+    {"Y float",    1e-6},
+    {"RGBA half",  1e-3},
+    {"Y half",     1e-3},
+    {"RGBA u16",   1.0 / 65535.0 + 1e-6},
+    {"RGB u16",    1.0 / 65535.0 + 1e-6},
+    {"YA u16",     1.0 / 65535.0 + 1e-6},
+    {"Y u16",      1.0 / 65535.0 + 1e-6},
+    {"RGBA u8",    1.0 / 255.0 + 1e-6},
+    {"RGB u8",     1.0 / 255.0 + 1e-6},
+    {"YA u8",      1.0 / 255.0 + 1e-6},
+    {"Y u8",       1.0 / 255.0 + 1e-6}
+  };
+  GRand  *rand;
+  gfloat *source;
+  gint    result = SUCCESS;
+  gint    i;
+
+  gegl_init (&argc, &argv);
+
+  rand = g_rand_new_with_seed (2345);
+
+  source = g_new (gfloat, WIDTH * HEIGHT * 4);
+
+  for (i = 0; i < WIDTH * HEIGHT * 4; i++)
+    source[i] = g_rand_double (rand);
+
+  for (i = 0; i < G_N_ELEMENTS (formats); i++)
+    {
+      if (! test_format (formats[i].format, formats[i].tolerance, source))
+        result = FAILURE;
+    }
+
+  g_free (source);
+  g_rand_free (rand);
+
+  gegl_exit ();
+
+  return result;
+}
@@ -0,0 +1,214 @@
+/* This file is a test-case for GEGL
+ *
+ * GEGL is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * GEGL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GEGL; if not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include <glib/gstdio.h>
+
+#include "gegl.h"
+
+#define SUCCESS    0
+#define FAILURE    -1
+
+#define WIDTH      1200
+#define HEIGHT     900
+
+/* a buffer whose tiles compress to different degrees: flat areas, a
+ * gradient, and noise that doesn't compress at all.
+ */
+static GeglBuffer *
+create_buffer (void)
+{
+  const Babl *format = babl_format ("R'G'B'A u8");
+  GeglBuffer *buffer;
+  guchar     *pixels;
+  GRand      *rand;
+  gint        x;
+  gint        y;
+
+  buffer = gegl_buffer_new (GEGL_RECTANGLE (0, 0, WIDTH, HEIGHT), format);
+  pixels = g_new (guchar, WIDTH * HEIGHT * 4);
+  rand   = g_rand_new_with_seed (1234);
+
+  for (y = 0; y < HEIGHT; y++)
+    {
+      for (x = 0; x < WIDTH; x++)
+        {
+          guchar *pixel = pixels + (y * WIDTH + x) * 4;
+
+          if (x < WIDTH / 3)
+            {
+              pixel[0] = pixel[1] = pixel[2] = y < HEIGHT / 2 ? 0 : 255;
+            }
+          else if (x < 2 * WIDTH / 3)
+            {
+              pixel[0] = x;
+              pixel[1] = y;
+              pixel[2] = x + y;
+            }
+          else
+            {
+              pixel[0] = g_rand_int (rand);
+              pixel[1] = g_rand_int (rand);
+              pixel[2] = g_rand_int (rand);
+            }
+
+          pixel[3] = 255;
+        }
+    }
+
+  gegl_buffer_set (buffer, NULL, 0, format, pixels, GEGL_AUTO_ROWSTRIDE);
+
+  g_rand_free (rand);
+  g_free (pixels);
+
+  return buffer;
+}
+
+static gboolean
+compare_buffers (const gchar         *what,
+                 GeglBuffer          *expected,
+                 GeglBuffer          *buffer,
+                 const GeglRectangle *rect)
+{
+  const Babl *format = babl_format ("R'G'B'A u8");
+  guchar     *expected_pixels;
+  guchar     *pixels;
+  gboolean    result = TRUE;
+
+  expected_pixels = g_new0 (guchar, rect->width * rect->height * 4);
+  pixels          = g_new0 (guchar, rect->width * rect->height * 4);
+
+  gegl_buffer_get (expected, rect, 1.0, format, expected_pixels,
+                   GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+  gegl_buffer_get (buffer, rect, 1.0, format, pixels,
+                   GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+
+  if (memcmp (expected_pixels, pixels, rect->width * rect->height * 4))
+    {
+      printf ("%s: the pixels of %d, %d, %d x %d differ\n",
+              what, rect->x, rect->y, rect->width, rect->height);
+      result = FALSE;
+    }
+
+  g_free (pixels);
+  g_free (expected_pixels);
+
+  return result;
+}
+
+gint
+main (gint    argc,
+      gchar **argv)
+{
+  GeglBuffer    *buffer;
+  GeglBuffer    *empty;
+  GeglBuffer    *loaded;
+  GeglRectangle  roi    = {300, 200, 500, 300};
+  gchar         *tmpdir;
+  gchar         *path;
+  gint           result = SUCCESS;
+
+  gegl_init (&argc, &argv);
+
+  tmpdir = g_dir_make_tmp ("test-buffer-save-XXXXXX", NULL);
+  path   = g_build_filename (tmpdir, "buffer.gegl", NULL);
+
+  buffer = create_buffer ();
+  empty  = gegl_buffer_new (GEGL_RECTANGLE (0, 0, WIDTH, HEIGHT),
+                            babl_format ("R'G'B'A u8"));
+
+  gegl_buffer_save_chunked (buffer, path, NULL);
+
+  /* the whole buffer */
+  loaded = gegl_buffer_load (path);
+
+  if (! gegl_rectangle_equal (gegl_buffer_get_extent (loaded),
+                              gegl_buffer_get_extent (buffer)))
+    {
+      printf ("the extent of the loaded buffer differs\n");
+      result = FAILURE;
+    }
+
+  if (! compare_buffers ("load", buffer, loaded,
+                         gegl_buffer_get_extent (buffer)))
+    result = FAILURE;
+
+  g_object_unref (loaded);
+
+  /* only the tiles intersecting the roi, the rest is left empty */
+  loaded = gegl_buffer_load_roi (path, &roi);
+
+  if (! compare_buffers ("load_roi", buffer, loaded, &roi) ||
+      ! compare_buffers ("load_roi, outside", empty, loaded,
+                         GEGL_RECTANGLE (0, 0, 100, 100)) ||
+      ! compare_buffers ("load_roi, outside", empty, loaded,
+                         GEGL_RECTANGLE (WIDTH - 100, HEIGHT - 100,
+                                         100, 100)))
+    {
+      result = FAILURE;
+    }
+
+  g_object_unref (loaded);
+
+  /* the default format still loads, and opens */
+  gegl_buffer_save (buffer, path, NULL);
+
+  loaded = gegl_buffer_load (path);
+
+  if (! compare_buffers ("uncompressed load", buffer, loaded,
+                         gegl_buffer_get_extent (buffer)))
+    result = FAILURE;
+
+  g_object_unref (loaded);
+
+  loaded = gegl_buffer_open (path);
+
+  if (! compare_buffers ("uncompressed open", buffer, loaded,
+                         gegl_buffer_get_extent (buffer)))
+    result = FAILURE;
+
+  g_object_unref (loaded);
+
+  /* and saving a part of a buffer only stores that part */
+  gegl_buffer_save_chunked (buffer, path, &roi);
+
+  loaded = gegl_buffer_load (path);
+
+  if (! compare_buffers ("save roi", buffer, loaded, &roi) ||
+      ! compare_buffers ("save roi, outside", empty, loaded,
+                         GEGL_RECTANGLE (0, 0, 100, 100)))
+    {
+      result = FAILURE;
+    }
+
+  g_object_unref (loaded);
+
+  g_object_unref (empty);
+  g_object_unref (buffer);
+
+  g_unlink (path);
+  g_rmdir (tmpdir);
+  g_free (path);
+  g_free (tmpdir);
+
+  gegl_exit ();
+
+  return result;
+}
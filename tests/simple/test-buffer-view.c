@@ -0,0 +1,322 @@
+/* This file is a test-case for GEGL
+ *
+ * GEGL is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * GEGL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GEGL; if not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include "gegl.h"
+
+#define SUCCESS    0
+#define FAILURE    -1
+
+#define N_VIEWS    50
+
+/* the value written at a given pixel */
+static guint32
+pixel_value (gint x,
+             gint y,
+             gint pass)
+{
+  return (guint32) (x * 7919 + y * 104729 + pass * 1299709);
+}
+
+static void
+random_rect (GRand         *rand,
+             GeglRectangle *rect)
+{
+  rect->x      = g_rand_int_range (rand, -100, 500);
+  rect->y      = g_rand_int_range (rand, -100, 500);
+  rect->width  = g_rand_int_range (rand, 1, 300);
+  rect->height = g_rand_int_range (rand, 1, 300);
+}
+
+/* fills @rect through a view, and checks that the tiles of the view cover
+ * it exactly.
+ */
+static gboolean
+write_view (GeglBuffer          *buffer,
+            const GeglRectangle *rect,
+            const Babl          *format,
+            gint                 pass)
+{
+  GeglBufferView           *view;
+  const GeglBufferViewTile *tiles;
+  gint                      n_tiles;
+  gint                      n_pixels = 0;
+  gboolean                  result   = TRUE;
+  gint                      i;
+
+  view  = gegl_buffer_view_open (buffer, rect, format, GEGL_ACCESS_WRITE);
+  tiles = gegl_buffer_view_get_tiles (view, &n_tiles);
+
+  if (gegl_buffer_view_is_direct (view) !=
+      (format == gegl_buffer_get_format (buffer)))
+    {
+      printf ("view of %s is unexpectedly %s\n",
+              babl_get_name (format),
+              gegl_buffer_view_is_direct (view) ? "direct" : "a copy");
+      result = FALSE;
+    }
+
+  for (i = 0; i < n_tiles; i++)
+    {
+      const GeglBufferViewTile *tile = &tiles[i];
+      gint                      x;
+      gint                      y;
+
+      if (! gegl_rectangle_contains (rect, &tile->rect))
+        {
+          printf ("tile %d of the view is outside of it\n", i);
+          result = FALSE;
+          continue;
+        }
+
+      for (y = 0; y < tile->rect.height; y++)
+        {
+          guint32 *row = (guint32 *) ((guchar *) tile->data +
+                                      y * tile->rowstride);
+
+          for (x = 0; x < tile->rect.width; x++)
+            row[x] = pixel_value (tile->rect.x + x, tile->rect.y + y, pass);
+        }
+
+      n_pixels += tile->rect.width * tile->rect.height;
+    }
+
+  if (n_pixels != rect->width * rect->height)
+    {
+      printf ("the view covers %d pixels instead of %d\n",
+              n_pixels, rect->width * rect->height);
+      result = FALSE;
+    }
+
+  gegl_buffer_view_close (view);
+
+  return result;
+}
+
+static gboolean
+check_buffer (GeglBuffer          *buffer,
+              const GeglRectangle *rect,
+              gint                 pass)
+{
+  guint32  *pixels;
+  gboolean  result = TRUE;
+  gint      x;
+  gint      y;
+
+  pixels = g_new (guint32, rect->width * rect->height);
+
+  gegl_buffer_get (buffer, rect, 1.0, gegl_buffer_get_format (buffer),
+                   pixels, GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+
+  for (y = 0; y < rect->height && result; y++)
+    {
+      for (x = 0; x < rect->width && result; x++)
+        {
+          if (pixels[y * rect->width + x] !=
+              pixel_value (rect->x + x, rect->y + y, pass))
+            {
+              printf ("wrong pixel at %d, %d after writing %d, %d, %d x %d\n",
+                      rect->x + x, rect->y + y,
+                      rect->x, rect->y, rect->width, rect->height);
+              result = FALSE;
+            }
+        }
+    }
+
+  g_free (pixels);
+
+  return result;
+}
+
+/* reads @rect through a view, comparing with gegl_buffer_get() */
+static gboolean
+read_view (GeglBuffer          *buffer,
+           const GeglRectangle *rect,
+           const Babl          *format)
+{
+  GeglBufferView           *view;
+  const GeglBufferViewTile *tiles;
+  gint                      bpp    = babl_format_get_bytes_per_pixel (format);
+  gint                      n_tiles;
+  guchar                   *pixels;
+  gboolean                  result = TRUE;
+  gint                      i;
+
+  pixels = g_new (guchar, rect->width * rect->height * bpp);
+
+  gegl_buffer_get (buffer, rect, 1.0, format,
+                   pixels, GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+
+  view  = gegl_buffer_view_open (buffer, rect, format, GEGL_ACCESS_READ);
+  tiles = gegl_buffer_view_get_tiles (view, &n_tiles);
+
+  for (i = 0; i < n_tiles && result; i++)
+    {
+      const GeglBufferViewTile *tile = &tiles[i];
+      gint                      y;
+
+      for (y = 0; y < tile->rect.height; y++)
+        {
+          const guchar *expected = pixels +
+                                   ((tile->rect.y - rect->y + y) *
+                                    rect->width +
+                                    tile->rect.x - rect->x) * bpp;
+
+          if (memcmp ((guchar *) tile->data + y * tile->rowstride,
+                      expected, tile->rect.width * bpp))
+            {
+              printf ("view of %d, %d, %d x %d differs in row %d\n",
+                      rect->x, rect->y, rect->width, rect->height,
+                      tile->rect.y + y);
+              result = FALSE;
+              break;
+            }
+        }
+    }
+
+  gegl_buffer_view_close (view);
+
+  g_free (pixels);
+
+  return result;
+}
+
+/* two linear opens of extents within a tile, held at the same time; the
+ * first one is accessed in place, the second one is a copy.
+ */
+static gboolean
+test_linear_nested (GeglBuffer *buffer,
+                    const Babl *format)
+{
+  const GeglRectangle  a = {2, 3, 10, 5};
+  const GeglRectangle  b = {20, 4, 8, 6};
+  guint32             *data_a;
+  guint32             *data_b;
+  guint32              pixel;
+  gint                 rowstride_a;
+  gint                 rowstride_b;
+  gboolean             result = TRUE;
+
+  data_a = gegl_buffer_linear_open (buffer, &a, &rowstride_a, format);
+  data_b = gegl_buffer_linear_open (buffer, &b, &rowstride_b, format);
+
+  data_a[0] = 0x11223344;
+  data_b[0] = 0x55667788;
+
+  /* closing the copy leaves the tile of the first one alone */
+  gegl_buffer_linear_close (buffer, data_b);
+
+  data_a[rowstride_a / 4] = 0x99aabbcc;
+
+  gegl_buffer_linear_close (buffer, data_a);
+
+  gegl_buffer_get (buffer, GEGL_RECTANGLE (a.x, a.y, 1, 1), 1.0, format,
+                   &pixel, GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+  result &= pixel == 0x11223344;
+
+  gegl_buffer_get (buffer, GEGL_RECTANGLE (a.x, a.y + 1, 1, 1), 1.0, format,
+                   &pixel, GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+  result &= pixel == 0x99aabbcc;
+
+  gegl_buffer_get (buffer, GEGL_RECTANGLE (b.x, b.y, 1, 1), 1.0, format,
+                   &pixel, GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+  result &= pixel == 0x55667788;
+
+  if (! result)
+    printf ("nested linear opens lost a write\n");
+
+  return result;
+}
+
+gint
+main (gint    argc,
+      gchar **argv)
+{
+  const Babl *format = babl_format ("R'G'B'A u8");
+  GeglBuffer *buffer;
+  GeglBuffer *shifted;
+  GRand      *rand;
+  gint        result = SUCCESS;
+  gint        i;
+
+  gegl_init (&argc, &argv);
+
+  rand   = g_rand_new_with_seed (5678);
+  buffer = g_object_new (GEGL_TYPE_BUFFER,
+                         "x",           0,
+                         "y",           0,
+                         "width",       400,
+                         "height",      400,
+                         "tile-width",  64,
+                         "tile-height", 32,
+                         "format",      format,
+                         NULL);
+  /* tiles not aligned to the origin */
+  shifted = g_object_new (GEGL_TYPE_BUFFER,
+                          "x",           0,
+                          "y",           0,
+                          "width",       400,
+                          "height",      400,
+                          "shift-x",     13,
+                          "shift-y",     -7,
+                          "tile-width",  64,
+                          "tile-height", 32,
+                          "format",      format,
+                          NULL);
+
+  for (i = 0; i < N_VIEWS && result == SUCCESS; i++)
+    {
+      GeglBuffer    *target = i % 2 ? shifted : buffer;
+      GeglRectangle  rect;
+
+      random_rect (rand, &rect);
+
+      if (! write_view (target, &rect, format, i) ||
+          ! check_buffer (target, &rect, i)       ||
+          ! read_view (target, &rect, format)     ||
+          ! read_view (target, &rect, babl_format ("RGBA float")))
+        {
+          result = FAILURE;
+        }
+    }
+
+  /* a converted view is written back on close */
+  if (result == SUCCESS)
+    {
+      GeglRectangle rect = {50, 60, 70, 80};
+
+      if (! write_view (buffer, &rect, babl_format ("RGBA u8"), N_VIEWS) ||
+          ! read_view (buffer, &rect, format))
+        {
+          result = FAILURE;
+        }
+    }
+
+  if (result == SUCCESS && ! test_linear_nested (buffer, format))
+    result = FAILURE;
+
+  g_object_unref (shifted);
+  g_object_unref (buffer);
+  g_rand_free (rand);
+
+  gegl_exit ();
+
+  return result;
+}
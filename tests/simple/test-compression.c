@@ -65,11 +65,9 @@ load_png (const gchar *path,
   return data;
 }
 
-gint
-main (gint    argc,
-      gchar **argv)
+static gint
+test_format (const Babl *format)
 {
-  const Babl   *format;
   gint          bpp;
   gchar        *path;
   gpointer      data;
@@ -83,10 +81,9 @@ main (gint    argc,
   gint          i;
   gint          result = SUCCESS;
 
-  gegl_init (&argc, &argv);
+  printf ("%s:\n", babl_get_name (format));
 
-  format = babl_format ("R'G'B'A u8");
-  bpp    = babl_format_get_bytes_per_pixel (format);
+  bpp = babl_format_get_bytes_per_pixel (format);
 
   path = g_build_filename (g_getenv ("ABS_TOP_SRCDIR"),
                            "tests", "compositions", "data", "car-stack.png",
@@ -109,7 +106,7 @@ main (gint    argc,
       gint                   compressed_size;
       gint                   trunc_size;
 
-      printf ("%s: ", algorithms[i]);
+      printf ("  %s: ", algorithms[i]);
       fflush (stdout);
 
       memset (compressed,   0, max_compressed_size);
@@ -135,7 +132,7 @@ main (gint    argc,
 
       printf ("pass (%d%%)\n", (100 * compressed_size + size / 2) / size);
 
-      printf ("%s (trunc.): ", algorithms[i]);
+      printf ("  %s (trunc.): ", algorithms[i]);
       fflush (stdout);
 
       trunc_size = compressed_size / 2;
@@ -170,6 +167,24 @@ fail:
 
   g_free (data);
 
+  return result;
+}
+
+gint
+main (gint    argc,
+      gchar **argv)
+{
+  gint result = SUCCESS;
+
+  gegl_init (&argc, &argv);
+
+  if (test_format (babl_format ("R'G'B'A u8")))
+    result = FAILURE;
+
+  /* exercises the byte-plane shuffling of multi-byte components */
+  if (test_format (babl_format ("RGBA float")))
+    result = FAILURE;
+
   gegl_exit ();
 
   return result;
@@ -0,0 +1,175 @@
+/* This file is a test-case for GEGL
+ *
+ * GEGL is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * GEGL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GEGL; if not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include "gegl.h"
+#include "gegl-cpuaccel-private.h"
+
+#define SUCCESS  0
+#define FAILURE -1
+#define SKIP     77
+
+/* odd-sized and offset, so that neither dimension is a multiple of the
+ * number of lines blurred together, nor aligned to the tile grid.
+ */
+#define AREA GEGL_RECTANGLE (3, 5, 37, 29)
+
+/* gegl:gblur-1d's enum values */
+#define ABYSS_NONE  0
+#define ABYSS_WHITE 3
+#define FILTER_IIR  2
+
+static GeglBuffer *
+create_input (const Babl *format)
+{
+  GeglBuffer *buffer;
+  gfloat     *data;
+  GRand      *rand;
+  gint        n;
+  gint        i;
+
+  n    = AREA->width * AREA->height * babl_format_get_n_components (format);
+  data = g_new (gfloat, n);
+  rand = g_rand_new_with_seed (0);
+
+  for (i = 0; i < n; i++)
+    data[i] = g_rand_double (rand);
+
+  buffer = gegl_buffer_new (AREA, format);
+
+  gegl_buffer_set (buffer, AREA, 0, format, data, GEGL_AUTO_ROWSTRIDE);
+
+  g_rand_free (rand);
+  g_free (data);
+
+  return buffer;
+}
+
+static gfloat *
+blur (GeglBuffer      *input,
+      GeglOrientation  orientation,
+      gint             abyss_policy,
+      gboolean         simd)
+{
+  const Babl *format = gegl_buffer_get_format (input);
+  GeglNode   *graph;
+  GeglNode   *source;
+  GeglNode   *gblur;
+  GeglBuffer *output;
+  gfloat     *data;
+
+  gegl_cpu_accel_set_use (simd);
+
+  graph  = gegl_node_new ();
+  source = gegl_node_new_child (graph,
+                                "operation", "gegl:buffer-source",
+                                "buffer",    input,
+                                NULL);
+  gblur  = gegl_node_new_child (graph,
+                                "operation",    "gegl:gblur-1d",
+                                "std-dev",      3.7,
+                                "orientation",  orientation,
+                                "filter",       FILTER_IIR,
+                                "abyss-policy", abyss_policy,
+                                NULL);
+
+  gegl_node_link (source, gblur);
+
+  output = gegl_buffer_new (AREA, format);
+
+  gegl_node_blit_buffer (gblur, output, NULL, 0, GEGL_ABYSS_NONE);
+
+  data = g_new (gfloat, AREA->width * AREA->height *
+                        babl_format_get_n_components (format));
+
+  gegl_buffer_get (output, AREA, 1.0, format, data,
+                   GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+
+  g_object_unref (output);
+  g_object_unref (graph);
+
+  gegl_cpu_accel_set_use (TRUE);
+
+  return data;
+}
+
+gint
+main (gint    argc,
+      gchar **argv)
+{
+  /* one format for each of the per-line kernels */
+  const gchar *formats[] = { "Y float", "YaA float", "RGB float",
+                             "RaGaBaA float", "CMYK float" };
+  GeglCpuAccelFlags accel;
+  gint              result = SUCCESS;
+  gint              i;
+
+  gegl_init (&argc, &argv);
+
+  accel = gegl_cpu_accel_get_support ();
+
+  if (! (accel & (GEGL_CPU_ACCEL_X86_SSE2 | GEGL_CPU_ACCEL_X86_AVX)))
+    {
+      gegl_exit ();
+
+      return SKIP;
+    }
+
+  for (i = 0; i < G_N_ELEMENTS (formats); i++)
+    {
+      const Babl *format = babl_format (formats[i]);
+      GeglBuffer *input  = create_input (format);
+      gint        orientation;
+      gint        abyss_policy;
+
+      for (orientation = GEGL_ORIENTATION_HORIZONTAL;
+           orientation <= GEGL_ORIENTATION_VERTICAL;
+           orientation++)
+        {
+          for (abyss_policy = ABYSS_NONE;
+               abyss_policy <= ABYSS_WHITE;
+               abyss_policy++)
+            {
+              gfloat *vector = blur (input, orientation, abyss_policy, TRUE);
+              gfloat *scalar = blur (input, orientation, abyss_policy, FALSE);
+
+              if (memcmp (vector, scalar,
+                          AREA->width * AREA->height *
+                          babl_format_get_bytes_per_pixel (format)))
+                {
+                  printf ("%s, orientation %d, abyss policy %d: "
+                          "SIMD result differs from scalar result\n",
+                          formats[i], orientation, abyss_policy);
+
+                  result = FAILURE;
+                }
+
+              g_free (vector);
+              g_free (scalar);
+            }
+        }
+
+      g_object_unref (input);
+    }
+
+  gegl_exit ();
+
+  return result;
+}
@@ -0,0 +1,161 @@
+/* This file is a test-case for GEGL
+ *
+ * GEGL is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * GEGL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GEGL; if not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include <glib/gstdio.h>
+
+#include "gegl.h"
+#include "gegl-instrument.h"
+
+#define SUCCESS    0
+#define FAILURE    -1
+
+/* check that the brackets of the trace are balanced, skipping over strings,
+ * as a cheap sanity check that we produced well-formed JSON.
+ */
+static gboolean
+is_balanced (const gchar *json)
+{
+  GString  *stack     = g_string_new (NULL);
+  gboolean  in_string = FALSE;
+  gboolean  result    = TRUE;
+
+  for (; *json && result; json++)
+    {
+      if (in_string)
+        {
+          if (*json == '\\')
+            json++;
+          else if (*json == '"')
+            in_string = FALSE;
+
+          continue;
+        }
+
+      switch (*json)
+        {
+        case '"':
+          in_string = TRUE;
+          break;
+
+        case '{':
+        case '[':
+          g_string_append_c (stack, *json);
+          break;
+
+        case '}':
+        case ']':
+          if (! stack->len ||
+              stack->str[stack->len - 1] != (*json == '}' ? '{' : '['))
+            {
+              result = FALSE;
+            }
+          else
+            {
+              g_string_truncate (stack, stack->len - 1);
+            }
+          break;
+        }
+    }
+
+  result = result && ! in_string && stack->len == 0;
+
+  g_string_free (stack, TRUE);
+
+  return result;
+}
+
+gint
+main (gint    argc,
+      gchar **argv)
+{
+  GeglNode   *graph;
+  GeglNode   *source;
+  GeglNode   *invert;
+  GeglNode   *threshold;
+  GeglBuffer *buffer;
+  gchar      *path;
+  gchar      *trace = NULL;
+  gint        result = SUCCESS;
+
+  gegl_init (&argc, &argv);
+
+  path = g_build_filename (g_get_tmp_dir (), "test-instrument-trace.json",
+                           NULL);
+
+  gegl_instrument_trace_enable (path);
+
+  graph  = gegl_node_new ();
+  source = gegl_node_new_child (graph,
+                                "operation", "gegl:checkerboard",
+                                NULL);
+  invert = gegl_node_new_child (graph,
+                                "operation", "gegl:invert-linear",
+                                NULL);
+  /* fused with invert, whose span should still be recorded */
+  threshold = gegl_node_new_child (graph,
+                                   "operation", "gegl:threshold",
+                                   NULL);
+
+  gegl_node_link_many (source, invert, threshold, NULL);
+
+  buffer = gegl_buffer_new (GEGL_RECTANGLE (0, 0, 512, 512),
+                            babl_format ("RGBA float"));
+
+  gegl_node_blit_buffer (threshold, buffer, NULL, 0, GEGL_ABYSS_NONE);
+
+  g_object_unref (buffer);
+  g_object_unref (graph);
+
+  gegl_instrument_trace_finish ();
+
+  if (gegl_instrument_trace_enabled)
+    {
+      printf ("tracing still enabled after finishing\n");
+      result = FAILURE;
+    }
+  else if (! g_file_get_contents (path, &trace, NULL, NULL))
+    {
+      printf ("trace file not written\n");
+      result = FAILURE;
+    }
+  else if (! g_str_has_prefix (trace, "{\"traceEvents\":[") ||
+           ! is_balanced (trace))
+    {
+      printf ("trace file is malformed\n");
+      result = FAILURE;
+    }
+  else if (! strstr (trace, "\"name\":\"gegl:invert-linear\",\"cat\":\"process\"") ||
+           ! strstr (trace, "\"name\":\"gegl:threshold\",\"cat\":\"process\"") ||
+           ! strstr (trace, "\"name\":\"gegl:checkerboard\",\"cat\":\"process\""))
+    {
+      printf ("trace file is missing process spans\n");
+      result = FAILURE;
+    }
+
+  g_free (trace);
+
+  g_unlink (path);
+  g_free (path);
+
+  gegl_exit ();
+
+  return result;
+}
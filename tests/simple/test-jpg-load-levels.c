@@ -0,0 +1,230 @@
+/* This file is a test-case for GEGL
+ *
+ * GEGL is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * GEGL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GEGL; if not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "gegl.h"
+#include "graph/gegl-node-private.h"
+#include "graph/gegl-cache.h"
+
+#define SUCCESS  0
+#define FAILURE -1
+#define SKIP     77
+
+/* gray-gradient.jpg is a 203x141, 8-bit gray image of smooth gradients.
+ * neither dimension is a multiple of 8, so libjpeg's scaled output, which
+ * is rounded up, doesn't match the extent of the mipmap level, which is
+ * rounded down.
+ */
+#define WIDTH  203
+#define HEIGHT 141
+
+/* libjpeg scales in the DCT domain, rather than averaging pixels */
+#define MAX_DIFFERENCE 3
+
+/* how far around the level to look for stray pixels */
+#define MARGIN 8
+
+/* loads the image at full resolution */
+static GeglBuffer *
+load (const gchar *path)
+{
+  GeglNode   *graph;
+  GeglNode   *load;
+  GeglNode   *sink;
+  GeglBuffer *buffer = NULL;
+
+  graph = gegl_node_new ();
+  load  = gegl_node_new_child (graph,
+                               "operation", "gegl:jpg-load",
+                               "path",      path,
+                               NULL);
+  sink  = gegl_node_new_child (graph,
+                               "operation", "gegl:buffer-sink",
+                               "buffer",    &buffer,
+                               NULL);
+
+  gegl_node_link (load, sink);
+  gegl_node_process (sink);
+
+  g_object_unref (graph);
+
+  return buffer;
+}
+
+/* decodes the image straight into the given mipmap level, and compares it
+ * to the full-resolution image, as downscaled by GEGL.  levels above 3 are
+ * beyond what libjpeg can decode to, and are rendered from level 3.
+ */
+static gboolean
+test_level (const gchar *path,
+            GeglBuffer  *full,
+            gint         level)
+{
+  const Babl    *format = babl_format ("Y' u8");
+  const gdouble  scale  = 1.0 / (1 << level);
+  const gint     width  = WIDTH  >> level;
+  const gint     height = HEIGHT >> level;
+  /* the size libjpeg decodes the level to */
+  const gint     jpeg_width  = (WIDTH  + (1 << level) - 1) >> level;
+  const gint     jpeg_height = (HEIGHT + (1 << level) - 1) >> level;
+  GeglRectangle  around;
+  GeglNode      *graph;
+  GeglNode      *load;
+  guchar        *pixels;
+  guchar        *expected;
+  gboolean       result = TRUE;
+  gint           x;
+  gint           y;
+
+  graph = gegl_node_new ();
+  load  = gegl_node_new_child (graph,
+                               "operation",    "gegl:jpg-load",
+                               "path",         path,
+                               "cache-policy", GEGL_CACHE_POLICY_ALWAYS,
+                               NULL);
+
+  pixels   = g_malloc (width * height);
+  expected = g_malloc (width * height);
+
+  gegl_node_blit (load, scale, GEGL_RECTANGLE (0, 0, width, height),
+                  format, pixels, GEGL_AUTO_ROWSTRIDE, GEGL_BLIT_CACHE);
+
+  gegl_buffer_get (full, GEGL_RECTANGLE (0, 0, width, height), scale,
+                   format, expected, GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+
+  for (y = 0; y < height && result; y++)
+    {
+      for (x = 0; x < width; x++)
+        {
+          gint value = pixels[y * width + x];
+          gint ref   = expected[y * width + x];
+
+          if (abs (value - ref) > MAX_DIFFERENCE)
+            {
+              printf ("level %d: pixel (%d, %d) is %d, expected %d\n",
+                      level, x, y, value, ref);
+
+              result = FALSE;
+              break;
+            }
+        }
+    }
+
+  g_free (expected);
+  g_free (pixels);
+
+  /* look at the level in the node's cache, which the loader decoded into,
+   * past the cache's abyss; everything outside of the area libjpeg decodes
+   * to must have been left alone.
+   */
+  around.x      = -MARGIN;
+  around.y      = -MARGIN;
+  around.width  = jpeg_width  + 2 * MARGIN;
+  around.height = jpeg_height + 2 * MARGIN;
+
+  gegl_buffer_set_abyss (GEGL_BUFFER (load->cache),
+                         GEGL_RECTANGLE (around.x      << level,
+                                         around.y      << level,
+                                         around.width  << level,
+                                         around.height << level));
+
+  pixels = g_malloc (around.width * around.height);
+
+  gegl_buffer_get (GEGL_BUFFER (load->cache), &around, scale,
+                   format, pixels, GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+
+  for (y = 0; y < around.height && result; y++)
+    {
+      for (x = 0; x < around.width; x++)
+        {
+          gint lx = around.x + x;
+          gint ly = around.y + y;
+
+          if (lx >= 0 && lx < jpeg_width && ly >= 0 && ly < jpeg_height)
+            continue;
+
+          if (pixels[y * around.width + x])
+            {
+              printf ("level %d: pixel (%d, %d), outside of the level, "
+                      "is %d\n",
+                      level, lx, ly, pixels[y * around.width + x]);
+
+              result = FALSE;
+              break;
+            }
+        }
+    }
+
+  g_free (pixels);
+  g_object_unref (graph);
+
+  return result;
+}
+
+gint
+main (gint    argc,
+      gchar **argv)
+{
+  GeglBuffer *full;
+  gchar      *path;
+  gint        level;
+  gint        result = SUCCESS;
+
+  gegl_init (&argc, &argv);
+
+  if (! gegl_has_operation ("gegl:jpg-load"))
+    {
+      gegl_exit ();
+
+      return SKIP;
+    }
+
+  /* levels are only passed on to the loader when rendering mipmaps */
+  g_object_set (gegl_config (),
+                "mipmap-rendering", TRUE,
+                NULL);
+
+  path = g_build_filename (g_getenv ("ABS_TOP_SRCDIR"),
+                           "tests", "compositions", "data",
+                           "gray-gradient.jpg",
+                           NULL);
+
+  full = load (path);
+
+  if (! full)
+    {
+      printf ("failed to load gray-gradient.jpg\n");
+
+      result = FAILURE;
+    }
+
+  for (level = 1; result == SUCCESS && level <= 4; level++)
+    {
+      if (! test_level (path, full, level))
+        result = FAILURE;
+    }
+
+  g_clear_object (&full);
+  g_free (path);
+
+  gegl_exit ();
+
+  return result;
+}
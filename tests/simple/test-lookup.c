@@ -0,0 +1,231 @@
+/* This file is a test-case for GEGL
+ *
+ * GEGL is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * GEGL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GEGL; if not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "gegl.h"
+#include "gegl-lookup.h"
+
+#define SUCCESS    0
+#define FAILURE    -1
+
+#define N_VALUES   10007
+#define N_PIXELS   10000
+#define LUT_SIZE   17
+
+static gint n_calls;
+
+static gfloat
+curve (gfloat   value,
+       gpointer data)
+{
+  n_calls++;
+
+  return value >= 0.0f ? sqrtf (value) : -2.0f * value;
+}
+
+/* an affine map, which both interpolations reproduce exactly */
+static void
+grade (const gfloat *rgb_in,
+       gfloat       *rgb_out,
+       gpointer      data)
+{
+  rgb_out[0] = 0.5f * rgb_in[1] + 0.1f;
+  rgb_out[1] = 0.8f * rgb_in[0] - 0.2f * rgb_in[2];
+  rgb_out[2] = 1.0f - rgb_in[2];
+}
+
+static gboolean
+test_map_array (GRand *rand)
+{
+  GeglLookup *batched;
+  GeglLookup *scalar;
+  gfloat     *src;
+  gfloat     *dest;
+  gboolean    result = TRUE;
+  gint        pass;
+  gint        i;
+
+  batched = gegl_lookup_new_full (curve, NULL, -2.0, 1.0, 0.00001);
+  scalar  = gegl_lookup_new_full (curve, NULL, -2.0, 1.0, 0.00001);
+
+  src  = g_new (gfloat, N_VALUES);
+  dest = g_new (gfloat, N_VALUES);
+
+  /* mostly within the range of the tables, some outside */
+  for (i = 0; i < N_VALUES; i++)
+    src[i] = g_rand_double_range (rand, -2.5, 1.1);
+
+  /* the first pass fills the tables in, the second reads them back */
+  for (pass = 0; pass < 2 && result; pass++)
+    {
+      gegl_lookup_map_array (batched, src, dest, N_VALUES);
+
+      for (i = 0; i < N_VALUES; i++)
+        {
+          gfloat expected = gegl_lookup (scalar, src[i]);
+
+          if (memcmp (&dest[i], &expected, sizeof (gfloat)))
+            {
+              printf ("map_array (%g) = %g, expected %g\n",
+                      src[i], dest[i], expected);
+              result = FALSE;
+              break;
+            }
+        }
+    }
+
+  g_free (dest);
+  g_free (src);
+  gegl_lookup_free (scalar);
+  gegl_lookup_free (batched);
+
+  return result;
+}
+
+static gboolean
+test_build (GRand *rand)
+{
+  GeglLookup *lookup;
+  gfloat     *src;
+  gfloat     *dest;
+  gboolean    result = TRUE;
+  gint        i;
+
+  lookup = gegl_lookup_new (curve, NULL);
+
+  gegl_lookup_build (lookup);
+
+  src  = g_new (gfloat, N_VALUES);
+  dest = g_new (gfloat, N_VALUES);
+
+  for (i = 0; i < N_VALUES; i++)
+    src[i] = g_rand_double_range (rand, 0.01, 0.99);
+
+  n_calls = 0;
+
+  gegl_lookup_map_array (lookup, src, dest, N_VALUES);
+
+  if (n_calls)
+    {
+      printf ("a built table called its function %d times\n", n_calls);
+      result = FALSE;
+    }
+
+  for (i = 0; i < N_VALUES && result; i++)
+    {
+      if (fabsf (dest[i] - sqrtf (src[i])) > 0.0001f)
+        {
+          printf ("a built table maps %g to %g, expected %g\n",
+                  src[i], dest[i], sqrtf (src[i]));
+          result = FALSE;
+        }
+    }
+
+  g_free (dest);
+  g_free (src);
+  gegl_lookup_free (lookup);
+
+  return result;
+}
+
+static gboolean
+test_3d (GRand                   *rand,
+         GeglLookupInterpolation  interpolation)
+{
+  GeglLookup3D *lookup;
+  gfloat       *pixels;
+  gfloat       *mapped;
+  gboolean      result = TRUE;
+  gint          i;
+
+  lookup = gegl_lookup_3d_new (grade, NULL, LUT_SIZE);
+
+  pixels = g_new (gfloat, 4 * N_PIXELS);
+  mapped = g_new (gfloat, 4 * N_PIXELS);
+
+  for (i = 0; i < 4 * N_PIXELS; i++)
+    pixels[i] = g_rand_double (rand);
+
+  memcpy (mapped, pixels, sizeof (gfloat) * 4 * N_PIXELS);
+
+  gegl_lookup_3d_map_array (lookup, mapped, mapped, N_PIXELS, 4,
+                            interpolation);
+
+  for (i = 0; i < N_PIXELS && result; i++)
+    {
+      gfloat expected[3];
+      gint   c;
+
+      grade (&pixels[4 * i], expected, NULL);
+
+      for (c = 0; c < 3; c++)
+        {
+          if (fabsf (mapped[4 * i + c] - expected[c]) > 0.00001f)
+            {
+              printf ("3d lookup of pixel %d is off by %g\n",
+                      i, fabsf (mapped[4 * i + c] - expected[c]));
+              result = FALSE;
+            }
+        }
+
+      if (mapped[4 * i + 3] != pixels[4 * i + 3])
+        {
+          printf ("3d lookup changed the alpha of pixel %d\n", i);
+          result = FALSE;
+        }
+    }
+
+  g_free (mapped);
+  g_free (pixels);
+  gegl_lookup_3d_free (lookup);
+
+  return result;
+}
+
+gint
+main (gint    argc,
+      gchar **argv)
+{
+  GRand *rand;
+  gint   result = SUCCESS;
+
+  gegl_init (&argc, &argv);
+
+  rand = g_rand_new_with_seed (4321);
+
+  if (! test_map_array (rand))
+    result = FAILURE;
+
+  if (! test_build (rand))
+    result = FAILURE;
+
+  if (! test_3d (rand, GEGL_LOOKUP_INTERPOLATION_TRILINEAR))
+    result = FAILURE;
+
+  if (! test_3d (rand, GEGL_LOOKUP_INTERPOLATION_TETRAHEDRAL))
+    result = FAILURE;
+
+  g_rand_free (rand);
+
+  gegl_exit ();
+
+  return result;
+}
@@ -0,0 +1,258 @@
+/* This file is a test-case for GEGL
+ *
+ * GEGL is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * GEGL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GEGL; if not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "gegl.h"
+
+#define SUCCESS  0
+#define FAILURE -1
+
+#define AREA GEGL_RECTANGLE (2, 3, 45, 37)
+
+/* gegl:median-blur's enum values */
+#define NEIGHBORHOOD_SQUARE  0
+#define NEIGHBORHOOD_CIRCLE  1
+#define NEIGHBORHOOD_DIAMOND 2
+
+/* the half-width of the window's row dy rows away from its center */
+static gint
+half_width (gint neighborhood,
+            gint radius,
+            gint dy)
+{
+  switch (neighborhood)
+    {
+    case NEIGHBORHOOD_CIRCLE:
+      {
+        /* the largest w with w^2 + dy^2 <= (radius + 1/2)^2 */
+        gint w = radius;
+
+        while (w * w + dy * dy > radius * radius + radius)
+          w--;
+
+        return w;
+      }
+
+    case NEIGHBORHOOD_DIAMOND:
+      return radius - abs (dy);
+
+    default:
+      return radius;
+    }
+}
+
+/* the median of each component over the window, with the input clamped at
+ * its edges, which is what gegl:median-blur computes with its default
+ * percentile and abyss policy.
+ */
+static void
+reference_median (const gint *src,
+                  gint       *dst,
+                  gint        n_components,
+                  gint        n_values,
+                  gint        neighborhood,
+                  gint        radius)
+{
+  const gint  width  = AREA->width;
+  const gint  height = AREA->height;
+  gint       *counts = g_new0 (gint, n_values);
+  gint        x, y, c;
+
+  for (y = 0; y < height; y++)
+    for (x = 0; x < width; x++)
+      for (c = 0; c < n_components; c++)
+        {
+          gint n   = 0;
+          gint sum = 0;
+          gint value;
+          gint dx, dy;
+
+          for (dy = -radius; dy <= radius; dy++)
+            {
+              gint w = half_width (neighborhood, radius, dy);
+
+              for (dx = -w; dx <= w; dx++)
+                {
+                  gint sx = CLAMP (x + dx, 0, width  - 1);
+                  gint sy = CLAMP (y + dy, 0, height - 1);
+
+                  counts[src[(sy * width + sx) * n_components + c]]++;
+                  n++;
+                }
+            }
+
+          for (value = 0; sum + counts[value] <= (n - 1) / 2; value++)
+            sum += counts[value];
+
+          dst[(y * width + x) * n_components + c] = value;
+
+          memset (counts, 0, n_values * sizeof (gint));
+        }
+
+  g_free (counts);
+}
+
+/* runs gegl:median-blur over random data in the given 8- or 16-bit format,
+ * and compares the result to a brute-force median.
+ */
+static gboolean
+test_median (const gchar *format_name,
+             gint         neighborhood,
+             gint         radius,
+             gboolean     high_precision)
+{
+  const Babl *format       = babl_format (format_name);
+  const gint  n_components = babl_format_get_n_components (format);
+  const gint  bpc          = babl_format_get_bytes_per_pixel (format) /
+                             n_components;
+  const gint  n            = AREA->width * AREA->height * n_components;
+  GeglBuffer *input;
+  GeglBuffer *output;
+  GeglNode   *graph;
+  GeglNode   *source;
+  GeglNode   *median;
+  guchar     *data;
+  gint       *src;
+  gint       *dst;
+  gint       *ref;
+  GRand      *rand;
+  gboolean    result = TRUE;
+  gint        i;
+
+  data = g_malloc (n * bpc);
+  src  = g_new (gint, n);
+  dst  = g_new (gint, n);
+  ref  = g_new (gint, n);
+  rand = g_rand_new_with_seed (radius);
+
+  for (i = 0; i < n; i++)
+    {
+      src[i] = g_rand_int_range (rand, 0, 1 << (8 * bpc));
+
+      if (bpc == 1)
+        data[i] = src[i];
+      else
+        ((guint16 *) data)[i] = src[i];
+    }
+
+  input = gegl_buffer_new (AREA, format);
+  gegl_buffer_set (input, AREA, 0, format, data, GEGL_AUTO_ROWSTRIDE);
+
+  graph  = gegl_node_new ();
+  source = gegl_node_new_child (graph,
+                                "operation", "gegl:buffer-source",
+                                "buffer",    input,
+                                NULL);
+  median = gegl_node_new_child (graph,
+                                "operation",      "gegl:median-blur",
+                                "neighborhood",   neighborhood,
+                                "radius",         radius,
+                                "high-precision", high_precision,
+                                NULL);
+
+  gegl_node_link (source, median);
+
+  output = gegl_buffer_new (AREA, format);
+
+  gegl_node_blit_buffer (median, output, NULL, 0, GEGL_ABYSS_NONE);
+
+  gegl_buffer_get (output, AREA, 1.0, format, data,
+                   GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+
+  for (i = 0; i < n; i++)
+    dst[i] = bpc == 1 ? data[i] : ((guint16 *) data)[i];
+
+  reference_median (src, ref, n_components, 1 << (8 * bpc),
+                    neighborhood, radius);
+
+  for (i = 0; i < n; i++)
+    {
+      if (dst[i] != ref[i])
+        {
+          printf ("%s, neighborhood %d, radius %d: pixel (%d, %d) "
+                  "component %d is %d, expected %d\n",
+                  format_name, neighborhood, radius,
+                  i / n_components % AREA->width,
+                  i / n_components / AREA->width,
+                  i % n_components, dst[i], ref[i]);
+
+          result = FALSE;
+          break;
+        }
+    }
+
+  g_object_unref (output);
+  g_object_unref (graph);
+  g_object_unref (input);
+  g_rand_free (rand);
+  g_free (ref);
+  g_free (dst);
+  g_free (src);
+  g_free (data);
+
+  return result;
+}
+
+gint
+main (gint    argc,
+      gchar **argv)
+{
+  gint result = SUCCESS;
+
+  gegl_init (&argc, &argv);
+
+  /* 8-bit data uses column histograms from a radius of 8 for square and
+   * circle neighborhoods, and from 40 for diamond ones; the radius below
+   * that uses the outline update.
+   */
+  if (! test_median ("Y' u8", NEIGHBORHOOD_SQUARE, 7, FALSE) ||
+      ! test_median ("Y' u8", NEIGHBORHOOD_SQUARE, 8, FALSE) ||
+      ! test_median ("R'G'B' u8", NEIGHBORHOOD_SQUARE, 11, FALSE) ||
+      ! test_median ("Y' u8", NEIGHBORHOOD_CIRCLE, 7, FALSE) ||
+      ! test_median ("Y' u8", NEIGHBORHOOD_CIRCLE, 8, FALSE) ||
+      ! test_median ("R'G'B' u8", NEIGHBORHOOD_CIRCLE, 13, FALSE) ||
+      ! test_median ("Y' u8", NEIGHBORHOOD_DIAMOND, 39, FALSE) ||
+      ! test_median ("Y' u8", NEIGHBORHOOD_DIAMOND, 40, FALSE) ||
+      ! test_median ("R'G'B' u8", NEIGHBORHOOD_DIAMOND, 42, FALSE))
+    {
+      result = FAILURE;
+    }
+
+  /* 16-bit data is binned exactly into 65536 bins when precision is asked
+   * for, and uses column histograms from a radius of 8 for circle
+   * neighborhoods, 40 for square ones, and 96 for diamond ones.
+   */
+  if (! test_median ("Y' u16", NEIGHBORHOOD_SQUARE, 3, TRUE) ||
+      ! test_median ("Y' u16", NEIGHBORHOOD_SQUARE, 9, TRUE) ||
+      ! test_median ("R'G'B' u16", NEIGHBORHOOD_SQUARE, 5, TRUE) ||
+      ! test_median ("Y' u16", NEIGHBORHOOD_SQUARE, 40, TRUE) ||
+      ! test_median ("Y' u16", NEIGHBORHOOD_CIRCLE, 8, TRUE) ||
+      ! test_median ("R'G'B' u16", NEIGHBORHOOD_CIRCLE, 10, TRUE) ||
+      ! test_median ("Y' u16", NEIGHBORHOOD_DIAMOND, 12, TRUE) ||
+      ! test_median ("Y' u16", NEIGHBORHOOD_DIAMOND, 96, TRUE))
+    {
+      result = FAILURE;
+    }
+
+  gegl_exit ();
+
+  return result;
+}
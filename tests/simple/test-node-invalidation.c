@@ -0,0 +1,202 @@
+/* This file is a test-case for GEGL
+ *
+ * GEGL is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * GEGL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GEGL; if not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include "gegl.h"
+
+#define SUCCESS    0
+#define FAILURE    -1
+
+#define SIZE       160
+
+/* collects the bounding box of the "invalidated" signals of a node */
+static void
+invalidated (GeglNode            *node,
+             const GeglRectangle *rect,
+             GeglRectangle       *dirty)
+{
+  gegl_rectangle_bounding_box (dirty, dirty, rect);
+}
+
+static gboolean
+check_dirty (const gchar         *what,
+             GeglRectangle       *dirty,
+             const GeglRectangle *expected)
+{
+  gboolean result = TRUE;
+
+  if (! gegl_rectangle_equal (dirty, expected))
+    {
+      printf ("%s invalidated %d, %d, %d x %d, expected %d, %d, %d x %d\n",
+              what,
+              dirty->x, dirty->y, dirty->width, dirty->height,
+              expected->x, expected->y, expected->width, expected->height);
+      result = FALSE;
+    }
+
+  gegl_rectangle_set (dirty, 0, 0, 0, 0);
+
+  return result;
+}
+
+/* render @node through its caches and without them, and compare */
+static gboolean
+check_render (const gchar *what,
+              GeglNode    *node)
+{
+  const Babl    *format = babl_format ("RGBA float");
+  GeglRectangle  roi    = {0, 0, SIZE, SIZE};
+  gfloat        *cached;
+  gfloat        *direct;
+  gboolean       result = TRUE;
+
+  cached = g_new0 (gfloat, SIZE * SIZE * 4);
+  direct = g_new0 (gfloat, SIZE * SIZE * 4);
+
+  gegl_node_blit (node, 1.0, &roi, format, cached,
+                  GEGL_AUTO_ROWSTRIDE, GEGL_BLIT_CACHE);
+  gegl_node_blit (node, 1.0, &roi, format, direct,
+                  GEGL_AUTO_ROWSTRIDE, GEGL_BLIT_DEFAULT);
+
+  if (memcmp (cached, direct, SIZE * SIZE * 4 * sizeof (gfloat)))
+    {
+      printf ("%s left stale pixels in the cache\n", what);
+      result = FALSE;
+    }
+
+  g_free (direct);
+  g_free (cached);
+
+  return result;
+}
+
+gint
+main (gint    argc,
+      gchar **argv)
+{
+  GeglNode      *graph;
+  GeglNode      *color;
+  GeglNode      *crop;
+  GeglNode      *opacity;
+  GeglNode      *rectangle;
+  GeglNode      *over;
+  GeglColor     *red;
+  GeglColor     *blue;
+  GeglRectangle  crop_dirty      = {0, 0, 0, 0};
+  GeglRectangle  opacity_dirty   = {0, 0, 0, 0};
+  GeglRectangle  rectangle_dirty = {0, 0, 0, 0};
+  gint           result = SUCCESS;
+
+  gegl_init (&argc, &argv);
+
+  red  = gegl_color_new ("red");
+  blue = gegl_color_new ("blue");
+
+  graph     = gegl_node_new ();
+  color     = gegl_node_new_child (graph,
+                                   "operation", "gegl:color",
+                                   "value",     red,
+                                   NULL);
+  crop      = gegl_node_new_child (graph,
+                                   "operation", "gegl:crop",
+                                   "width",     100.0,
+                                   "height",    100.0,
+                                   NULL);
+  opacity   = gegl_node_new_child (graph,
+                                   "operation", "gegl:opacity",
+                                   "value",     0.5,
+                                   NULL);
+  rectangle = gegl_node_new_child (graph,
+                                   "operation", "gegl:rectangle",
+                                   "x",         40.0,
+                                   "y",         40.0,
+                                   "width",     20.0,
+                                   "height",    20.0,
+                                   "color",     blue,
+                                   NULL);
+  over      = gegl_node_new_child (graph,
+                                   "operation", "gegl:over",
+                                   NULL);
+
+  gegl_node_link_many (color, crop, opacity, over, NULL);
+  gegl_node_connect_to (rectangle, "output", over, "aux");
+
+  if (! check_render ("initial graph", over))
+    result = FAILURE;
+
+  g_signal_connect (crop, "invalidated",
+                    G_CALLBACK (invalidated), &crop_dirty);
+  g_signal_connect (opacity, "invalidated",
+                    G_CALLBACK (invalidated), &opacity_dirty);
+  g_signal_connect (rectangle, "invalidated",
+                    G_CALLBACK (invalidated), &rectangle_dirty);
+
+  /* growing the crop only damages the strip it grew by, downstream too */
+  gegl_node_set (crop, "width", 120.0, NULL);
+
+  if (! check_dirty ("growing the crop", &crop_dirty,
+                     GEGL_RECTANGLE (100, 0, 20, 100)) ||
+      ! check_dirty ("growing the crop, downstream", &opacity_dirty,
+                     GEGL_RECTANGLE (100, 0, 20, 100)) ||
+      ! check_render ("growing the crop", over))
+    {
+      result = FAILURE;
+    }
+
+  /* and shrinking it the strip it lost */
+  gegl_node_set (crop, "height", 70.0, NULL);
+
+  if (! check_dirty ("shrinking the crop", &crop_dirty,
+                     GEGL_RECTANGLE (0, 70, 120, 30)) ||
+      ! check_dirty ("shrinking the crop, downstream", &opacity_dirty,
+                     GEGL_RECTANGLE (0, 70, 120, 30)) ||
+      ! check_render ("shrinking the crop", over))
+    {
+      result = FAILURE;
+    }
+
+  /* the properties of a rectangle are handled by its internal crop */
+  gegl_node_set (rectangle, "width", 30.0, NULL);
+
+  if (! check_dirty ("widening the rectangle", &rectangle_dirty,
+                     GEGL_RECTANGLE (60, 40, 10, 20)) ||
+      ! check_render ("widening the rectangle", over))
+    {
+      result = FAILURE;
+    }
+
+  /* while changing what is inside still damages all of it */
+  gegl_node_set (opacity, "value", 0.25, NULL);
+
+  if (! check_dirty ("changing the opacity", &opacity_dirty,
+                     GEGL_RECTANGLE (0, 0, 120, 70)) ||
+      ! check_render ("changing the opacity", over))
+    {
+      result = FAILURE;
+    }
+
+  g_object_unref (graph);
+  g_object_unref (blue);
+  g_object_unref (red);
+
+  gegl_exit ();
+
+  return result;
+}
@@ -0,0 +1,238 @@
+/* This file is a test-case for GEGL
+ *
+ * GEGL is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * GEGL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GEGL; if not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <stdio.h>
+
+#include "gegl.h"
+
+#define SUCCESS  0
+#define FAILURE -1
+
+#define N_THREADS 4
+
+/* gegl-parallel.c splits work into this many chunks per thread; the sizes
+ * below are chosen to be smaller than, equal to, and larger than the
+ * resulting number of chunks, so that some chunks are single elements, and
+ * others are split unevenly.
+ */
+#define CHUNKS_PER_THREAD 8
+#define N_CHUNKS          (N_THREADS * CHUNKS_PER_THREAD)
+
+static const gint sizes[] = { 5, N_CHUNKS - 1, N_CHUNKS, N_CHUNKS + 1, 1000 };
+
+/* the size of the nested range distributed for each element of the outer
+ * range or area.
+ */
+#define NESTED_SIZE (N_CHUNKS + 3)
+
+typedef struct
+{
+  GeglRectangle area;
+  gint         *counts;
+  gint          n;
+  gboolean      nested;
+} Visits;
+
+static void
+visit_nested (gsize    offset,
+              gsize    size,
+              gpointer user_data)
+{
+  gint  *counts = user_data;
+  gsize  i;
+
+  for (i = offset; i < offset + size; i++)
+    g_atomic_int_inc (&counts[i]);
+}
+
+static void
+visit (Visits *visits,
+       gint    i)
+{
+  if (visits->nested)
+    {
+      /* distributing from inside a worker publishes a job that other
+       * workers help with while the caller waits for it.
+       */
+      gegl_parallel_distribute_range (NESTED_SIZE, 0.0, visit_nested,
+                                      &visits->counts[i * NESTED_SIZE]);
+    }
+  else
+    {
+      g_atomic_int_inc (&visits->counts[i]);
+    }
+}
+
+static void
+visit_range (gsize    offset,
+             gsize    size,
+             gpointer user_data)
+{
+  Visits *visits = user_data;
+  gsize   i;
+
+  for (i = offset; i < offset + size; i++)
+    visit (visits, i);
+}
+
+static void
+visit_area (const GeglRectangle *area,
+            gpointer             user_data)
+{
+  Visits *visits = user_data;
+  gint    x, y;
+
+  for (y = area->y; y < area->y + area->height; y++)
+    for (x = area->x; x < area->x + area->width; x++)
+      {
+        if (x < visits->area.x || x >= visits->area.x + visits->area.width ||
+            y < visits->area.y || y >= visits->area.y + visits->area.height)
+          {
+            g_atomic_int_inc (&visits->n);
+          }
+        else
+          {
+            visit (visits,
+                   (y - visits->area.y) * visits->area.width +
+                   (x - visits->area.x));
+          }
+      }
+}
+
+/* checks that each of the n elements was visited exactly once */
+static gboolean
+check_visits (const gchar *name,
+              Visits      *visits,
+              gint         n)
+{
+  gint i;
+
+  if (visits->n)
+    {
+      printf ("%s: %d elements outside of the area were visited\n",
+              name, visits->n);
+
+      return FALSE;
+    }
+
+  if (visits->nested)
+    n *= NESTED_SIZE;
+
+  for (i = 0; i < n; i++)
+    {
+      if (visits->counts[i] != 1)
+        {
+          printf ("%s: element %d was visited %d times\n",
+                  name, i, visits->counts[i]);
+
+          return FALSE;
+        }
+    }
+
+  return TRUE;
+}
+
+static gboolean
+test_range (gint     size,
+            gboolean nested)
+{
+  Visits   visits = { 0, };
+  gchar   *name;
+  gboolean result;
+
+  visits.counts = g_new0 (gint, size * (nested ? NESTED_SIZE : 1));
+  visits.nested = nested;
+
+  gegl_parallel_distribute_range (size, 0.0, visit_range, &visits);
+
+  name   = g_strdup_printf ("range of %d%s", size, nested ? ", nested" : "");
+  result = check_visits (name, &visits, size);
+
+  g_free (name);
+  g_free (visits.counts);
+
+  return result;
+}
+
+static gboolean
+test_area (gint              size,
+           GeglSplitStrategy split_strategy,
+           gboolean          nested)
+{
+  Visits   visits = { 0, };
+  gchar   *name;
+  gboolean result;
+
+  /* size is the extent along the direction the area is split in */
+  if (split_strategy == GEGL_SPLIT_STRATEGY_HORIZONTAL)
+    visits.area = *GEGL_RECTANGLE (-3, 5, 11, size);
+  else
+    visits.area = *GEGL_RECTANGLE (-3, 5, size, 11);
+
+  visits.counts = g_new0 (gint, visits.area.width * visits.area.height *
+                                (nested ? NESTED_SIZE : 1));
+  visits.nested = nested;
+
+  gegl_parallel_distribute_area (&visits.area, 0.0, split_strategy,
+                                 visit_area, &visits);
+
+  name   = g_strdup_printf ("%s area of %d%s",
+                            split_strategy == GEGL_SPLIT_STRATEGY_HORIZONTAL ?
+                              "horizontal" : "vertical",
+                            size, nested ? ", nested" : "");
+  result = check_visits (name, &visits,
+                         visits.area.width * visits.area.height);
+
+  g_free (name);
+  g_free (visits.counts);
+
+  return result;
+}
+
+gint
+main (gint    argc,
+      gchar **argv)
+{
+  gint result = SUCCESS;
+  gint i;
+
+  gegl_init (&argc, &argv);
+
+  g_object_set (gegl_config (),
+                "threads", N_THREADS,
+                NULL);
+
+  for (i = 0; i < G_N_ELEMENTS (sizes); i++)
+    {
+      gint nested;
+
+      for (nested = FALSE; nested <= TRUE; nested++)
+        {
+          if (! test_range (sizes[i], nested) ||
+              ! test_area (sizes[i], GEGL_SPLIT_STRATEGY_HORIZONTAL, nested) ||
+              ! test_area (sizes[i], GEGL_SPLIT_STRATEGY_VERTICAL, nested))
+            {
+              result = FAILURE;
+            }
+        }
+    }
+
+  gegl_exit ();
+
+  return result;
+}
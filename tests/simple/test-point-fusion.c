@@ -0,0 +1,136 @@
+/* This file is a test-case for GEGL
+ *
+ * GEGL is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * GEGL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GEGL; if not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include "gegl.h"
+
+#define SUCCESS    0
+#define FAILURE    -1
+
+#define SIZE       200
+
+/* render a chain of point filters and composers, mixing formats.  when
+ * @fusible is FALSE, every intermediate result is also consumed by a
+ * second node, which prevents the chain from being fused.
+ */
+static gfloat *
+render (gboolean fusible,
+        gint     level)
+{
+  GeglNode   *graph;
+  GeglNode   *source;
+  GeglNode   *color;
+  GeglColor  *value;
+  GeglNode   *chain[4];
+  GeglBuffer *buffer;
+  gfloat     *data;
+  gint        size = SIZE >> level;
+  gint        i;
+
+  value  = gegl_color_new ("rgb(0.3, 0.6, 0.9)");
+  graph  = gegl_node_new ();
+  source = gegl_node_new_child (graph,
+                                "operation", "gegl:checkerboard",
+                                "x",         7,
+                                "y",         5,
+                                NULL);
+  color  = gegl_node_new_child (graph,
+                                "operation", "gegl:color",
+                                "value",     value,
+                                NULL);
+
+  chain[0] = gegl_node_new_child (graph,
+                                  "operation", "gegl:invert-linear",
+                                  NULL);
+  chain[1] = gegl_node_new_child (graph,
+                                  "operation", "gegl:brightness-contrast",
+                                  "contrast",   1.4,
+                                  "brightness", 0.1,
+                                  NULL);
+  chain[2] = gegl_node_new_child (graph,
+                                  "operation", "gegl:threshold",
+                                  "value",     0.4,
+                                  NULL);
+  chain[3] = gegl_node_new_child (graph,
+                                  "operation", "gegl:multiply",
+                                  NULL);
+
+  gegl_node_link_many (source, chain[0], chain[1], chain[2], chain[3], NULL);
+  gegl_node_connect (chain[3], "aux", color, "output");
+
+  if (! fusible)
+    {
+      for (i = 0; i < 3; i++)
+        {
+          GeglNode *sink = gegl_node_new_child (graph,
+                                                "operation", "gegl:nop",
+                                                NULL);
+
+          gegl_node_connect (sink, "input", chain[i], "output");
+        }
+    }
+
+  buffer = gegl_buffer_new (GEGL_RECTANGLE (0, 0, size, size),
+                            babl_format ("RGBA float"));
+
+  gegl_node_blit_buffer (chain[3], buffer, NULL, level, GEGL_ABYSS_NONE);
+
+  data = g_new (gfloat, size * size * 4);
+
+  gegl_buffer_get (buffer, NULL, 1.0, babl_format ("RGBA float"), data,
+                   GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+
+  g_object_unref (buffer);
+  g_object_unref (graph);
+  g_object_unref (value);
+
+  return data;
+}
+
+gint
+main (gint    argc,
+      gchar **argv)
+{
+  gint result = SUCCESS;
+  gint level;
+
+  gegl_init (&argc, &argv);
+
+  for (level = 0; level <= 1; level++)
+    {
+      gfloat *fused     = render (TRUE,  level);
+      gfloat *separate  = render (FALSE, level);
+      gint    size      = SIZE >> level;
+
+      if (memcmp (fused, separate, size * size * 4 * sizeof (gfloat)))
+        {
+          printf ("fused result differs from separate result at level %d\n",
+                  level);
+          result = FAILURE;
+        }
+
+      g_free (fused);
+      g_free (separate);
+    }
+
+  gegl_exit ();
+
+  return result;
+}
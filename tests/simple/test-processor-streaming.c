@@ -0,0 +1,166 @@
+/* This file is a test-case for GEGL
+ *
+ * GEGL is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * GEGL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GEGL; if not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <stdio.h>
+#include <math.h>
+
+#include "gegl.h"
+#include "graph/gegl-node-private.h"
+#include "graph/gegl-cache.h"
+
+#define SUCCESS    0
+#define FAILURE    -1
+
+#define WIDTH      256
+#define HEIGHT     1024
+#define CHUNK_SIZE 1024
+
+/* returns the area of the valid region of the node's cache */
+static gint
+cached_area (GeglNode *node)
+{
+  GeglRectangle *rectangles;
+  gint           n_rectangles;
+  gint           area = 0;
+  gint           i;
+
+  if (! node->cache)
+    return 0;
+
+  gegl_region_get_rectangles (node->cache->valid_region[0],
+                              &rectangles, &n_rectangles);
+
+  for (i = 0; i < n_rectangles; i++)
+    area += rectangles[i].width * rectangles[i].height;
+
+  g_free (rectangles);
+
+  return area;
+}
+
+/* render checkerboard -> invert (cached) -> box-blur into a buffer, in
+ * small chunks, and return the pixels together with the area left in the
+ * cache of the intermediate node.
+ */
+static gfloat *
+render (gboolean  streaming,
+        gint     *intermediate_area)
+{
+  GeglNode      *graph;
+  GeglNode      *source;
+  GeglNode      *invert;
+  GeglNode      *blur;
+  GeglNode      *sink;
+  GeglBuffer    *buffer;
+  GeglProcessor *processor;
+  gfloat        *data;
+
+  buffer = gegl_buffer_new (GEGL_RECTANGLE (0, 0, WIDTH, HEIGHT),
+                            babl_format ("RGBA float"));
+
+  graph  = gegl_node_new ();
+  source = gegl_node_new_child (graph,
+                                "operation", "gegl:checkerboard",
+                                "x",         13,
+                                "y",         11,
+                                NULL);
+  invert = gegl_node_new_child (graph,
+                                "operation",    "gegl:invert-linear",
+                                "cache-policy", GEGL_CACHE_POLICY_ALWAYS,
+                                NULL);
+  blur   = gegl_node_new_child (graph,
+                                "operation", "gegl:box-blur",
+                                "radius",    5,
+                                NULL);
+  sink   = gegl_node_new_child (graph,
+                                "operation", "gegl:write-buffer",
+                                "buffer",    buffer,
+                                NULL);
+
+  gegl_node_link_many (source, invert, blur, sink, NULL);
+
+  processor = g_object_new (GEGL_TYPE_PROCESSOR,
+                            "node",      sink,
+                            "chunksize", CHUNK_SIZE,
+                            "rectangle", GEGL_RECTANGLE (0, 0, WIDTH, HEIGHT),
+                            "streaming", streaming,
+                            NULL);
+
+  while (gegl_processor_work (processor, NULL));
+
+  *intermediate_area = cached_area (invert);
+
+  g_object_unref (processor);
+
+  data = g_new (gfloat, WIDTH * HEIGHT * 4);
+
+  gegl_buffer_get (buffer, NULL, 1.0, babl_format ("RGBA float"), data,
+                   GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+
+  g_object_unref (graph);
+  g_object_unref (buffer);
+
+  return data;
+}
+
+gint
+main (gint    argc,
+      gchar **argv)
+{
+  gfloat *streamed;
+  gfloat *reference;
+  gint    streamed_area;
+  gint    reference_area;
+  gint    result = SUCCESS;
+  gint    i;
+
+  gegl_init (&argc, &argv);
+
+  reference = render (FALSE, &reference_area);
+  streamed  = render (TRUE,  &streamed_area);
+
+  for (i = 0; i < WIDTH * HEIGHT * 4; i++)
+    {
+      if (fabs (reference[i] - streamed[i]) > 1e-5)
+        {
+          printf ("streamed result differs at pixel %d, %d\n",
+                  (i / 4) % WIDTH, (i / 4) / WIDTH);
+          result = FAILURE;
+          break;
+        }
+    }
+
+  if (reference_area < WIDTH * HEIGHT)
+    {
+      printf ("intermediate node was not cached\n");
+      result = FAILURE;
+    }
+  else if (streamed_area > WIDTH * HEIGHT / 8)
+    {
+      printf ("intermediate cache still holds %d pixels after streaming\n",
+              streamed_area);
+      result = FAILURE;
+    }
+
+  g_free (reference);
+  g_free (streamed);
+
+  gegl_exit ();
+
+  return result;
+}
@@ -0,0 +1,227 @@
+/* This file is a test-case for GEGL
+ *
+ * GEGL is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * GEGL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GEGL; if not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include "gegl.h"
+#include "graph/gegl-region.h"
+
+#define SUCCESS    0
+#define FAILURE    -1
+
+#define SIZE       128
+#define MAX_RECT   24
+#define N_OPS      2000
+#define N_QUERIES  20
+
+/* the pixels of the region, kept up to date alongside it */
+static guchar mask[SIZE][SIZE];
+
+static void
+mask_set (const GeglRectangle *rect,
+          guchar               value)
+{
+  gint x;
+  gint y;
+
+  for (y = MAX (rect->y, 0); y < MIN (rect->y + rect->height, SIZE); y++)
+    for (x = MAX (rect->x, 0); x < MIN (rect->x + rect->width, SIZE); x++)
+      mask[y][x] = value;
+}
+
+static GeglOverlapType
+mask_rect_in (const GeglRectangle *rect)
+{
+  gboolean in  = FALSE;
+  gboolean out = FALSE;
+  gint     x;
+  gint     y;
+
+  for (y = rect->y; y < rect->y + rect->height; y++)
+    {
+      for (x = rect->x; x < rect->x + rect->width; x++)
+        {
+          if (x >= 0 && x < SIZE && y >= 0 && y < SIZE && mask[y][x])
+            in = TRUE;
+          else
+            out = TRUE;
+        }
+    }
+
+  if (! in)
+    return GEGL_OVERLAP_RECTANGLE_OUT;
+  else if (out)
+    return GEGL_OVERLAP_RECTANGLE_PART;
+  else
+    return GEGL_OVERLAP_RECTANGLE_IN;
+}
+
+static void
+random_rect (GRand         *rand,
+             GeglRectangle *rect)
+{
+  rect->x      = g_rand_int_range (rand, -8, SIZE);
+  rect->y      = g_rand_int_range (rand, -8, SIZE);
+  rect->width  = g_rand_int_range (rand, 0, MAX_RECT);
+  rect->height = g_rand_int_range (rand, 0, MAX_RECT);
+}
+
+/* check that the rectangles of @region are banded and cover exactly the
+ * pixels of the mask.
+ */
+static gboolean
+check_region (GeglRegion *region)
+{
+  static guchar  covered[SIZE][SIZE];
+  GeglRectangle *rectangles;
+  GeglRectangle  extents;
+  gint           n_rectangles;
+  gboolean       result = TRUE;
+  gint           i;
+
+  gegl_region_get_rectangles (region, &rectangles, &n_rectangles);
+  gegl_region_get_clipbox (region, &extents);
+
+  memset (covered, 0, sizeof (covered));
+
+  for (i = 0; i < n_rectangles && result; i++)
+    {
+      const GeglRectangle *rect = &rectangles[i];
+
+      if (! gegl_rectangle_contains (&extents, rect))
+        {
+          printf ("rectangle %d is outside the extents\n", i);
+          result = FALSE;
+        }
+
+      if (i > 0)
+        {
+          const GeglRectangle *prev = &rectangles[i - 1];
+
+          if (prev->y == rect->y ?
+              prev->height != rect->height ||
+              prev->x + prev->width >= rect->x :
+              prev->y + prev->height > rect->y)
+            {
+              printf ("rectangles %d and %d are not banded\n", i - 1, i);
+              result = FALSE;
+            }
+        }
+
+      if (result)
+        {
+          gint x;
+          gint y;
+
+          for (y = rect->y; y < rect->y + rect->height; y++)
+            for (x = rect->x; x < rect->x + rect->width; x++)
+              covered[y][x] = 1;
+        }
+    }
+
+  if (result && memcmp (covered, mask, sizeof (mask)))
+    {
+      printf ("region does not cover the expected pixels\n");
+      result = FALSE;
+    }
+
+  g_free (rectangles);
+
+  return result;
+}
+
+gint
+main (gint    argc,
+      gchar **argv)
+{
+  GeglRegion *region;
+  GRand      *rand;
+  gint        result = SUCCESS;
+  gint        i;
+
+  gegl_init (&argc, &argv);
+
+  rand   = g_rand_new_with_seed (3456);
+  region = gegl_region_new ();
+
+  /* the region stays within the mask, so that every pixel it covers can
+   * be checked.
+   */
+  for (i = 0; i < N_OPS && result == SUCCESS; i++)
+    {
+      GeglRectangle rect;
+      gint          j;
+
+      random_rect (rand, &rect);
+      gegl_rectangle_intersect (&rect, &rect,
+                                GEGL_RECTANGLE (0, 0, SIZE, SIZE));
+
+      if (g_rand_int_range (rand, 0, 3))
+        {
+          gegl_region_union_with_rect (region, &rect);
+          mask_set (&rect, 1);
+        }
+      else
+        {
+          GeglRegion *tmp = gegl_region_rectangle (&rect);
+
+          gegl_region_subtract (region, tmp);
+          mask_set (&rect, 0);
+
+          gegl_region_destroy (tmp);
+        }
+
+      if (! check_region (region))
+        {
+          printf ("after operation %d\n", i);
+          result = FAILURE;
+        }
+
+      for (j = 0; j < N_QUERIES && result == SUCCESS; j++)
+        {
+          GeglRectangle query;
+
+          random_rect (rand, &query);
+
+          if (query.width > 0 && query.height > 0 &&
+              gegl_region_rect_in (region, &query) != mask_rect_in (&query))
+            {
+              printf ("rect_in (%d, %d, %d, %d) is wrong\n",
+                      query.x, query.y, query.width, query.height);
+              result = FAILURE;
+            }
+
+          if (gegl_region_point_in (region, query.x, query.y) !=
+              (query.x >= 0 && query.x < SIZE &&
+               query.y >= 0 && query.y < SIZE &&
+               mask[query.y][query.x]))
+            {
+              printf ("point_in (%d, %d) is wrong\n", query.x, query.y);
+              result = FAILURE;
+            }
+        }
+    }
+
+  gegl_region_destroy (region);
+  g_rand_free (rand);
+
+  gegl_exit ();
+
+  return result;
+}
@@ -0,0 +1,191 @@
+/* This file is a test-case for GEGL
+ *
+ * GEGL is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * GEGL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GEGL; if not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <stdio.h>
+
+#include "gegl.h"
+#include "gegl-buffer-private.h"
+#include "graph/gegl-node-private.h"
+#include "graph/gegl-cache.h"
+
+#define SUCCESS    0
+#define FAILURE    -1
+
+#define SIZE       128
+
+typedef struct
+{
+  GeglNode *graph;
+  GeglNode *source;
+  GeglNode *blur;
+} Chain;
+
+/* a source, and a blur caching its result, in a graph of their own */
+static void
+chain_init (Chain      *chain,
+            GeglBuffer *buffer)
+{
+  chain->graph = gegl_node_new ();
+
+  if (buffer)
+    {
+      chain->source = gegl_node_new_child (chain->graph,
+                                           "operation", "gegl:buffer-source",
+                                           "buffer",    buffer,
+                                           NULL);
+    }
+  else
+    {
+      chain->source = gegl_node_new_child (chain->graph,
+                                           "operation", "gegl:checkerboard",
+                                           "x",         7,
+                                           "y",         5,
+                                           NULL);
+    }
+
+  chain->blur = gegl_node_new_child (chain->graph,
+                                     "operation", "gegl:box-blur",
+                                     "radius",    2,
+                                     NULL);
+
+  gegl_node_set (chain->blur,
+                 "cache-policy", GEGL_CACHE_POLICY_ALWAYS,
+                 NULL);
+
+  gegl_node_link (chain->source, chain->blur);
+}
+
+static void
+chain_render (Chain *chain)
+{
+  gegl_node_blit (chain->blur, 1.0, GEGL_RECTANGLE (0, 0, SIZE, SIZE),
+                  NULL, NULL, GEGL_AUTO_ROWSTRIDE, GEGL_BLIT_CACHE);
+}
+
+/* whether the first tiles of the caches of both chains share their data */
+static gboolean
+chains_share (Chain *a,
+              Chain *b)
+{
+  GeglTile *tile_a;
+  GeglTile *tile_b;
+  gboolean  shared;
+
+  tile_a = gegl_buffer_get_tile (GEGL_BUFFER (gegl_node_get_cache (a->blur)),
+                                 0, 0, 0);
+  tile_b = gegl_buffer_get_tile (GEGL_BUFFER (gegl_node_get_cache (b->blur)),
+                                 0, 0, 0);
+
+  shared = gegl_tile_get_data (tile_a) == gegl_tile_get_data (tile_b);
+
+  gegl_tile_unref (tile_b);
+  gegl_tile_unref (tile_a);
+
+  return shared;
+}
+
+static void
+chain_clear (Chain *chain)
+{
+  g_object_unref (chain->graph);
+}
+
+gint
+main (gint    argc,
+      gchar **argv)
+{
+  const gfloat  gray[4] = {0.5, 0.5, 0.5, 1.0};
+  GeglBuffer   *buffer;
+  Chain         a, b, c, d, e;
+  gint          result = SUCCESS;
+
+  gegl_init (&argc, &argv);
+
+  g_object_set (gegl_config (),
+                "shared-cache", TRUE,
+                NULL);
+
+  chain_init (&a, NULL);
+  chain_init (&b, NULL);
+
+  chain_render (&a);
+  chain_render (&b);
+
+  if (! chains_share (&a, &b))
+    {
+      printf ("identical chains did not share their result\n");
+      result = FAILURE;
+    }
+
+  /* a different blur is a different result */
+  gegl_node_set (b.blur, "radius", 3, NULL);
+
+  chain_render (&b);
+
+  if (chains_share (&a, &b))
+    {
+      printf ("a changed chain kept sharing its result\n");
+      result = FAILURE;
+    }
+
+  /* buffers can change behind the back of a node, so they are not hashed */
+  buffer = gegl_buffer_new (GEGL_RECTANGLE (0, 0, SIZE, SIZE),
+                            babl_format ("RGBA float"));
+
+  gegl_buffer_set_color_from_pixel (buffer, NULL, gray,
+                                    babl_format ("RGBA float"));
+
+  chain_init (&c, buffer);
+  chain_init (&d, buffer);
+
+  chain_render (&c);
+  chain_render (&d);
+
+  if (chains_share (&c, &d))
+    {
+      printf ("chains reading a buffer shared their result\n");
+      result = FAILURE;
+    }
+
+  /* and nothing is shared unless asked for */
+  g_object_set (gegl_config (),
+                "shared-cache", FALSE,
+                NULL);
+
+  chain_init (&e, NULL);
+
+  chain_render (&e);
+
+  if (chains_share (&a, &e))
+    {
+      printf ("a result was shared with sharing disabled\n");
+      result = FAILURE;
+    }
+
+  chain_clear (&e);
+  chain_clear (&d);
+  chain_clear (&c);
+  chain_clear (&b);
+  chain_clear (&a);
+
+  g_object_unref (buffer);
+
+  gegl_exit ();
+
+  return result;
+}
@@ -0,0 +1,170 @@
+/* This file is a test-case for GEGL
+ *
+ * GEGL is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * GEGL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GEGL; if not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include "gegl.h"
+
+#define SUCCESS    0
+#define FAILURE    -1
+
+#define SIZE       64
+#define SPAN       150
+#define N_SPANS    20
+
+/* sample a span with the span function and pixel by pixel with the plain
+ * sampler function, and check that both give the same bytes.
+ */
+static gboolean
+test_span (GeglBuffer        *buffer,
+           const Babl        *format,
+           GeglSamplerType    sampler_type,
+           GeglAbyssPolicy    abyss_policy,
+           GeglBufferMatrix2 *scale,
+           gdouble            x,
+           gdouble            y,
+           gdouble            dx,
+           gdouble            dy)
+{
+  GeglSampler           *sampler;
+  GeglSamplerGetFun      get_fun;
+  GeglSamplerGetSpanFun  get_span_fun;
+  gint                   bpp = babl_format_get_bytes_per_pixel (format);
+  guchar                *span;
+  guchar                *pixels;
+  gboolean               result = TRUE;
+  gint                   i;
+
+  sampler      = gegl_buffer_sampler_new (buffer, format, sampler_type);
+  get_fun      = gegl_sampler_get_fun (sampler);
+  get_span_fun = gegl_sampler_get_span_fun (sampler);
+
+  if (! get_span_fun)
+    {
+      printf ("sampler type %d has no span function\n", sampler_type);
+      g_object_unref (sampler);
+
+      return FALSE;
+    }
+
+  span   = g_malloc0 (SPAN * bpp);
+  pixels = g_malloc0 (SPAN * bpp);
+
+  get_span_fun (sampler, x, y, dx, dy, scale, span, SPAN, abyss_policy);
+
+  for (i = 0; i < SPAN; i++)
+    {
+      get_fun (sampler, x, y, scale, pixels + i * bpp, abyss_policy);
+
+      x += dx;
+      y += dy;
+    }
+
+  if (memcmp (span, pixels, SPAN * bpp))
+    {
+      printf ("span differs from single samples: sampler %d, abyss %d, "
+              "format %s\n",
+              sampler_type, abyss_policy, babl_get_name (format));
+      result = FALSE;
+    }
+
+  g_free (pixels);
+  g_free (span);
+
+  g_object_unref (sampler);
+
+  return result;
+}
+
+gint
+main (gint    argc,
+      gchar **argv)
+{
+  const GeglSamplerType sampler_types[] = {GEGL_SAMPLER_NEAREST,
+                                           GEGL_SAMPLER_LINEAR,
+                                           GEGL_SAMPLER_CUBIC};
+  const GeglAbyssPolicy abyss_policies[] = {GEGL_ABYSS_NONE,
+                                            GEGL_ABYSS_CLAMP,
+                                            GEGL_ABYSS_LOOP,
+                                            GEGL_ABYSS_BLACK};
+  const gchar          *formats[] = {"RGBA float",
+                                     "R'G'B'A u8",
+                                     "Y float"};
+  GeglBuffer           *buffer;
+  GRand                *rand;
+  gfloat               *data;
+  gint                  result = SUCCESS;
+  gint                  i;
+
+  gegl_init (&argc, &argv);
+
+  rand = g_rand_new_with_seed (1234);
+
+  data = g_new (gfloat, SIZE * SIZE * 4);
+
+  for (i = 0; i < SIZE * SIZE * 4; i++)
+    data[i] = g_rand_double (rand);
+
+  buffer = gegl_buffer_new (GEGL_RECTANGLE (0, 0, SIZE, SIZE),
+                            babl_format ("RGBA float"));
+  gegl_buffer_set (buffer, NULL, 0, babl_format ("RGBA float"), data,
+                   GEGL_AUTO_ROWSTRIDE);
+
+  for (i = 0; i < N_SPANS && result == SUCCESS; i++)
+    {
+      GeglBufferMatrix2 scale;
+      gdouble           x  = g_rand_double_range (rand, -20.0, SIZE + 20.0);
+      gdouble           y  = g_rand_double_range (rand, -20.0, SIZE + 20.0);
+      gdouble           dx = g_rand_double_range (rand, -1.5, 1.5);
+      gdouble           dy = g_rand_double_range (rand, -1.5, 1.5);
+      gint              s;
+      gint              a;
+      gint              f;
+
+      /* every other span downscales enough for the box filter to kick in */
+      scale.coeff[0][0] = dx * (i % 2 ? 3.0 : 1.0);
+      scale.coeff[1][0] = dy * (i % 2 ? 3.0 : 1.0);
+      scale.coeff[0][1] = -dy;
+      scale.coeff[1][1] = dx;
+
+      for (s = 0; s < G_N_ELEMENTS (sampler_types); s++)
+        {
+          for (a = 0; a < G_N_ELEMENTS (abyss_policies); a++)
+            {
+              for (f = 0; f < G_N_ELEMENTS (formats); f++)
+                {
+                  if (! test_span (buffer, babl_format (formats[f]),
+                                   sampler_types[s], abyss_policies[a],
+                                   &scale, x, y, dx, dy))
+                    {
+                      result = FAILURE;
+                    }
+                }
+            }
+        }
+    }
+
+  g_object_unref (buffer);
+  g_free (data);
+  g_rand_free (rand);
+
+  gegl_exit ();
+
+  return result;
+}
@@ -0,0 +1,148 @@
+/* This file is a test-case for GEGL
+ *
+ * GEGL is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * GEGL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GEGL; if not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "gegl.h"
+
+#define SUCCESS  0
+#define FAILURE -1
+#define SKIP     77
+
+/* pyramid-tiled.tif is a 256x256, 8-bit gray image, tiled 64x64, whose
+ * full-resolution pixels are all 200.  its single SubIFD holds a 128x128
+ * reduced-resolution image whose four tiles are 40, 60, 80 and 100, in
+ * row-major order, so that the file's own level 1 can be told apart from
+ * one downscaled from level 0.  the file has no level 2.
+ */
+#define FULL_VALUE 200
+
+static gint
+quadrant_value (gint x,
+                gint y,
+                gint size)
+{
+  gint tx = x >= size / 2;
+  gint ty = y >= size / 2;
+
+  return 40 + 20 * (ty * 2 + tx);
+}
+
+static gboolean
+test_level (GeglBuffer *buffer,
+            gint        level)
+{
+  const gint  size   = 256 >> level;
+  guchar     *pixels = g_malloc (size * size);
+  gboolean    result = TRUE;
+  gint        x;
+  gint        y;
+
+  gegl_buffer_get (buffer, GEGL_RECTANGLE (0, 0, size, size),
+                   1.0 / (1 << level),
+                   babl_format ("Y' u8"), pixels,
+                   GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+
+  for (y = 0; y < size && result; y++)
+    {
+      for (x = 0; x < size; x++)
+        {
+          gint expected = level ? quadrant_value (x, y, size) : FULL_VALUE;
+          gint value    = pixels[y * size + x];
+
+          if (abs (value - expected) > (level > 1 ? 1 : 0))
+            {
+              printf ("level %d: pixel (%d, %d) is %d, expected %d\n",
+                      level, x, y, value, expected);
+
+              result = FALSE;
+              break;
+            }
+        }
+    }
+
+  g_free (pixels);
+
+  return result;
+}
+
+gint
+main (gint    argc,
+      gchar **argv)
+{
+  GeglNode   *graph;
+  GeglNode   *load;
+  GeglNode   *sink;
+  GeglBuffer *buffer = NULL;
+  gchar      *path;
+  gint        level;
+  gint        result = SUCCESS;
+
+  gegl_init (&argc, &argv);
+
+  if (! gegl_has_operation ("gegl:tiff-load"))
+    {
+      gegl_exit ();
+
+      return SKIP;
+    }
+
+  path = g_build_filename (g_getenv ("ABS_TOP_SRCDIR"),
+                           "tests", "compositions", "data",
+                           "pyramid-tiled.tif",
+                           NULL);
+
+  graph = gegl_node_new ();
+  load  = gegl_node_new_child (graph,
+                               "operation", "gegl:tiff-load",
+                               "path",      path,
+                               NULL);
+  sink  = gegl_node_new_child (graph,
+                               "operation", "gegl:buffer-sink",
+                               "buffer",    &buffer,
+                               NULL);
+
+  gegl_node_link (load, sink);
+  gegl_node_process (sink);
+
+  g_free (path);
+
+  if (! buffer)
+    {
+      printf ("failed to load pyramid-tiled.tif\n");
+
+      result = FAILURE;
+    }
+
+  /* level 0 and 1 are read from the file, level 2 is synthesized from the
+   * file's level 1 by the zoom handler.
+   */
+  for (level = 0; result == SUCCESS && level <= 2; level++)
+    {
+      if (! test_level (buffer, level))
+        result = FAILURE;
+    }
+
+  g_clear_object (&buffer);
+  g_object_unref (graph);
+
+  gegl_exit ();
+
+  return result;
+}
@@ -0,0 +1,190 @@
+/* This file is a test-case for GEGL
+ *
+ * GEGL is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * GEGL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GEGL; if not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include "gegl.h"
+
+#define SUCCESS    0
+#define FAILURE    -1
+
+#define TILE_SIZE     64
+#define CACHE_TILES   16
+#define WORKING_TILES 4
+#define SCAN_TILES    24
+
+static void
+fill (GeglBuffer *buffer,
+      gint        n_tiles,
+      guchar      seed)
+{
+  const Babl *format = babl_format ("Y u8");
+  guchar      data[TILE_SIZE * TILE_SIZE];
+  gint        i;
+
+  for (i = 0; i < n_tiles; i++)
+    {
+      memset (data, (guchar) (seed + i), sizeof (data));
+
+      gegl_buffer_set (buffer,
+                       GEGL_RECTANGLE (i * TILE_SIZE, 0, TILE_SIZE, TILE_SIZE),
+                       0, format, data, GEGL_AUTO_ROWSTRIDE);
+    }
+}
+
+static gboolean
+verify (GeglBuffer *buffer,
+        gint        n_tiles,
+        guchar      seed)
+{
+  const Babl *format = babl_format ("Y u8");
+  guchar      data[TILE_SIZE * TILE_SIZE];
+  gint        i;
+  gint        j;
+
+  for (i = 0; i < n_tiles; i++)
+    {
+      gegl_buffer_get (buffer,
+                       GEGL_RECTANGLE (i * TILE_SIZE, 0, TILE_SIZE, TILE_SIZE),
+                       1.0, format, data,
+                       GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+
+      for (j = 0; j < TILE_SIZE * TILE_SIZE; j++)
+        {
+          if (data[j] != (guchar) (seed + i))
+            return FALSE;
+        }
+    }
+
+  return TRUE;
+}
+
+/* interleave accesses to a small working set with scans over a buffer larger
+ * than the cache, and make sure the data survives eviction under the given
+ * policy.
+ */
+static gint
+test_policy (const gchar *policy)
+{
+  GeglBuffer *working;
+  GeglBuffer *scan;
+  gint        ghost_hits;
+  gint        result = SUCCESS;
+  gint        i;
+
+  g_object_set (gegl_config (),
+                "tile-cache-policy", policy,
+                NULL);
+
+  working = gegl_buffer_new (
+    GEGL_RECTANGLE (0, 0, WORKING_TILES * TILE_SIZE, TILE_SIZE),
+    babl_format ("Y u8"));
+  scan    = gegl_buffer_new (
+    GEGL_RECTANGLE (0, 0, SCAN_TILES * TILE_SIZE, TILE_SIZE),
+    babl_format ("Y u8"));
+
+  gegl_reset_stats ();
+
+  fill (working, WORKING_TILES, 1);
+  fill (scan,    SCAN_TILES,    2);
+
+  for (i = 0; i < 4; i++)
+    {
+      if (! verify (working, WORKING_TILES, 1) ||
+          ! verify (scan,    SCAN_TILES,    2))
+        {
+          printf ("\n  %s: data mismatch", policy);
+          result = FAILURE;
+
+          break;
+        }
+    }
+
+  g_object_get (gegl_stats (),
+                "tile-cache-ghost-hits", &ghost_hits,
+                NULL);
+
+  /* repeated scans over a buffer larger than the cache must hit the ghosts of
+   * the adaptive policies, and never those of plain LRU.
+   */
+  if ((ghost_hits > 0) != (g_strcmp0 (policy, "lru") != 0))
+    {
+      printf ("\n  %s: unexpected ghost hits (%d)", policy, ghost_hits);
+      result = FAILURE;
+    }
+
+  g_object_unref (scan);
+  g_object_unref (working);
+
+  return result;
+}
+
+static gint
+test_lru (void)
+{
+  return test_policy ("lru");
+}
+
+static gint
+test_arc (void)
+{
+  return test_policy ("arc");
+}
+
+static gint
+test_clock_pro (void)
+{
+  return test_policy ("clock-pro");
+}
+
+#define RUN_TEST(test) \
+  do \
+  { \
+    printf (#test "..."); \
+    fflush (stdout); \
+    \
+    if (test_##test () == SUCCESS) \
+      printf (" passed\n"); \
+    else \
+      { \
+        printf (" FAILED\n"); \
+        result = FAILURE; \
+      } \
+  } while (FALSE)
+
+int main (int argc, char *argv[])
+{
+  gint result = SUCCESS;
+
+  gegl_init (&argc, &argv);
+
+  g_object_set (gegl_config (),
+                "tile-width",      TILE_SIZE,
+                "tile-height",     TILE_SIZE,
+                "tile-cache-size", (guint64) CACHE_TILES * TILE_SIZE * TILE_SIZE,
+                NULL);
+
+  RUN_TEST (lru);
+  RUN_TEST (arc);
+  RUN_TEST (clock_pro);
+
+  gegl_exit ();
+
+  return result;
+}
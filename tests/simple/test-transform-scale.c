@@ -0,0 +1,190 @@
+/* This file is a test-case for GEGL
+ *
+ * GEGL is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * GEGL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GEGL; if not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <stdio.h>
+#include <math.h>
+
+#include "gegl.h"
+
+#define SUCCESS    0
+#define FAILURE    -1
+
+#define WIDTH      400
+#define HEIGHT     300
+
+/* render @source scaled by @x, @y with gegl:scale-ratio, and return the
+ * pixels of @rect.
+ */
+static gfloat *
+render (GeglBuffer          *source,
+        gdouble              x,
+        gdouble              y,
+        GeglSamplerType      sampler,
+        const GeglRectangle *rect)
+{
+  GeglNode   *graph;
+  GeglNode   *input;
+  GeglNode   *scale;
+  GeglBuffer *buffer;
+  gfloat     *data;
+
+  graph = gegl_node_new ();
+  input = gegl_node_new_child (graph,
+                               "operation", "gegl:buffer-source",
+                               "buffer",    source,
+                               NULL);
+  scale = gegl_node_new_child (graph,
+                               "operation", "gegl:scale-ratio",
+                               "x",         x,
+                               "y",         y,
+                               "sampler",   sampler,
+                               NULL);
+
+  gegl_node_link (input, scale);
+
+  buffer = gegl_buffer_new (rect, babl_format ("RaGaBaA float"));
+
+  gegl_node_blit_buffer (scale, buffer, rect, 0, GEGL_ABYSS_NONE);
+
+  data = g_new (gfloat, rect->width * rect->height * 4);
+
+  gegl_buffer_get (buffer, rect, 1.0, babl_format ("RaGaBaA float"), data,
+                   GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+
+  g_object_unref (buffer);
+  g_object_unref (graph);
+
+  return data;
+}
+
+/* sample @source the way the general affine path does, one output pixel
+ * at a time.
+ */
+static gfloat *
+render_reference (GeglBuffer          *source,
+                  gdouble              x,
+                  gdouble              y,
+                  GeglSamplerType      sampler_type,
+                  const GeglRectangle *rect)
+{
+  GeglSampler       *sampler;
+  GeglBufferMatrix2  jacobian = {{{1.0 / x, 0.0}, {0.0, 1.0 / y}}};
+  gfloat            *data;
+  gfloat            *dst;
+  gint               i;
+  gint               j;
+
+  sampler = gegl_buffer_sampler_new (source, babl_format ("RaGaBaA float"),
+                                     sampler_type);
+
+  data = g_new (gfloat, rect->width * rect->height * 4);
+  dst  = data;
+
+  for (j = 0; j < rect->height; j++)
+    {
+      for (i = 0; i < rect->width; i++)
+        {
+          gegl_sampler_get (sampler,
+                            (rect->x + i + 0.5) / x,
+                            (rect->y + j + 0.5) / y,
+                            &jacobian, dst, GEGL_ABYSS_NONE);
+          dst += 4;
+        }
+    }
+
+  g_object_unref (sampler);
+
+  return data;
+}
+
+gint
+main (gint    argc,
+      gchar **argv)
+{
+  const GeglSamplerType samplers[] = {GEGL_SAMPLER_LINEAR,
+                                      GEGL_SAMPLER_CUBIC};
+  const gdouble         scales[][2] = {{0.13, 0.21},
+                                       {2.7,  1.6}};
+  GeglBuffer           *source;
+  GRand                *rand;
+  gfloat               *data;
+  gint                  result = SUCCESS;
+  gint                  i;
+  gint                  s;
+  gint                  k;
+
+  gegl_init (&argc, &argv);
+
+  rand = g_rand_new_with_seed (4321);
+
+  data = g_new (gfloat, WIDTH * HEIGHT * 4);
+
+  for (i = 0; i < WIDTH * HEIGHT * 4; i++)
+    data[i] = g_rand_double (rand);
+
+  source = gegl_buffer_new (GEGL_RECTANGLE (0, 0, WIDTH, HEIGHT),
+                            babl_format ("RGBA float"));
+  gegl_buffer_set (source, NULL, 0, babl_format ("RGBA float"), data,
+                   GEGL_AUTO_ROWSTRIDE);
+
+  g_free (data);
+
+  /* compare the separable scale path against per-pixel sampling, inside
+   * the image where the affine path does not clip.
+   */
+  for (s = 0; s < G_N_ELEMENTS (samplers); s++)
+    {
+      for (k = 0; k < G_N_ELEMENTS (scales); k++)
+        {
+          GeglRectangle  rect = {4, 4,
+                                 WIDTH  * scales[k][0] - 8,
+                                 HEIGHT * scales[k][1] - 8};
+          gfloat        *scaled;
+          gfloat        *reference;
+
+          scaled    = render (source, scales[k][0], scales[k][1],
+                              samplers[s], &rect);
+          reference = render_reference (source, scales[k][0], scales[k][1],
+                                        samplers[s], &rect);
+
+          for (i = 0; i < rect.width * rect.height * 4; i++)
+            {
+              if (fabs (scaled[i] - reference[i]) > 1e-4)
+                {
+                  printf ("scale %g x %g with sampler %d differs from "
+                          "sampling per pixel at %d, %d\n",
+                          scales[k][0], scales[k][1], samplers[s],
+                          rect.x + (i / 4) % rect.width,
+                          rect.y + (i / 4) / rect.width);
+                  result = FAILURE;
+                  break;
+                }
+            }
+
+          g_free (reference);
+          g_free (scaled);
+        }
+    }
+
+  g_object_unref (source);
+  g_rand_free (rand);
+
+  gegl_exit ();
+
+  return result;
+}